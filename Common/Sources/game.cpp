@@ -9,7 +9,10 @@
 
 #include "resourceSystem.h"
 #include "gameCameraSystem.h"
+#include "visibilitySystem.h"
+#include "renderPassShadow.h"
 #include "windowSystem.h"
+#include "jobSystem.h"
 
 #include "Components/lightSource.h"
 #include "Components/rendered.h"
@@ -19,7 +22,9 @@ std::unique_ptr<GAME_MANAGER> pGameManager;
 bool GAME_MANAGER::Init()
 {
     srand((UINT)time(0));
-    ECS::pEcsCoordinator.reset(new ECS::ECS_COORDINATOR());
+    ECS::pJobSystem.reset(new ECS::JOB_SYSTEM());
+    ECS::pJobSystem->Init();
+    ECS::pEcsCoordinator.reset(new ECS::ECS_COORDINATOR(ECS::COMPONENT_STORAGE_MODE::ARCHETYPE_CHUNKS));
     pWindowSystem.reset(new WINDOW_SYSTEM());
     
     if (!pWindowSystem->Init()) {
@@ -261,6 +266,14 @@ void GAME_MANAGER::LoadSponzaLevel()
 void GAME_MANAGER::Run() {
     LoadSponzaLevel();
 
+    //independent systems are updated concurrently, order matters only for conflicting ones
+    const std::vector<ECS::I_SYSTEM*> updateSystemList = {
+        ECS::pEcsCoordinator->GetSystem<GAME_CAMERA_CONROL>(),
+        ECS::pEcsCoordinator->GetSystem<GUI_SYSTEM>(),
+        ECS::pEcsCoordinator->GetSystem<VISIBILITY_SYSTEM>(),
+        ECS::pEcsCoordinator->GetSystem<RENDER_PASS_SHADOW>(),
+    };
+
     while (true)
     {
         bool isWindowAlive = pWindowSystem->Update();
@@ -268,9 +281,7 @@ void GAME_MANAGER::Run() {
             break;
         }
         //Updates
-        ECS::pEcsCoordinator->GetSystem<GAME_CAMERA_CONROL>()->Update();
-        ECS::pEcsCoordinator->GetSystem<GUI_SYSTEM>()->Update();
-        ECS::pEcsCoordinator->GetSystem<RENDER_SYSTEM>()->Update();
+        ECS::pEcsCoordinator->UpdateSystems(updateSystemList);
 
         //Render
         ECS::pEcsCoordinator->GetSystem<RENDER_SYSTEM>()->Render();
@@ -282,4 +293,5 @@ void GAME_MANAGER::Term()
     ECS::pEcsCoordinator->GetSystem<GUI_SYSTEM> ()->Term();
     ECS::pEcsCoordinator->GetSystem<RENDER_SYSTEM>()->Term();
     pWindowSystem->Term();
+    ECS::pJobSystem->Term();
 }
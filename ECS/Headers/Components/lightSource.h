@@ -8,11 +8,14 @@ struct POINT_LIGHT_COMPONENT : ECS::COMPONENT< POINT_LIGHT_COMPONENT> {
     float intensity;
 };
 
-struct SPOT_LIGHT_COMPONENT : ECS::COMPONENT< POINT_LIGHT_COMPONENT> {
+struct SPOT_LIGHT_COMPONENT : ECS::COMPONENT< SPOT_LIGHT_COMPONENT> {
     float areaLight;
     glm::vec3 color;
     float intensity;
     glm::vec3 direction;
+    //half angles of cone in radians, light fades out between them
+    float innerConeAngle;
+    float outerConeAngle;
 };
 
 struct DIRECTIONAL_LIGHT_COMPONENT : ECS::COMPONENT< DIRECTIONAL_LIGHT_COMPONENT> {
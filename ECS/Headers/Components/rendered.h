@@ -3,6 +3,3 @@
 
 struct RENDERED_COMPONENT : public ECS::COMPONENT<RENDERED_COMPONENT> {
 };
-
-struct VISIBLE_COMPONENT : public ECS::COMPONENT<VISIBLE_COMPONENT> {
-};
@@ -0,0 +1,362 @@
+#pragma once
+#include "ecsCommon.h"
+#include "support.h"
+#include <array>
+#include <memory>
+#include <new>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ECS {
+    //entities with the same signature are stored together in fixed-size chunks,
+    //each chunk keeps one tightly packed column per component type (SoA)
+    const size_t ARCHETYPE_CHUNK_SIZE = 16 * 1024;
+    const size_t ARCHETYPE_CHUNK_ALIGNMENT = 64;
+
+    struct COMPONENT_TYPE_INFO
+    {
+        size_t      size      = 0;
+        size_t      alignment = 0;
+        const char* typeName  = nullptr;
+        void (*pMoveConstruct)(void* pDst, void* pSrc) = nullptr;
+        void (*pDestroy)(void* pData)                  = nullptr;
+    };
+
+    class COMPONENT_TYPE_REGISTRY
+    {
+    public:
+        template<class T>
+        static const COMPONENT_TYPE_INFO& Register() {
+            COMPONENT_TYPE_INFO& typeInfo = GetTypeInfoTable()[T::GetTypeId()];
+            if (typeInfo.size == 0) {
+                typeInfo.size = sizeof(T);
+                typeInfo.alignment = alignof(T);
+                typeInfo.typeName = typeid(T).name();
+                typeInfo.pMoveConstruct = [](void* pDst, void* pSrc) { new (pDst) T(std::move(*static_cast<T*>(pSrc))); };
+                typeInfo.pDestroy = [](void* pData) { static_cast<T*>(pData)->~T(); };
+            }
+            return typeInfo;
+        }
+
+        static const COMPONENT_TYPE_INFO& Get(COMPONENT_TYPE componentType) {
+            ASSERT_MSG(GetTypeInfoTable()[componentType].size != 0, "Component type wasn't registered in archetype storage");
+            return GetTypeInfoTable()[componentType];
+        }
+    private:
+        static std::array<COMPONENT_TYPE_INFO, MAX_COMPONENTS>& GetTypeInfoTable() {
+            static std::array<COMPONENT_TYPE_INFO, MAX_COMPONENTS> typeInfoTable;
+            return typeInfoTable;
+        }
+    };
+
+    class ARCHETYPE;
+
+    class alignas(ARCHETYPE_CHUNK_ALIGNMENT) ARCHETYPE_CHUNK
+    {
+    public:
+        ARCHETYPE_CHUNK(const ARCHETYPE* pArchetype) : m_pArchetype(pArchetype), m_size(0) {}
+
+        uint32_t GetSize() const { return m_size; }
+
+        const ENTITY_TYPE* GetEntities() const {
+            return reinterpret_cast<const ENTITY_TYPE*>(m_data);
+        }
+
+        //returns nullptr if archetype doesn't contain component type
+        template<class T>
+        T* GetColumn();
+
+        void* GetColumnData(COMPONENT_TYPE componentType);
+    private:
+        friend class ARCHETYPE;
+
+        ENTITY_TYPE* GetMutableEntities() {
+            return reinterpret_cast<ENTITY_TYPE*>(m_data);
+        }
+
+        uint8_t          m_data[ARCHETYPE_CHUNK_SIZE];
+        const ARCHETYPE* m_pArchetype;
+        uint32_t         m_size;
+    };
+
+    struct ARCHETYPE_LOCATION
+    {
+        ARCHETYPE* pArchetype = nullptr;
+        uint32_t   chunkId    = 0;
+        uint32_t   rowId      = 0;
+    };
+
+    class ARCHETYPE
+    {
+        static constexpr uint16_t INVALID_COLUMN_OFFSET = std::numeric_limits<uint16_t>::max();
+    public:
+        ARCHETYPE(const COMPONENT_SIGNATURE& signature) : m_signature(signature), m_chunkCapacity(0) {
+            static_assert(ARCHETYPE_CHUNK_SIZE < INVALID_COLUMN_OFFSET, "Column offsets are stored in uint16_t");
+            m_columnOffsetTable.fill(INVALID_COLUMN_OFFSET);
+
+            size_t rowSize = sizeof(ENTITY_TYPE);
+            size_t alignmentReserve = 0;
+            for (size_t componentType = 0; componentType < MAX_COMPONENTS; componentType++) {
+                if (!signature.test(componentType)) {
+                    continue;
+                }
+                const COMPONENT_TYPE_INFO& typeInfo = COMPONENT_TYPE_REGISTRY::Get((COMPONENT_TYPE)componentType);
+                ASSERT(typeInfo.alignment <= ARCHETYPE_CHUNK_ALIGNMENT);
+                m_componentTypeList.push_back((COMPONENT_TYPE)componentType);
+                rowSize += typeInfo.size;
+                alignmentReserve += typeInfo.alignment;
+            }
+            ASSERT_MSG(rowSize + alignmentReserve <= ARCHETYPE_CHUNK_SIZE, "Archetype row doesn't fit into chunk");
+            m_chunkCapacity = static_cast<uint32_t>((ARCHETYPE_CHUNK_SIZE - alignmentReserve) / rowSize);
+
+            //entities ids go first, then component columns
+            size_t offset = sizeof(ENTITY_TYPE) * m_chunkCapacity;
+            for (COMPONENT_TYPE componentType : m_componentTypeList) {
+                const COMPONENT_TYPE_INFO& typeInfo = COMPONENT_TYPE_REGISTRY::Get(componentType);
+                offset = (offset + typeInfo.alignment - 1) & ~(typeInfo.alignment - 1);
+                m_columnOffsetTable[componentType] = static_cast<uint16_t>(offset);
+                offset += typeInfo.size * m_chunkCapacity;
+            }
+            ASSERT(offset <= ARCHETYPE_CHUNK_SIZE);
+        }
+
+        ~ARCHETYPE() {
+            for (auto& pChunk : m_chunkList) {
+                for (uint32_t rowId = 0; rowId < pChunk->m_size; rowId++) {
+                    DestroyRow(*pChunk, rowId);
+                }
+            }
+        }
+
+        const COMPONENT_SIGNATURE& GetSignature() const { return m_signature; }
+        const std::vector<COMPONENT_TYPE>& GetComponentTypes() const { return m_componentTypeList; }
+        uint32_t GetChunkCapacity() const { return m_chunkCapacity; }
+
+        size_t GetChunksNum() const { return m_chunkList.size(); }
+        ARCHETYPE_CHUNK* GetChunk(size_t chunkId) { return m_chunkList[chunkId].get(); }
+
+        bool HasComponent(COMPONENT_TYPE componentType) const {
+            return m_columnOffsetTable[componentType] != INVALID_COLUMN_OFFSET;
+        }
+
+        uint16_t GetColumnOffset(COMPONENT_TYPE componentType) const {
+            return m_columnOffsetTable[componentType];
+        }
+
+        void* GetComponentData(const ARCHETYPE_LOCATION& location, COMPONENT_TYPE componentType) {
+            return GetComponentData(*m_chunkList[location.chunkId], location.rowId, componentType);
+        }
+
+        //components in allocated row are not constructed, caller must construct each column
+        ARCHETYPE_LOCATION AllocateRow(ENTITY_TYPE entity) {
+            if (m_chunkList.empty() || m_chunkList.back()->m_size == m_chunkCapacity) {
+                m_chunkList.emplace_back(new ARCHETYPE_CHUNK(this));
+            }
+            ARCHETYPE_CHUNK& chunk = *m_chunkList.back();
+            ARCHETYPE_LOCATION location;
+            location.pArchetype = this;
+            location.chunkId = static_cast<uint32_t>(m_chunkList.size() - 1);
+            location.rowId = chunk.m_size++;
+            chunk.GetMutableEntities()[location.rowId] = entity;
+            return location;
+        }
+
+        //destroys components of the row and fills the hole with the last row of the archetype,
+        //returns true if some entity was moved into the freed location
+        bool FreeRow(const ARCHETYPE_LOCATION& location, ENTITY_TYPE& movedEntity) {
+            ARCHETYPE_CHUNK& chunk = *m_chunkList[location.chunkId];
+            ARCHETYPE_CHUNK& lastChunk = *m_chunkList.back();
+            const uint32_t lastRowId = lastChunk.m_size - 1;
+            DestroyRow(chunk, location.rowId);
+
+            bool isRowMoved = false;
+            if (&chunk != &lastChunk || location.rowId != lastRowId) {
+                //we want to avoid holes in chunks, so put last row to the place of removed one
+                for (COMPONENT_TYPE componentType : m_componentTypeList) {
+                    const COMPONENT_TYPE_INFO& typeInfo = COMPONENT_TYPE_REGISTRY::Get(componentType);
+                    void* pDst = GetComponentData(chunk, location.rowId, componentType);
+                    void* pSrc = GetComponentData(lastChunk, lastRowId, componentType);
+                    typeInfo.pMoveConstruct(pDst, pSrc);
+                    typeInfo.pDestroy(pSrc);
+                }
+                movedEntity = lastChunk.GetEntities()[lastRowId];
+                chunk.GetMutableEntities()[location.rowId] = movedEntity;
+                isRowMoved = true;
+            }
+
+            if (--lastChunk.m_size == 0) {
+                m_chunkList.pop_back();
+            }
+            return isRowMoved;
+        }
+    private:
+        ARCHETYPE(const ARCHETYPE& archetype) = delete;
+        ARCHETYPE& operator=(const ARCHETYPE& archetype) = delete;
+
+        void* GetComponentData(ARCHETYPE_CHUNK& chunk, uint32_t rowId, COMPONENT_TYPE componentType) const {
+            const uint16_t columnOffset = m_columnOffsetTable[componentType];
+            ASSERT(columnOffset != INVALID_COLUMN_OFFSET);
+            return chunk.m_data + columnOffset + rowId * COMPONENT_TYPE_REGISTRY::Get(componentType).size;
+        }
+
+        void DestroyRow(ARCHETYPE_CHUNK& chunk, uint32_t rowId) const {
+            for (COMPONENT_TYPE componentType : m_componentTypeList) {
+                COMPONENT_TYPE_REGISTRY::Get(componentType).pDestroy(GetComponentData(chunk, rowId, componentType));
+            }
+        }
+
+        COMPONENT_SIGNATURE                           m_signature;
+        std::vector<COMPONENT_TYPE>                   m_componentTypeList;
+        std::array<uint16_t, MAX_COMPONENTS>          m_columnOffsetTable;
+        uint32_t                                      m_chunkCapacity;
+        std::vector<std::unique_ptr<ARCHETYPE_CHUNK>> m_chunkList;
+    };
+
+    template<class T>
+    T* ARCHETYPE_CHUNK::GetColumn() {
+        return static_cast<T*>(GetColumnData(T::GetTypeId()));
+    }
+
+    inline void* ARCHETYPE_CHUNK::GetColumnData(COMPONENT_TYPE componentType) {
+        if (!m_pArchetype->HasComponent(componentType)) {
+            return nullptr;
+        }
+        return m_data + m_pArchetype->GetColumnOffset(componentType);
+    }
+
+    class ARCHETYPE_STORAGE
+    {
+    public:
+        ARCHETYPE_STORAGE() {}
+
+        ~ARCHETYPE_STORAGE() {
+            m_archetypeList.clear();
+            m_archetypeTable.clear();
+        }
+
+        template<class T>
+        void InsertData(ENTITY_TYPE entity, T& component) {
+            EmplaceData<T>(entity, component);
+        }
+
+        template<class T>
+        void InsertData(ENTITY_TYPE entity, T&& component) {
+            EmplaceData<T>(entity, std::move(component));
+        }
+
+        template<class T>
+        void RemoveData(ENTITY_TYPE entity) {
+            RemoveData(entity, T::GetTypeId());
+        }
+
+        void RemoveData(ENTITY_TYPE entity, COMPONENT_TYPE componentType) {
+            ASSERT(entity < MAX_ENTITIES);
+            const ARCHETYPE_LOCATION& location = m_entityLocationList[entity];
+            ASSERT_MSG(location.pArchetype && location.pArchetype->HasComponent(componentType), "Trying to remove component, that doesn't belongs to entity");
+            COMPONENT_SIGNATURE signature = location.pArchetype->GetSignature();
+            signature.reset(componentType);
+            MoveEntity(entity, signature.any() ? GetArchetype(signature) : nullptr);
+        }
+
+        template<class T>
+        T* GetData(ENTITY_TYPE entity) {
+            ASSERT(entity < MAX_ENTITIES);
+            const ARCHETYPE_LOCATION& location = m_entityLocationList[entity];
+            if (!location.pArchetype || !location.pArchetype->HasComponent(T::GetTypeId())) {
+                return nullptr;
+            }
+            return static_cast<T*>(location.pArchetype->GetComponentData(location, T::GetTypeId()));
+        }
+
+        void DestroyEntity(ENTITY_TYPE entity) {
+            ASSERT(entity < MAX_ENTITIES);
+            if (m_entityLocationList[entity].pArchetype) {
+                MoveEntity(entity, nullptr);
+            }
+        }
+
+        //calls func(ARCHETYPE_CHUNK&) for each non-empty chunk, which archetype contains all components from signature
+        template<class FUNC>
+        void ForEachChunk(const COMPONENT_SIGNATURE& signature, FUNC&& func) {
+            for (ARCHETYPE* pArchetype : m_archetypeList) {
+                if ((pArchetype->GetSignature() & signature) != signature) {
+                    continue;
+                }
+                for (size_t chunkId = 0; chunkId < pArchetype->GetChunksNum(); chunkId++) {
+                    func(*pArchetype->GetChunk(chunkId));
+                }
+            }
+        }
+
+        size_t GetArchetypesNum() const { return m_archetypeList.size(); }
+        //changed when some entity moves to other archetype or row, so its components change address
+        uint32_t GetLayoutVersion() const { return m_layoutVersion; }
+    private:
+        ARCHETYPE_STORAGE(const ARCHETYPE_STORAGE& storage) = delete;
+        ARCHETYPE_STORAGE& operator=(const ARCHETYPE_STORAGE& storage) = delete;
+
+        template<class T, class ARG>
+        void EmplaceData(ENTITY_TYPE entity, ARG&& component) {
+            ASSERT(entity < MAX_ENTITIES);
+            const COMPONENT_TYPE componentType = T::GetTypeId();
+            COMPONENT_TYPE_REGISTRY::Register<T>();
+
+            ARCHETYPE_LOCATION& location = m_entityLocationList[entity];
+            if (location.pArchetype && location.pArchetype->HasComponent(componentType)) {
+                *static_cast<T*>(location.pArchetype->GetComponentData(location, componentType)) = std::forward<ARG>(component);
+                return;
+            }
+
+            COMPONENT_SIGNATURE signature;
+            if (location.pArchetype) {
+                signature = location.pArchetype->GetSignature();
+            }
+            signature.set(componentType);
+            MoveEntity(entity, GetArchetype(signature));
+            new (location.pArchetype->GetComponentData(location, componentType)) T(std::forward<ARG>(component));
+        }
+
+        //moves components shared by both archetypes, new components of destination archetype stay unconstructed
+        void MoveEntity(ENTITY_TYPE entity, ARCHETYPE* pDstArchetype) {
+            const ARCHETYPE_LOCATION srcLocation = m_entityLocationList[entity];
+            ARCHETYPE_LOCATION dstLocation;
+            if (pDstArchetype) {
+                dstLocation = pDstArchetype->AllocateRow(entity);
+            }
+
+            if (srcLocation.pArchetype) {
+                m_layoutVersion++;
+                if (pDstArchetype) {
+                    for (COMPONENT_TYPE componentType : srcLocation.pArchetype->GetComponentTypes()) {
+                        if (pDstArchetype->HasComponent(componentType)) {
+                            COMPONENT_TYPE_REGISTRY::Get(componentType).pMoveConstruct(
+                                pDstArchetype->GetComponentData(dstLocation, componentType),
+                                srcLocation.pArchetype->GetComponentData(srcLocation, componentType));
+                        }
+                    }
+                }
+                ENTITY_TYPE movedEntity = 0;
+                if (srcLocation.pArchetype->FreeRow(srcLocation, movedEntity)) {
+                    m_entityLocationList[movedEntity] = srcLocation;
+                }
+            }
+            m_entityLocationList[entity] = dstLocation;
+        }
+
+        ARCHETYPE* GetArchetype(const COMPONENT_SIGNATURE& signature) {
+            auto archetype = m_archetypeTable.find(signature);
+            if (archetype == m_archetypeTable.end()) {
+                archetype = m_archetypeTable.emplace(signature, std::make_unique<ARCHETYPE>(signature)).first;
+                m_archetypeList.push_back(archetype->second.get());
+            }
+            return archetype->second.get();
+        }
+
+        std::unordered_map<COMPONENT_SIGNATURE, std::unique_ptr<ARCHETYPE>> m_archetypeTable;
+        std::vector<ARCHETYPE*>                                             m_archetypeList;
+        std::array<ARCHETYPE_LOCATION, MAX_ENTITIES>                        m_entityLocationList;
+        uint32_t                                                            m_layoutVersion = 0;
+    };
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "ecsCommon.h"
 #include "component.h"
+#include "archetypeStorage.h"
 #include <unordered_map>
 
 namespace ECS {
@@ -17,7 +18,7 @@ namespace ECS {
     {
         static const size_t INVALID_COMPONENT_ID = MAX_ENTITIES;//std::numeric_limits<size_t>::max();
     public:
-        COMPONENT_CONTAINER() : m_curSize(0) 
+        COMPONENT_CONTAINER() : m_curSize(0), m_layoutVersion(0)
         {
             m_entityToIndexMap.fill(INVALID_COMPONENT_ID);
             m_indexToEntityMap.fill(INVALID_ENTITY_ID);
@@ -71,6 +72,7 @@ namespace ECS {
             m_componentArray[removedComponentId] = m_componentArray[lastElementId];
             m_entityToIndexMap[entityOflastElement] = removedComponentId;
             m_indexToEntityMap[removedComponentId] = entityOflastElement;
+            m_layoutVersion++;
         }
 
         T* GetData(ENTITY_TYPE entity) {
@@ -79,9 +81,27 @@ namespace ECS {
             return componentId == INVALID_COMPONENT_ID ? nullptr : &m_componentArray[componentId];
         }
 
-        auto GetDataRange() const {
-            std::pair<std::array<T>::iterator, std::array<T>::iterator> p(m_componentArray.begin(), m_componentArray.at(m_curSize));
-            return p;
+        bool HasData(ENTITY_TYPE entity) const {
+            ASSERT(entity < MAX_ENTITIES);
+            return m_entityToIndexMap[entity] != INVALID_COMPONENT_ID;
+        }
+
+        size_t GetSize() const {
+            return m_curSize;
+        }
+
+        //changed when component of some entity moves to other place in the array
+        uint32_t GetLayoutVersion() const {
+            return m_layoutVersion;
+        }
+
+        //entities in the same order as their components
+        const ENTITY_TYPE* GetEntities() const {
+            return m_indexToEntityMap.data();
+        }
+
+        std::pair<T*, T*> GetDataRange() {
+            return { m_componentArray.data(), m_componentArray.data() + m_curSize };
         }
 
         void DestroyComponent(ENTITY_TYPE entity) override {
@@ -93,14 +113,20 @@ namespace ECS {
         }
     private:
         size_t                                    m_curSize;
+        uint32_t                                  m_layoutVersion;
         std::array<T, MAX_ENTITIES>               m_componentArray;
         std::array<size_t, MAX_ENTITIES>          m_entityToIndexMap;
         std::array<ENTITY_TYPE, MAX_ENTITIES>     m_indexToEntityMap;
     };
 
+    enum class COMPONENT_STORAGE_MODE {
+        COMPONENT_CONTAINERS, //one dense array per component type
+        ARCHETYPE_CHUNKS,     //entities with the same signature share SoA chunks
+    };
+
     class COMPONENT_MANAGER {
     public:
-        COMPONENT_MANAGER() {}
+        COMPONENT_MANAGER(COMPONENT_STORAGE_MODE storageMode = COMPONENT_STORAGE_MODE::COMPONENT_CONTAINERS) : m_storageMode(storageMode) {}
 
         ~COMPONENT_MANAGER() {
             for (auto& componentContainer : m_componentRegistryList) {
@@ -109,36 +135,86 @@ namespace ECS {
             m_componentRegistryList.clear();
         }
 
+        COMPONENT_STORAGE_MODE GetStorageMode() const {
+            return m_storageMode;
+        }
+
         template<class T>
         void AddComponent(ENTITY_TYPE entity, T& component) {
+            if (m_storageMode == COMPONENT_STORAGE_MODE::ARCHETYPE_CHUNKS) {
+                m_archetypeStorage.InsertData(entity, component);
+                return;
+            }
             GetComponentContainer<T>()->InsertData(entity, component);
         }
 
         template<class T>
         void AddComponent(ENTITY_TYPE entity, T&& component) {
+            if (m_storageMode == COMPONENT_STORAGE_MODE::ARCHETYPE_CHUNKS) {
+                m_archetypeStorage.InsertData(entity, std::move(component));
+                return;
+            }
             GetComponentContainer<T>()->InsertData(entity, std::move(component));
         }
 
         template<class T>
         void RemoveComponent(ENTITY_TYPE entity) {
+            if (m_storageMode == COMPONENT_STORAGE_MODE::ARCHETYPE_CHUNKS) {
+                m_archetypeStorage.RemoveData<T>(entity);
+                return;
+            }
             GetComponentContainer<T>()->RemoveData(entity);
         }
 
+        //components of one type are contiguous only in containers, archetype chunks are walked by ForEachChunk
         template<class T>
-        auto GetComponentContainerDataRange() {
-            GetComponentContainer<T>()->GetDataRange();
+        std::pair<T*, T*> GetComponentContainerDataRange() {
+            if (m_storageMode == COMPONENT_STORAGE_MODE::ARCHETYPE_CHUNKS) {
+                ERROR_MSG("Component data range requires component containers storage mode");
+                return { nullptr, nullptr };
+            }
+            return GetComponentContainer<T>()->GetDataRange();
         }
 
+        //pointer is valid until components move: in containers mode when component of type T is removed from any entity,
+        //in archetype mode when any component is added to or removed from any entity, because rows of its archetype are moved.
+        //GetLayoutVersion<T>() is changed on every such move
         template<class T>
         T* GetComponent(ENTITY_TYPE entity) {
+            if (m_storageMode == COMPONENT_STORAGE_MODE::ARCHETYPE_CHUNKS) {
+                return m_archetypeStorage.GetData<T>(entity);
+            }
             return GetComponentContainer<T>()->GetData(entity);
         }
+        //changed when components of type T move in memory, per type for containers, shared by all types for archetypes
+        template<class T>
+        uint32_t GetLayoutVersion() {
+            if (m_storageMode == COMPONENT_STORAGE_MODE::ARCHETYPE_CHUNKS) {
+                return m_archetypeStorage.GetLayoutVersion();
+            }
+            return GetComponentContainer<T>()->GetLayoutVersion();
+        }
+
+        //reference has the same lifetime as GetComponent pointer
         template<class T>
         const T& GetConstComponent(ENTITY_TYPE entity) const {
-            return GetComponentContainer<T>()->GetData(entity);
+            //container of the type is created on first access, it doesn't change stored components
+            const T* pComponent = const_cast<COMPONENT_MANAGER*>(this)->GetComponent<T>(entity);
+            ASSERT_MSG(pComponent != nullptr, "Entity doesn't have the component");
+            return *pComponent;
+        }
+
+        template<class FUNC>
+        void ForEachChunk(const COMPONENT_SIGNATURE& signature, FUNC&& func) {
+            ASSERT_MSG(m_storageMode == COMPONENT_STORAGE_MODE::ARCHETYPE_CHUNKS, "Chunk iteration requires archetype storage mode");
+            m_archetypeStorage.ForEachChunk(signature, std::forward<FUNC>(func));
         }
 
         void DestroyEntitiesComponents(ENTITY_TYPE entity, const COMPONENT_SIGNATURE& entitySignature) {
+            if (m_storageMode == COMPONENT_STORAGE_MODE::ARCHETYPE_CHUNKS) {
+                m_archetypeStorage.DestroyEntity(entity);
+                return;
+            }
             for (auto& componentContainer: m_componentRegistryList) {
                 if (entitySignature.test(componentContainer.first)) {
                     componentContainer.second->DestroyComponent(entity);
@@ -150,9 +226,6 @@ namespace ECS {
         const char* GetTypeName() const {
             return GetComponentContainer<T>()->GetTypeName();
         }
-    private:
-        COMPONENT_MANAGER(const COMPONENT_MANAGER& cmpMng) = delete;
-        COMPONENT_MANAGER& operator=(const COMPONENT_MANAGER& cmpMng) = delete;
 
         template<class T>
         COMPONENT_CONTAINER<T>* GetComponentContainer() {
@@ -164,7 +237,12 @@ namespace ECS {
             } 
             return static_cast<COMPONENT_CONTAINER<T>*>(componentContainer->second);
         }
+    private:
+        COMPONENT_MANAGER(const COMPONENT_MANAGER& cmpMng) = delete;
+        COMPONENT_MANAGER& operator=(const COMPONENT_MANAGER& cmpMng) = delete;
 
+        COMPONENT_STORAGE_MODE                                     m_storageMode;
         std::unordered_map<COMPONENT_TYPE, I_COMPONENT_CONTAINER*> m_componentRegistryList;
+        ARCHETYPE_STORAGE                                          m_archetypeStorage;
     };
 };
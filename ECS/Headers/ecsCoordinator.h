@@ -5,10 +5,13 @@
 #include "componentManager.h"
 #include "entityManager.h"
 #include "systemManager.h"
+#include "view.h"
 
 namespace ECS {
     class ECS_COORDINATOR {
     public:
+        ECS_COORDINATOR(COMPONENT_STORAGE_MODE storageMode = COMPONENT_STORAGE_MODE::COMPONENT_CONTAINERS) : m_componentMng(storageMode) {}
+
         template<class S>
         S* CreateSystem() {
             return m_systemMng.RegisterSystem<S>();
@@ -32,6 +35,10 @@ namespace ECS {
             m_systemMng.SubscrubeToEventType(pSystem, E::GetTypeId());
         }
 
+        void UpdateSystems(const std::vector<I_SYSTEM*>& systemList) const {
+            m_systemMng.UpdateSystems(systemList);
+        }
+
         void DestroySystem(I_SYSTEM* pSystem) {
             DEBUG_MSG("DestroySystem() is not implemented!");
         }
@@ -75,6 +82,31 @@ namespace ECS {
             return m_componentMng.GetComponentContainerDataRange<C>();
         }
 
+        template<class... C>
+        VIEW<C...> GetView() {
+            return VIEW<C...>(m_componentMng);
+        }
+
+        //orders entities the same way as C components lie in memory, sorts again after storage moved components
+        template<class C>
+        void SortEntitiesByComponent(ENTITY_SET& entitySet) {
+            entitySet.SortByKey([this](ENTITY_TYPE entityId) {
+                return reinterpret_cast<size_t>(m_componentMng.GetComponent<C>(entityId));
+            }, m_componentMng.GetLayoutVersion<C>());
+        }
+
+        //walks archetype chunks which contain all of C components, func(ARCHETYPE_CHUNK&)
+        template<class... C, class FUNC>
+        void ForEachChunk(FUNC&& func) {
+            COMPONENT_SIGNATURE signature;
+            (signature.set(C::GetTypeId()), ...);
+            m_componentMng.ForEachChunk(signature, std::forward<FUNC>(func));
+        }
+
+        COMPONENT_STORAGE_MODE GetStorageMode() const {
+            return m_componentMng.GetStorageMode();
+        }
+
         template<class C>
         void RemoveComponentFromEntity(ENTITY_TYPE entityId) {
             COMPONENT_TYPE componentId = C::GetTypeId();
@@ -0,0 +1,98 @@
+#pragma once
+#include "ecsCommon.h"
+#include "support.h"
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace ECS {
+    //sparse set of entities: O(1) insert/erase/find, iteration goes over packed array
+    class ENTITY_SET
+    {
+        static constexpr ENTITY_TYPE INVALID_DENSE_ID = MAX_ENTITIES;
+    public:
+        using const_iterator = const ENTITY_TYPE*;
+
+        ENTITY_SET() : m_size(0), m_isSorted(true), m_sortedKeyVersion(0) {
+            m_sparseArray.fill(INVALID_DENSE_ID);
+        }
+
+        bool contains(ENTITY_TYPE entity) const {
+            ASSERT(entity < MAX_ENTITIES);
+            return m_sparseArray[entity] != INVALID_DENSE_ID;
+        }
+
+        const_iterator find(ENTITY_TYPE entity) const {
+            return contains(entity) ? &m_denseArray[m_sparseArray[entity]] : end();
+        }
+
+        bool insert(ENTITY_TYPE entity) {
+            if (contains(entity)) {
+                return false;
+            }
+            m_sparseArray[entity] = m_size;
+            m_denseArray[m_size++] = entity;
+            m_isSorted = false;
+            return true;
+        }
+
+        bool erase(ENTITY_TYPE entity) {
+            if (!contains(entity)) {
+                return false;
+            }
+            //put last entity to the place of removed one, keep array packed
+            const ENTITY_TYPE denseId = m_sparseArray[entity];
+            const ENTITY_TYPE lastEntity = m_denseArray[--m_size];
+            m_denseArray[denseId] = lastEntity;
+            m_sparseArray[lastEntity] = denseId;
+            m_sparseArray[entity] = INVALID_DENSE_ID;
+            m_isSorted = m_isSorted && denseId == m_size;
+            return true;
+        }
+
+        void clear() {
+            for (ENTITY_TYPE denseId = 0; denseId < m_size; denseId++) {
+                m_sparseArray[m_denseArray[denseId]] = INVALID_DENSE_ID;
+            }
+            m_size = 0;
+            m_isSorted = true;
+        }
+
+        //reorders packed array by key(entity), does nothing if neither set nor keys were changed since last sort.
+        //keyVersion must change whenever keys can change, e.g. when component storage moves rows
+        template<class KEY_FUNC>
+        void SortByKey(KEY_FUNC&& keyFunc, uint32_t keyVersion) {
+            if (m_isSorted && m_sortedKeyVersion == keyVersion) {
+                return;
+            }
+            std::array<std::pair<size_t, ENTITY_TYPE>, MAX_ENTITIES> sortKeys;
+            for (ENTITY_TYPE denseId = 0; denseId < m_size; denseId++) {
+                sortKeys[denseId] = { static_cast<size_t>(keyFunc(m_denseArray[denseId])), m_denseArray[denseId] };
+            }
+            std::sort(sortKeys.begin(), sortKeys.begin() + m_size);
+            for (ENTITY_TYPE denseId = 0; denseId < m_size; denseId++) {
+                m_denseArray[denseId] = sortKeys[denseId].second;
+                m_sparseArray[m_denseArray[denseId]] = denseId;
+            }
+            m_isSorted = true;
+            m_sortedKeyVersion = keyVersion;
+        }
+
+        const_iterator begin() const { return m_denseArray.data(); }
+        const_iterator end() const { return m_denseArray.data() + m_size; }
+        const ENTITY_TYPE* data() const { return m_denseArray.data(); }
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        ENTITY_TYPE operator[](size_t denseId) const {
+            ASSERT(denseId < m_size);
+            return m_denseArray[denseId];
+        }
+    private:
+        ENTITY_TYPE                            m_size;
+        bool                                   m_isSorted;
+        uint32_t                               m_sortedKeyVersion;
+        std::array<ENTITY_TYPE, MAX_ENTITIES>  m_sparseArray;
+        std::array<ENTITY_TYPE, MAX_ENTITIES>  m_denseArray;
+    };
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ECS {
+    using JOB_FUNC = std::function<void()>;
+
+    class JOB_COUNTER
+    {
+    public:
+        JOB_COUNTER() : m_pendingJobsNum(0) {}
+
+        bool IsDone() const {
+            return m_pendingJobsNum.load(std::memory_order_acquire) == 0;
+        }
+    private:
+        friend class JOB_SYSTEM;
+        std::atomic<uint32_t> m_pendingJobsNum;
+    };
+
+    //every thread owns a job queue: owner pops from the back, idle threads steal from the front of others queues
+    class JOB_SYSTEM
+    {
+    public:
+        JOB_SYSTEM();
+        ~JOB_SYSTEM();
+
+        //workersNum == 0 means one worker per hardware thread except the calling one
+        void Init(uint32_t workersNum = 0);
+        void Term();
+
+        uint32_t GetWorkersNum() const { return static_cast<uint32_t>(m_workerList.size()); }
+
+        void Schedule(JOB_FUNC&& job, JOB_COUNTER* pCounter = nullptr);
+        //for long jobs like file loading: they are taken only by idle workers, never by waiting threads,
+        //so a frame waiting for its own jobs isn't stalled by them
+        void ScheduleBackground(JOB_FUNC&& job, JOB_COUNTER* pCounter = nullptr);
+        //executes queued jobs while counter isn't done, so it's safe to wait from inside of a job
+        void Wait(const JOB_COUNTER& counter);
+
+        //splits [0, count) into batches and calls func(begin, end) for each of them, returns when all batches are done
+        template<class FUNC>
+        void ParallelFor(size_t count, size_t batchSize, FUNC&& func) {
+            if (batchSize == 0) {
+                batchSize = 1;
+            }
+            if (m_workerList.empty() || count <= batchSize) {
+                func(size_t(0), count);
+                return;
+            }
+            JOB_COUNTER counter;
+            for (size_t begin = batchSize; begin < count; begin += batchSize) {
+                const size_t end = std::min(begin + batchSize, count);
+                Schedule([&func, begin, end]() { func(begin, end); }, &counter);
+            }
+            //first batch goes to the calling thread
+            func(size_t(0), batchSize);
+            Wait(counter);
+        }
+    private:
+        struct JOB
+        {
+            JOB_FUNC     func;
+            JOB_COUNTER* pCounter = nullptr;
+        };
+
+        struct JOB_QUEUE
+        {
+            std::mutex      lock;
+            std::deque<JOB> jobList;
+        };
+
+        JOB_SYSTEM(const JOB_SYSTEM& jobSystem) = delete;
+        JOB_SYSTEM& operator=(const JOB_SYSTEM& jobSystem) = delete;
+
+        void WorkerLoop(uint32_t queueId);
+        bool TryExecuteJob(uint32_t queueId, bool isBackgroundAllowed);
+        bool PopJob(uint32_t queueId, JOB& job);
+        bool StealJob(uint32_t queueId, JOB& job);
+        bool PopBackgroundJob(JOB& job);
+        void ExecuteJob(JOB& job);
+        uint32_t GetCurrentQueueId() const;
+
+        std::vector<std::unique_ptr<JOB_QUEUE>> m_queueList;
+        JOB_QUEUE                               m_backgroundQueue;
+        std::vector<std::thread>                m_workerList;
+
+        std::mutex                              m_wakeLock;
+        std::condition_variable                 m_wakeCondition;
+        std::atomic<uint32_t>                   m_queuedJobsNum;
+        std::atomic<bool>                       m_isRunning;
+    };
+
+    extern std::unique_ptr<JOB_SYSTEM> pJobSystem;
+}
@@ -19,5 +19,27 @@ std::string formatString(const char *fmt, ...);
 
 std::vector<char> ReadFile(const std::string& filename);
 
+//read only view of whole file, os reads pages when they are touched first time
+class MAPPED_FILE
+{
+public:
+    MAPPED_FILE() : m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr), m_pData(nullptr), m_dataSize(0) {}
+    ~MAPPED_FILE() { Close(); }
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    const uint8_t* GetData() const { return m_pData; }
+    size_t         GetSize() const { return m_dataSize; }
+private:
+    MAPPED_FILE(const MAPPED_FILE& mappedFile) = delete;
+    MAPPED_FILE& operator=(const MAPPED_FILE& mappedFile) = delete;
+
+    HANDLE         m_file;
+    HANDLE         m_mapping;
+    const uint8_t* m_pData;
+    size_t         m_dataSize;
+};
+
 bool IsAnyMaskState(uint32_t mask, uint32_t state);
 bool IsEachMaskState(uint32_t mask, uint32_t state);
@@ -1,10 +1,20 @@
 #pragma once
+#include <algorithm>
 #include <vector>
-#include <unordered_set>
+#include <unordered_map>
 #include "ecsCommon.h"
+#include "entitySet.h"
 #include "event.h"
+#include "jobSystem.h"
 
 namespace ECS {
+    //access to component of one entity, entity is referenced by variable since it's usually created after systems init
+    struct ENTITY_COMPONENT_ACCESS {
+        COMPONENT_TYPE     componentType;
+        const ENTITY_TYPE* pEntityId;
+        bool               isWrite;
+    };
+
     class I_SYSTEM {
     public:
         virtual const char* GetTypeName() const = 0;
@@ -23,7 +33,13 @@ namespace ECS {
 
         virtual void SendEvent(EVENT_TYPE eventType, std::shared_ptr<I_EVENT>& eventPtr) = 0;
 
-        //virtual void Update() = 0;
+        //component access declared by system, used to decide which systems may update concurrently
+        virtual const COMPONENT_SIGNATURE& GetReadAccessSignature  () const = 0;
+        virtual const COMPONENT_SIGNATURE& GetWriteAccessSignature () const = 0;
+        virtual bool                       IsExclusiveAccess       () const = 0;
+        virtual const std::vector<ENTITY_COMPONENT_ACCESS>& GetEntityAccessList() const = 0;
+
+        virtual void Update() {}
     };
 
     template<class T>
@@ -43,7 +59,7 @@ namespace ECS {
         }
 
         bool IsEntityHandling(ENTITY_TYPE entity) const override {
-            return m_entityList.find(entity) != m_entityList.end();
+            return m_entityList.contains(entity);
         }
         void AddEntity(ENTITY_TYPE entityId) override {
             m_entityList.insert(entityId);
@@ -76,7 +92,71 @@ namespace ECS {
             m_eventList.emplace(eventType, eventPtr);
         }
 
+        const COMPONENT_SIGNATURE& GetReadAccessSignature() const override {
+            return m_readAccessSignature;
+        }
+
+        const COMPONENT_SIGNATURE& GetWriteAccessSignature() const override {
+            return m_writeAccessSignature;
+        }
+
+        bool IsExclusiveAccess() const override {
+            return m_isExclusiveAccess || !m_isAccessDeclared;
+        }
+
+        const std::vector<ENTITY_COMPONENT_ACCESS>& GetEntityAccessList() const override {
+            return m_entityAccessList;
+        }
+
     protected:
+        template<class... C>
+        void DeclareReadAccess() {
+            (m_readAccessSignature.set(C::GetTypeId()), ...);
+            m_isAccessDeclared = true;
+        }
+
+        template<class... C>
+        void DeclareWriteAccess() {
+            (m_writeAccessSignature.set(C::GetTypeId()), ...);
+            m_isAccessDeclared = true;
+        }
+
+        //access to component of one entity doesn't conflict with access to the same component of other entities.
+        //entity id is read when systems are scheduled, so the variable may be set after Init
+        template<class C>
+        void DeclareEntityReadAccess(const ENTITY_TYPE& entityId) {
+            m_entityAccessList.push_back({ C::GetTypeId(), &entityId, false });
+            m_isAccessDeclared = true;
+        }
+
+        template<class C>
+        void DeclareEntityWriteAccess(const ENTITY_TYPE& entityId) {
+            m_entityAccessList.push_back({ C::GetTypeId(), &entityId, true });
+            m_isAccessDeclared = true;
+        }
+
+        //system adds/removes components or entities, or uses main thread only api (glfw, imgui),
+        //such systems are updated alone on the calling thread
+        void DeclareExclusiveAccess() {
+            m_isExclusiveAccess = true;
+            m_isAccessDeclared = true;
+        }
+
+        //calls func(ENTITY_TYPE) for every handled entity, batches are spread over job system workers
+        template<class FUNC>
+        void ParallelForEntities(size_t batchSize, FUNC&& func) {
+            auto processBatch = [this, &func](size_t begin, size_t end) {
+                for (size_t entityId = begin; entityId < end; entityId++) {
+                    func(m_entityList[entityId]);
+                }
+            };
+            if (!pJobSystem) {
+                processBatch(0, m_entityList.size());
+                return;
+            }
+            pJobSystem->ParallelFor(m_entityList.size(), batchSize, processBatch);
+        }
+
         template<class E>
         bool IsEventList() const {
             return  m_eventList.find(E::GetTypeId()) != m_eventList.end();
@@ -95,10 +175,16 @@ namespace ECS {
         static const SYSTEM_TYPE              m_systemTypeId;
 
         COMPONENT_SIGNATURE                   m_componentSignature;
-        std::unordered_set<ENTITY_TYPE>       m_entityList;
+        ENTITY_SET                            m_entityList;
 
         EVENT_SIGNATURE                                               m_eventSignature;
         std::unordered_multimap<EVENT_TYPE, std::shared_ptr<I_EVENT>> m_eventList;
+
+        COMPONENT_SIGNATURE                   m_readAccessSignature;
+        COMPONENT_SIGNATURE                   m_writeAccessSignature;
+        std::vector<ENTITY_COMPONENT_ACCESS>  m_entityAccessList;
+        bool                                  m_isExclusiveAccess = false;
+        bool                                  m_isAccessDeclared = false;
     };
 
     template<class T>
@@ -172,6 +258,40 @@ namespace ECS {
         }
 
 
+        //updates systems in waves: system goes to the wave after the last preceding system it conflicts with,
+        //systems inside one wave run concurrently on job system
+        void UpdateSystems(const std::vector<I_SYSTEM*>& systemList) const {
+            std::vector<std::vector<I_SYSTEM*>> waveList;
+            std::vector<size_t> systemWave(systemList.size(), 0);
+            for (size_t systemId = 0; systemId < systemList.size(); systemId++) {
+                for (size_t prevSystemId = 0; prevSystemId < systemId; prevSystemId++) {
+                    if (IsAccessConflict(systemList[systemId], systemList[prevSystemId])) {
+                        systemWave[systemId] = std::max(systemWave[systemId], systemWave[prevSystemId] + 1);
+                    }
+                }
+                if (systemWave[systemId] >= waveList.size()) {
+                    waveList.resize(systemWave[systemId] + 1);
+                }
+                waveList[systemWave[systemId]].push_back(systemList[systemId]);
+            }
+
+            for (const std::vector<I_SYSTEM*>& wave : waveList) {
+                if (!pJobSystem || wave.size() == 1) {
+                    for (I_SYSTEM* pSystem : wave) {
+                        pSystem->Update();
+                    }
+                    continue;
+                }
+                JOB_COUNTER waveCounter;
+                for (size_t systemId = 1; systemId < wave.size(); systemId++) {
+                    I_SYSTEM* pSystem = wave[systemId];
+                    pJobSystem->Schedule([pSystem]() { pSystem->Update(); }, &waveCounter);
+                }
+                wave[0]->Update();
+                pJobSystem->Wait(waveCounter);
+            }
+        }
+
         void UpdateEntityHandlingForSystem(I_SYSTEM* pSystem, ENTITY_TYPE entityId, const COMPONENT_SIGNATURE& entitySignature) const {
             const COMPONENT_SIGNATURE& sysSignature = pSystem->GetComponentsSignature();
             bool isEntityShouldHandled = (sysSignature & entitySignature) == sysSignature;
@@ -182,6 +302,35 @@ namespace ECS {
             }
         }
     private:
+        static bool IsAccessConflict(const I_SYSTEM* pSystem0, const I_SYSTEM* pSystem1) {
+            if (pSystem0->IsExclusiveAccess() || pSystem1->IsExclusiveAccess()) {
+                return true;
+            }
+            const COMPONENT_SIGNATURE access0 = pSystem0->GetReadAccessSignature() | pSystem0->GetWriteAccessSignature();
+            const COMPONENT_SIGNATURE access1 = pSystem1->GetReadAccessSignature() | pSystem1->GetWriteAccessSignature();
+            if ((pSystem0->GetWriteAccessSignature() & access1).any() || (pSystem1->GetWriteAccessSignature() & access0).any()) {
+                return true;
+            }
+            return IsEntityAccessConflict(pSystem0, pSystem1) || IsEntityAccessConflict(pSystem1, pSystem0);
+        }
+
+        static bool IsEntityAccessConflict(const I_SYSTEM* pSystem0, const I_SYSTEM* pSystem1) {
+            const COMPONENT_SIGNATURE access1 = pSystem1->GetReadAccessSignature() | pSystem1->GetWriteAccessSignature();
+            for (const ENTITY_COMPONENT_ACCESS& entityAccess0 : pSystem0->GetEntityAccessList()) {
+                const COMPONENT_SIGNATURE& conflictAccess1 = entityAccess0.isWrite ? access1 : pSystem1->GetWriteAccessSignature();
+                if (conflictAccess1.test(entityAccess0.componentType)) {
+                    return true;
+                }
+                for (const ENTITY_COMPONENT_ACCESS& entityAccess1 : pSystem1->GetEntityAccessList()) {
+                    if (entityAccess0.componentType == entityAccess1.componentType && *entityAccess0.pEntityId == *entityAccess1.pEntityId &&
+                        (entityAccess0.isWrite || entityAccess1.isWrite)) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
         std::unordered_map<SYSTEM_TYPE, I_SYSTEM*>     m_systemRegistryList;
         std::unordered_multimap<EVENT_TYPE, I_SYSTEM*> m_subscrubesTable;
     };
@@ -0,0 +1,141 @@
+#pragma once
+#include "componentManager.h"
+#include <tuple>
+#include <vector>
+
+namespace ECS {
+    //iterates entities which have all of C components, components containers are resolved once on creation
+    //usage: for (auto [entity, transform, rotation] : pEcsCoordinator->GetView<TRANSFORM_COMPONENT, ROTATE_COMPONENT>())
+    template<class... C>
+    class VIEW
+    {
+        static_assert(sizeof...(C) > 0, "View requires at least one component type");
+    public:
+        using VALUE_TYPE = std::tuple<ENTITY_TYPE, C&...>;
+
+        class ITERATOR
+        {
+        public:
+            ITERATOR(VIEW* pView, size_t position) : m_pView(pView), m_position(position), m_rowId(0) {
+                if (m_pView->m_isArchetypeMode) {
+                    SelectChunk();
+                } else {
+                    SkipIncompleteEntities();
+                }
+            }
+
+            VALUE_TYPE operator*() const {
+                if (m_pView->m_isArchetypeMode) {
+                    return VALUE_TYPE(m_pChunkEntities[m_rowId], std::get<C*>(m_chunkColumns)[m_rowId]...);
+                }
+                const ENTITY_TYPE entity = m_pView->m_pEntities[m_position];
+                return VALUE_TYPE(entity, *std::get<COMPONENT_CONTAINER<C>*>(m_pView->m_containers)->GetData(entity)...);
+            }
+
+            ITERATOR& operator++() {
+                if (m_pView->m_isArchetypeMode) {
+                    if (++m_rowId == m_chunkSize) {
+                        m_position++;
+                        m_rowId = 0;
+                        SelectChunk();
+                    }
+                } else {
+                    m_position++;
+                    SkipIncompleteEntities();
+                }
+                return *this;
+            }
+
+            bool operator==(const ITERATOR& iter) const {
+                return m_position == iter.m_position && m_rowId == iter.m_rowId;
+            }
+            bool operator!=(const ITERATOR& iter) const {
+                return !(*this == iter);
+            }
+        private:
+            void SkipIncompleteEntities() {
+                while (m_position < m_pView->m_entitiesNum && !m_pView->IsEntityComplete(m_pView->m_pEntities[m_position])) {
+                    m_position++;
+                }
+            }
+
+            void SelectChunk() {
+                if (m_position >= m_pView->m_chunkList.size()) {
+                    return;
+                }
+                ARCHETYPE_CHUNK* pChunk = m_pView->m_chunkList[m_position];
+                m_chunkSize = pChunk->GetSize();
+                m_pChunkEntities = pChunk->GetEntities();
+                m_chunkColumns = std::tuple<C*...>(pChunk->GetColumn<C>()...);
+            }
+
+            VIEW*              m_pView;
+            size_t             m_position;
+            uint32_t           m_rowId;
+            uint32_t           m_chunkSize = 0;
+            const ENTITY_TYPE* m_pChunkEntities = nullptr;
+            std::tuple<C*...>  m_chunkColumns;
+        };
+
+        VIEW(COMPONENT_MANAGER& componentMng)
+            : m_isArchetypeMode(componentMng.GetStorageMode() == COMPONENT_STORAGE_MODE::ARCHETYPE_CHUNKS),
+              m_pEntities(nullptr), m_entitiesNum(0)
+        {
+            if (m_isArchetypeMode) {
+                COMPONENT_SIGNATURE signature;
+                (signature.set(C::GetTypeId()), ...);
+                componentMng.ForEachChunk(signature, [this](ARCHETYPE_CHUNK& chunk) {
+                    m_chunkList.push_back(&chunk);
+                });
+                return;
+            }
+
+            m_containers = std::tuple<COMPONENT_CONTAINER<C>*...>(componentMng.GetComponentContainer<C>()...);
+            //walk entities of the smallest container, others are only probed
+            m_entitiesNum = MAX_ENTITIES;
+            (SelectSmallestContainer(std::get<COMPONENT_CONTAINER<C>*>(m_containers)), ...);
+        }
+
+        ITERATOR begin() { return ITERATOR(this, 0); }
+        ITERATOR end() { return ITERATOR(this, m_isArchetypeMode ? m_chunkList.size() : m_entitiesNum); }
+
+        //calls func(ENTITY_TYPE, C&...) for each entity, cheaper than iterators for archetype storage
+        template<class FUNC>
+        void Each(FUNC&& func) {
+            if (m_isArchetypeMode) {
+                for (ARCHETYPE_CHUNK* pChunk : m_chunkList) {
+                    const ENTITY_TYPE* pEntities = pChunk->GetEntities();
+                    std::tuple<C*...> columns(pChunk->GetColumn<C>()...);
+                    for (uint32_t rowId = 0; rowId < pChunk->GetSize(); rowId++) {
+                        func(pEntities[rowId], std::get<C*>(columns)[rowId]...);
+                    }
+                }
+                return;
+            }
+            for (size_t entityId = 0; entityId < m_entitiesNum; entityId++) {
+                const ENTITY_TYPE entity = m_pEntities[entityId];
+                if (IsEntityComplete(entity)) {
+                    func(entity, *std::get<COMPONENT_CONTAINER<C>*>(m_containers)->GetData(entity)...);
+                }
+            }
+        }
+    private:
+        template<class T>
+        void SelectSmallestContainer(COMPONENT_CONTAINER<T>* pContainer) {
+            if (pContainer->GetSize() < m_entitiesNum) {
+                m_entitiesNum = pContainer->GetSize();
+                m_pEntities = pContainer->GetEntities();
+            }
+        }
+
+        bool IsEntityComplete(ENTITY_TYPE entity) const {
+            return (std::get<COMPONENT_CONTAINER<C>*>(m_containers)->HasData(entity) && ...);
+        }
+
+        bool                                   m_isArchetypeMode;
+        std::tuple<COMPONENT_CONTAINER<C>*...> m_containers;
+        const ENTITY_TYPE*                     m_pEntities;
+        size_t                                 m_entitiesNum;
+        std::vector<ARCHETYPE_CHUNK*>          m_chunkList;
+    };
+}
@@ -0,0 +1,190 @@
+#include "jobSystem.h"
+#include "support.h"
+
+namespace ECS {
+    std::unique_ptr<JOB_SYSTEM> pJobSystem;
+
+    //queue 0 belongs to the thread which called Init(), workers use 1..N
+    static thread_local uint32_t currentQueueId = 0;
+
+    JOB_SYSTEM::JOB_SYSTEM() : m_queuedJobsNum(0), m_isRunning(false)
+    {
+    }
+
+    JOB_SYSTEM::~JOB_SYSTEM()
+    {
+        Term();
+    }
+
+    void JOB_SYSTEM::Init(uint32_t workersNum)
+    {
+        ASSERT(!m_isRunning);
+        if (workersNum == 0) {
+            const uint32_t hardwareThreadsNum = std::thread::hardware_concurrency();
+            workersNum = hardwareThreadsNum > 1 ? hardwareThreadsNum - 1 : 0;
+        }
+
+        m_isRunning = true;
+        for (uint32_t queueId = 0; queueId <= workersNum; queueId++) {
+            m_queueList.emplace_back(new JOB_QUEUE);
+        }
+        for (uint32_t workerId = 0; workerId < workersNum; workerId++) {
+            m_workerList.emplace_back(&JOB_SYSTEM::WorkerLoop, this, workerId + 1);
+        }
+        DEBUG_MSG(formatString("Job system started with %u workers\n", workersNum).c_str());
+    }
+
+    void JOB_SYSTEM::Term()
+    {
+        if (!m_isRunning) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> wakeLock(m_wakeLock);
+            m_isRunning = false;
+        }
+        m_wakeCondition.notify_all();
+        for (std::thread& worker : m_workerList) {
+            worker.join();
+        }
+        m_workerList.clear();
+        m_queueList.clear();
+        m_backgroundQueue.jobList.clear();
+    }
+
+    void JOB_SYSTEM::Schedule(JOB_FUNC&& job, JOB_COUNTER* pCounter)
+    {
+        if (pCounter) {
+            pCounter->m_pendingJobsNum.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (m_workerList.empty()) {
+            job();
+            if (pCounter) {
+                pCounter->m_pendingJobsNum.fetch_sub(1, std::memory_order_release);
+            }
+            return;
+        }
+
+        //job is counted before it's visible, otherwise a worker can execute it and decrement the counter first
+        {
+            std::lock_guard<std::mutex> wakeLock(m_wakeLock);
+            m_queuedJobsNum++;
+        }
+        JOB_QUEUE& queue = *m_queueList[GetCurrentQueueId()];
+        {
+            std::lock_guard<std::mutex> queueLock(queue.lock);
+            queue.jobList.push_back({ std::move(job), pCounter });
+        }
+        m_wakeCondition.notify_one();
+    }
+
+    void JOB_SYSTEM::ScheduleBackground(JOB_FUNC&& job, JOB_COUNTER* pCounter)
+    {
+        if (m_workerList.empty()) {
+            Schedule(std::move(job), pCounter);
+            return;
+        }
+        if (pCounter) {
+            pCounter->m_pendingJobsNum.fetch_add(1, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard<std::mutex> wakeLock(m_wakeLock);
+            m_queuedJobsNum++;
+        }
+        {
+            std::lock_guard<std::mutex> queueLock(m_backgroundQueue.lock);
+            m_backgroundQueue.jobList.push_back({ std::move(job), pCounter });
+        }
+        m_wakeCondition.notify_one();
+    }
+
+    void JOB_SYSTEM::Wait(const JOB_COUNTER& counter)
+    {
+        const uint32_t queueId = GetCurrentQueueId();
+        while (!counter.IsDone()) {
+            if (!TryExecuteJob(queueId, false)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JOB_SYSTEM::WorkerLoop(uint32_t queueId)
+    {
+        currentQueueId = queueId;
+        while (true) {
+            if (TryExecuteJob(queueId, true)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> wakeLock(m_wakeLock);
+            m_wakeCondition.wait(wakeLock, [this]() { return m_queuedJobsNum > 0 || !m_isRunning; });
+            if (!m_isRunning) {
+                return;
+            }
+        }
+    }
+
+    bool JOB_SYSTEM::TryExecuteJob(uint32_t queueId, bool isBackgroundAllowed)
+    {
+        //frame jobs go first, background ones only when there is nothing else to do
+        JOB job;
+        if (!PopJob(queueId, job) && !StealJob(queueId, job) && !(isBackgroundAllowed && PopBackgroundJob(job))) {
+            return false;
+        }
+        ExecuteJob(job);
+        return true;
+    }
+
+    void JOB_SYSTEM::ExecuteJob(JOB& job)
+    {
+        m_queuedJobsNum--;
+        job.func();
+        if (job.pCounter) {
+            job.pCounter->m_pendingJobsNum.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    bool JOB_SYSTEM::PopJob(uint32_t queueId, JOB& job)
+    {
+        JOB_QUEUE& queue = *m_queueList[queueId];
+        std::lock_guard<std::mutex> queueLock(queue.lock);
+        if (queue.jobList.empty()) {
+            return false;
+        }
+        job = std::move(queue.jobList.back());
+        queue.jobList.pop_back();
+        return true;
+    }
+
+    bool JOB_SYSTEM::StealJob(uint32_t queueId, JOB& job)
+    {
+        const uint32_t queuesNum = static_cast<uint32_t>(m_queueList.size());
+        for (uint32_t shift = 1; shift < queuesNum; shift++) {
+            JOB_QUEUE& victimQueue = *m_queueList[(queueId + shift) % queuesNum];
+            std::lock_guard<std::mutex> queueLock(victimQueue.lock);
+            if (victimQueue.jobList.empty()) {
+                continue;
+            }
+            job = std::move(victimQueue.jobList.front());
+            victimQueue.jobList.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool JOB_SYSTEM::PopBackgroundJob(JOB& job)
+    {
+        std::lock_guard<std::mutex> queueLock(m_backgroundQueue.lock);
+        if (m_backgroundQueue.jobList.empty()) {
+            return false;
+        }
+        job = std::move(m_backgroundQueue.jobList.front());
+        m_backgroundQueue.jobList.pop_front();
+        return true;
+    }
+
+    uint32_t JOB_SYSTEM::GetCurrentQueueId() const
+    {
+        //threads which aren't owned by job system share the queue of the main thread
+        return currentQueueId < m_queueList.size() ? currentQueueId : 0;
+    }
+}
@@ -45,6 +45,52 @@ std::vector<char> ReadFile(const std::string & filename)
     return buffer;
 }
 
+bool MAPPED_FILE::Open(const std::string& filename)
+{
+    Close();
+    m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    //empty files can't be mapped
+    if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0) {
+        Close();
+        return false;
+    }
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping == nullptr) {
+        WARNING_MSG(formatString("Cannot map file %s!", filename.c_str()).c_str());
+        Close();
+        return false;
+    }
+    m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_pData == nullptr) {
+        WARNING_MSG(formatString("Cannot map file %s!", filename.c_str()).c_str());
+        Close();
+        return false;
+    }
+    m_dataSize = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MAPPED_FILE::Close()
+{
+    if (m_pData) {
+        UnmapViewOfFile(m_pData);
+        m_pData = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+    m_dataSize = 0;
+}
+
 bool IsAnyMaskState(uint32_t mask, uint32_t state)
 {
     return (mask & state) || !state;
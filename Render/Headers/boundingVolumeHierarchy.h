@@ -0,0 +1,143 @@
+#pragma once
+#include <array>
+#include <cfloat>
+#include <vector>
+#include <xmmintrin.h>
+#include <glm/glm.hpp>
+
+struct AABB
+{
+    glm::vec3 minPos = glm::vec3(FLT_MAX);
+    glm::vec3 maxPos = glm::vec3(-FLT_MAX);
+
+    void Extend(const AABB& aabb) {
+        minPos = glm::min(minPos, aabb.minPos);
+        maxPos = glm::max(maxPos, aabb.maxPos);
+    }
+    glm::vec3 GetCenter() const { return (maxPos + minPos) * 0.5f; }
+    glm::vec3 GetExtent() const { return (maxPos - minPos) * 0.5f; }
+    float     GetSurfaceArea() const {
+        const glm::vec3 size = glm::max(maxPos - minPos, glm::vec3(0.f));
+        return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+};
+
+struct FRUSTUM
+{
+    static constexpr uint32_t PLANES_NUM = 6;
+
+    //planes point inside, they are taken from clip space bounds -w <= x,y <= w, 0 <= z <= w
+    explicit FRUSTUM(const glm::mat4x4& viewProj);
+
+    //conservative, boxes near frustum corners may be reported as intersected
+    bool IsIntersected(const AABB& aabb) const;
+
+    std::array<glm::vec4, PLANES_NUM> planes;
+};
+
+//bounding volume hierarchy over item bounds, built with binned SAH
+//nodes are stored depth first: left child follows its parent, so the tree is one array without pointers
+class BOUNDING_VOLUME_HIERARCHY
+{
+public:
+    static constexpr uint32_t LEAF_SIZE = 4;
+    static constexpr uint32_t INVALID_ID = UINT32_MAX;
+
+    void Build(const std::vector<AABB>& itemBoundsList);
+    void Clear();
+
+    //calls func(itemId) for every item which intersects the frustum
+    template<class FUNC>
+    void QueryFrustum(const FRUSTUM& frustum, FUNC&& func) const;
+    //finds the closest item which bounds are hit by the ray, direction doesn't need to be normalized
+    bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t& hitItemId, float& hitDistance) const;
+
+    bool     IsEmpty() const { return m_nodeList.empty(); }
+    uint32_t GetItemsNum() const { return static_cast<uint32_t>(m_itemBoundsList.size()); }
+private:
+    struct NODE
+    {
+        AABB     bounds;
+        //inner node: right child id, leaf: id of its bounds packet
+        uint32_t rightChildOrPacketId;
+        uint32_t itemsNum;
+
+        bool IsLeaf() const { return itemsNum != 0; }
+    };
+
+    //bounds of leaf items in SoA layout, so they are tested against a plane with a few sse instructions
+    struct BOUNDS_PACKET
+    {
+        __m128 centerX;
+        __m128 centerY;
+        __m128 centerZ;
+        __m128 extentX;
+        __m128 extentY;
+        __m128 extentZ;
+    };
+
+    uint32_t BuildNode(uint32_t begin, uint32_t end);
+    bool     FindSplit(uint32_t begin, uint32_t end, const AABB& centerBounds, int& splitAxis, float& splitPos) const;
+    void     UpdateLeafPacket(uint32_t nodeId);
+    //returns mask of lanes inside planes from planeMask
+    int      TestPacket(const BOUNDS_PACKET& packet, const FRUSTUM& frustum, uint32_t planeMask) const;
+
+    std::vector<NODE>          m_nodeList;
+    std::vector<BOUNDS_PACKET> m_packetList;
+    //item ids of leaves, each leaf takes LEAF_SIZE slots, unused ones are INVALID_ID
+    std::vector<uint32_t>      m_leafItemList;
+    std::vector<AABB>          m_itemBoundsList;
+    //used only while building
+    std::vector<uint32_t>      m_buildItemList;
+};
+
+template<class FUNC>
+void BOUNDING_VOLUME_HIERARCHY::QueryFrustum(const FRUSTUM& frustum, FUNC&& func) const
+{
+    if (m_nodeList.empty()) {
+        return;
+    }
+    const uint32_t ALL_PLANES_MASK = (1 << FRUSTUM::PLANES_NUM) - 1;
+
+    //plane mask keeps planes which intersect the parent, planes the parent is inside of aren't tested again
+    std::vector<std::pair<uint32_t, uint32_t>> nodeStack;
+    nodeStack.emplace_back(0, ALL_PLANES_MASK);
+    while (!nodeStack.empty()) {
+        const uint32_t nodeId = nodeStack.back().first;
+        uint32_t planeMask = nodeStack.back().second;
+        nodeStack.pop_back();
+
+        const NODE& node = m_nodeList[nodeId];
+        const glm::vec3 center = node.bounds.GetCenter();
+        const glm::vec3 extent = node.bounds.GetExtent();
+        bool isOutside = false;
+        for (uint32_t planeId = 0; planeId < FRUSTUM::PLANES_NUM && !isOutside; planeId++) {
+            if ((planeMask & (1 << planeId)) == 0) {
+                continue;
+            }
+            const glm::vec4& plane = frustum.planes[planeId];
+            const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+            const float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+            isOutside = distance + radius < 0.f;
+            if (distance - radius >= 0.f) {
+                planeMask &= ~(1 << planeId);
+            }
+        }
+        if (isOutside) {
+            continue;
+        }
+
+        if (!node.IsLeaf()) {
+            nodeStack.emplace_back(node.rightChildOrPacketId, planeMask);
+            nodeStack.emplace_back(nodeId + 1, planeMask);
+            continue;
+        }
+        const int insideMask = planeMask ? TestPacket(m_packetList[node.rightChildOrPacketId], frustum, planeMask) : (1 << LEAF_SIZE) - 1;
+        const uint32_t firstSlot = node.rightChildOrPacketId * LEAF_SIZE;
+        for (uint32_t lane = 0; lane < node.itemsNum; lane++) {
+            if (insideMask & (1 << lane)) {
+                func(m_leafItemList[firstSlot + lane]);
+            }
+        }
+    }
+}
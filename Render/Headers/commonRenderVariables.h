@@ -11,11 +11,20 @@ extern ECS::ENTITY_TYPE gameCamera;
 extern std::vector<ECS::ENTITY_TYPE> pointLights;
 extern ECS::ENTITY_TYPE directionalLight;
 
+//reduced resolutions run on downsampled depth and normal, result is blurred and upsampled with depth awareness
+enum SSAO_RESOLUTION {
+    SSAO_RESOLUTION_FULL,
+    SSAO_RESOLUTION_HALF,
+    SSAO_RESOLUTION_QUARTER,
+    SSAO_RESOLUTION_LAST
+};
+
 //todo: make it right
 struct SSAO_VARIABLES {
     bool  turnOffSSAO = false;
     float radius = 8.f;
     float bias = 0.1f;
+    int   resolution = SSAO_RESOLUTION_HALF;
 };
 
 struct DEBUG_VARIABLES {
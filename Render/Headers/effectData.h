@@ -15,13 +15,24 @@ namespace EFFECT_DATA {
         SHR_SSAO_BLEND = 5,
         SHR_TERRAIN = 6,
         SHR_UI = 7,
+        SHR_FILL_GBUFFER_BINDLESS = 8,
+        SHR_FILL_GBUFFER_INDIRECT = 9,
+        SHR_SHADOW_INDIRECT = 10,
+        SHR_GPU_CULLING = 11,
+        SHR_HI_Z_BUILD = 12,
+        SHR_LIGHT_CLUSTERING = 13,
+        SHR_SSAO_DEPTH_NORMAL = 14,
+        SHR_SSAO_LOW_RES = 15,
+        SHR_SSAO_BILATERAL_BLUR = 16,
+        SHR_SSAO_UPSAMPLE = 17,
         SHR_LAST
     };
 
     enum SHADER_TYPE {
         VERTEX = 0,
         PIXEL = 1,
-        LAST = 2
+        COMPUTE = 2,
+        LAST = 3
     };
 }
 
@@ -50,9 +61,15 @@ namespace EFFECT_DATA
         CB_UI,
         CB_CUSTOM,
         CB_DEBUG,
+        CB_CULLING,
+        CB_LIGHT_CLUSTERS,
         CB_LAST
     };
 
+    //directional light shadow map is an atlas of cascades, must match common.fx
+    static const uint32_t SHADOW_CASCADES_NUM = 4;
+    static const uint32_t SHADOW_ATLAS_COLUMNS = 2;
+
     struct CB_COMMON_DATA_STRUCT {
         alignas(16) glm::vec3 vViewPos;
         float                 fTime;
@@ -60,20 +77,21 @@ namespace EFFECT_DATA
         alignas(16) glm::mat4 mProj;
         alignas(16) glm::mat4 mProjInv;
         alignas(16) glm::mat4 mView;
+        alignas(16) glm::mat4 mViewInv;
     };
 
+    //point and spot lights are taken from LIGHT_CLUSTERING_SYSTEM buffers
     struct CB_LIGHTS_STRUCT {
         TRANSFORM_COMPONENT         dirLightTransform;
         DIRECTIONAL_LIGHT_COMPONENT dirLight;
 
-        alignas(16) TRANSFORM_COMPONENT pointLight0Transform;
-        POINT_LIGHT_COMPONENT           pointLight0;
-        
-        glm::mat4x4 dirLightViewProj;
-        glm::mat4x4 pointLight0ViewProj;
+        alignas(16) glm::mat4x4 dirLightCascadeViewProj[SHADOW_CASCADES_NUM];
 
         glm::vec3 ambientColor;
+        //view space depth of far bound of each cascade
+        alignas(16) glm::vec4 dirLightCascadeSplits;
     };
+    static_assert(SHADOW_CASCADES_NUM == 4, "dirLightCascadeSplits stores one split per vector component");
 
     struct CB_TERRAIN_STRUCT {
         glm::vec2 terrainStartPos;
@@ -101,6 +119,27 @@ namespace EFFECT_DATA
         int drawMode;
     };
 
+    struct CB_CULLING_STRUCT {
+        glm::vec4   frustumPlanes[6];
+        //view projection the depth pyramid was built with
+        glm::mat4x4 hiZViewProj;
+        //size of depth buffer the pyramid was built from
+        glm::vec2   hiZSize;
+        uint32_t    instancesNum;
+        uint32_t    flags;
+    };
+
+    struct CB_LIGHT_CLUSTERS_STRUCT {
+        glm::mat4x4 view;
+        glm::mat4x4 projInv;
+        glm::uvec3  clustersNum;
+        uint32_t    lightsNum;
+        //depth slice of view depth z is log(z) * scale + bias
+        glm::vec2   sliceScaleBias;
+        float       nearPlane;
+        float       farPlane;
+    };
+
     const uint32_t CONST_BUFFERS_SIZE[] =
     {
         sizeof(CB_COMMON_DATA_STRUCT),
@@ -110,6 +149,17 @@ namespace EFFECT_DATA
         sizeof(CB_UI_STRUCT),
         sizeof(CB_CUSTOM_STRUCT),
         sizeof(CB_DEBUG_STRUCT),
+        sizeof(CB_CULLING_STRUCT),
+        sizeof(CB_LIGHT_CLUSTERS_STRUCT),
+    };
+
+    //textures of material in global bindless array start from materialId * BINDLESS_MATERIAL_TEXTURES_NUM
+    enum BINDLESS_MATERIAL_TEXTURES
+    {
+        BINDLESS_ALBEDO = 0,
+        BINDLESS_NORMAL = 1,
+        BINDLESS_METAL_ROUGHNESS = 2,
+        BINDLESS_MATERIAL_TEXTURES_NUM
     };
 
     const unsigned int CONST_BUFFERS_SLOT[] =
@@ -121,5 +171,7 @@ namespace EFFECT_DATA
         6,
         4,
         15,
+        7,
+        8,
     };
 }
@@ -16,6 +16,9 @@ public:
 
         ECS::pEcsCoordinator->SubscrubeSystemToEventType<KEY_STATE_EVENT>(this);
         ECS::pEcsCoordinator->SubscrubeSystemToEventType<MOUSE_STATE_EVENT>(this);
+
+        DeclareReadAccess<INPUT_CONTROLLED>();
+        DeclareWriteAccess<TRANSFORM_COMPONENT, ROTATE_COMPONENT, CAMERA_COMPONENT>();
     }
 
     void Update() {
@@ -23,14 +26,13 @@ public:
             return;
         }
 
-        for (auto it = m_entityList.begin(); it != m_entityList.end(); it++) {
+        auto cameraView = ECS::pEcsCoordinator->GetView<TRANSFORM_COMPONENT, ROTATE_COMPONENT, CAMERA_COMPONENT, INPUT_CONTROLLED>();
+        for (auto [cameraEntity, cameraPos, cameraRotation, camera, inputControlled] : cameraView) {
             bool isCameraMoved = false;
-            TRANSFORM_COMPONENT* cameraPos = ECS::pEcsCoordinator->GetComponent<TRANSFORM_COMPONENT>(*it);
-            ROTATE_COMPONENT* cameraRotation = ECS::pEcsCoordinator->GetComponent<ROTATE_COMPONENT>(*it);
 
             auto kse = GetEventList<KEY_STATE_EVENT>();
             for (auto event = kse.first; event != kse.second; event++) {
-                const glm::vec3 dirLookAt = cameraRotation->quaternion * glm::vec3(1.f, 0.f, 0.f);
+                const glm::vec3 dirLookAt = cameraRotation.quaternion * glm::vec3(1.f, 0.f, 0.f);
                 const KEY_STATE_EVENT* keyboardEvent = static_cast<const KEY_STATE_EVENT*>(event->second.get());
                 const KEY_STATE* keyInput = keyboardEvent->keyState;
                 if (keyInput->isButtonPressed.test(GLFW_KEY_W) ||
@@ -52,16 +54,16 @@ public:
                 }
 
                 if (keyInput->isButtonPressed.test(GLFW_KEY_W)) {
-                    cameraPos->position += cameraMovementSpeed * dirLookAt;
+                    cameraPos.position += cameraMovementSpeed * dirLookAt;
                 }
                 if (keyInput->isButtonPressed.test(GLFW_KEY_S)) {
-                    cameraPos->position -= cameraMovementSpeed * dirLookAt;
+                    cameraPos.position -= cameraMovementSpeed * dirLookAt;
                 }
                 if (keyInput->isButtonPressed.test(GLFW_KEY_A)) {
-                    cameraPos->position -= cameraMovementSpeed * sidewayVector;
+                    cameraPos.position -= cameraMovementSpeed * sidewayVector;
                 }
                 if (keyInput->isButtonPressed.test(GLFW_KEY_D)) {
-                    cameraPos->position += cameraMovementSpeed * sidewayVector;
+                    cameraPos.position += cameraMovementSpeed * sidewayVector;
                 }
             }
 
@@ -84,15 +86,14 @@ public:
 
                 glm::quat yawQuater = glm::angleAxis(yaw, UP_VECTOR);
                 glm::quat rollQuater = glm::angleAxis(-roll, glm::vec3(0.f, 0.f, 1.f));
-                cameraRotation->quaternion = yawQuater * rollQuater;
+                cameraRotation.quaternion = yawQuater * rollQuater;
             }
 
 
             if (true) {
-                const glm::vec3 dirLookAt = normalize(cameraRotation->quaternion * glm::vec3(1.f, 0.f, 0.f));
-                CAMERA_COMPONENT* camera = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(*it);
-                camera->viewMatrix = glm::lookAt(cameraPos->position, cameraPos->position + dirLookAt, UP_VECTOR);
-                camera->projMatrix = glm::perspective(camera->fov, camera->aspectRatio, camera->nearPlane, camera->farPlane);
+                const glm::vec3 dirLookAt = normalize(cameraRotation.quaternion * glm::vec3(1.f, 0.f, 0.f));
+                camera.viewMatrix = glm::lookAt(cameraPos.position, cameraPos.position + dirLookAt, UP_VECTOR);
+                camera.projMatrix = glm::perspective(camera.fov, camera.aspectRatio, camera.nearPlane, camera.farPlane);
                 //https://matthewwellings.com/blog/the-new-vulkan-coordinate-system/
                 const glm::mat4 clip(
                     1.0f, 0.0f, 0.0f, 0.0f,
@@ -100,7 +101,7 @@ public:
                     0.0f, 0.0f, 1.0f, 0.f,
                     0.0f, 0.0f, 0.0f, 1.0f
                 );
-                camera->viewProjMatrix = clip * camera->projMatrix * camera->viewMatrix;
+                camera.viewProjMatrix = clip * camera.projMatrix * camera.viewMatrix;
             }
         }
         ClearEventList();
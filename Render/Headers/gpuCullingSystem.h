@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <vector>
+
+#include "ecsCoordinator.h"
+#include "renderGraph.h"
+#include "vulkanDriver.h"
+
+//each view has its own draw list
+enum GPU_CULLING_VIEW {
+    //instances not occluded in depth pyramid of previous frame
+    GPU_VIEW_GAME_CAMERA,
+    //instances occluded in previous frame pyramid, but visible in the pyramid built after GPU_VIEW_GAME_CAMERA is drawn
+    GPU_VIEW_GAME_CAMERA_DISOCCLUDED,
+    //one view for each cascade of directional light shadow map
+    GPU_VIEW_SHADOW_CASCADE_0,
+    GPU_VIEW_SHADOW_CASCADE_LAST = GPU_VIEW_SHADOW_CASCADE_0 + EFFECT_DATA::SHADOW_CASCADES_NUM - 1,
+
+    GPU_VIEW_LAST
+};
+
+//must match INSTANCE_DATA in gpuDrivenCommon.fx
+struct GPU_INSTANCE_DATA
+{
+    glm::mat4x4 modelMatrix;
+    glm::vec3   aabbMin;
+    uint32_t    indexesNum;
+    glm::vec3   aabbMax;
+    uint32_t    firstIndex;
+    uint32_t    vertexOffset;
+    uint32_t    materialId;
+    glm::uvec2  padding;
+};
+
+//gpu driven path for rendered primitives: instances are culled by compute shader which writes indirect draw commands,
+//so a pass records one draw for all primitives instead of draw, descriptors and push constants for each of them
+class GPU_CULLING_SYSTEM : public ECS::SYSTEM<GPU_CULLING_SYSTEM>
+{
+public:
+    bool Init();
+    void Term();
+
+    void AddEntity(ECS::ENTITY_TYPE entityId) override;
+    void RemoveEntity(ECS::ENTITY_TYPE entityId) override;
+
+    //without bindless textures and indirect first instance passes draw entities one by one
+    bool IsEnabled() const { return m_isEnabled; }
+    //must be recorded outside of render pass, before the view is drawn
+    //game camera views are also tested against depth pyramid of RENDER_PASS_HI_Z
+    void CullInstances(GPU_CULLING_VIEW view, const glm::mat4x4& viewProj);
+    //targets read by CullInstances, they must be declared by render graph passes which cull instances
+    void AddCullingResources(std::vector<RENDER_GRAPH_RESOURCE>& resourceList) const;
+    //shader must take instance data by SV_InstanceID from INSTANCE_BUFFER_SLOT
+    void DrawInstances(GPU_CULLING_VIEW view);
+
+    static constexpr uint32_t INSTANCE_BUFFER_SLOT = 40;
+private:
+    static constexpr uint32_t CULLING_GROUP_SIZE = 64;
+    static constexpr uint32_t DRAW_COMMAND_BUFFER_SLOT = 41;
+    static constexpr uint32_t DRAW_COUNT_BUFFER_SLOT = 42;
+    static constexpr uint32_t OCCLUDED_BUFFER_SLOT = 43;
+    static constexpr uint32_t HI_Z_FIRST_SLOT = 50;
+
+    //must match gpuCullingCS.fx
+    enum CULLING_FLAGS {
+        CULLING_FLAG_OCCLUSION = 1 << 0,
+        //store per instance result of occlusion test for disoccluded view
+        CULLING_FLAG_WRITE_OCCLUDED = 1 << 1,
+        //test only instances stored as occluded
+        CULLING_FLAG_ONLY_OCCLUDED = 1 << 2,
+    };
+
+    //buffers of one frame context, gpu doesn't use them after the context is started again
+    struct FRAME_DATA
+    {
+        VULKAN_BUFFER                            instanceBuffer;
+        VULKAN_BUFFER                            occludedBuffer;
+        std::array<VULKAN_BUFFER, GPU_VIEW_LAST> drawCommandBuffer;
+        std::array<VULKAN_BUFFER, GPU_VIEW_LAST> drawCountBuffer;
+        uint32_t                                 instancesCapacity = 0;
+        bool                                     isInstanceBufferDirty = true;
+    };
+
+    void     UpdateInstanceList();
+    void     UpdateFrameData(FRAME_DATA& frameData);
+    VkResult CreateFrameBuffers(FRAME_DATA& frameData, uint32_t instancesCapacity);
+    void     DestroyFrameBuffers(FRAME_DATA& frameData);
+
+    bool                                      m_isEnabled = false;
+    //instances are changed on level loading, so the list is rebuilt instead of updated
+    bool                                      m_isInstanceListDirty = true;
+    std::vector<GPU_INSTANCE_DATA>            m_instanceDataList;
+    std::array<FRAME_DATA, NUM_FRAME_BUFFERS> m_frameDataList;
+};
@@ -3,13 +3,16 @@
 #include "GLFW/glfw3.h"
 #include "vulkanResourcesDescription.h"
 
+class RENDER_GRAPH;
+
 class GUI_SYSTEM : public ECS::SYSTEM<GUI_SYSTEM> {
 public:
     bool Init();
     void Update();
-    void Render();
+    void AddToRenderGraph(RENDER_GRAPH& renderGraph);
     void Term();
 private:
+    void Render();
     void BindGLFWInterface();
     void DescribeInterface();
     void BeginRenderPass();
@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <vector>
+
+#include "ecsCoordinator.h"
+#include "vulkanDriver.h"
+
+class RENDER_GRAPH;
+
+//must match LIGHT_DATA in lightClustersCommon.fx
+struct GPU_LIGHT_DATA
+{
+    glm::vec3 position;
+    float     radius;
+    //color multiplied by intensity
+    glm::vec3 radiance;
+    //cone falloff is saturate(dot(direction, -L) * spotScale + spotOffset), point lights have 0 and 1
+    float     spotScale;
+    glm::vec3 direction;
+    float     spotOffset;
+};
+
+//clustered lighting: camera frustum is split to screen tiles and exponential depth slices, compute shader writes
+//list of point and spot lights for each cluster, so shading loops only over lights which affect pixel cluster
+class LIGHT_CLUSTERING_SYSTEM : public ECS::SYSTEM<LIGHT_CLUSTERING_SYSTEM>
+{
+public:
+    bool Init();
+    void Term();
+
+    //clusters are built by a pass without render targets, it must be added before lights are shaded
+    void AddToRenderGraph(RENDER_GRAPH& renderGraph);
+    //shader must include lightClustersCommon.fx
+    void SetClustersAsSRV();
+
+    static constexpr uint32_t CLUSTERS_X = 16;
+    static constexpr uint32_t CLUSTERS_Y = 9;
+    static constexpr uint32_t CLUSTERS_Z = 24;
+    static constexpr uint32_t CLUSTERS_NUM = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+    //must match lightClustersCommon.fx, lights over it are dropped from the cluster
+    static constexpr uint32_t MAX_CLUSTER_LIGHTS = 128;
+private:
+    static constexpr uint32_t CLUSTERING_GROUP_SIZE = 64;
+    static constexpr uint32_t LIGHT_BUFFER_SLOT = 44;
+    static constexpr uint32_t CLUSTER_LIGHTS_NUM_BUFFER_SLOT = 45;
+    static constexpr uint32_t CLUSTER_LIGHT_LIST_BUFFER_SLOT = 46;
+    static constexpr uint32_t MIN_LIGHTS_CAPACITY = 64;
+
+    //buffers of one frame context, gpu doesn't use them after the context is started again
+    struct FRAME_DATA
+    {
+        //written by cpu each frame
+        VULKAN_BUFFER lightBuffer;
+        VULKAN_BUFFER clusterLightsNumBuffer;
+        VULKAN_BUFFER clusterLightListBuffer;
+        uint32_t      lightsCapacity = 0;
+    };
+
+    void     GatherLights();
+    void     BuildClusters();
+    VkResult CreateLightBuffer(FRAME_DATA& frameData, uint32_t lightsCapacity);
+    VkResult CreateClusterBuffers(FRAME_DATA& frameData);
+    void     DestroyFrameBuffers(FRAME_DATA& frameData);
+
+    std::vector<GPU_LIGHT_DATA>               m_lightDataList;
+    std::array<FRAME_DATA, NUM_FRAME_BUFFERS> m_frameDataList;
+};
@@ -8,7 +8,7 @@ struct VULKAN_TEXTURE;
 struct MATERIAL_COMPONENT : public ECS::COMPONENT<MATERIAL_COMPONENT>
 {
     MATERIAL_COMPONENT() : pAlbedoTex(nullptr), pNormalTex(nullptr), pDisplacementTex(nullptr), pMetalRoughnessTex(nullptr), pEmissiveTex(nullptr),
-    isDoubleSided(false), alphaMode(ALPHA_MODE::ALPHA_OPAQUE), alphaCutFactor(1.f), baseColor(0.f) {}
+    isDoubleSided(false), alphaMode(ALPHA_MODE::ALPHA_OPAQUE), alphaCutFactor(1.f), baseColor(0.f), materialId(0) {}
 
     enum class ALPHA_MODE { ALPHA_OPAQUE, ALPHA_BLEND, ALPHA_MASK };
 
@@ -16,6 +16,8 @@ struct MATERIAL_COMPONENT : public ECS::COMPONENT<MATERIAL_COMPONENT>
     ALPHA_MODE alphaMode;
     float alphaCutFactor;
     glm::fvec4 baseColor;
+    //index of material textures in bindless texture array
+    uint32_t materialId;
 
     const VULKAN_TEXTURE* pAlbedoTex;
     const VULKAN_TEXTURE* pNormalTex;
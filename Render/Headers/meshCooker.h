@@ -0,0 +1,119 @@
+#pragma once
+#include <string>
+
+#include "support.h"
+
+//cooked model package: header, fixed size tables and gpu ready vertex and index data, so loading doesn't parse anything.
+//offsets are from the file start and aligned to MESH_PACKAGE_ALIGNMENT, sections are stored in the enum order
+enum MESH_PACKAGE_SECTION {
+    //files the package is cooked from, it is cooked again when any of them is changed
+    MESH_PACKAGE_SOURCE_FILES,
+    MESH_PACKAGE_IMAGES,
+    MESH_PACKAGE_MATERIALS,
+    MESH_PACKAGE_MESH_HOLDERS,
+    MESH_PACKAGE_PRIMITIVES,
+    //root nodes of the default scene
+    MESH_PACKAGE_NODES,
+    //SIMPLE_VERTEX of all primitives
+    MESH_PACKAGE_VERTEXES,
+    //16 bit, relative to the first vertex of the primitive
+    MESH_PACKAGE_INDEXES,
+    //chars of paths, not null terminated
+    MESH_PACKAGE_STRINGS,
+
+    MESH_PACKAGE_SECTIONS_NUM
+};
+
+static const uint32_t MESH_PACKAGE_MAGIC = 0x48534d55; //UMSH
+static const uint32_t MESH_PACKAGE_ALIGNMENT = 16;
+
+struct MESH_PACKAGE_HEADER
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sectionOffsets[MESH_PACKAGE_SECTIONS_NUM];
+    //number of elements
+    uint32_t sectionSizes[MESH_PACKAGE_SECTIONS_NUM];
+};
+
+struct MESH_PACKAGE_STRING
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct MESH_PACKAGE_SOURCE_FILE
+{
+    MESH_PACKAGE_STRING path;
+    uint64_t            fileSize;
+    int64_t             writeTime;
+};
+
+struct MESH_PACKAGE_IMAGE
+{
+    //relative to the source model directory
+    MESH_PACKAGE_STRING uri;
+    //TEXTURE_COOK_FORMAT
+    uint32_t            cookFormat;
+    //GetTextureSourceHash of the image, cached texture is loaded by it
+    uint64_t            sourceHash;
+};
+
+struct MESH_PACKAGE_MATERIAL
+{
+    glm::vec4 baseColor;
+    float     alphaCutFactor;
+    //MATERIAL_COMPONENT::ALPHA_MODE
+    uint32_t  alphaMode;
+    uint32_t  isDoubleSided;
+    //image ids, -1 means default texture
+    int32_t   albedoImageId;
+    int32_t   metalRoughnessImageId;
+    int32_t   normalImageId;
+    int32_t   emissiveImageId;
+};
+
+struct MESH_PACKAGE_MESH_HOLDER
+{
+    uint32_t firstPrimitive;
+    uint32_t primitivesNum;
+};
+
+struct MESH_PACKAGE_PRIMITIVE
+{
+    uint32_t  firstVertex;
+    uint32_t  vertexesNum;
+    uint32_t  firstIndex;
+    uint32_t  indexesNum;
+    //-1 means default material
+    int32_t   materialId;
+    //scaled like vertex positions
+    glm::vec3 minPos;
+    glm::vec3 maxPos;
+};
+
+struct MESH_PACKAGE_NODE
+{
+    glm::mat4x4 matrix;
+    glm::vec4   rotation;
+    glm::vec3   translation;
+    glm::vec3   scale;
+    //-1 means node without mesh
+    int32_t     meshHolderId;
+};
+
+//checks layout of mapped package, that its tables reference only existing elements and that its sources weren't changed after it was cooked
+bool IsMeshPackageUpToDate(const uint8_t* pPackageData, size_t packageSize);
+
+//parses gltf, converts vertexes and indexes to the formats drawn by the render and writes the package
+bool CookMesh(const std::string& sourcePath, const std::string& destPath);
+
+template<class T>
+const T* GetMeshPackageSection(const uint8_t* pPackageData, MESH_PACKAGE_SECTION section) {
+    const MESH_PACKAGE_HEADER* pHeader = reinterpret_cast<const MESH_PACKAGE_HEADER*>(pPackageData);
+    return reinterpret_cast<const T*>(pPackageData + pHeader->sectionOffsets[section]);
+}
+
+inline std::string GetMeshPackageString(const uint8_t* pPackageData, const MESH_PACKAGE_STRING& string) {
+    return std::string(GetMeshPackageSection<char>(pPackageData, MESH_PACKAGE_STRINGS) + string.offset, string.length);
+}
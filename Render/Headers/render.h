@@ -5,7 +5,6 @@
 class RENDER_SYSTEM : public ECS::SYSTEM<RENDER_SYSTEM> {
 public:
     bool Init();
-    void Update();
     void Render();
     void Term();
 };
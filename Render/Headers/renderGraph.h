@@ -0,0 +1,63 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "renderTargetManager.h"
+
+enum RENDER_GRAPH_ACCESS
+{
+    //sampled by shaders
+    RG_ACCESS_SRV,
+    //storage image written by compute shader
+    RG_ACCESS_UAV,
+    RG_ACCESS_RENDER_TARGET,
+    RG_ACCESS_DEPTH_BUFFER,
+};
+
+struct RENDER_GRAPH_RESOURCE
+{
+    RENDER_TARGET_ID    rtIndex;
+    RENDER_GRAPH_ACCESS access;
+    //content written by previous passes is kept, srv is always read
+    bool                isLoaded = false;
+};
+
+//frame is described by passes and render targets they use. passes which affect neither back buffer, history targets nor
+//other side effects are culled, targets of a pass are moved to needed layouts by one barrier before it, transient targets
+//with disjoint lifetimes share memory and attachment content nobody needs is neither loaded nor stored
+class RENDER_GRAPH
+{
+public:
+    using EXECUTE_FUNC = std::function<void()>;
+
+    //passes are executed in order of adding, each render target can be used once by a pass
+    void AddPass(const char* name, const std::vector<RENDER_GRAPH_RESOURCE>& resourceList, EXECUTE_FUNC executeFunc, bool hasSideEffects = false);
+    //must be called before frame is started, transient targets are recreated if their lifetimes don't fit current memory sharing
+    void Compile();
+    //passes are removed after execution
+    void Execute();
+private:
+    struct PASS
+    {
+        const char*                        name;
+        std::vector<RENDER_GRAPH_RESOURCE> resourceList;
+        EXECUTE_FUNC                       executeFunc;
+        bool                               hasSideEffects;
+    };
+
+    static bool          IsRead(const RENDER_GRAPH_RESOURCE& resource) { return resource.access == RG_ACCESS_SRV || resource.isLoaded; }
+    static bool          IsWrite(const RENDER_GRAPH_RESOURCE& resource) { return resource.access != RG_ACCESS_SRV; }
+    static bool          IsAttachment(const RENDER_GRAPH_RESOURCE& resource);
+    static VkImageLayout GetLayout(RENDER_GRAPH_ACCESS access);
+    //content of persistent targets is used out of the frame
+    static bool          IsPersistent(RENDER_TARGET_ID rtIndex) { return !pRenderTargetManager->IsTransientRenderTarget(rtIndex); }
+
+    void CullPasses();
+    bool IsContentLoaded(uint32_t passId, RENDER_TARGET_ID rtIndex) const;
+    bool IsContentStored(uint32_t passId, RENDER_TARGET_ID rtIndex) const;
+private:
+    std::vector<PASS> m_passList;
+};
+
+extern std::unique_ptr<RENDER_GRAPH> pRenderGraph;
@@ -1,12 +1,23 @@
 #pragma once
 #include "vulkanDriver.h"
 #include "ecsCoordinator.h"
+#include "renderTargetEnum.h"
+
+class RENDER_GRAPH;
 
 class RENDER_PASS_BLEND_SSAO : public ECS::SYSTEM<RENDER_PASS_BLEND_SSAO> {
 public:
     void Init();
-    void Render();
+    void AddToRenderGraph(RENDER_GRAPH& renderGraph);
 private:
+    void Blend();
+    //levelId 0 is half resolution, see SSAO_RESOLUTION
+    void Upsample(uint32_t levelId);
+    void BilateralBlur(RENDER_TARGET_ID sourceId, RENDER_TARGET_ID destId, RENDER_TARGET_ID depthNormalId, const glm::vec2& direction);
+
     void BeginRenderPass();
     void EndRenderPass();
+
+    //must match ssaoBilateralBlurCS.fx
+    static constexpr uint32_t BLUR_GROUP_SIZE = 64;
 };
\ No newline at end of file
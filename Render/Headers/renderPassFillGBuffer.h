@@ -2,14 +2,25 @@
 
 #include "vulkanDriver.h"
 #include "ecsCoordinator.h"
+#include "gpuCullingSystem.h"
+
+class RENDER_GRAPH;
 
 class RENDER_PASS_FILL_GBUFFER : public ECS::SYSTEM<RENDER_PASS_FILL_GBUFFER> {
 public:
     void Init();
-    void Render();
+    void AddToRenderGraph(RENDER_GRAPH& renderGraph);
+    //second phase of gpu occlusion culling, must be added after RENDER_PASS_HI_Z
+    void AddDisoccludedToRenderGraph(RENDER_GRAPH& renderGraph);
 private:
-    void BeginRenderPass();
-    void EndRenderPass();
+    void Render();
+    void RenderDisoccluded();
+    void BeginRenderPass(bool isSecondary, VkAttachmentLoadOp loadOp);
+    void EndRenderPass(bool isSecondary);
+    void FillConstBuffers();
+    void RenderIndirect(GPU_CULLING_SYSTEM* pGpuCullingSystem, GPU_CULLING_VIEW view);
+    //records [begin, end) part of entity list into current recording context
+    void RecordEntities(const std::vector<ECS::ENTITY_TYPE>& entityList, size_t begin, size_t end);
 private:
     VkRenderPass m_renderPass;
     VkFramebuffer m_frameBuffer;
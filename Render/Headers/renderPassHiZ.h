@@ -0,0 +1,29 @@
+#pragma once
+#include "vulkanDriver.h"
+#include "ecsCoordinator.h"
+#include "renderTargetEnum.h"
+
+class RENDER_GRAPH;
+
+//builds max depth pyramid from depth buffer of game camera, the pyramid is used for occlusion culling on gpu
+//it is kept till the next build, so before the build it holds depth of previous frame
+class RENDER_PASS_HI_Z : public ECS::SYSTEM<RENDER_PASS_HI_Z> {
+public:
+    void Init();
+    //one pass for each level
+    void AddToRenderGraph(RENDER_GRAPH& renderGraph);
+
+    bool               IsPyramidValid() const;
+    const glm::mat4x4& GetPyramidViewProj() const { return m_pyramidViewProj; }
+    glm::vec2          GetPyramidBaseSize() const { return m_pyramidBaseSize; }
+    //levels are set to slots [firstSlot, firstSlot + HI_Z_LEVELS_NUM)
+    void               SetPyramidAsSRV(uint32_t firstSlot);
+
+    static constexpr uint32_t SOURCE_SLOT = 50;
+private:
+    void             BuildLevel(uint32_t levelId);
+    RENDER_TARGET_ID GetSourceId(uint32_t levelId) const;
+private:
+    glm::mat4x4 m_pyramidViewProj = glm::mat4x4(1.f);
+    glm::vec2   m_pyramidBaseSize = glm::vec2(0.f);
+};
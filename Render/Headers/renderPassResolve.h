@@ -3,11 +3,14 @@
 #include "ecsCoordinator.h"
 #include "vulkanDriver.h"
 
+class RENDER_GRAPH;
+
 class RENDER_PASS_RESOLVE : public ECS::SYSTEM<RENDER_PASS_RESOLVE> {
 public:
     void Init();
-    void Render();
+    void AddToRenderGraph(RENDER_GRAPH& renderGraph);
 private:
+    void Render();
     void BeginRenderPass();
     void Draw();
     void EndRenderPass();
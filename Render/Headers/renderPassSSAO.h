@@ -2,11 +2,18 @@
 #include "vulkanDriver.h"
 #include "ecsCoordinator.h"
 
+class RENDER_GRAPH;
+
 class RENDER_PASS_SSAO : public ECS::SYSTEM<RENDER_PASS_SSAO> {
 public:
     void Init();
-    void Render();
+    void AddToRenderGraph(RENDER_GRAPH& renderGraph);
 private:
+    void RenderFullResolution();
+    //levelId 0 is half resolution, see SSAO_RESOLUTION
+    void DownsampleDepthNormal(uint32_t levelId);
+    void RenderReducedResolution(uint32_t levelId);
+
     void BeginRenderPass();
     void EndRenderPass();
 
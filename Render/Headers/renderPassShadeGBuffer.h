@@ -1,11 +1,14 @@
 #pragma once
 #include "ecsCoordinator.h"
 
+class RENDER_GRAPH;
+
 class RENDER_PASS_SHADE_GBUFFER : public ECS::SYSTEM<RENDER_PASS_SHADE_GBUFFER> {
 public:
     void Init();
-    void Render();
+    void AddToRenderGraph(RENDER_GRAPH& renderGraph);
 private:
+    void Render();
     void BeginRenderPass();
     void EndRenderPass();
 };
@@ -1,18 +1,53 @@
 #pragma once
+#include <array>
+#include <vector>
 
 #include "vulkanDriver.h"
 #include "ecsCoordinator.h"
 
+struct CAMERA_COMPONENT;
+class RENDER_GRAPH;
+
 class RENDER_PASS_SHADOW : public ECS::SYSTEM<RENDER_PASS_SHADOW> {
 public:
     void Init();
     void Update();
-    void Render();
+    void AddToRenderGraph(RENDER_GRAPH& renderGraph);
+
+    //casters set is changed, cached cascades are drawn again
+    void AddEntity(ECS::ENTITY_TYPE entityId) override;
+    void RemoveEntity(ECS::ENTITY_TYPE entityId) override;
+
+    //cascade matrices and splits for shaders which sample the shadow map
+    void FillCascadeData(EFFECT_DATA::CB_LIGHTS_STRUCT& lightBufferData) const;
 private:
-    void BeginRenderPass();
+    struct SHADOW_CASCADE {
+        glm::mat4x4 proj;
+        //bounds of the cascade, casters are culled with it
+        glm::mat4x4 viewProj;
+        //viewProj moved to the cascade region of the atlas, it is used for rendering and sampling
+        glm::mat4x4 atlasViewProj;
+        VkRect2D    atlasRect;
+        //view space depth of camera frustum slice the cascade is fit to
+        float       splitDepth;
+        //atlas region keeps the cascade from previous frames until it is invalidated.
+        //casters have no runtime transforms, so only caster set, bias and cascade bounds changes invalidate it
+        bool        isDirty = true;
+    };
+
+    void UpdateCascades(const CAMERA_COMPONENT& camera, const glm::mat4x4& lightView);
+    void Render();
+    void BeginRenderPass(VkAttachmentLoadOp loadOp);
     void EndRenderPass();
 private:
     VkRenderPass m_renderPass;
     VkFramebuffer m_frameBuffer;
-};
 
+    std::array<SHADOW_CASCADE, EFFECT_DATA::SHADOW_CASCADES_NUM> m_cascadeList;
+    std::vector<ECS::ENTITY_TYPE>                                m_casterList;
+    bool                                                         m_isCasterListDirty = true;
+    //size of atlas region of one cascade
+    uint32_t                                                     m_cascadeSize = 0;
+    //bias is baked into cached depth
+    glm::vec2                                                    m_cachedDepthBias = glm::vec2(0.f);
+};
@@ -1,16 +1,35 @@
 #pragma once
+#include <cstdint>
 
 enum RENDER_TARGET_ID
 {
     RT_FP16,
+    //rgb is albedo, a is metalness
     RT_GBUFFER_ALBEDO,
+    //rg is octahedral encoded world normal, b is roughness, world position is restored from depth
     RT_GBUFFER_NORMAL,
-    RT_GBUFFER_METALL_ROUGHNESS,
-    RT_GBUFFER_WORLD_POS, //tmp
     RT_SSAO_MASK,
     RT_SSAO_MASK_BLENDED,
+    //reduced resolution ssao targets, half and quarter of back buffer, see SSAO_RESOLUTION
+    //view space normal and depth of the closest full resolution texel
+    RT_SSAO_DEPTH_NORMAL_HALF,
+    RT_SSAO_DEPTH_NORMAL_QUARTER,
+    RT_SSAO_MASK_HALF,
+    RT_SSAO_MASK_QUARTER,
+    //intermediate target of separable blur
+    RT_SSAO_BLUR_HALF,
+    RT_SSAO_BLUR_QUARTER,
     RT_SHADOW_MAP,
     RT_DEPTH_BUFFER,
+    //max depth pyramid, level 0 is half of depth buffer
+    RT_HI_Z_0,
+    RT_HI_Z_1,
+    RT_HI_Z_2,
+    RT_HI_Z_3,
+    RT_HI_Z_4,
+    RT_HI_Z_5,
+    RT_HI_Z_6,
+    RT_HI_Z_7,
     RT_BACK_BUFFER,
     RT_LAST
 };
@@ -19,12 +38,27 @@ static const char* RENDER_TARGET_NAME[] = {
     "FP16",
     "GBUFFER_ALBEDO",
     "GBUFFER_NORMAL",
-    "GBUFFER_METALL_ROUGHNESS",
-    "GBUFFER_WORLD_POS",
     "SSAO_MASK",
     "SSAO_MASK_BLENDED",
+    "SSAO_DEPTH_NORMAL_HALF",
+    "SSAO_DEPTH_NORMAL_QUARTER",
+    "SSAO_MASK_HALF",
+    "SSAO_MASK_QUARTER",
+    "SSAO_BLUR_HALF",
+    "SSAO_BLUR_QUARTER",
     "SHADOW_MAP",
     "DEPTH_BUFFER",
+    "HI_Z_0",
+    "HI_Z_1",
+    "HI_Z_2",
+    "HI_Z_3",
+    "HI_Z_4",
+    "HI_Z_5",
+    "HI_Z_6",
+    "HI_Z_7",
     "BACK_BUFFER",
     "LAST"
 };
+
+static const uint32_t HI_Z_LEVELS_NUM = RT_HI_Z_7 - RT_HI_Z_0 + 1;
+static const uint32_t SSAO_REDUCED_LEVELS_NUM = RT_SSAO_MASK_QUARTER - RT_SSAO_MASK_HALF + 1;
@@ -2,6 +2,24 @@
 #include "renderTargetEnum.h"
 #include "vulkanDriver.h"
 
+//passes of the frame which use the target, ids are execution order of RENDER_GRAPH
+struct RENDER_TARGET_LIFETIME
+{
+    uint32_t firstPassId = UINT32_MAX;
+    uint32_t lastPassId = 0;
+
+    bool IsUsed() const { return firstPassId <= lastPassId; }
+    bool IsOverlapped(const RENDER_TARGET_LIFETIME& lifetime) const {
+        return IsUsed() && lifetime.IsUsed() && firstPassId <= lifetime.lastPassId && lifetime.firstPassId <= lastPassId;
+    }
+};
+
+struct RENDER_TARGET_TRANSITION
+{
+    RENDER_TARGET_ID rtIndex;
+    VkImageLayout    layout;
+};
+
 //todo: plz, rewrite get/return mechanism for render targets!
 class RENDER_TARGET_MANAGER {
 public:
@@ -15,15 +33,49 @@ public:
     void SetTextureAsRenderTarget(RENDER_TARGET_ID rtIndex, size_t slotIndex, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp);
     void SetTextureAsDepthBuffer(RENDER_TARGET_ID rtIndex, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp);
     void SetTextureAsSRV(RENDER_TARGET_ID rtIndex, size_t slotIndex);
+    //storage image for compute shaders, target must be created with VK_IMAGE_USAGE_STORAGE_BIT
+    void SetTextureAsUAV(RENDER_TARGET_ID rtIndex, size_t slotIndex);
 
     void ReturnRenderTarget(RENDER_TARGET_ID rtIndex);
     void ReturnAllRenderTargetsToPool();
+
+    //layouts of several targets are changed with one barrier, targets mustn't be obtained
+    void ChangeLayouts(const std::vector<RENDER_TARGET_TRANSITION>& transitionList);
+    //relaxes ops passed to SetTextureAsRenderTarget and SetTextureAsDepthBuffer till the end of frame:
+    //undefined content isn't loaded and content which is never read again isn't stored
+    void SetContentUsage(RENDER_TARGET_ID rtIndex, bool isContentLoaded, bool isContentStored);
+    //transient targets with disjoint lifetimes share memory, targets are recreated when sharing is changed
+    //must be called outside of frame, content of transient targets is lost
+    void AliasTransientRenderTargets(const std::array<RENDER_TARGET_LIFETIME, RT_LAST>& lifetimeList);
+
+    const VULKAN_TEXTURE& GetRenderTarget(RENDER_TARGET_ID rtIndex) const { return m_renderTargetList[rtIndex]; }
+    //history targets keep content and layout between frames, they are read in the next frame before being rewritten
+    bool IsHistoryRenderTarget(RENDER_TARGET_ID rtIndex) const;
+    bool IsHistoryValid(RENDER_TARGET_ID rtIndex) const;
+    //transient targets are fully rewritten each frame, so their memory can be aliased
+    bool IsTransientRenderTarget(RENDER_TARGET_ID rtIndex) const { return !IsHistoryRenderTarget(rtIndex) && rtIndex != RT_BACK_BUFFER; }
 private:
     void ObtainRenderTarget(RENDER_TARGET_ID rtIndex, VkAccessFlags accessFlags, VkImageLayout layout);
+    void AddTransition(RENDER_TARGET_ID rtIndex, VkImageLayout layout, std::vector<TEXTURE_LAYOUT_TRANSITION>& transitionList);
+    void SetAttachmentOps(RENDER_TARGET_ID rtIndex, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp);
+
+    //targets with the same memory id are bound to one allocation
+    bool CreateTransientRenderTargets(const std::array<uint32_t, RT_LAST>& memoryIdList);
+    void DestroyTransientRenderTargets();
 private:
     std::bitset<RT_LAST>                         m_renderTargetsAvailabilityMask;
     std::array<VkAttachmentDescription, RT_LAST> m_renderTargetDesc;
     std::array<VULKAN_TEXTURE,          RT_LAST> m_renderTargetList;
+
+    std::bitset<RT_LAST>                         m_skipLoadMask;
+    std::bitset<RT_LAST>                         m_skipStoreMask;
+
+    std::array<VULKAN_TEXTURE_CREATE_DATA, RT_LAST> m_transientCreateDataList;
+    std::array<VkMemoryRequirements,       RT_LAST> m_memRequirementsList;
+    std::array<uint32_t,                   RT_LAST> m_memoryIdList;
+    std::vector<VULKAN_MEMORY_ALLOCATION>           m_aliasedMemoryList;
+    //target shares its memory with other ones
+    std::bitset<RT_LAST>                            m_aliasedMask;
 };
 
 extern std::unique_ptr<RENDER_TARGET_MANAGER> pRenderTargetManager;
@@ -1,8 +1,10 @@
 #pragma once
 #include <string>
+#include "boundingVolumeHierarchy.h"
 #include "vulkanResourcesDescription.h"
 #include "materialManager.h"
 #include "meshManager.h"
+#include "textureCooker.h"
 
 enum DEFAULT_TEXTURES {
     DEFAULT_BLACK_TEXTURE,
@@ -20,12 +22,6 @@ enum DEFAULT_TEXTURES {
 struct MESH_HOLDER_COMPONENT;
 struct NODE_COMPONENT;
 
-struct AABB
-{
-    glm::vec2 minPos;
-    glm::vec2 maxPos;
-};
-
 struct MESH_PRIMITIVE : public ECS::COMPONENT<MESH_PRIMITIVE>
 {
     const VULKAN_MESH*           pMesh;
@@ -71,15 +67,33 @@ public:
     void CreateDefaultResources();
     bool LoadModel(const std::string& levelName);
     void UnloadScene();
+    //requests mips of visible materials textures and swaps in streamed ones, it must be called before the frame is started
+    void UpdateTextureStreaming();
 
     const VULKAN_TEXTURE* GetDefaultTexture(int textureId) const { return &m_defaultTextureList[textureId]; }
+    //all model meshes are in these buffers, so they can be drawn by one indirect draw
+    const VULKAN_BUFFER&  GetSharedVertexBuffer() const { return m_sharedVertexBuffer; }
+    const VULKAN_BUFFER&  GetSharedIndexBuffer() const { return m_sharedIndexBuffer; }
 private:
     bool LoadMesh(const std::string& meshName);
-    bool LoadTexture(const std::string& textureName, const std::string& textureDir, VULKAN_TEXTURE& texture);
+    //creates meshes and their entities from cooked package, geometry of all of them is uploaded by one copy
+    bool LoadMeshes(const uint8_t* pPackageData, uint32_t storeMeshOffset, uint32_t storeMeshHolderOffset, uint32_t storeMaterialOffset);
+    //can be called from worker threads, upload is finished by staging ring later. source is read and cooked only if cache doesn't have it
+    bool LoadTexture(const std::string& textureName, const std::string& textureDir, uint64_t sourceHash, TEXTURE_COOK_FORMAT format, VULKAN_TEXTURE& texture);
     void CreateDefalutTextures();
+    void CreateSharedGeometryBuffers();
+    //vertexes are SIMPLE_VERTEX, indexes are 16 bit
+    bool AddGeometryToSharedBuffers(const uint8_t* pVertexData, uint32_t vertexesNum, const uint8_t* pIndexData, uint32_t indexesNum);
 private:
     const std::string CACHE_TEXTURE_DIR = "../Media/Textures/_textureCache/";
+    const std::string CACHE_MESH_DIR = "../Media/Meshes/_meshCache/";
+    const std::string MESH_PACKAGE_EXT = ".umesh";
     static const uint32_t MAX_ARRAY_SIZE = 1024;
+    static const uint64_t TEXTURE_MEMORY_BUDGET = 512 * 1024 * 1024;
+    //copies of loaded textures are submitted after each batch, so gpu uploads overlap decoding of the rest
+    static const uint32_t TEXTURE_UPLOAD_BATCH_SIZE = 8;
+    static const uint32_t SHARED_VERTEX_BUFFER_SIZE = 64 * 1024 * 1024;
+    static const uint32_t SHARED_INDEX_BUFFER_SIZE = 16 * 1024 * 1024;
 
     std::array<VULKAN_MESH, MAX_ARRAY_SIZE>           m_meshList;
     std::array<MESH_HOLDER_COMPONENT, MAX_ARRAY_SIZE> m_meshHolderList;
@@ -93,6 +107,11 @@ private:
     uint32_t m_materialNum;
     uint32_t m_nodeNum;
 
+    VULKAN_BUFFER m_sharedVertexBuffer;
+    VULKAN_BUFFER m_sharedIndexBuffer;
+    uint32_t      m_sharedVertexesNum;
+    uint32_t      m_sharedIndexesNum;
+
     std::array<VULKAN_TEXTURE, DEFAULT_LAST_TEXTURE> m_defaultTextureList;
     MATERIAL_COMPONENT m_defaultMaterial;
     MESH_HOLDER_COMPONENT m_defaultMesh;
@@ -25,6 +25,15 @@ public:
     const std::vector<VkDescriptorSetLayoutBinding>& GetDecriptorLayouts(uint8_t shaderId) const;
     const VkShaderModule& GetVertexShader(uint8_t shaderId) const;
     const VkShaderModule& GetPixelShader(uint8_t shaderId) const;
+    const VkShaderModule& GetComputeShader(uint8_t shaderId) const;
+    //such shaders take textures from global bindless array of the driver
+    bool                  IsUseBindlessTextures(uint8_t shaderId) const {
+        return shaderId == EFFECT_DATA::SHR_FILL_GBUFFER_BINDLESS || shaderId == EFFECT_DATA::SHR_FILL_GBUFFER_INDIRECT;
+    }
+    //compute shaders have only cs stage, others have vs and ps
+    bool                  IsComputeShader(uint8_t shaderId) const {
+        return shaderId == EFFECT_DATA::SHR_GPU_CULLING || shaderId == EFFECT_DATA::SHR_LIGHT_CLUSTERING || shaderId == EFFECT_DATA::SHR_SSAO_BILATERAL_BLUR;
+    }
 private:
     void   InitShaderDecriptorLayoutTable();
     void   CompileShader(uint8_t shaderId, EFFECT_DATA::SHADER_TYPE type) const;
@@ -35,6 +44,7 @@ private:
     std::array<std::vector<VkDescriptorSetLayoutBinding>, EFFECT_DATA::SHR_LAST> m_shaderDesc;
     std::array<SHADER_MODULE, EFFECT_DATA::SHR_LAST> m_vertexShaderModules;
     std::array<SHADER_MODULE, EFFECT_DATA::SHR_LAST> m_pixelShaderModules;
+    std::array<SHADER_MODULE, EFFECT_DATA::SHR_LAST> m_computeShaderModules;
 };
 
 extern std::unique_ptr<SHADER_MANAGER> pShaderManager;
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include <vector>
+
+//usage of texture defines compressed format of its cached version
+enum TEXTURE_COOK_FORMAT {
+    //bc7, all four channels
+    TEXTURE_COOK_COLOR,
+    //bc5, xy of tangent space normal, z is reconstructed by shader
+    TEXTURE_COOK_NORMAL,
+};
+
+//hash of source content, packages store it so cached texture is found without reading the source
+uint64_t GetTextureSourceHash(const std::vector<char>& sourceData);
+//name of cached texture is made of source hash, so changed sources are cooked again whatever their names are
+std::string GetCookedTextureName(uint64_t sourceHash, TEXTURE_COOK_FORMAT format);
+
+//decodes png/jpg, builds full mip chain with kaiser filter, compresses it and writes dds
+//blocks are compressed by job system workers, it's safe to call from a job
+bool CookTexture(const std::vector<char>& sourceData, TEXTURE_COOK_FORMAT format, const std::string& destPath);
@@ -0,0 +1,97 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jobSystem.h"
+#include "vulkanResourcesDescription.h"
+
+namespace gli {
+    class texture;
+}
+
+//textures are created with low mips only, higher mips are loaded from texture cache when screen size of primitives
+//using them needs it. textures not used for the longest time lose high mips first when memory budget is exceeded
+class TEXTURE_STREAMING_MANAGER
+{
+public:
+    void Init(uint64_t memoryBudget);
+    void Term();
+
+    //can be called from worker threads, texture is created with mips not bigger than MIN_RESIDENT_SIZE
+    //address of the texture must stay the same, its content is replaced when other mips become resident
+    bool AddTexture(const std::string& cachedTexturePath, const gli::texture& gliTexture, VULKAN_TEXTURE& texture);
+    //main thread only. screenSize is size in pixels the texture is drawn with, the biggest one is kept until Update
+    void RequestTexture(const VULKAN_TEXTURE* pTexture, float screenSize);
+    //must be called before the frame is started: replaces textures with loaded ones, evicts and starts loads
+    void Update(std::vector<const VULKAN_TEXTURE*>& changedTextureList);
+
+    //budget is checked against the size of all texture images: resident, being loaded and retired but not destroyed yet
+    void     SetMemoryBudget(uint64_t memoryBudget) { m_memoryBudget = memoryBudget; }
+    uint64_t GetMemoryBudget() const { return m_memoryBudget; }
+    uint64_t GetCommittedSize() const { return m_committedSize; }
+private:
+    static constexpr uint32_t MIN_RESIDENT_SIZE = 128;
+    static constexpr uint32_t MAX_LOADS_IN_FLIGHT = 4;
+
+    struct STREAMED_TEXTURE
+    {
+        std::string           cachedTexturePath;
+        VULKAN_TEXTURE*       pTexture;
+        std::vector<uint64_t> levelSizeList;
+        //width or height of the first mip, the bigger one
+        float                 textureSize;
+        //the smallest mips which are never evicted start from it
+        uint32_t              minResidentMip;
+        //the smallest mips are kept in memory, so evicted texture is created again without reading the file
+        std::vector<uint8_t>  minResidentMipData;
+        VkExtent3D            minResidentMipExtent;
+        VkFormat              format;
+        uint32_t              residentMip;
+        //best mip requested this frame
+        uint32_t              requestedMip;
+        uint64_t              lastUsedFrameId = 0;
+
+        bool                  isLoading = false;
+        uint32_t              loadingMip;
+        bool                  isLoaded;
+        VULKAN_TEXTURE        loadedTexture;
+        ECS::JOB_COUNTER      loadCounter;
+    };
+
+    struct RETIRED_TEXTURE
+    {
+        VULKAN_TEXTURE texture;
+        uint64_t       textureSize;
+        uint64_t       retiredFrameId;
+    };
+
+    static VkResult CreateTexture(const gli::texture& gliTexture, uint32_t firstMip, VULKAN_TEXTURE& texture);
+    static VkResult CreateMinResidentTexture(const STREAMED_TEXTURE& streamedTexture, VULKAN_TEXTURE& texture);
+    static uint64_t GetResidentSize(const STREAMED_TEXTURE& streamedTexture, uint32_t firstMip);
+
+    void FinishLoads(std::vector<const VULKAN_TEXTURE*>& changedTextureList);
+    void StartLoad(STREAMED_TEXTURE& streamedTexture, uint32_t firstMip);
+    bool StartEviction(STREAMED_TEXTURE& streamedTexture);
+    void EvictTextures(uint64_t neededSize);
+    void DestroyRetiredTextures(bool isForced);
+
+    std::mutex                                     m_lock;
+    std::vector<std::unique_ptr<STREAMED_TEXTURE>> m_textureList;
+    std::unordered_map<const VULKAN_TEXTURE*, uint32_t> m_textureIdMap;
+    std::deque<RETIRED_TEXTURE>                    m_retiredTextureList;
+
+    uint64_t m_frameId = 0;
+    uint64_t m_memoryBudget = 0;
+    //size of resident, loading and retired textures
+    uint64_t m_committedSize = 0;
+    //part of committed size which is released when loads in flight are finished and retired textures are destroyed
+    uint64_t m_releasingSize = 0;
+    //loads and evictions, both wait for upload and retire the old texture
+    uint32_t m_loadsInFlightNum = 0;
+};
+
+extern std::unique_ptr<TEXTURE_STREAMING_MANAGER> pTextureStreamingManager;
@@ -1,9 +1,36 @@
 #pragma once
+#include <array>
+#include <vector>
+
+#include "boundingVolumeHierarchy.h"
 #include "ecsCoordinator.h"
 
+enum VISIBILITY_VIEW {
+    VIEW_GAME_CAMERA,
+
+    VIEW_LAST
+};
+
+//culls rendered primitives by their bounds, passes draw visible lists instead of all entities
 class VISIBILITY_SYSTEM : public ECS::SYSTEM<VISIBILITY_SYSTEM>
 {
 public:
     bool Init();
     void Update();
+
+    void AddEntity(ECS::ENTITY_TYPE entityId) override;
+    void RemoveEntity(ECS::ENTITY_TYPE entityId) override;
+
+    //entities are in MESH_PRIMITIVE storage order
+    const std::vector<ECS::ENTITY_TYPE>& GetVisibleEntities(VISIBILITY_VIEW view) const { return m_visibleEntityList[view]; }
+    void CullFrustum(const glm::mat4x4& viewProj, std::vector<ECS::ENTITY_TYPE>& visibleEntityList) const;
+    bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, ECS::ENTITY_TYPE& hitEntity, float& hitDistance) const;
+private:
+    void UpdateBounds();
+
+    bool                                                      m_isBoundsDirty = true;
+    BOUNDING_VOLUME_HIERARCHY                                 m_bvh;
+    //bvh item id is index in this list
+    std::vector<ECS::ENTITY_TYPE>                             m_itemEntityList;
+    std::array<std::vector<ECS::ENTITY_TYPE>, VIEW_LAST>      m_visibleEntityList;
 };
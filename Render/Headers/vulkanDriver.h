@@ -2,23 +2,36 @@
 
 #define NOMINMAX
 #include <array>
+#include <atomic>
+#include <bitset>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 #include <vulkan/vulkan.h>
 
 #include "effectData.h"
+#include "vulkanMemoryAllocator.h"
 #include "vulkanResourcesDescription.h"
+#include "vulkanStagingRing.h"
 
 const uint32_t NUM_FRAME_BUFFERS = 2;
 const uint32_t NUM_CONSTANT_BUFFERS = 16;
+//const buffer data of all draws of one frame must fit it, draws with data over the limit are skipped
+const uint32_t FRAME_CONST_BUFFER_SIZE = 4 * 1024 * 1024;
+const uint32_t INVALID_CONST_BUFFER_OFFSET = UINT32_MAX;
 const uint32_t MAX_RENDER_TARGETS = 4;
+const uint32_t MAX_DESCRIPTOR_SLOTS = 128;
+const uint32_t MAX_BINDLESS_TEXTURES = 4096;
 
 struct QUEUE_FAMILIES {
     struct QUEUE_FAMILY_CREATE_PARAMS {
         std::optional<uint32_t> graphicsFamilyIndex;
         std::optional<uint32_t> presentFamilyIndex;
+        //family without graphics bit if device has one, graphics family otherwise
+        std::optional<uint32_t> transferFamilyIndex;
 
         bool IsComplete() {
             return graphicsFamilyIndex.has_value() && presentFamilyIndex.has_value();
@@ -28,6 +41,7 @@ struct QUEUE_FAMILIES {
     QUEUE_FAMILY_CREATE_PARAMS createParams;
     VkQueue graphicsQueue;
     VkQueue presentQueue;
+    VkQueue transferQueue;
 };
 
 struct SWAP_CHAIN {
@@ -180,6 +194,61 @@ struct PIPLINE_STATE {
     }
 };
 
+//everything needed to create pipeline outside of its render pass, records are saved with pipeline cache for precompilation
+struct PIPLINE_CACHE_RECORD {
+    PIPLINE_STATE     piplineState;
+    RENDER_PASS_STATE renderPassState;
+};
+
+//everything which is needed to record commands from one thread: own pools and own copy of the state cache
+struct RECORDING_CONTEXT {
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    bool            isRecorded = false;
+
+    //secondary command buffers are allocated on demand and reused each frame
+    std::array<VkCommandPool, NUM_FRAME_BUFFERS>                commandPool = {};
+    std::array<std::vector<VkCommandBuffer>, NUM_FRAME_BUFFERS> secondaryCommandBuffers;
+    std::array<uint32_t, NUM_FRAME_BUFFERS>                     usedSecondaryCommandBuffersNum = {};
+    std::array<VkDescriptorPool, NUM_FRAME_BUFFERS>             descriptorPool = {};
+    //sets with the same shader and images are reused until the pool is reset
+    std::array<std::unordered_map<size_t, VkDescriptorSet>, NUM_FRAME_BUFFERS> descriptorSetCache;
+
+    //bound images and storage buffers sorted by slot
+    std::vector<std::pair<uint8_t, VkDescriptorImageInfo>>  passImageDescriptors;
+    std::vector<std::pair<uint8_t, VkDescriptorBufferInfo>> passBufferDescriptors;
+    //dynamic offsets of const buffers by slot, descriptors themselves never change
+    std::array<uint32_t, NUM_CONSTANT_BUFFERS>              constBufferOffsets = {};
+    bool                                                    updateConstBufferOffsets = false;
+
+    uint32_t                 pushConstantBufferDirtySize = 0;
+    std::array<uint8_t, 128> pushConstantBuffer;
+    VkRect2D                 dynamicScissorRect;
+    glm::vec2                dynamicBiasParams;
+    bool                     isDynamicDepthBiasDirty = false;
+    bool                     isDynamicScissorRectDirty = false;
+
+    VkDescriptorSet       descriptorSet = VK_NULL_HANDLE;
+    PIPLINE_LAYOUT_STATE  piplineLayoutState;
+    VkPipelineLayout      piplineLayout = VK_NULL_HANDLE;
+    PIPLINE_STATE         piplineState;
+    VkPipeline            pipeline = VK_NULL_HANDLE;
+
+    bool                  updatePiplineLayout = true;
+    bool                  updatePiplineState = true;
+    bool                  updateDescriptorSet = true;
+
+    VULKAN_BUFFER         vertexBuffer;
+    VULKAN_BUFFER         indexBuffer;
+};
+
+struct TEXTURE_LAYOUT_TRANSITION {
+    VULKAN_TEXTURE* pTexture;
+    VkImageLayout   oldLayout;
+    VkImageLayout   newLayout;
+    //memory of the texture was used by other texture before
+    bool            isAliased;
+};
+
 
 class VULKAN_DRIVER_INTERFACE {
 public:
@@ -194,17 +263,36 @@ public:
     
     void WaitGPU();
     void DropPiplineStateCache();
+    //frame buffers are cached by images, they must be dropped after render targets are recreated, gpu must be idle
+    void DropFrameBufferCache();
+    //creates pipelines used in previous sessions on job system threads, shaders must be loaded
+    void PrecompilePipelines();
     void SubmitCommandBuffer();
 
     void ClearBackBuffer(const glm::vec4& clearColor);
+    void ClearDepthBuffer(const VkRect2D& rect, float clearDepth = 1.f);
 
     void SetVertexBuffer(VULKAN_BUFFER vertexBuffer, uint32_t offset);
     void SetIndexBuffer(VULKAN_BUFFER indexBuffer, uint32_t offset);
 
     void FillPushConstantBuffer(const void* pData, uint32_t dataSize);
-    void FillConstBuffer(uint32_t bufferId, const void* pData, uint32_t dataSize);
+    //returns offset of data in current frame, it can be passed to SetConstBuffer for per draw data.
+    //returns INVALID_CONST_BUFFER_OFFSET when frame region is full, draws using it are skipped
+    uint32_t FillConstBuffer(uint32_t bufferId, const void* pData, uint32_t dataSize);
+    //binds last data filled on the main thread
     void SetConstBuffer(uint32_t bufferId);
+    void SetConstBuffer(uint32_t bufferId, uint32_t offset);
     void SetTexture(const VULKAN_TEXTURE* texture, uint32_t slot);
+    //fills element of global texture array used by bindless shaders, see SHADER_MANAGER::IsUseBindlessTextures
+    //the element is changed from the next frame, previous texture must live until frames in flight are done
+    void SetBindlessTexture(uint32_t textureId, const VULKAN_TEXTURE* pTexture);
+    bool IsBindlessSupported() const { return m_isBindlessSupported; }
+    void SetStorageBuffer(const VULKAN_BUFFER& buffer, uint32_t slot);
+    //texture must be in VK_IMAGE_LAYOUT_GENERAL and created with VK_IMAGE_USAGE_STORAGE_BIT
+    void SetStorageImage(const VULKAN_TEXTURE* texture, uint32_t slot);
+    //indirect draws take instance data by first instance and material textures from bindless array
+    bool IsGpuDrivenSupported() const { return m_isBindlessSupported && m_deviceFeatures.drawIndirectFirstInstance; }
+    bool IsDrawIndirectCountSupported() const { return m_isDrawIndirectCountSupported; }
     void SetShader(uint8_t shaderId);
     void SetVertexFormat(uint8_t vertexFormat);
 
@@ -219,13 +307,27 @@ public:
     void SetScissorRect(const VkRect2D& scissorRect);
     void SetDepthBiasParams(float depthBiasConstant, float depthBiasSlope);
     
-    void BeginRenderPass();
+    //with useSecondaryCommandBuffers draws must be recorded between Begin/EndSecondaryRecording, main context only executes them
+    void BeginRenderPass(bool useSecondaryCommandBuffers = false);
     void EndRenderPass();
+    //can be called from any thread, each recording context must be used by one thread at a time
+    void BeginSecondaryRecording(uint32_t recordingContextId);
+    void EndSecondaryRecording();
+    void ExecuteSecondaryCommandBuffers();
+    uint32_t GetRecordingContextsNum() const { return static_cast<uint32_t>(m_recordingContextList.size()); }
     void ChangeTextureLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VULKAN_TEXTURE& texture);
+    //all transitions are recorded with one barrier
+    void ChangeTextureLayouts(const std::vector<TEXTURE_LAYOUT_TRANSITION>& transitionList);
+    void BufferBarrier(const VULKAN_BUFFER& buffer, VkAccessFlags srcAccess, VkPipelineStageFlags srcStage, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage);
+    //fills buffer with zeros, must be called outside of render pass
+    void ClearBuffer(const VULKAN_BUFFER& buffer);
 
     void Draw(uint32_t vertexesNum);
     void DrawIndexed(uint32_t indexesNum, uint32_t vertexBufferOffset = 0, uint32_t indexBufferOffset = 0);
     void DrawFullscreen();
+    //draw count is read from countBuffer if it's supported, otherwise maxDrawsNum commands are drawn and unused ones must be zero
+    void DrawIndexedIndirect(const VULKAN_BUFFER& commandBuffer, const VULKAN_BUFFER& countBuffer, uint32_t maxDrawsNum);
+    void Dispatch(uint32_t groupsNumX, uint32_t groupsNumY = 1, uint32_t groupsNumZ = 1);
 
     uint32_t GetMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
@@ -234,6 +336,12 @@ public:
     void DestroyShader(VkShaderModule& shaderModule) const;
 
     VkResult CreateRenderTarget(VULKAN_TEXTURE_CREATE_DATA& createData, VULKAN_TEXTURE& texture);
+    //image is created without memory, several render targets with disjoint lifetimes can be bound to one allocation
+    VkResult CreateAliasedRenderTarget(const VULKAN_TEXTURE_CREATE_DATA& createData, VULKAN_TEXTURE& texture, VkMemoryRequirements& memRequirements);
+    VkResult AllocateAliasedMemory(const VkMemoryRequirements& memRequirements, VULKAN_MEMORY_ALLOCATION& allocation);
+    //creates view of the render target, memory isn't owned by the texture
+    VkResult BindAliasedMemory(const VULKAN_MEMORY_ALLOCATION& allocation, VULKAN_TEXTURE& texture);
+    void     FreeAliasedMemory(VULKAN_MEMORY_ALLOCATION& allocation);
     VkResult CreateTexture(VULKAN_TEXTURE_CREATE_DATA& createData, VULKAN_TEXTURE& texture);
     void     DestroyTexture(VULKAN_TEXTURE& texture);
 
@@ -244,13 +352,20 @@ public:
     VkResult      CreateBuffer  (const VkBufferCreateInfo& bufferInfo, bool isUpdatedByCPU, VULKAN_BUFFER& createdBuffer);
     VkResult      CreateAndFillBuffer(const VkBufferCreateInfo& bufferInfo, const uint8_t* pSourceData, bool isUpdatedByCPU, VULKAN_BUFFER& createdBuffer);
     VkResult      FillBuffer    (const uint8_t* rawData, uint64_t rawDataSize, uint64_t offset, VULKAN_BUFFER& buffer);
+    //fills part of gpu only buffer through staging ring, the part mustn't be used by frames in flight
+    UPLOAD_TICKET UploadBuffer  (const uint8_t* rawData, uint64_t rawDataSize, uint64_t offset, VULKAN_BUFFER& buffer);
     void          CopyBuffer    (VULKAN_BUFFER srcBuffer, VULKAN_BUFFER dstBuffer, VkDeviceSize size);
     void          DestroyBuffer (VULKAN_BUFFER& buffer);
 
-    VkResult AllocateMemory (const VkMemoryAllocateInfo& allocationInfo, VkDeviceMemory& allocatedMemory);
-    void     FreeMemory (VkDeviceMemory& allocatedMemory);
+    //uploads of CreateAndFillBuffer and CreateTexture are asynchronous, they are submitted before the frame at latest
+    bool          IsUploadComplete(UPLOAD_TICKET ticket) { return m_stagingRing.IsComplete(ticket); }
+    void          WaitUpload(UPLOAD_TICKET ticket) { m_stagingRing.Wait(ticket); }
+    //starts gpu copies of recorded uploads without waiting for the next frame, can be called from any thread
+    UPLOAD_TICKET SubmitUploads() { return m_stagingRing.Submit(); }
 
     float     GetFrameGpuTime()    const { return m_frameGpuTime; }
+    //resources indexed by it aren't used by gpu after StartFrame
+    uint32_t  GetCurContextId()    const { return m_curContextId; }
     const VULKAN_TEXTURE & GetCurSwapChainTexture () const { return m_swapChain.swapChainTexture[m_swapChain.curSwapChainImageId]; }
 private:
     //functions
@@ -261,23 +376,32 @@ private:
     VkResult InitInstance();
     VkResult InitPhysicalDevice();
     VkResult InitLogicalDevice();
+    VkResult InitMemoryAllocator();
     VkResult InitDebugMessenger();
     VkResult InitWindowSurface();
     VkResult InitSwapChain();
     VkResult InitSwapChainImages();
     VkResult InitSwapChainFrameBuffers();
     VkResult InitCommandBuffers();
+    VkResult InitRecordingContexts();
     VkResult InitSemaphoresAndFences();
     VkResult InitIntermediateBuffers();
     VkResult InitConstBuffers();
     VkResult InitSamplers();
+    VkResult InitBindlessTextures();
+    VkResult InitPipelineCache();
 
-    VkResult CreateDecriptorPools();
+    VkResult CreateDecriptorPools(std::array<VkDescriptorPool, NUM_FRAME_BUFFERS>& descriptorPool);
     VkResult CreateDecsriptorSetLayout(uint8_t shaderId);
     VkResult CreatePiplineLayout(const PIPLINE_LAYOUT_STATE& piplineLayoutKey);
-    VkResult CreateGraphicPipeline(const PIPLINE_STATE& psoKey);
+    //can be called from any thread, doesn't add pipeline to the cache
+    VkResult CreateGraphicPipeline(const PIPLINE_CACHE_RECORD& psoRecord, VkPipeline& pipeline);
+    //returns pipeline which is in the cache, it differs from passed one if other thread has stored it first
+    VkPipeline StoreGraphicPipeline(const PIPLINE_CACHE_RECORD& psoRecord, VkPipeline pipeline);
+    VkResult CreateComputePipeline(uint8_t shaderId, VkPipelineLayout pipelineLayout, VkPipeline& pipeline);
     VkResult CreateRenderPass(const RENDER_PASS_STATE& rtState);
     VkResult CreateFrameBuffer(const FRAME_BUFFER_STATE& frameBufferState);
+    void     SetImageDescriptor(const VULKAN_TEXTURE* texture, uint32_t slot, VkImageLayout layout);
 
     VkResult RecreateSwapChain();
 
@@ -285,26 +409,38 @@ private:
     void TermConstBuffers();
     void TermSamplers();
     void TermSwapChain();
+    void TermRecordingContexts();
+    void TermBindlessTextures();
+    //applies texture writes to the set of current context
+    void FlushBindlessTextures();
+    void TermPipelineCache();
 
     void            SetupCurrentCommandBuffer(VkCommandBuffer newCurrentBuffer);
     VkCommandBuffer BeginSingleTimeCommands();
     void            EndSingleTimeCommands(VkCommandBuffer commandBuffer);
 
     uint32_t GetDeviceCoherentValue(uint32_t bufferSize) const;
+    void     SetupUploadSharingMode(VkSharingMode& sharingMode, uint32_t& queueFamilyIndexCount, const uint32_t*& pQueueFamilyIndices) const;
 
     VkResult CreateTextureImage(const VkImageCreateInfo& imageInfo, VULKAN_TEXTURE& createdTexure);
-    VkResult CopyBufferToTexture(const VULKAN_BUFFER& buffer, VkDeviceSize bufferOffset, VULKAN_TEXTURE& texture, uint32_t mipLevel);
     VkResult CreateImageView(const VkImageViewCreateInfo& imageViewInfo, VULKAN_TEXTURE& texture);
+    VkResult CreateRenderTargetView(VULKAN_TEXTURE& texture);
+    void     FillLayoutBarrier(VkImageLayout oldLayout, VkImageLayout newLayout, const VULKAN_TEXTURE& texture,
+        VkImageMemoryBarrier& barrier, VkPipelineStageFlags& sourceStage, VkPipelineStageFlags& destinationStage) const;
 
     void     SetupSamples();
     VkResult CreateSampler(VkFilter minMagFilter, VkSamplerMipmapMode mapFilter, VkSamplerAddressMode addressMode, 
         VkCompareOp compareOp, float anisoParam, VkSampler& sampler);
     void     DestroySampler(VkSampler& sampler);
 
+    RECORDING_CONTEXT& GetCurRecordingContext();
+    void     InvalidateRecordingContextState(RECORDING_CONTEXT& context);
     bool     UpdatePiplineState();
 
     int DeviceSuitabilityRate(const VkPhysicalDevice& device) const;
     QUEUE_FAMILIES::QUEUE_FAMILY_CREATE_PARAMS FindQueueFamilies(const VkPhysicalDevice& device) const;
+    bool CheckBindlessSupport(const VkPhysicalDevice& device) const;
+    bool CheckDeviceExtentionSupport(const VkPhysicalDevice& device, const char* extentionName) const;
     SWAP_CHAIN::SWAP_CHAIN_CREATE_PARAMS GetSwapChainCreateParams(const VkPhysicalDevice& device) const;
 
     void TermDebugMessenger();
@@ -320,14 +456,18 @@ private:
     VkPhysicalDevice m_physicalDevice;
     VkDevice         m_device;
 	QUEUE_FAMILIES   m_queueFamilies;
+    std::array<uint32_t, 2> m_uploadQueueFamilyIndices;
+    //graphics queue is used by the frame and by the staging ring
+    std::mutex       m_graphicsQueueLock;
 
     VkPhysicalDeviceProperties m_deviceProperties;
     VkPhysicalDeviceFeatures   m_deviceFeatures;
 
+    VULKAN_MEMORY_ALLOCATOR m_memoryAllocator;
+
     VkSurfaceKHR                                  m_windowSurface;
     SWAP_CHAIN                                    m_swapChain;
 
-    VkCommandBuffer m_curCommandBuffer;
     VkCommandPool   m_commandPool;
 	VkCommandBuffer m_commandBuffers[NUM_FRAME_BUFFERS];
 
@@ -336,51 +476,58 @@ private:
 	VkFence     m_cpuGpuSyncFence[NUM_FRAME_BUFFERS];
     VkFence     m_waitGpuFence;
 
-    //todo:: make one buffer for everything https://developer.nvidia.com/vulkan-memory-management
-    std::array<uint32_t, NUM_CONSTANT_BUFFERS>          m_constBufferLastRecordOffset;
-    std::array<uint32_t, NUM_CONSTANT_BUFFERS>          m_constBufferOffsets;
-    std::array<VULKAN_BUFFER, NUM_CONSTANT_BUFFERS>  m_constBuffers;
+    //all const buffers live in one persistently mapped buffer, each frame context uses own region of it
+    VULKAN_BUFFER                                    m_constBuffer;
+    uint32_t                                         m_constBufferFrameSize;
+    uint32_t                                         m_constBufferAlignment;
+    std::atomic<uint32_t>                            m_constBufferFrameOffset;
+    std::array<uint32_t, EFFECT_DATA::CB_LAST>       m_constBufferLastRecordOffset;
+    //uniform buffer descriptors of each shader sorted by binding, it is the order of dynamic offsets
+    std::array<std::vector<std::pair<uint8_t, VkDescriptorBufferInfo>>, EFFECT_DATA::SHR_LAST> m_constBufferDescriptors;
     std::array<VkSampler, EFFECT_DATA::SAMPLER_LAST>              m_samplers;
 
-    //used for intermediate stage of creating texture
-    VULKAN_BUFFER m_intermediateStagingBuffer;
+    //used for uploading data to buffers and textures
+    VULKAN_BUFFER       m_stagingRingBuffer;
+    VULKAN_STAGING_RING m_stagingRing;
 
-    //todo: validate all resource descriptors at the same time
-    std::vector<std::pair<uint8_t, VkDescriptorImageInfo>>              m_curPassImageDescriptors;
-    std::vector<std::pair<uint8_t, VkDescriptorBufferInfo>>             m_curPassBufferDescriptors;
     std::array<std::pair<uint8_t, VkDescriptorImageInfo>, EFFECT_DATA::SAMPLER_LAST> m_samplerDescriptors;
 
-    uint32_t                                       m_pushConstantBufferDirtySize;
-    std::array<uint8_t, 128>                       m_pushConstantBuffer;
-    VkRect2D                                       m_dynamicScissorRect;
-    glm::vec2                                      m_dynamicBiasParams;
-
-    bool                                           m_isDynamicDepthBiasDirty;
-    bool                                           m_isDynamicScissorRectDirty;
-
-    std::array<VkDescriptorPool, NUM_FRAME_BUFFERS>                 m_descriptorPool;
+    //main context records primary command buffers, others record secondary ones on job system threads
+    RECORDING_CONTEXT                                               m_mainRecordingContext;
+    std::vector<std::unique_ptr<RECORDING_CONTEXT>>                 m_recordingContextList;
     std::array<VkDescriptorSetLayout, EFFECT_DATA::SHR_LAST>        m_descriptorSetLayout;
+    //image and storage buffer bindings of each shader, resources set for other slots are skipped
+    std::array<std::bitset<MAX_DESCRIPTOR_SLOTS>, EFFECT_DATA::SHR_LAST> m_imageDescriptorSlots;
+    std::array<std::bitset<MAX_DESCRIPTOR_SLOTS>, EFFECT_DATA::SHR_LAST> m_storageImageDescriptorSlots;
+    std::array<std::bitset<MAX_DESCRIPTOR_SLOTS>, EFFECT_DATA::SHR_LAST> m_storageBufferDescriptorSlots;
+
+    //descriptor indexing path: set with all material textures per frame context
+    bool                                                                   m_isBindlessSupported;
+    std::mutex                                                             m_bindlessLock;
+    VkDescriptorSetLayout                                                  m_bindlessSetLayout;
+    VkDescriptorPool                                                       m_bindlessDescriptorPool;
+    std::array<VkDescriptorSet, NUM_FRAME_BUFFERS>                         m_bindlessDescriptorSets;
+    //element id and view, written to the set of a context on its StartFrame
+    std::array<std::vector<std::pair<uint32_t, VkImageView>>, NUM_FRAME_BUFFERS> m_bindlessWriteList;
+
+    //VK_KHR_draw_indirect_count, device is created with 1.1 api where it isn't core
+    bool                                  m_isDrawIndirectCountSupported;
+    PFN_vkCmdDrawIndexedIndirectCountKHR  m_vkCmdDrawIndexedIndirectCount;
+    //guards caches below while secondary command buffers are recorded
+    std::mutex                                   m_cacheLock;
     std::unordered_map<size_t, VkRenderPass>     m_renderPassCache;
     std::unordered_map<size_t, VkFramebuffer>    m_frameBufferCache;
     std::unordered_map<size_t, VkPipelineLayout> m_pipelineLayoutCache;
     std::unordered_map<size_t, VkPipeline>       m_pipelineStateCache;
+    //driver cache is serialized to disk, records of created pipelines are saved with it
+    VkPipelineCache                                        m_pipelineCache;
+    std::unordered_map<size_t, PIPLINE_CACHE_RECORD>       m_pipelineRecordCache;
     
     RENDER_PASS_STATE     m_curRenderPassState;
     VkRenderPass          m_curRenderPass;
     FRAME_BUFFER_STATE    m_curFrameBufferState;
     VkFramebuffer         m_curFrameBuffer;
-    VkDescriptorSet       m_curDescriptorSet;
-    PIPLINE_LAYOUT_STATE  m_curPiplineLayoutState;
-    VkPipelineLayout      m_curPiplineLayout;
-    PIPLINE_STATE         m_curPiplineState;
-    VkPipeline            m_curPipeline;
-
-    bool                  m_updatePiplineLayout;
-    bool                  m_updatePiplineState;
-    bool                  m_updateDescriptorSet;
-    
-    VULKAN_BUFFER                m_curVertexBuffer;
-    VULKAN_BUFFER                m_curIndexBuffer;
+    bool                  m_isSecondaryRenderPass;
 
     size_t                   m_defaultRenderPassHashValue;
     VULKAN_TEXTURE           m_emptyTexture;
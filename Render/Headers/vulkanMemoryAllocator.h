@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "vulkanResourcesDescription.h"
+
+//one vkAllocateMemory call, ranges inside are placed with two level segregated fit (TLSF)
+class VULKAN_MEMORY_BLOCK
+{
+public:
+    VULKAN_MEMORY_BLOCK(VkDeviceMemory memory, VkDeviceSize size, uint32_t poolId, uint8_t* pMappedData);
+
+    bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, uint32_t& nodeId);
+    void Free(uint32_t nodeId);
+
+    VkDeviceMemory GetMemory() const { return m_memory; }
+    VkDeviceSize   GetSize() const { return m_size; }
+    uint8_t*       GetMappedData() const { return m_pMappedData; }
+    uint32_t       GetPoolId() const { return m_poolId; }
+    VkDeviceSize   GetAllocationSize(uint32_t nodeId) const { return m_nodeList[nodeId].size; }
+    bool           IsEmpty() const { return m_allocationsNum == 0; }
+private:
+    static constexpr uint32_t SL_LOG2 = 4;
+    static constexpr uint32_t SL_COUNT = 1 << SL_LOG2;
+    static constexpr uint32_t FL_COUNT = 64 - SL_LOG2 + 1;
+    static constexpr uint32_t INVALID_NODE_ID = UINT32_MAX;
+
+    struct NODE
+    {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        uint32_t     prevPhysicalId;
+        uint32_t     nextPhysicalId;
+        uint32_t     prevFreeId;
+        uint32_t     nextFreeId;
+        bool         isFree;
+    };
+
+    void     MapSize(VkDeviceSize size, uint32_t& flId, uint32_t& slId) const;
+    uint32_t FindFreeNode(VkDeviceSize size) const;
+    void     InsertFreeNode(uint32_t nodeId);
+    void     RemoveFreeNode(uint32_t nodeId);
+    uint32_t SplitNode(uint32_t nodeId, VkDeviceSize leftSize);
+    void     MergeWithNext(uint32_t nodeId);
+    uint32_t CreateNode();
+    void     ReleaseNode(uint32_t nodeId);
+
+    VkDeviceMemory m_memory;
+    VkDeviceSize   m_size;
+    uint32_t       m_poolId;
+    uint8_t*       m_pMappedData;
+
+    VkDeviceSize   m_usedSize;
+    uint32_t       m_allocationsNum;
+
+    std::vector<NODE>     m_nodeList;
+    std::vector<uint32_t> m_unusedNodeIdList;
+
+    uint64_t                                               m_flBitmap;
+    std::array<uint32_t, FL_COUNT>                         m_slBitmap;
+    std::array<std::array<uint32_t, SL_COUNT>, FL_COUNT>   m_freeListHead;
+};
+
+//sub-allocates resources from big per memory type blocks instead of a vkAllocateMemory call per resource
+class VULKAN_MEMORY_ALLOCATOR
+{
+public:
+    VULKAN_MEMORY_ALLOCATOR();
+
+    VkResult Init(VkPhysicalDevice physicalDevice, VkDevice device);
+    void     Term();
+
+    //linear resources are buffers and linear images, they never share a block with optimal images (bufferImageGranularity)
+    VkResult Allocate(const VkMemoryRequirements& memReq, uint32_t memoryTypeId, bool isLinearResource, VULKAN_MEMORY_ALLOCATION& allocation);
+    void     Free(VULKAN_MEMORY_ALLOCATION& allocation);
+    VkResult Flush(const VULKAN_MEMORY_ALLOCATION& allocation, VkDeviceSize offset, VkDeviceSize size);
+private:
+    static constexpr uint32_t POOLS_NUM = VK_MAX_MEMORY_TYPES * 2;
+
+    VkResult CreateBlock(uint32_t poolId, VkDeviceSize blockSize, VULKAN_MEMORY_BLOCK*& pBlock);
+    void     DestroyBlock(VULKAN_MEMORY_BLOCK& block);
+    bool     AllocateFromBlock(VULKAN_MEMORY_BLOCK& block, const VkMemoryRequirements& memReq, VULKAN_MEMORY_ALLOCATION& allocation);
+    VkDeviceSize GetAlignment(uint32_t poolId, VkDeviceSize alignment) const;
+
+    static uint32_t GetPoolId(uint32_t memoryTypeId, bool isLinearResource) { return memoryTypeId * 2 + (isLinearResource ? 0 : 1); }
+    static uint32_t GetMemoryTypeId(uint32_t poolId) { return poolId / 2; }
+
+    VkDevice                         m_device;
+    VkPhysicalDeviceMemoryProperties m_memoryProperties;
+    VkDeviceSize                     m_nonCoherentAtomSize;
+    std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES> m_blockSize;
+
+    mutable std::mutex                                                    m_lock;
+    std::array<std::vector<std::unique_ptr<VULKAN_MEMORY_BLOCK>>, POOLS_NUM> m_poolList;
+};
@@ -2,6 +2,25 @@
 #include "vulkan/vulkan.h"
 #include <vector>
 
+class VULKAN_MEMORY_BLOCK;
+
+//monotonic id of a staging ring batch, resource data is on gpu when its batch is done. zero means nothing to wait
+using UPLOAD_TICKET = uint64_t;
+
+//range of a device memory block, see VULKAN_MEMORY_ALLOCATOR
+struct VULKAN_MEMORY_ALLOCATION
+{
+    VULKAN_MEMORY_ALLOCATION() : memory(VK_NULL_HANDLE), offset(0), size(0), pMappedData(nullptr), pBlock(nullptr), nodeId(0) {}
+
+    VkDeviceMemory       memory;
+    VkDeviceSize         offset;
+    VkDeviceSize         size;
+    //not null for host visible memory, points to the beginning of allocation
+    uint8_t*             pMappedData;
+    VULKAN_MEMORY_BLOCK* pBlock;
+    uint32_t             nodeId;
+};
+
 struct VULKAN_TEXTURE_CREATE_DATA
 {
     VULKAN_TEXTURE_CREATE_DATA() : extent{ 0, 0, 0 }, mipLevels(0), format(VK_FORMAT_UNDEFINED), usage(VK_IMAGE_USAGE_FLAG_BITS_MAX_ENUM), pData(nullptr), dataSize(0) {}
@@ -19,7 +38,7 @@ struct VULKAN_TEXTURE_CREATE_DATA
 
 struct VULKAN_TEXTURE
 {
-    VULKAN_TEXTURE() : width(0), height(0), format(VK_FORMAT_UNDEFINED), mipLevels(0), image(VK_NULL_HANDLE), imageMemory(VK_NULL_HANDLE), imageView(VK_NULL_HANDLE) {}
+    VULKAN_TEXTURE() : width(0), height(0), format(VK_FORMAT_UNDEFINED), mipLevels(0), image(VK_NULL_HANDLE), imageMemory(), imageView(VK_NULL_HANDLE), uploadTicket(0) {}
 
     uint32_t width;
     uint32_t height;
@@ -28,12 +47,13 @@ struct VULKAN_TEXTURE
 
     VkImage image;
     VkImageView imageView;
-    VkDeviceMemory imageMemory;
+    VULKAN_MEMORY_ALLOCATION imageMemory;
+    UPLOAD_TICKET uploadTicket;
 };
 
 struct VULKAN_BUFFER
 {
-    VULKAN_BUFFER() : bufferSize(0), realBufferSize(0), buffer(), bufferMemory() {}
+    VULKAN_BUFFER() : bufferSize(0), realBufferSize(0), usage(0), buffer(), bufferMemory(), uploadTicket(0) {}
     bool operator==(const VULKAN_BUFFER& vkBuf) const {
         return buffer == vkBuf.buffer;
     }
@@ -43,8 +63,10 @@ struct VULKAN_BUFFER
 
     size_t   bufferSize;
     size_t   realBufferSize;
+    VkBufferUsageFlags usage;
     VkBuffer buffer;
-    VkDeviceMemory bufferMemory;
+    VULKAN_MEMORY_ALLOCATION bufferMemory;
+    UPLOAD_TICKET uploadTicket;
 };
 
 struct VULKAN_MESH
@@ -54,4 +76,7 @@ struct VULKAN_MESH
     VULKAN_BUFFER indexBuffer;
     size_t numOfVertexes;
     size_t numOfIndexes;
+    //position of mesh data if buffers are shared by several meshes
+    uint32_t firstIndex = 0;
+    uint32_t vertexOffset = 0;
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "vulkanResourcesDescription.h"
+
+//uploads data to gpu resources through persistently mapped ring buffer
+//copies are batched into one command buffer per submit, ring regions are reused when fence of their batch is signaled
+class VULKAN_STAGING_RING
+{
+public:
+    VULKAN_STAGING_RING();
+
+    //if transfer queue differs from graphics one, every batch is chained to graphics queue with a semaphore
+    //graphics queue lock is shared with the driver, both submit to graphics queue
+    VkResult Init(VkDevice device, const VULKAN_BUFFER& ringBuffer, uint32_t transferFamilyIndex, VkQueue transferQueue,
+        VkQueue graphicsQueue, std::mutex& graphicsQueueLock);
+    void     Term();
+
+    //can be called from any thread, returned ticket is done when data is in the resource
+    UPLOAD_TICKET UploadBuffer(const uint8_t* pData, VkDeviceSize dataSize, const VULKAN_BUFFER& dstBuffer, VkDeviceSize dstOffset);
+    UPLOAD_TICKET UploadTexture(const VULKAN_TEXTURE_CREATE_DATA& createData, const VULKAN_TEXTURE& dstTexture);
+
+    //submits recorded copies, returns ticket of submitted batch
+    UPLOAD_TICKET Submit();
+    bool          IsComplete(UPLOAD_TICKET ticket);
+    void          Wait(UPLOAD_TICKET ticket);
+private:
+    static constexpr uint32_t BATCHES_NUM = 8;
+
+    struct BATCH
+    {
+        VkCommandBuffer            commandBuffer = VK_NULL_HANDLE;
+        VkFence                    fence = VK_NULL_HANDLE;
+        VkSemaphore                semaphore = VK_NULL_HANDLE;
+        UPLOAD_TICKET              ticket = 0;
+        VkDeviceSize               ringEnd = 0;
+        //uploads which don't fit the ring get own staging buffer, it lives until batch is done
+        std::vector<VULKAN_BUFFER> tempBufferList;
+    };
+
+    BATCH&         GetRecordingBatch();
+    VULKAN_BUFFER& Reserve(VkDeviceSize size, VkDeviceSize& stagingOffset);
+    bool           TryReserveRing(VkDeviceSize size, VkDeviceSize& offset);
+    UPLOAD_TICKET  SubmitRecordingBatch();
+    void           RetireOldestBatch(bool waitFence);
+    void           RetireCompletedBatches();
+
+    VkDevice     m_device;
+    VkQueue      m_transferQueue;
+    VkQueue      m_graphicsQueue;
+    VkCommandPool m_commandPool;
+    VULKAN_BUFFER m_ringBuffer;
+    bool          m_isDedicatedTransferQueue;
+    std::mutex*   m_pGraphicsQueueLock;
+
+    std::mutex    m_lock;
+    VkDeviceSize  m_ringHead;
+    VkDeviceSize  m_ringTail;
+
+    std::array<BATCH, BATCHES_NUM> m_batchList;
+    std::deque<uint32_t>           m_inFlightBatchList;
+    uint32_t                       m_recordingBatchId;
+    bool                           m_isRecording;
+    UPLOAD_TICKET                  m_nextTicket;
+    UPLOAD_TICKET                  m_completedTicket;
+};
@@ -0,0 +1,265 @@
+#include "boundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "support.h"
+
+static const uint32_t SAH_BINS_NUM = 12;
+
+FRUSTUM::FRUSTUM(const glm::mat4x4& viewProj)
+{
+    //rows of transposed matrix are rows of viewProj
+    const glm::mat4x4 viewProjRows = glm::transpose(viewProj);
+    planes[0] = viewProjRows[3] + viewProjRows[0];
+    planes[1] = viewProjRows[3] - viewProjRows[0];
+    planes[2] = viewProjRows[3] + viewProjRows[1];
+    planes[3] = viewProjRows[3] - viewProjRows[1];
+    planes[4] = viewProjRows[2];
+    planes[5] = viewProjRows[3] - viewProjRows[2];
+}
+
+bool FRUSTUM::IsIntersected(const AABB& aabb) const
+{
+    for (const glm::vec4& plane : planes) {
+        //box corner which is the farthest along plane normal
+        const glm::vec3 farCorner = glm::mix(aabb.minPos, aabb.maxPos, glm::greaterThan(glm::vec3(plane), glm::vec3(0.f)));
+        if (glm::dot(glm::vec3(plane), farCorner) + plane.w < 0.f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool IntersectRay(const AABB& aabb, const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance, float& distance)
+{
+    const glm::vec3 t1 = (aabb.minPos - origin) * invDirection;
+    const glm::vec3 t2 = (aabb.maxPos - origin) * invDirection;
+    const glm::vec3 tMin = glm::min(t1, t2);
+    const glm::vec3 tMax = glm::max(t1, t2);
+    const float entry = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.f));
+    const float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+    distance = entry;
+    return entry <= exit;
+}
+
+void BOUNDING_VOLUME_HIERARCHY::Clear()
+{
+    m_nodeList.clear();
+    m_packetList.clear();
+    m_leafItemList.clear();
+    m_itemBoundsList.clear();
+}
+
+void BOUNDING_VOLUME_HIERARCHY::Build(const std::vector<AABB>& itemBoundsList)
+{
+    Clear();
+    if (itemBoundsList.empty()) {
+        return;
+    }
+    m_itemBoundsList = itemBoundsList;
+    m_buildItemList.resize(itemBoundsList.size());
+    std::iota(m_buildItemList.begin(), m_buildItemList.end(), 0);
+
+    m_nodeList.reserve(2 * (itemBoundsList.size() / LEAF_SIZE + 1));
+    BuildNode(0, static_cast<uint32_t>(m_buildItemList.size()));
+    m_buildItemList.clear();
+}
+
+uint32_t BOUNDING_VOLUME_HIERARCHY::BuildNode(uint32_t begin, uint32_t end)
+{
+    const uint32_t nodeId = static_cast<uint32_t>(m_nodeList.size());
+    m_nodeList.emplace_back();
+
+    AABB bounds;
+    AABB centerBounds;
+    for (uint32_t buildId = begin; buildId < end; buildId++) {
+        const AABB& itemBounds = m_itemBoundsList[m_buildItemList[buildId]];
+        const glm::vec3 center = itemBounds.GetCenter();
+        bounds.Extend(itemBounds);
+        centerBounds.Extend({ center, center });
+    }
+    m_nodeList[nodeId].bounds = bounds;
+
+    if (end - begin <= LEAF_SIZE) {
+        const uint32_t packetId = static_cast<uint32_t>(m_packetList.size());
+        m_packetList.emplace_back();
+        m_leafItemList.resize(m_leafItemList.size() + LEAF_SIZE, INVALID_ID);
+        for (uint32_t buildId = begin; buildId < end; buildId++) {
+            m_leafItemList[packetId * LEAF_SIZE + buildId - begin] = m_buildItemList[buildId];
+        }
+        m_nodeList[nodeId].rightChildOrPacketId = packetId;
+        m_nodeList[nodeId].itemsNum = end - begin;
+        UpdateLeafPacket(nodeId);
+        return nodeId;
+    }
+
+    uint32_t middle = begin;
+    int splitAxis;
+    float splitPos;
+    if (FindSplit(begin, end, centerBounds, splitAxis, splitPos)) {
+        auto middleIt = std::partition(m_buildItemList.begin() + begin, m_buildItemList.begin() + end, [this, splitAxis, splitPos](uint32_t itemId) {
+            return m_itemBoundsList[itemId].GetCenter()[splitAxis] < splitPos;
+        });
+        middle = static_cast<uint32_t>(middleIt - m_buildItemList.begin());
+    }
+    //all centers are in one point or split puts everything to one side
+    if (middle == begin || middle == end) {
+        middle = begin + (end - begin) / 2;
+    }
+
+    m_nodeList[nodeId].itemsNum = 0;
+    BuildNode(begin, middle);
+    const uint32_t rightChildId = BuildNode(middle, end);
+    m_nodeList[nodeId].rightChildOrPacketId = rightChildId;
+    return nodeId;
+}
+
+bool BOUNDING_VOLUME_HIERARCHY::FindSplit(uint32_t begin, uint32_t end, const AABB& centerBounds, int& splitAxis, float& splitPos) const
+{
+    //cost of split is sum of children surface areas weighted by their items number
+    float bestCost = FLT_MAX;
+    bool isSplitFound = false;
+    for (int axis = 0; axis < 3; axis++) {
+        const float axisMin = centerBounds.minPos[axis];
+        const float axisMax = centerBounds.maxPos[axis];
+        if (axisMax <= axisMin) {
+            continue;
+        }
+        const float binScale = SAH_BINS_NUM / (axisMax - axisMin);
+
+        std::array<AABB, SAH_BINS_NUM>     binBounds;
+        std::array<uint32_t, SAH_BINS_NUM> binItemsNum = {};
+        for (uint32_t buildId = begin; buildId < end; buildId++) {
+            const AABB& itemBounds = m_itemBoundsList[m_buildItemList[buildId]];
+            const uint32_t binId = std::min(static_cast<uint32_t>((itemBounds.GetCenter()[axis] - axisMin) * binScale), SAH_BINS_NUM - 1);
+            binBounds[binId].Extend(itemBounds);
+            binItemsNum[binId]++;
+        }
+
+        std::array<float, SAH_BINS_NUM - 1> leftCost;
+        AABB leftBounds;
+        uint32_t leftItemsNum = 0;
+        for (uint32_t binId = 0; binId < SAH_BINS_NUM - 1; binId++) {
+            leftBounds.Extend(binBounds[binId]);
+            leftItemsNum += binItemsNum[binId];
+            leftCost[binId] = leftBounds.GetSurfaceArea() * leftItemsNum;
+        }
+        AABB rightBounds;
+        uint32_t rightItemsNum = 0;
+        for (uint32_t binId = SAH_BINS_NUM - 1; binId > 0; binId--) {
+            rightBounds.Extend(binBounds[binId]);
+            rightItemsNum += binItemsNum[binId];
+            const float cost = leftCost[binId - 1] + rightBounds.GetSurfaceArea() * rightItemsNum;
+            if (cost < bestCost) {
+                bestCost = cost;
+                splitAxis = axis;
+                splitPos = axisMin + binId / binScale;
+                isSplitFound = true;
+            }
+        }
+    }
+    return isSplitFound;
+}
+
+void BOUNDING_VOLUME_HIERARCHY::UpdateLeafPacket(uint32_t nodeId)
+{
+    const NODE& node = m_nodeList[nodeId];
+    ASSERT(node.IsLeaf());
+
+    alignas(16) std::array<std::array<float, LEAF_SIZE>, 6> packetData = {};
+    for (uint32_t lane = 0; lane < node.itemsNum; lane++) {
+        const AABB& itemBounds = m_itemBoundsList[m_leafItemList[node.rightChildOrPacketId * LEAF_SIZE + lane]];
+        const glm::vec3 center = itemBounds.GetCenter();
+        const glm::vec3 extent = itemBounds.GetExtent();
+        for (int axis = 0; axis < 3; axis++) {
+            packetData[axis][lane] = center[axis];
+            packetData[3 + axis][lane] = extent[axis];
+        }
+    }
+
+    BOUNDS_PACKET& packet = m_packetList[node.rightChildOrPacketId];
+    packet.centerX = _mm_load_ps(packetData[0].data());
+    packet.centerY = _mm_load_ps(packetData[1].data());
+    packet.centerZ = _mm_load_ps(packetData[2].data());
+    packet.extentX = _mm_load_ps(packetData[3].data());
+    packet.extentY = _mm_load_ps(packetData[4].data());
+    packet.extentZ = _mm_load_ps(packetData[5].data());
+}
+
+int BOUNDING_VOLUME_HIERARCHY::TestPacket(const BOUNDS_PACKET& packet, const FRUSTUM& frustum, uint32_t planeMask) const
+{
+    //box is outside if it is behind any plane even with its extent projected to the plane normal
+    const __m128 zero = _mm_setzero_ps();
+    __m128 isInside = _mm_cmpeq_ps(zero, zero);
+    for (uint32_t planeId = 0; planeId < FRUSTUM::PLANES_NUM; planeId++) {
+        if ((planeMask & (1 << planeId)) == 0) {
+            continue;
+        }
+        const glm::vec4& plane = frustum.planes[planeId];
+        __m128 distance = _mm_mul_ps(packet.centerX, _mm_set1_ps(plane.x));
+        distance = _mm_add_ps(distance, _mm_mul_ps(packet.centerY, _mm_set1_ps(plane.y)));
+        distance = _mm_add_ps(distance, _mm_mul_ps(packet.centerZ, _mm_set1_ps(plane.z)));
+        distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+
+        __m128 radius = _mm_mul_ps(packet.extentX, _mm_set1_ps(std::abs(plane.x)));
+        radius = _mm_add_ps(radius, _mm_mul_ps(packet.extentY, _mm_set1_ps(std::abs(plane.y))));
+        radius = _mm_add_ps(radius, _mm_mul_ps(packet.extentZ, _mm_set1_ps(std::abs(plane.z))));
+
+        isInside = _mm_and_ps(isInside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+    }
+    return _mm_movemask_ps(isInside);
+}
+
+bool BOUNDING_VOLUME_HIERARCHY::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t& hitItemId, float& hitDistance) const
+{
+    hitItemId = INVALID_ID;
+    hitDistance = maxDistance;
+    if (m_nodeList.empty()) {
+        return false;
+    }
+    const glm::vec3 invDirection = 1.f / direction;
+
+    std::vector<uint32_t> nodeStack;
+    nodeStack.push_back(0);
+    while (!nodeStack.empty()) {
+        const uint32_t nodeId = nodeStack.back();
+        nodeStack.pop_back();
+
+        //hit distance could become smaller since the node was pushed
+        const NODE& node = m_nodeList[nodeId];
+        float nodeDistance;
+        if (!IntersectRay(node.bounds, origin, invDirection, hitDistance, nodeDistance)) {
+            continue;
+        }
+
+        if (!node.IsLeaf()) {
+            //nearer child is popped first
+            const uint32_t leftChildId = nodeId + 1;
+            const uint32_t rightChildId = node.rightChildOrPacketId;
+            float leftDistance, rightDistance;
+            const bool isLeftHit = IntersectRay(m_nodeList[leftChildId].bounds, origin, invDirection, hitDistance, leftDistance);
+            const bool isRightHit = IntersectRay(m_nodeList[rightChildId].bounds, origin, invDirection, hitDistance, rightDistance);
+            if (isLeftHit && isRightHit) {
+                nodeStack.push_back(leftDistance < rightDistance ? rightChildId : leftChildId);
+                nodeStack.push_back(leftDistance < rightDistance ? leftChildId : rightChildId);
+            } else if (isLeftHit) {
+                nodeStack.push_back(leftChildId);
+            } else if (isRightHit) {
+                nodeStack.push_back(rightChildId);
+            }
+            continue;
+        }
+
+        for (uint32_t lane = 0; lane < node.itemsNum; lane++) {
+            const uint32_t itemId = m_leafItemList[node.rightChildOrPacketId * LEAF_SIZE + lane];
+            float itemDistance;
+            if (IntersectRay(m_itemBoundsList[itemId], origin, invDirection, hitDistance, itemDistance) &&
+                (hitItemId == INVALID_ID || itemDistance < hitDistance)) {
+                hitItemId = itemId;
+                hitDistance = itemDistance;
+            }
+        }
+    }
+    return hitItemId != INVALID_ID;
+}
@@ -0,0 +1,245 @@
+#include "gpuCullingSystem.h"
+
+#include "boundingVolumeHierarchy.h"
+#include "geometry.h"
+#include "renderPassHiZ.h"
+#include "renderTargetManager.h"
+#include "resourceSystem.h"
+
+#include "Components/rendered.h"
+
+bool GPU_CULLING_SYSTEM::Init()
+{
+    ECS::pEcsCoordinator->SubscrubeSystemToComponentType<RENDERED_COMPONENT>(this);
+    ECS::pEcsCoordinator->SubscrubeSystemToComponentType<MESH_PRIMITIVE>(this);
+    m_isEnabled = pDrvInterface->IsGpuDrivenSupported();
+    return true;
+}
+
+void GPU_CULLING_SYSTEM::Term()
+{
+    for (FRAME_DATA& frameData : m_frameDataList) {
+        DestroyFrameBuffers(frameData);
+    }
+}
+
+void GPU_CULLING_SYSTEM::AddEntity(ECS::ENTITY_TYPE entityId)
+{
+    ECS::SYSTEM<GPU_CULLING_SYSTEM>::AddEntity(entityId);
+    m_isInstanceListDirty = true;
+}
+
+void GPU_CULLING_SYSTEM::RemoveEntity(ECS::ENTITY_TYPE entityId)
+{
+    ECS::SYSTEM<GPU_CULLING_SYSTEM>::RemoveEntity(entityId);
+    m_isInstanceListDirty = true;
+}
+
+void GPU_CULLING_SYSTEM::UpdateInstanceList()
+{
+    m_instanceDataList.clear();
+    for (ECS::ENTITY_TYPE entity : m_entityList) {
+        const MESH_PRIMITIVE* pMeshPrimitive = ECS::pEcsCoordinator->GetComponent<MESH_PRIMITIVE>(entity);
+        const VULKAN_MESH* pMesh = pMeshPrimitive->pMesh;
+        //one indirect draw can take only meshes from shared buffers
+        if (pMesh->numOfIndexes == 0 || pMesh->indexBuffer != pResourceSystem->GetSharedIndexBuffer()) {
+            continue;
+        }
+        GPU_INSTANCE_DATA instanceData = {};
+        //primitives are drawn without node transforms, as on cpu path
+        instanceData.modelMatrix = glm::mat4x4(1.f);
+        instanceData.aabbMin = pMeshPrimitive->aabb.minPos;
+        instanceData.aabbMax = pMeshPrimitive->aabb.maxPos;
+        instanceData.indexesNum = static_cast<uint32_t>(pMesh->numOfIndexes);
+        instanceData.firstIndex = pMesh->firstIndex;
+        instanceData.vertexOffset = pMesh->vertexOffset;
+        instanceData.materialId = pMeshPrimitive->pMaterial->materialId;
+        m_instanceDataList.push_back(instanceData);
+    }
+
+    for (FRAME_DATA& frameData : m_frameDataList) {
+        frameData.isInstanceBufferDirty = true;
+    }
+    m_isInstanceListDirty = false;
+}
+
+void GPU_CULLING_SYSTEM::UpdateFrameData(FRAME_DATA& frameData)
+{
+    if (m_isInstanceListDirty) {
+        UpdateInstanceList();
+    }
+    if (!frameData.isInstanceBufferDirty) {
+        return;
+    }
+    const uint32_t instancesNum = static_cast<uint32_t>(m_instanceDataList.size());
+    if (instancesNum > frameData.instancesCapacity) {
+        DestroyFrameBuffers(frameData);
+        if (CreateFrameBuffers(frameData, instancesNum) != VK_SUCCESS) {
+            m_isEnabled = false;
+            return;
+        }
+        //disoccluded phase reads flags before the first phase writes them, when pyramid becomes valid during the frame
+        pDrvInterface->ClearBuffer(frameData.occludedBuffer);
+        pDrvInterface->BufferBarrier(frameData.occludedBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    }
+    if (instancesNum) {
+        pDrvInterface->UploadBuffer((const uint8_t*)m_instanceDataList.data(), instancesNum * sizeof(GPU_INSTANCE_DATA), 0, frameData.instanceBuffer);
+    }
+    frameData.isInstanceBufferDirty = false;
+}
+
+VkResult GPU_CULLING_SYSTEM::CreateFrameBuffers(FRAME_DATA& frameData, uint32_t instancesCapacity)
+{
+    VkBufferCreateInfo instanceBufferInfo = {};
+    instanceBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    instanceBufferInfo.size = instancesCapacity * sizeof(GPU_INSTANCE_DATA);
+    instanceBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    instanceBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkResult result = pDrvInterface->CreateBuffer(instanceBufferInfo, false, frameData.instanceBuffer);
+    if (result != VK_SUCCESS) {
+        ERROR_MSG("Instance buffer not created!");
+        return result;
+    }
+
+    VkBufferCreateInfo occludedBufferInfo = instanceBufferInfo;
+    occludedBufferInfo.size = instancesCapacity * sizeof(uint32_t);
+    occludedBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    result = pDrvInterface->CreateBuffer(occludedBufferInfo, false, frameData.occludedBuffer);
+    if (result != VK_SUCCESS) {
+        ERROR_MSG("Occluded instances buffer not created!");
+        return result;
+    }
+
+    //commands are written by culling shader, count is reset by transfer before it
+    VkBufferCreateInfo commandBufferInfo = {};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    commandBufferInfo.size = instancesCapacity * sizeof(VkDrawIndexedIndirectCommand);
+    commandBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    commandBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBufferCreateInfo countBufferInfo = commandBufferInfo;
+    countBufferInfo.size = sizeof(uint32_t);
+
+    for (uint32_t view = 0; view < GPU_VIEW_LAST; view++) {
+        result = pDrvInterface->CreateBuffer(commandBufferInfo, false, frameData.drawCommandBuffer[view]);
+        if (result != VK_SUCCESS) {
+            ERROR_MSG("Draw command buffer not created!");
+            return result;
+        }
+        result = pDrvInterface->CreateBuffer(countBufferInfo, false, frameData.drawCountBuffer[view]);
+        if (result != VK_SUCCESS) {
+            ERROR_MSG("Draw count buffer not created!");
+            return result;
+        }
+    }
+    frameData.instancesCapacity = instancesCapacity;
+    return VK_SUCCESS;
+}
+
+void GPU_CULLING_SYSTEM::DestroyFrameBuffers(FRAME_DATA& frameData)
+{
+    if (frameData.instancesCapacity == 0) {
+        return;
+    }
+    pDrvInterface->DestroyBuffer(frameData.instanceBuffer);
+    pDrvInterface->DestroyBuffer(frameData.occludedBuffer);
+    for (uint32_t view = 0; view < GPU_VIEW_LAST; view++) {
+        pDrvInterface->DestroyBuffer(frameData.drawCommandBuffer[view]);
+        pDrvInterface->DestroyBuffer(frameData.drawCountBuffer[view]);
+    }
+    frameData.instancesCapacity = 0;
+}
+
+void GPU_CULLING_SYSTEM::CullInstances(GPU_CULLING_VIEW view, const glm::mat4x4& viewProj)
+{
+    FRAME_DATA& frameData = m_frameDataList[pDrvInterface->GetCurContextId()];
+    UpdateFrameData(frameData);
+    const uint32_t instancesNum = static_cast<uint32_t>(m_instanceDataList.size());
+    if (!m_isEnabled || instancesNum == 0) {
+        return;
+    }
+    const VULKAN_BUFFER& drawCommandBuffer = frameData.drawCommandBuffer[view];
+    const VULKAN_BUFFER& drawCountBuffer = frameData.drawCountBuffer[view];
+
+    //without draw count all commands are drawn, so ones after the culled count must be empty
+    const bool isDrawCountSupported = pDrvInterface->IsDrawIndirectCountSupported();
+    pDrvInterface->ClearBuffer(drawCountBuffer);
+    pDrvInterface->BufferBarrier(drawCountBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    if (!isDrawCountSupported) {
+        pDrvInterface->ClearBuffer(drawCommandBuffer);
+        pDrvInterface->BufferBarrier(drawCommandBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    }
+
+    EFFECT_DATA::CB_CULLING_STRUCT cullingData;
+    const FRUSTUM frustum(viewProj);
+    std::copy(frustum.planes.begin(), frustum.planes.end(), cullingData.frustumPlanes);
+    cullingData.instancesNum = instancesNum;
+    cullingData.flags = 0;
+
+    //shader expects all slots to be set, pyramid is bound even if it isn't tested
+    RENDER_PASS_HI_Z* pHiZPass = ECS::pEcsCoordinator->GetSystem<RENDER_PASS_HI_Z>();
+    const bool isPyramidValid = pHiZPass->IsPyramidValid();
+    if (isPyramidValid) {
+        cullingData.hiZViewProj = pHiZPass->GetPyramidViewProj();
+        cullingData.hiZSize = pHiZPass->GetPyramidBaseSize();
+        if (view == GPU_VIEW_GAME_CAMERA) {
+            cullingData.flags |= CULLING_FLAG_OCCLUSION;
+        }
+    }
+    if (view == GPU_VIEW_GAME_CAMERA) {
+        cullingData.flags |= CULLING_FLAG_WRITE_OCCLUDED;
+    }
+    if (view == GPU_VIEW_GAME_CAMERA_DISOCCLUDED) {
+        ASSERT_MSG(isPyramidValid, "Pyramid must be built before disoccluded instances are culled!");
+        cullingData.flags |= CULLING_FLAG_OCCLUSION | CULLING_FLAG_ONLY_OCCLUDED;
+        //results of GPU_VIEW_GAME_CAMERA culling
+        pDrvInterface->BufferBarrier(frameData.occludedBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    }
+    pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_CULLING, &cullingData, sizeof(cullingData));
+
+    pDrvInterface->SetShader(EFFECT_DATA::SHR_GPU_CULLING);
+    pDrvInterface->SetStorageBuffer(frameData.instanceBuffer, INSTANCE_BUFFER_SLOT);
+    pDrvInterface->SetStorageBuffer(drawCommandBuffer, DRAW_COMMAND_BUFFER_SLOT);
+    pDrvInterface->SetStorageBuffer(drawCountBuffer, DRAW_COUNT_BUFFER_SLOT);
+    pDrvInterface->SetStorageBuffer(frameData.occludedBuffer, OCCLUDED_BUFFER_SLOT);
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_CULLING);
+    pHiZPass->SetPyramidAsSRV(HI_Z_FIRST_SLOT);
+    pDrvInterface->Dispatch((instancesNum + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE);
+    pRenderTargetManager->ReturnAllRenderTargetsToPool();
+
+    pDrvInterface->BufferBarrier(drawCommandBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+    pDrvInterface->BufferBarrier(drawCountBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+}
+
+void GPU_CULLING_SYSTEM::AddCullingResources(std::vector<RENDER_GRAPH_RESOURCE>& resourceList) const
+{
+    if (!m_isEnabled) {
+        return;
+    }
+    //pyramid is bound even if it isn't tested
+    for (uint32_t levelId = 0; levelId < HI_Z_LEVELS_NUM; levelId++) {
+        resourceList.push_back({ RENDER_TARGET_ID(RT_HI_Z_0 + levelId), RG_ACCESS_SRV });
+    }
+}
+
+void GPU_CULLING_SYSTEM::DrawInstances(GPU_CULLING_VIEW view)
+{
+    const FRAME_DATA& frameData = m_frameDataList[pDrvInterface->GetCurContextId()];
+    const uint32_t instancesNum = static_cast<uint32_t>(m_instanceDataList.size());
+    if (!m_isEnabled || instancesNum == 0) {
+        return;
+    }
+    ASSERT_MSG(!frameData.isInstanceBufferDirty, "Instances must be culled before drawing!");
+
+    pDrvInterface->SetStorageBuffer(frameData.instanceBuffer, INSTANCE_BUFFER_SLOT);
+    pDrvInterface->SetVertexFormat(SIMPLE_VERTEX::formatId);
+    pDrvInterface->SetVertexBuffer(pResourceSystem->GetSharedVertexBuffer(), 0);
+    pDrvInterface->SetIndexBuffer(pResourceSystem->GetSharedIndexBuffer(), 0);
+    pDrvInterface->DrawIndexedIndirect(frameData.drawCommandBuffer[view], frameData.drawCountBuffer[view], instancesNum);
+}
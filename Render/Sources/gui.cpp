@@ -20,6 +20,7 @@
 #include "windowSystem.h"
 
 #include "resourceSystem.h"
+#include "renderGraph.h"
 #include "renderTargetManager.h"
 
 static GLFWwindow* g_Window = NULL;    // Main window
@@ -41,6 +42,9 @@ struct GUI_SHADER_PUSH_CONST_DATA
 };
 
 bool GUI_SYSTEM::Init() {
+    //imgui and glfw must be used from the main thread, interface also adds components to lights
+    DeclareExclusiveAccess();
+
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGui::StyleColorsDark();
@@ -181,6 +185,16 @@ void GUI_SYSTEM::Update() {
     ImGui::Render();
 }
 
+void GUI_SYSTEM::AddToRenderGraph(RENDER_GRAPH& renderGraph)
+{
+    //gui is drawn over resolved frame
+    std::vector<RENDER_GRAPH_RESOURCE> resourceList = { { RT_BACK_BUFFER, RG_ACCESS_RENDER_TARGET, true } };
+    if (m_debugRT != RT_LAST && m_debugRT != RT_BACK_BUFFER) {
+        resourceList.push_back({ (RENDER_TARGET_ID)m_debugRT, RG_ACCESS_SRV });
+    }
+    renderGraph.AddPass("gui", resourceList, [this]() { Render(); });
+}
+
 void GUI_SYSTEM::Render() {
     ImDrawData* draw_data = ImGui::GetDrawData();
 
@@ -516,6 +530,7 @@ void GUI_SYSTEM::DescribeInterface()
     ImGui::Separator();
     if (ImGui::CollapsingHeader("SSAO params")) {
         ImGui::Checkbox("Turn off ssao", &gSSAODebugVariables.turnOffSSAO);
+        ImGui::Combo("Resolution", &gSSAODebugVariables.resolution, "Full\0Half\0Quarter\0");
         ImGui::SliderFloat("Bias", &gSSAODebugVariables.bias, 0.001f, 0.5f, "%.3f");
         ImGui::SliderFloat("Radius", &gSSAODebugVariables.radius, 0.1f, 10.0f);
     }
@@ -0,0 +1,164 @@
+#include "lightClusteringSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "commonRenderVariables.h"
+#include "renderGraph.h"
+
+#include "Components/camera.h"
+#include "Components/lightSource.h"
+#include "Components/transformation.h"
+
+bool LIGHT_CLUSTERING_SYSTEM::Init()
+{
+    for (FRAME_DATA& frameData : m_frameDataList) {
+        if (CreateClusterBuffers(frameData) != VK_SUCCESS || CreateLightBuffer(frameData, MIN_LIGHTS_CAPACITY) != VK_SUCCESS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LIGHT_CLUSTERING_SYSTEM::Term()
+{
+    for (FRAME_DATA& frameData : m_frameDataList) {
+        DestroyFrameBuffers(frameData);
+    }
+}
+
+void LIGHT_CLUSTERING_SYSTEM::AddToRenderGraph(RENDER_GRAPH& renderGraph)
+{
+    //cluster buffers aren't tracked by the graph, so the pass is never culled
+    renderGraph.AddPass("light clustering", {}, [this]() { BuildClusters(); }, true);
+}
+
+void LIGHT_CLUSTERING_SYSTEM::GatherLights()
+{
+    //areaLight of point and spot lights is radius of their influence
+    m_lightDataList.clear();
+    for (auto [lightEntity, light, transform] : ECS::pEcsCoordinator->GetView<POINT_LIGHT_COMPONENT, TRANSFORM_COMPONENT>()) {
+        GPU_LIGHT_DATA lightData;
+        lightData.position = transform.position;
+        lightData.radius = light.areaLight;
+        lightData.radiance = light.color * light.intensity;
+        lightData.direction = glm::vec3(0.f, 0.f, 1.f);
+        lightData.spotScale = 0.f;
+        lightData.spotOffset = 1.f;
+        m_lightDataList.push_back(lightData);
+    }
+    for (auto [lightEntity, light, transform] : ECS::pEcsCoordinator->GetView<SPOT_LIGHT_COMPONENT, TRANSFORM_COMPONENT>()) {
+        const float cosInner = std::cos(light.innerConeAngle);
+        const float cosOuter = std::cos(light.outerConeAngle);
+        GPU_LIGHT_DATA lightData;
+        lightData.position = transform.position;
+        lightData.radius = light.areaLight;
+        lightData.radiance = light.color * light.intensity;
+        lightData.direction = glm::normalize(light.direction);
+        lightData.spotScale = 1.f / std::max(cosInner - cosOuter, 0.001f);
+        lightData.spotOffset = -cosOuter * lightData.spotScale;
+        m_lightDataList.push_back(lightData);
+    }
+}
+
+void LIGHT_CLUSTERING_SYSTEM::BuildClusters()
+{
+    GatherLights();
+
+    FRAME_DATA& frameData = m_frameDataList[pDrvInterface->GetCurContextId()];
+    const uint32_t lightsNum = static_cast<uint32_t>(m_lightDataList.size());
+    if (lightsNum > frameData.lightsCapacity) {
+        const uint32_t lightsCapacity = std::max(lightsNum, 2 * frameData.lightsCapacity);
+        pDrvInterface->DestroyBuffer(frameData.lightBuffer);
+        if (CreateLightBuffer(frameData, lightsCapacity) != VK_SUCCESS) {
+            return;
+        }
+    }
+    if (lightsNum) {
+        pDrvInterface->FillBuffer((const uint8_t*)m_lightDataList.data(), lightsNum * sizeof(GPU_LIGHT_DATA), 0, frameData.lightBuffer);
+    }
+
+    const CAMERA_COMPONENT* pCamera = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera);
+    const float depthRangeLog = std::log(pCamera->farPlane / pCamera->nearPlane);
+
+    EFFECT_DATA::CB_LIGHT_CLUSTERS_STRUCT clustersData;
+    clustersData.view = pCamera->viewMatrix;
+    clustersData.projInv = glm::inverse(pCamera->projMatrix);
+    clustersData.clustersNum = glm::uvec3(CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z);
+    clustersData.lightsNum = lightsNum;
+    clustersData.sliceScaleBias = glm::vec2(CLUSTERS_Z / depthRangeLog, -(CLUSTERS_Z * std::log(pCamera->nearPlane)) / depthRangeLog);
+    clustersData.nearPlane = pCamera->nearPlane;
+    clustersData.farPlane = pCamera->farPlane;
+    pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_LIGHT_CLUSTERS, &clustersData, EFFECT_DATA::CONST_BUFFERS_SIZE[EFFECT_DATA::CB_LIGHT_CLUSTERS]);
+
+    pDrvInterface->SetShader(EFFECT_DATA::SHR_LIGHT_CLUSTERING);
+    pDrvInterface->SetStorageBuffer(frameData.lightBuffer, LIGHT_BUFFER_SLOT);
+    pDrvInterface->SetStorageBuffer(frameData.clusterLightsNumBuffer, CLUSTER_LIGHTS_NUM_BUFFER_SLOT);
+    pDrvInterface->SetStorageBuffer(frameData.clusterLightListBuffer, CLUSTER_LIGHT_LIST_BUFFER_SLOT);
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_LIGHT_CLUSTERS);
+    pDrvInterface->Dispatch((CLUSTERS_NUM + CLUSTERING_GROUP_SIZE - 1) / CLUSTERING_GROUP_SIZE);
+
+    pDrvInterface->BufferBarrier(frameData.clusterLightsNumBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    pDrvInterface->BufferBarrier(frameData.clusterLightListBuffer, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+void LIGHT_CLUSTERING_SYSTEM::SetClustersAsSRV()
+{
+    const FRAME_DATA& frameData = m_frameDataList[pDrvInterface->GetCurContextId()];
+    pDrvInterface->SetStorageBuffer(frameData.lightBuffer, LIGHT_BUFFER_SLOT);
+    pDrvInterface->SetStorageBuffer(frameData.clusterLightsNumBuffer, CLUSTER_LIGHTS_NUM_BUFFER_SLOT);
+    pDrvInterface->SetStorageBuffer(frameData.clusterLightListBuffer, CLUSTER_LIGHT_LIST_BUFFER_SLOT);
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_LIGHT_CLUSTERS);
+}
+
+VkResult LIGHT_CLUSTERING_SYSTEM::CreateLightBuffer(FRAME_DATA& frameData, uint32_t lightsCapacity)
+{
+    VkBufferCreateInfo lightBufferInfo = {};
+    lightBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    lightBufferInfo.size = lightsCapacity * sizeof(GPU_LIGHT_DATA);
+    lightBufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    lightBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkResult result = pDrvInterface->CreateBuffer(lightBufferInfo, true, frameData.lightBuffer);
+    if (result != VK_SUCCESS) {
+        ERROR_MSG("Light buffer not created!");
+        return result;
+    }
+    frameData.lightsCapacity = lightsCapacity;
+    return VK_SUCCESS;
+}
+
+VkResult LIGHT_CLUSTERING_SYSTEM::CreateClusterBuffers(FRAME_DATA& frameData)
+{
+    //both are written by clustering shader only
+    VkBufferCreateInfo clusterBufferInfo = {};
+    clusterBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    clusterBufferInfo.size = CLUSTERS_NUM * sizeof(uint32_t);
+    clusterBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    clusterBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkResult result = pDrvInterface->CreateBuffer(clusterBufferInfo, false, frameData.clusterLightsNumBuffer);
+    if (result != VK_SUCCESS) {
+        ERROR_MSG("Cluster lights number buffer not created!");
+        return result;
+    }
+
+    clusterBufferInfo.size = CLUSTERS_NUM * MAX_CLUSTER_LIGHTS * sizeof(uint32_t);
+    result = pDrvInterface->CreateBuffer(clusterBufferInfo, false, frameData.clusterLightListBuffer);
+    if (result != VK_SUCCESS) {
+        ERROR_MSG("Cluster light list buffer not created!");
+        return result;
+    }
+    return VK_SUCCESS;
+}
+
+void LIGHT_CLUSTERING_SYSTEM::DestroyFrameBuffers(FRAME_DATA& frameData)
+{
+    if (frameData.lightsCapacity == 0) {
+        return;
+    }
+    pDrvInterface->DestroyBuffer(frameData.lightBuffer);
+    pDrvInterface->DestroyBuffer(frameData.clusterLightsNumBuffer);
+    pDrvInterface->DestroyBuffer(frameData.clusterLightListBuffer);
+    frameData.lightsCapacity = 0;
+}
@@ -0,0 +1,483 @@
+#include "meshCooker.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "geometry.h"
+#include "materialManager.h"
+#include "textureCooker.h"
+
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_STB_IMAGE
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#define TINYGLTF_NO_EXTERNAL_IMAGE
+#define TINYGLTF_NOEXCEPTION
+#define JSON_NOEXCEPTION
+#include "tiny_gltf.h"
+
+//packages cooked by previous versions are cooked again after it is changed
+static const uint32_t MESH_COOKER_VERSION = 2;
+//gltf models are authored in centimeters
+static const float MESH_POSITION_SCALE = 0.1f;
+
+static const std::array<size_t, MESH_PACKAGE_SECTIONS_NUM> SECTION_ELEMENT_SIZES = {
+    sizeof(MESH_PACKAGE_SOURCE_FILE),
+    sizeof(MESH_PACKAGE_IMAGE),
+    sizeof(MESH_PACKAGE_MATERIAL),
+    sizeof(MESH_PACKAGE_MESH_HOLDER),
+    sizeof(MESH_PACKAGE_PRIMITIVE),
+    sizeof(MESH_PACKAGE_NODE),
+    sizeof(SIMPLE_VERTEX),
+    sizeof(uint16_t),
+    sizeof(char),
+};
+
+static uint64_t AlignPackageOffset(uint64_t offset)
+{
+    return (offset + MESH_PACKAGE_ALIGNMENT - 1) & ~uint64_t(MESH_PACKAGE_ALIGNMENT - 1);
+}
+
+static bool GetSourceFileInfo(const std::string& path, uint64_t& fileSize, int64_t& writeTime)
+{
+    std::error_code fileError;
+    fileSize = std::filesystem::file_size(path, fileError);
+    if (fileError) {
+        return false;
+    }
+    writeTime = std::filesystem::last_write_time(path, fileError).time_since_epoch().count();
+    return !fileError;
+}
+
+static bool IsPackageStringValid(const MESH_PACKAGE_HEADER& header, const MESH_PACKAGE_STRING& string)
+{
+    return uint64_t(string.offset) + string.length <= header.sectionSizes[MESH_PACKAGE_STRINGS];
+}
+
+//-1 is allowed by tables which reference optional elements
+static bool IsPackageIdValid(const MESH_PACKAGE_HEADER& header, MESH_PACKAGE_SECTION section, int32_t id)
+{
+    return id == -1 || (id >= 0 && uint32_t(id) < header.sectionSizes[section]);
+}
+
+static bool IsPackageRangeValid(const MESH_PACKAGE_HEADER& header, MESH_PACKAGE_SECTION section, uint32_t first, uint32_t num)
+{
+    return uint64_t(first) + num <= header.sectionSizes[section];
+}
+
+bool IsMeshPackageUpToDate(const uint8_t* pPackageData, size_t packageSize)
+{
+    if (packageSize < sizeof(MESH_PACKAGE_HEADER)) {
+        return false;
+    }
+    const MESH_PACKAGE_HEADER& header = *reinterpret_cast<const MESH_PACKAGE_HEADER*>(pPackageData);
+    if (header.magic != MESH_PACKAGE_MAGIC || header.version != MESH_COOKER_VERSION) {
+        return false;
+    }
+    for (uint32_t sectionId = 0; sectionId < MESH_PACKAGE_SECTIONS_NUM; sectionId++) {
+        const uint64_t sectionOffset = header.sectionOffsets[sectionId];
+        if (sectionOffset % MESH_PACKAGE_ALIGNMENT || sectionOffset + header.sectionSizes[sectionId] * SECTION_ELEMENT_SIZES[sectionId] > packageSize) {
+            return false;
+        }
+    }
+
+    const MESH_PACKAGE_IMAGE* pImageList = GetMeshPackageSection<MESH_PACKAGE_IMAGE>(pPackageData, MESH_PACKAGE_IMAGES);
+    for (uint32_t imageId = 0; imageId < header.sectionSizes[MESH_PACKAGE_IMAGES]; imageId++) {
+        if (!IsPackageStringValid(header, pImageList[imageId].uri)) {
+            return false;
+        }
+    }
+    //tables are used by the loader without checks, so every reference must stay inside its section
+    const MESH_PACKAGE_MATERIAL* pMaterialList = GetMeshPackageSection<MESH_PACKAGE_MATERIAL>(pPackageData, MESH_PACKAGE_MATERIALS);
+    for (uint32_t materialId = 0; materialId < header.sectionSizes[MESH_PACKAGE_MATERIALS]; materialId++) {
+        const MESH_PACKAGE_MATERIAL& material = pMaterialList[materialId];
+        for (int32_t imageId : { material.albedoImageId, material.metalRoughnessImageId, material.normalImageId, material.emissiveImageId }) {
+            if (!IsPackageIdValid(header, MESH_PACKAGE_IMAGES, imageId)) {
+                return false;
+            }
+        }
+    }
+    const MESH_PACKAGE_MESH_HOLDER* pMeshHolderList = GetMeshPackageSection<MESH_PACKAGE_MESH_HOLDER>(pPackageData, MESH_PACKAGE_MESH_HOLDERS);
+    for (uint32_t meshHolderId = 0; meshHolderId < header.sectionSizes[MESH_PACKAGE_MESH_HOLDERS]; meshHolderId++) {
+        const MESH_PACKAGE_MESH_HOLDER& meshHolder = pMeshHolderList[meshHolderId];
+        if (!IsPackageRangeValid(header, MESH_PACKAGE_PRIMITIVES, meshHolder.firstPrimitive, meshHolder.primitivesNum)) {
+            return false;
+        }
+    }
+    const MESH_PACKAGE_PRIMITIVE* pPrimitiveList = GetMeshPackageSection<MESH_PACKAGE_PRIMITIVE>(pPackageData, MESH_PACKAGE_PRIMITIVES);
+    for (uint32_t primitiveId = 0; primitiveId < header.sectionSizes[MESH_PACKAGE_PRIMITIVES]; primitiveId++) {
+        const MESH_PACKAGE_PRIMITIVE& primitive = pPrimitiveList[primitiveId];
+        if (!IsPackageIdValid(header, MESH_PACKAGE_MATERIALS, primitive.materialId) ||
+            !IsPackageRangeValid(header, MESH_PACKAGE_VERTEXES, primitive.firstVertex, primitive.vertexesNum) ||
+            !IsPackageRangeValid(header, MESH_PACKAGE_INDEXES, primitive.firstIndex, primitive.indexesNum)) {
+            return false;
+        }
+    }
+    const MESH_PACKAGE_NODE* pNodeList = GetMeshPackageSection<MESH_PACKAGE_NODE>(pPackageData, MESH_PACKAGE_NODES);
+    for (uint32_t nodeId = 0; nodeId < header.sectionSizes[MESH_PACKAGE_NODES]; nodeId++) {
+        if (!IsPackageIdValid(header, MESH_PACKAGE_MESH_HOLDERS, pNodeList[nodeId].meshHolderId)) {
+            return false;
+        }
+    }
+
+    //shipped packages can be used without sources
+    const MESH_PACKAGE_SOURCE_FILE* pSourceFileList = GetMeshPackageSection<MESH_PACKAGE_SOURCE_FILE>(pPackageData, MESH_PACKAGE_SOURCE_FILES);
+    for (uint32_t sourceFileId = 0; sourceFileId < header.sectionSizes[MESH_PACKAGE_SOURCE_FILES]; sourceFileId++) {
+        const MESH_PACKAGE_SOURCE_FILE& sourceFile = pSourceFileList[sourceFileId];
+        if (!IsPackageStringValid(header, sourceFile.path)) {
+            return false;
+        }
+        uint64_t fileSize;
+        int64_t writeTime;
+        if (GetSourceFileInfo(GetMeshPackageString(pPackageData, sourceFile.path), fileSize, writeTime) &&
+            (fileSize != sourceFile.fileSize || writeTime != sourceFile.writeTime)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class MESH_PACKAGE_BUILDER
+{
+public:
+    MESH_PACKAGE_STRING AddString(const std::string& string);
+    bool AddSourceFile(const std::string& path);
+    bool AddImages(const tinygltf::Model& gltfModel, const std::string& baseDir);
+    void AddMaterials(const tinygltf::Model& gltfModel);
+    bool AddMeshes(const tinygltf::Model& gltfModel);
+    void AddNodes(const tinygltf::Model& gltfModel);
+    bool Write(const std::string& destPath) const;
+private:
+    static const uint8_t* GetAttributeData(const tinygltf::Model& gltfModel, const tinygltf::Primitive& gltfPrimitive, const char* attributeName, size_t& byteStride);
+    bool AddIndexes(const tinygltf::Model& gltfModel, const tinygltf::Primitive& gltfPrimitive, MESH_PACKAGE_PRIMITIVE& primitive);
+
+    std::vector<MESH_PACKAGE_SOURCE_FILE> m_sourceFileList;
+    std::vector<MESH_PACKAGE_IMAGE>       m_imageList;
+    std::vector<MESH_PACKAGE_MATERIAL>    m_materialList;
+    std::vector<MESH_PACKAGE_MESH_HOLDER> m_meshHolderList;
+    std::vector<MESH_PACKAGE_PRIMITIVE>   m_primitiveList;
+    std::vector<MESH_PACKAGE_NODE>        m_nodeList;
+    std::vector<SIMPLE_VERTEX>            m_vertexList;
+    std::vector<uint16_t>                 m_indexList;
+    std::string                           m_stringData;
+};
+
+MESH_PACKAGE_STRING MESH_PACKAGE_BUILDER::AddString(const std::string& string)
+{
+    MESH_PACKAGE_STRING packageString;
+    packageString.offset = static_cast<uint32_t>(m_stringData.size());
+    packageString.length = static_cast<uint32_t>(string.size());
+    m_stringData += string;
+    return packageString;
+}
+
+bool MESH_PACKAGE_BUILDER::AddSourceFile(const std::string& path)
+{
+    MESH_PACKAGE_SOURCE_FILE sourceFile;
+    if (!GetSourceFileInfo(path, sourceFile.fileSize, sourceFile.writeTime)) {
+        WARNING_MSG(formatString("Can't get info of mesh source %s!\n", path.c_str()).c_str());
+        return false;
+    }
+    sourceFile.path = AddString(path);
+    m_sourceFileList.push_back(sourceFile);
+    return true;
+}
+
+bool MESH_PACKAGE_BUILDER::AddImages(const tinygltf::Model& gltfModel, const std::string& baseDir)
+{
+    //normal maps keep only xy, images used for anything else stay full color
+    std::vector<TEXTURE_COOK_FORMAT> imageFormatList(gltfModel.images.size(), TEXTURE_COOK_COLOR);
+    for (const tinygltf::Material& gltfMaterial : gltfModel.materials) {
+        if (gltfMaterial.normalTexture.index != -1) {
+            imageFormatList[gltfModel.textures[gltfMaterial.normalTexture.index].source] = TEXTURE_COOK_NORMAL;
+        }
+    }
+    for (const tinygltf::Material& gltfMaterial : gltfModel.materials) {
+        for (int textureId : { gltfMaterial.pbrMetallicRoughness.baseColorTexture.index, gltfMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index,
+            gltfMaterial.emissiveTexture.index }) {
+            if (textureId != -1) {
+                imageFormatList[gltfModel.textures[textureId].source] = TEXTURE_COOK_COLOR;
+            }
+        }
+    }
+
+    //images are package sources too, so hashes stored here are updated when an image is changed
+    for (size_t imageId = 0; imageId < gltfModel.images.size(); imageId++) {
+        const std::string imagePath = baseDir + "/" + gltfModel.images[imageId].uri;
+        const std::vector<char> imageData = ReadFile(imagePath);
+        if (imageData.empty() || !AddSourceFile(imagePath)) {
+            WARNING_MSG(formatString("Can't read mesh image %s!\n", imagePath.c_str()).c_str());
+            return false;
+        }
+        MESH_PACKAGE_IMAGE image;
+        image.uri = AddString(gltfModel.images[imageId].uri);
+        image.cookFormat = imageFormatList[imageId];
+        image.sourceHash = GetTextureSourceHash(imageData);
+        m_imageList.push_back(image);
+    }
+    return true;
+}
+
+void MESH_PACKAGE_BUILDER::AddMaterials(const tinygltf::Model& gltfModel)
+{
+    auto GetImageId = [&gltfModel](int textureId) {
+        return textureId != -1 ? static_cast<int32_t>(gltfModel.textures[textureId].source) : -1;
+    };
+
+    for (const tinygltf::Material& gltfMaterial : gltfModel.materials) {
+        MESH_PACKAGE_MATERIAL material;
+        material.baseColor = glm::make_vec4(gltfMaterial.pbrMetallicRoughness.baseColorFactor.data());
+        material.alphaCutFactor = static_cast<float>(gltfMaterial.alphaCutoff);
+        material.alphaMode = static_cast<uint32_t>(MATERIAL_COMPONENT::ALPHA_MODE::ALPHA_OPAQUE);
+        if (gltfMaterial.alphaMode == "BLEND") {
+            material.alphaMode = static_cast<uint32_t>(MATERIAL_COMPONENT::ALPHA_MODE::ALPHA_BLEND);
+        }
+        if (gltfMaterial.alphaMode == "MASK") {
+            material.alphaMode = static_cast<uint32_t>(MATERIAL_COMPONENT::ALPHA_MODE::ALPHA_MASK);
+        }
+        material.isDoubleSided = gltfMaterial.doubleSided;
+        material.albedoImageId = GetImageId(gltfMaterial.pbrMetallicRoughness.baseColorTexture.index);
+        material.metalRoughnessImageId = GetImageId(gltfMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index);
+        material.normalImageId = GetImageId(gltfMaterial.normalTexture.index);
+        material.emissiveImageId = GetImageId(gltfMaterial.emissiveTexture.index);
+        m_materialList.push_back(material);
+    }
+}
+
+const uint8_t* MESH_PACKAGE_BUILDER::GetAttributeData(const tinygltf::Model& gltfModel, const tinygltf::Primitive& gltfPrimitive, const char* attributeName, size_t& byteStride)
+{
+    auto attributeIt = gltfPrimitive.attributes.find(attributeName);
+    if (attributeIt == gltfPrimitive.attributes.end()) {
+        return nullptr;
+    }
+    const tinygltf::Accessor& accessor = gltfModel.accessors[attributeIt->second];
+    const tinygltf::BufferView& bufferView = gltfModel.bufferViews[accessor.bufferView];
+    byteStride = accessor.ByteStride(bufferView);
+    return &gltfModel.buffers[bufferView.buffer].data[accessor.byteOffset + bufferView.byteOffset];
+}
+
+bool MESH_PACKAGE_BUILDER::AddIndexes(const tinygltf::Model& gltfModel, const tinygltf::Primitive& gltfPrimitive, MESH_PACKAGE_PRIMITIVE& primitive)
+{
+    primitive.firstIndex = static_cast<uint32_t>(m_indexList.size());
+    if (gltfPrimitive.indices == -1) {
+        //not indexed primitives are drawn with the same path as indexed ones
+        primitive.indexesNum = primitive.vertexesNum;
+        m_indexList.resize(m_indexList.size() + primitive.indexesNum);
+        for (uint32_t index = 0; index < primitive.indexesNum; index++) {
+            m_indexList[primitive.firstIndex + index] = static_cast<uint16_t>(index);
+        }
+        return true;
+    }
+
+    const tinygltf::Accessor& accessor = gltfModel.accessors[gltfPrimitive.indices];
+    const tinygltf::BufferView& bufferView = gltfModel.bufferViews[accessor.bufferView];
+    const uint8_t* pData = &gltfModel.buffers[bufferView.buffer].data[accessor.byteOffset + bufferView.byteOffset];
+    primitive.indexesNum = static_cast<uint32_t>(accessor.count);
+    m_indexList.resize(m_indexList.size() + primitive.indexesNum);
+    uint16_t* pIndexes = &m_indexList[primitive.firstIndex];
+
+    switch (accessor.componentType) {
+        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
+        {
+            const uint32_t* pData32 = reinterpret_cast<const uint32_t*>(pData);
+            std::transform(pData32, pData32 + accessor.count, pIndexes, [](uint32_t index) { return static_cast<uint16_t>(index); });
+            break;
+        }
+        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
+        {
+            memcpy(pIndexes, pData, accessor.count * sizeof(uint16_t));
+            break;
+        }
+        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
+        {
+            std::copy(pData, pData + accessor.count, pIndexes);
+            break;
+        }
+        default:
+        {
+            ERROR_MSG("Not implemented type");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MESH_PACKAGE_BUILDER::AddMeshes(const tinygltf::Model& gltfModel)
+{
+    for (const tinygltf::Mesh& gltfMesh : gltfModel.meshes) {
+        MESH_PACKAGE_MESH_HOLDER meshHolder;
+        meshHolder.firstPrimitive = static_cast<uint32_t>(m_primitiveList.size());
+        meshHolder.primitivesNum = static_cast<uint32_t>(gltfMesh.primitives.size());
+        m_meshHolderList.push_back(meshHolder);
+
+        for (const tinygltf::Primitive& gltfPrimitive : gltfMesh.primitives) {
+            ASSERT(gltfPrimitive.mode == TINYGLTF_MODE_TRIANGLES);
+
+            const tinygltf::Accessor& posAccessor = gltfModel.accessors[gltfPrimitive.attributes.find("POSITION")->second];
+            size_t posByteStride = 0;
+            size_t normByteStride = 0;
+            size_t uv0ByteStride = 0;
+            const uint8_t* bufferPos = GetAttributeData(gltfModel, gltfPrimitive, "POSITION", posByteStride);
+            const uint8_t* bufferNormals = GetAttributeData(gltfModel, gltfPrimitive, "NORMAL", normByteStride);
+            const uint8_t* bufferTexCoordSet0 = GetAttributeData(gltfModel, gltfPrimitive, "TEXCOORD_0", uv0ByteStride);
+
+            MESH_PACKAGE_PRIMITIVE primitive;
+            primitive.firstVertex = static_cast<uint32_t>(m_vertexList.size());
+            primitive.vertexesNum = static_cast<uint32_t>(posAccessor.count);
+            primitive.materialId = gltfPrimitive.material;
+            //bounds are scaled like vertex positions
+            primitive.minPos = glm::vec3(glm::make_vec3(posAccessor.minValues.data())) * MESH_POSITION_SCALE;
+            primitive.maxPos = glm::vec3(glm::make_vec3(posAccessor.maxValues.data())) * MESH_POSITION_SCALE;
+            if (primitive.vertexesNum > std::numeric_limits<uint16_t>::max() + 1) {
+                WARNING_MSG("Primitive has too many vertexes for 16 bit indexes!\n");
+            }
+
+            //TODO: use separated buffers, don't blend them into one buffer
+            m_vertexList.resize(m_vertexList.size() + primitive.vertexesNum);
+            for (uint32_t verId = 0; verId < primitive.vertexesNum; verId++) {
+                SIMPLE_VERTEX& vertex = m_vertexList[primitive.firstVertex + verId];
+                vertex.position = glm::make_vec3((const float*)&bufferPos[verId * posByteStride]) * MESH_POSITION_SCALE;
+                if (bufferTexCoordSet0) {
+                    vertex.texCoord = glm::make_vec2((const float*)&bufferTexCoordSet0[verId * uv0ByteStride]);
+                } else {
+                    vertex.texCoord = glm::vec2(0.f, 0.f);
+                }
+                if (bufferNormals) {
+                    vertex.normal = glm::make_vec3((const float*)&bufferNormals[verId * normByteStride]);
+                } else {
+                    vertex.normal = glm::vec3(0.f, 1.f, 0.f);
+                }
+            }
+
+            if (!AddIndexes(gltfModel, gltfPrimitive, primitive)) {
+                return false;
+            }
+            m_primitiveList.push_back(primitive);
+        }
+    }
+    return true;
+}
+
+void MESH_PACKAGE_BUILDER::AddNodes(const tinygltf::Model& gltfModel)
+{
+    if (gltfModel.scenes.empty()) {
+        return;
+    }
+    const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
+    for (int gltfNodeId : scene.nodes) {
+        const tinygltf::Node& gltfNode = gltfModel.nodes[gltfNodeId];
+
+        MESH_PACKAGE_NODE node;
+        node.translation = gltfNode.translation.size() == 3 ? glm::vec3(glm::make_vec3(gltfNode.translation.data())) : glm::vec3(0.f);
+        node.rotation = gltfNode.rotation.size() == 4 ? glm::vec4(glm::make_vec4(gltfNode.rotation.data())) : glm::vec4(0.f, 0.f, 0.f, 1.f);
+        node.scale = gltfNode.scale.size() == 3 ? glm::vec3(glm::make_vec3(gltfNode.scale.data())) : glm::vec3(1.f);
+        node.matrix = gltfNode.matrix.size() == 16 ? glm::mat4x4(glm::make_mat4x4(gltfNode.matrix.data())) : glm::mat4x4(1.f);
+        node.meshHolderId = gltfNode.mesh;
+        m_nodeList.push_back(node);
+    }
+}
+
+bool MESH_PACKAGE_BUILDER::Write(const std::string& destPath) const
+{
+    const std::array<std::pair<const void*, size_t>, MESH_PACKAGE_SECTIONS_NUM> sectionList = { {
+        { m_sourceFileList.data(), m_sourceFileList.size() },
+        { m_imageList.data(), m_imageList.size() },
+        { m_materialList.data(), m_materialList.size() },
+        { m_meshHolderList.data(), m_meshHolderList.size() },
+        { m_primitiveList.data(), m_primitiveList.size() },
+        { m_nodeList.data(), m_nodeList.size() },
+        { m_vertexList.data(), m_vertexList.size() },
+        { m_indexList.data(), m_indexList.size() },
+        { m_stringData.data(), m_stringData.size() },
+    } };
+
+    MESH_PACKAGE_HEADER header = {};
+    header.magic = MESH_PACKAGE_MAGIC;
+    header.version = MESH_COOKER_VERSION;
+    uint64_t sectionOffset = AlignPackageOffset(sizeof(MESH_PACKAGE_HEADER));
+    for (uint32_t sectionId = 0; sectionId < MESH_PACKAGE_SECTIONS_NUM; sectionId++) {
+        header.sectionOffsets[sectionId] = sectionOffset;
+        header.sectionSizes[sectionId] = static_cast<uint32_t>(sectionList[sectionId].second);
+        sectionOffset = AlignPackageOffset(sectionOffset + sectionList[sectionId].second * SECTION_ELEMENT_SIZES[sectionId]);
+    }
+
+    //file is written under unique name and renamed, so loading never sees partially written package
+    std::error_code fileError;
+    std::filesystem::create_directories(std::filesystem::path(destPath).parent_path(), fileError);
+    const std::string tempPath = formatString("%s.%zx.tmp", destPath.c_str(), std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        const char padding[MESH_PACKAGE_ALIGNMENT] = {};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(MESH_PACKAGE_HEADER));
+        for (uint32_t sectionId = 0; sectionId < MESH_PACKAGE_SECTIONS_NUM; sectionId++) {
+            file.write(padding, static_cast<std::streamsize>(header.sectionOffsets[sectionId] - static_cast<uint64_t>(file.tellp())));
+            file.write(static_cast<const char*>(sectionList[sectionId].first), sectionList[sectionId].second * SECTION_ELEMENT_SIZES[sectionId]);
+        }
+        if (!file.good()) {
+            file.close();
+            std::filesystem::remove(tempPath, fileError);
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath, destPath, fileError);
+    if (fileError) {
+        std::filesystem::remove(tempPath, fileError);
+        return false;
+    }
+    return true;
+}
+
+bool CookMesh(const std::string& sourcePath, const std::string& destPath)
+{
+    tinygltf::Model gltfModel;
+    tinygltf::TinyGLTF gltfContext;
+    std::string error;
+    std::string warning;
+
+    bool binary = false;
+    size_t extpos = sourcePath.rfind('.', sourcePath.length());
+    if (extpos != std::string::npos) {
+        binary = (sourcePath.substr(extpos + 1, sourcePath.length() - extpos) == "glb");
+    }
+
+    bool fileLoaded = false;
+    if (binary) {
+        fileLoaded = gltfContext.LoadBinaryFromFile(&gltfModel, &error, &warning, sourcePath.c_str());
+    } else {
+        fileLoaded = gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, sourcePath.c_str());
+    }
+    if (!fileLoaded) {
+        WARNING_MSG(formatString("Can't open %s mesh file! %s\n", sourcePath.c_str(), error.c_str()).c_str());
+        return false;
+    }
+
+    MESH_PACKAGE_BUILDER packageBuilder;
+    if (!packageBuilder.AddSourceFile(sourcePath)) {
+        return false;
+    }
+    //embedded buffers are covered by the model file
+    const std::string baseDir = tinygltf::GetBaseDir(sourcePath);
+    for (const tinygltf::Buffer& gltfBuffer : gltfModel.buffers) {
+        if (!gltfBuffer.uri.empty() && !tinygltf::IsDataURI(gltfBuffer.uri) && !packageBuilder.AddSourceFile(baseDir + "/" + gltfBuffer.uri)) {
+            return false;
+        }
+    }
+    if (!packageBuilder.AddImages(gltfModel, baseDir)) {
+        return false;
+    }
+    packageBuilder.AddMaterials(gltfModel);
+    if (!packageBuilder.AddMeshes(gltfModel)) {
+        return false;
+    }
+    packageBuilder.AddNodes(gltfModel);
+    return packageBuilder.Write(destPath);
+}
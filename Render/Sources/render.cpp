@@ -6,6 +6,7 @@
 #include "effectData.h"
 #include "materialManager.h"
 #include "render.h"
+#include "renderGraph.h"
 #include "resourceSystem.h"
 #include "renderTargetManager.h"
 #include "support.h"
@@ -19,7 +20,10 @@
 #include "Events/debug.h"
 
 #include "visibilitySystem.h"
+#include "gpuCullingSystem.h"
+#include "lightClusteringSystem.h"
 #include "renderPassFillGBuffer.h"
+#include "renderPassHiZ.h"
 #include "renderPassShadeGBuffer.h"
 #include "renderPassResolve.h"
 #include "renderPassShadow.h"
@@ -40,6 +44,7 @@ bool RENDER_SYSTEM::Init()
 {
     pDrvInterface.reset(new VULKAN_DRIVER_INTERFACE());
     pRenderTargetManager.reset(new RENDER_TARGET_MANAGER());
+    pRenderGraph.reset(new RENDER_GRAPH());
 
     bool isDriverInited = pDrvInterface->Init();
     if (!isDriverInited) {
@@ -54,7 +59,10 @@ bool RENDER_SYSTEM::Init()
     pRenderTargetManager->Init(pDrvInterface->GetBackBufferWidth(), pDrvInterface->GetBackBufferHeight(), pDrvInterface->GetBackBufferFormat());
 
     ECS::pEcsCoordinator->CreateSystem<VISIBILITY_SYSTEM>()->Init();
+    ECS::pEcsCoordinator->CreateSystem<GPU_CULLING_SYSTEM>()->Init();
+    ECS::pEcsCoordinator->CreateSystem<LIGHT_CLUSTERING_SYSTEM>()->Init();
     ECS::pEcsCoordinator->CreateSystem<RENDER_PASS_FILL_GBUFFER>()->Init();
+    ECS::pEcsCoordinator->CreateSystem<RENDER_PASS_HI_Z>()->Init();
     ECS::pEcsCoordinator->CreateSystem<RENDER_PASS_SHADE_GBUFFER>()->Init();
     ECS::pEcsCoordinator->CreateSystem<RENDER_PASS_RESOLVE>()->Init();
     ECS::pEcsCoordinator->CreateSystem<RENDER_PASS_SHADOW>()->Init();
@@ -64,32 +72,35 @@ bool RENDER_SYSTEM::Init()
     return true;
 }
 
-void RENDER_SYSTEM::Update()
-{
-    ECS::pEcsCoordinator->GetSystem <VISIBILITY_SYSTEM>()->Update();
-    ECS::pEcsCoordinator->GetSystem <RENDER_PASS_SHADOW>()->Update();
-}
-
 void RENDER_SYSTEM::Render()
 {
-    pDrvInterface->StartFrame();
-    pRenderTargetManager->StartFrame();
+    pResourceSystem->UpdateTextureStreaming();
 
-    ECS::pEcsCoordinator->GetSystem <RENDER_PASS_SHADOW>()->Render();
+    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_SHADOW>()->AddToRenderGraph(*pRenderGraph);
     //ECS::pEcsCoordinator->GetSystem<TERRAIN_SYSTEM>()->Render();
-    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_FILL_GBUFFER>()->Render();
-    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_SSAO>()->Render();
-    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_BLEND_SSAO>()->Render();
-    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_SHADE_GBUFFER>()->Render();
-    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_RESOLVE>()->Render();
-    ECS::pEcsCoordinator->GetSystem<GUI_SYSTEM>()->Render();
+    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_FILL_GBUFFER>()->AddToRenderGraph(*pRenderGraph);
+    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_HI_Z>()->AddToRenderGraph(*pRenderGraph);
+    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_FILL_GBUFFER>()->AddDisoccludedToRenderGraph(*pRenderGraph);
+    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_SSAO>()->AddToRenderGraph(*pRenderGraph);
+    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_BLEND_SSAO>()->AddToRenderGraph(*pRenderGraph);
+    ECS::pEcsCoordinator->GetSystem<LIGHT_CLUSTERING_SYSTEM>()->AddToRenderGraph(*pRenderGraph);
+    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_SHADE_GBUFFER>()->AddToRenderGraph(*pRenderGraph);
+    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_RESOLVE>()->AddToRenderGraph(*pRenderGraph);
+    ECS::pEcsCoordinator->GetSystem<GUI_SYSTEM>()->AddToRenderGraph(*pRenderGraph);
+    //transient render targets can be recreated, so it is done before frame
+    pRenderGraph->Compile();
 
+    pDrvInterface->StartFrame();
+    pRenderTargetManager->StartFrame();
+    pRenderGraph->Execute();
     pRenderTargetManager->EndFrame();
     pDrvInterface->EndFrame();
 }
 
 void RENDER_SYSTEM::Term()
 {
+    ECS::pEcsCoordinator->GetSystem<GPU_CULLING_SYSTEM>()->Term();
+    ECS::pEcsCoordinator->GetSystem<LIGHT_CLUSTERING_SYSTEM>()->Term();
     pResourceSystem->Term();
     pDrvInterface->Term();
     pResourceSystem.release();
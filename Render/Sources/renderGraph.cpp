@@ -0,0 +1,150 @@
+#include "renderGraph.h"
+
+#include <algorithm>
+
+std::unique_ptr<RENDER_GRAPH> pRenderGraph;
+
+void RENDER_GRAPH::AddPass(const char* name, const std::vector<RENDER_GRAPH_RESOURCE>& resourceList, EXECUTE_FUNC executeFunc, bool hasSideEffects)
+{
+    std::bitset<RT_LAST> usedMask;
+    for (const RENDER_GRAPH_RESOURCE& resource : resourceList) {
+        ASSERT_MSG(!usedMask.test(resource.rtIndex), "Render target is used twice by one pass!");
+        usedMask.set(resource.rtIndex);
+    }
+    m_passList.push_back({ name, resourceList, std::move(executeFunc), hasSideEffects });
+}
+
+void RENDER_GRAPH::Compile()
+{
+    CullPasses();
+
+    std::array<RENDER_TARGET_LIFETIME, RT_LAST> lifetimeList;
+    for (uint32_t passId = 0; passId < m_passList.size(); passId++) {
+        for (const RENDER_GRAPH_RESOURCE& resource : m_passList[passId].resourceList) {
+            RENDER_TARGET_LIFETIME& lifetime = lifetimeList[resource.rtIndex];
+            lifetime.firstPassId = std::min(lifetime.firstPassId, passId);
+            lifetime.lastPassId = std::max(lifetime.lastPassId, passId);
+        }
+    }
+    pRenderTargetManager->AliasTransientRenderTargets(lifetimeList);
+}
+
+void RENDER_GRAPH::Execute()
+{
+    std::vector<RENDER_TARGET_TRANSITION> transitionList;
+    for (uint32_t passId = 0; passId < m_passList.size(); passId++) {
+        const PASS& pass = m_passList[passId];
+
+        transitionList.clear();
+        for (const RENDER_GRAPH_RESOURCE& resource : pass.resourceList) {
+            transitionList.push_back({ resource.rtIndex, GetLayout(resource.access) });
+            if (IsAttachment(resource)) {
+                pRenderTargetManager->SetContentUsage(resource.rtIndex, IsContentLoaded(passId, resource.rtIndex), IsContentStored(passId, resource.rtIndex));
+            }
+        }
+        pRenderTargetManager->ChangeLayouts(transitionList);
+
+        pass.executeFunc();
+
+        //targets set by pass without declaration keep ops which are passed
+        for (const RENDER_GRAPH_RESOURCE& resource : pass.resourceList) {
+            if (IsAttachment(resource)) {
+                pRenderTargetManager->SetContentUsage(resource.rtIndex, true, true);
+            }
+        }
+    }
+    m_passList.clear();
+}
+
+void RENDER_GRAPH::CullPasses()
+{
+    //walks passes backward, pass is alive if it writes content which is read by alive passes after it
+    std::bitset<RT_LAST> readMask;
+    std::vector<bool> isAliveList(m_passList.size(), false);
+    for (size_t passId = m_passList.size(); passId-- > 0;) {
+        const PASS& pass = m_passList[passId];
+        bool isAlive = pass.hasSideEffects;
+        for (const RENDER_GRAPH_RESOURCE& resource : pass.resourceList) {
+            isAlive |= IsWrite(resource) && (readMask.test(resource.rtIndex) || IsPersistent(resource.rtIndex));
+        }
+        if (!isAlive) {
+            continue;
+        }
+        isAliveList[passId] = true;
+        for (const RENDER_GRAPH_RESOURCE& resource : pass.resourceList) {
+            if (IsWrite(resource) && !resource.isLoaded) {
+                readMask.reset(resource.rtIndex);
+            }
+        }
+        for (const RENDER_GRAPH_RESOURCE& resource : pass.resourceList) {
+            if (IsRead(resource)) {
+                readMask.set(resource.rtIndex);
+            }
+        }
+    }
+
+    std::vector<PASS> alivePassList;
+    for (size_t passId = 0; passId < m_passList.size(); passId++) {
+        if (isAliveList[passId]) {
+            alivePassList.push_back(std::move(m_passList[passId]));
+        }
+    }
+    m_passList = std::move(alivePassList);
+}
+
+bool RENDER_GRAPH::IsContentLoaded(uint32_t passId, RENDER_TARGET_ID rtIndex) const
+{
+    if (IsPersistent(rtIndex)) {
+        return true;
+    }
+    //content of transient target is undefined till the first write in the frame
+    for (uint32_t prevPassId = 0; prevPassId < passId; prevPassId++) {
+        for (const RENDER_GRAPH_RESOURCE& resource : m_passList[prevPassId].resourceList) {
+            if (resource.rtIndex == rtIndex && IsWrite(resource)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool RENDER_GRAPH::IsContentStored(uint32_t passId, RENDER_TARGET_ID rtIndex) const
+{
+    if (IsPersistent(rtIndex)) {
+        return true;
+    }
+    for (uint32_t nextPassId = passId + 1; nextPassId < m_passList.size(); nextPassId++) {
+        for (const RENDER_GRAPH_RESOURCE& resource : m_passList[nextPassId].resourceList) {
+            if (resource.rtIndex != rtIndex) {
+                continue;
+            }
+            if (IsRead(resource)) {
+                return true;
+            }
+            //overwritten before anybody reads it
+            return false;
+        }
+    }
+    return false;
+}
+
+bool RENDER_GRAPH::IsAttachment(const RENDER_GRAPH_RESOURCE& resource)
+{
+    return resource.access == RG_ACCESS_RENDER_TARGET || resource.access == RG_ACCESS_DEPTH_BUFFER;
+}
+
+VkImageLayout RENDER_GRAPH::GetLayout(RENDER_GRAPH_ACCESS access)
+{
+    switch (access) {
+    case RG_ACCESS_SRV:
+        return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    case RG_ACCESS_UAV:
+        return VK_IMAGE_LAYOUT_GENERAL;
+    case RG_ACCESS_RENDER_TARGET:
+        return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    case RG_ACCESS_DEPTH_BUFFER:
+        return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    }
+    ERROR_MSG("Unknown render graph access!");
+    return VK_IMAGE_LAYOUT_UNDEFINED;
+}
@@ -5,16 +5,60 @@
 #include "geometry.h"
 
 #include "commonRenderVariables.h"
+#include "renderGraph.h"
 #include "renderTargetManager.h"
 
 void RENDER_PASS_BLEND_SSAO::Init()
 {
 }
 
-void RENDER_PASS_BLEND_SSAO::Render()
+void RENDER_PASS_BLEND_SSAO::AddToRenderGraph(RENDER_GRAPH& renderGraph)
+{
+    if (gSSAODebugVariables.turnOffSSAO || gSSAODebugVariables.resolution == SSAO_RESOLUTION_FULL) {
+        const std::vector<RENDER_GRAPH_RESOURCE> resourceList = {
+            { RT_SSAO_MASK_BLENDED, RG_ACCESS_RENDER_TARGET },
+            { RT_SSAO_MASK,         RG_ACCESS_SRV },
+        };
+        renderGraph.AddPass("blend ssao", resourceList, [this]() { Blend(); });
+        return;
+    }
+
+    const uint32_t levelId = gSSAODebugVariables.resolution - SSAO_RESOLUTION_HALF;
+    const RENDER_TARGET_ID depthNormalId = RENDER_TARGET_ID(RT_SSAO_DEPTH_NORMAL_HALF + levelId);
+    const RENDER_TARGET_ID ssaoMaskId = RENDER_TARGET_ID(RT_SSAO_MASK_HALF + levelId);
+    const RENDER_TARGET_ID ssaoBlurId = RENDER_TARGET_ID(RT_SSAO_BLUR_HALF + levelId);
+
+    //separable blur, result is back in the mask
+    const std::vector<RENDER_GRAPH_RESOURCE> horizontalBlurResourceList = {
+        { ssaoBlurId,    RG_ACCESS_UAV },
+        { ssaoMaskId,    RG_ACCESS_SRV },
+        { depthNormalId, RG_ACCESS_SRV },
+    };
+    renderGraph.AddPass("ssao horizontal blur", horizontalBlurResourceList, [=]() {
+        BilateralBlur(ssaoMaskId, ssaoBlurId, depthNormalId, glm::vec2(1.f, 0.f));
+    });
+    const std::vector<RENDER_GRAPH_RESOURCE> verticalBlurResourceList = {
+        { ssaoMaskId,    RG_ACCESS_UAV },
+        { ssaoBlurId,    RG_ACCESS_SRV },
+        { depthNormalId, RG_ACCESS_SRV },
+    };
+    renderGraph.AddPass("ssao vertical blur", verticalBlurResourceList, [=]() {
+        BilateralBlur(ssaoBlurId, ssaoMaskId, depthNormalId, glm::vec2(0.f, 1.f));
+    });
+
+    const std::vector<RENDER_GRAPH_RESOURCE> upsampleResourceList = {
+        { RT_SSAO_MASK_BLENDED, RG_ACCESS_RENDER_TARGET },
+        { RT_DEPTH_BUFFER,      RG_ACCESS_SRV },
+        { ssaoMaskId,           RG_ACCESS_SRV },
+        { depthNormalId,        RG_ACCESS_SRV },
+    };
+    renderGraph.AddPass("ssao upsample", upsampleResourceList, [this, levelId]() { Upsample(levelId); });
+}
+
+void RENDER_PASS_BLEND_SSAO::Blend()
 {
     BeginRenderPass();
-    
+
     pDrvInterface->SetShader(EFFECT_DATA::SHR_SSAO_BLEND);
     pDrvInterface->SetVertexFormat(EMPTY_VERTEX::formatId);
     pDrvInterface->DrawFullscreen();
@@ -22,6 +66,47 @@ void RENDER_PASS_BLEND_SSAO::Render()
     EndRenderPass();
 }
 
+void RENDER_PASS_BLEND_SSAO::Upsample(uint32_t levelId)
+{
+    const RENDER_TARGET_ID depthNormalId = RENDER_TARGET_ID(RT_SSAO_DEPTH_NORMAL_HALF + levelId);
+    const RENDER_TARGET_ID ssaoMaskId = RENDER_TARGET_ID(RT_SSAO_MASK_HALF + levelId);
+
+    pRenderTargetManager->SetTextureAsRenderTarget(RT_SSAO_MASK_BLENDED, 0, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE);
+    pRenderTargetManager->SetTextureAsSRV(RT_DEPTH_BUFFER, 25);
+    pRenderTargetManager->SetTextureAsSRV(ssaoMaskId, 30);
+    pRenderTargetManager->SetTextureAsSRV(depthNormalId, 32);
+    pDrvInterface->BeginRenderPass();
+
+    pDrvInterface->SetShader(EFFECT_DATA::SHR_SSAO_UPSAMPLE);
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_COMMON_DATA);
+    pDrvInterface->SetVertexFormat(EMPTY_VERTEX::formatId);
+    pDrvInterface->DrawFullscreen();
+
+    EndRenderPass();
+}
+
+void RENDER_PASS_BLEND_SSAO::BilateralBlur(RENDER_TARGET_ID sourceId, RENDER_TARGET_ID destId, RENDER_TARGET_ID depthNormalId, const glm::vec2& direction)
+{
+    //compute shader, each group blurs BLUR_GROUP_SIZE texels of one line
+    pRenderTargetManager->SetTextureAsSRV(sourceId, 30);
+    pRenderTargetManager->SetTextureAsSRV(depthNormalId, 32);
+    pRenderTargetManager->SetTextureAsUAV(destId, 33);
+
+    pDrvInterface->SetShader(EFFECT_DATA::SHR_SSAO_BILATERAL_BLUR);
+    EFFECT_DATA::CB_CUSTOM_STRUCT blurData;
+    blurData.cb0 = glm::vec4(direction, 0.f, 0.f);
+    pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_CUSTOM, &blurData, sizeof(blurData));
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_CUSTOM);
+
+    const VULKAN_TEXTURE& dest = pRenderTargetManager->GetRenderTarget(destId);
+    const bool isHorizontal = direction.x > 0.f;
+    const uint32_t lineLength = isHorizontal ? dest.width : dest.height;
+    const uint32_t linesNum = isHorizontal ? dest.height : dest.width;
+    pDrvInterface->Dispatch((lineLength + BLUR_GROUP_SIZE - 1) / BLUR_GROUP_SIZE, linesNum);
+
+    pRenderTargetManager->ReturnAllRenderTargetsToPool();
+}
+
 void RENDER_PASS_BLEND_SSAO::BeginRenderPass()
 {
     pRenderTargetManager->SetTextureAsRenderTarget(RT_SSAO_MASK_BLENDED, 0, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE);
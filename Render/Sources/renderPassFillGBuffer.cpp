@@ -2,51 +2,138 @@
 
 #include "commonRenderVariables.h"
 #include "ecsCoordinator.h"
+#include "jobSystem.h"
 
 #include "Components/rendered.h"
 #include "Components/camera.h"
 #include "Components/transformation.h"
 #include "Events/debug.h"
 
+#include "gpuCullingSystem.h"
+#include "renderGraph.h"
 #include "resourceSystem.h"
 #include "renderTargetManager.h"
+#include "visibilitySystem.h"
+
+static const glm::vec4 SKY_COLOR = { 0.1f, 0.6f, 0.9f, 0.f };
+
+struct BINDLESS_PUSH_CONSTANT
+{
+    glm::mat4x4 modelMatrix;
+    uint32_t    materialId;
+};
 
 void RENDER_PASS_FILL_GBUFFER::Init()
 {
-    ECS::pEcsCoordinator->SubscrubeSystemToComponentType<VISIBLE_COMPONENT>(this);
+    ECS::pEcsCoordinator->SubscrubeSystemToComponentType<RENDERED_COMPONENT>(this);
     ECS::pEcsCoordinator->SubscrubeSystemToComponentType<MESH_PRIMITIVE>(this);
 }
 
-void RENDER_PASS_FILL_GBUFFER::BeginRenderPass()
+void RENDER_PASS_FILL_GBUFFER::BeginRenderPass(bool isSecondary, VkAttachmentLoadOp loadOp)
 {
-    pRenderTargetManager->SetTextureAsRenderTarget(RT_GBUFFER_ALBEDO, 0, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
-    pRenderTargetManager->SetTextureAsRenderTarget(RT_GBUFFER_NORMAL, 1, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
-    pRenderTargetManager->SetTextureAsRenderTarget(RT_GBUFFER_METALL_ROUGHNESS, 2, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
-    pRenderTargetManager->SetTextureAsRenderTarget(RT_GBUFFER_WORLD_POS, 3, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
-    pRenderTargetManager->SetTextureAsDepthBuffer(RT_DEPTH_BUFFER, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
-    pDrvInterface->BeginRenderPass();
+    pRenderTargetManager->SetTextureAsRenderTarget(RT_GBUFFER_ALBEDO, 0, loadOp, VK_ATTACHMENT_STORE_OP_STORE);
+    pRenderTargetManager->SetTextureAsRenderTarget(RT_GBUFFER_NORMAL, 1, loadOp, VK_ATTACHMENT_STORE_OP_STORE);
+    pRenderTargetManager->SetTextureAsDepthBuffer(RT_DEPTH_BUFFER, loadOp, VK_ATTACHMENT_STORE_OP_STORE);
+    pDrvInterface->BeginRenderPass(isSecondary);
 }
 
-void RENDER_PASS_FILL_GBUFFER::EndRenderPass()
+void RENDER_PASS_FILL_GBUFFER::EndRenderPass(bool isSecondary)
 {
+    if (isSecondary) {
+        pDrvInterface->ExecuteSecondaryCommandBuffers();
+    }
     pDrvInterface->EndRenderPass();
     pRenderTargetManager->ReturnAllRenderTargetsToPool();
 }
 
+void RENDER_PASS_FILL_GBUFFER::AddToRenderGraph(RENDER_GRAPH& renderGraph)
+{
+    std::vector<RENDER_GRAPH_RESOURCE> resourceList = {
+        { RT_GBUFFER_ALBEDO, RG_ACCESS_RENDER_TARGET },
+        { RT_GBUFFER_NORMAL, RG_ACCESS_RENDER_TARGET },
+        { RT_DEPTH_BUFFER,   RG_ACCESS_DEPTH_BUFFER },
+    };
+    ECS::pEcsCoordinator->GetSystem<GPU_CULLING_SYSTEM>()->AddCullingResources(resourceList);
+    renderGraph.AddPass("fill gbuffer", resourceList, [this]() { Render(); });
+}
+
+void RENDER_PASS_FILL_GBUFFER::AddDisoccludedToRenderGraph(RENDER_GRAPH& renderGraph)
+{
+    GPU_CULLING_SYSTEM* pGpuCullingSystem = ECS::pEcsCoordinator->GetSystem<GPU_CULLING_SYSTEM>();
+    if (!pGpuCullingSystem->IsEnabled()) {
+        return;
+    }
+    //disoccluded instances are drawn over the first phase
+    std::vector<RENDER_GRAPH_RESOURCE> resourceList = {
+        { RT_GBUFFER_ALBEDO, RG_ACCESS_RENDER_TARGET, true },
+        { RT_GBUFFER_NORMAL, RG_ACCESS_RENDER_TARGET, true },
+        { RT_DEPTH_BUFFER,   RG_ACCESS_DEPTH_BUFFER,  true },
+    };
+    pGpuCullingSystem->AddCullingResources(resourceList);
+    renderGraph.AddPass("fill gbuffer disoccluded", resourceList, [this]() { RenderDisoccluded(); });
+}
+
 void RENDER_PASS_FILL_GBUFFER::Render()
 {
-    BeginRenderPass();
+    FillConstBuffers();
+
+    //gpu driven path draws all instances with one indirect draw, so there is nothing to record in parallel
+    GPU_CULLING_SYSTEM* pGpuCullingSystem = ECS::pEcsCoordinator->GetSystem<GPU_CULLING_SYSTEM>();
+    if (pGpuCullingSystem->IsEnabled()) {
+        RenderIndirect(pGpuCullingSystem, GPU_VIEW_GAME_CAMERA);
+        return;
+    }
+
+    BeginRenderPass(true, VK_ATTACHMENT_LOAD_OP_CLEAR);
+
+    const std::vector<ECS::ENTITY_TYPE>& visibleEntityList = ECS::pEcsCoordinator->GetSystem<VISIBILITY_SYSTEM>()->GetVisibleEntities(VIEW_GAME_CAMERA);
+
+    //one batch per recording context, batch id selects the context
+    const uint32_t contextsNum = pDrvInterface->GetRecordingContextsNum();
+    const size_t batchSize = std::max<size_t>((visibleEntityList.size() + contextsNum - 1) / contextsNum, 1);
+    ECS::pJobSystem->ParallelFor(visibleEntityList.size(), batchSize, [this, batchSize, &visibleEntityList](size_t begin, size_t end) {
+        pDrvInterface->BeginSecondaryRecording(static_cast<uint32_t>(begin / batchSize));
+        if (begin == 0) {
+            pDrvInterface->ClearBackBuffer(SKY_COLOR);
+        }
+        RecordEntities(visibleEntityList, begin, end);
+        pDrvInterface->EndSecondaryRecording();
+    });
+
+    EndRenderPass(true);
+}
+
+void RENDER_PASS_FILL_GBUFFER::RenderDisoccluded()
+{
+    //depth pyramid is built from depth of Render(), instances hidden only in previous frame pyramid are drawn over it
+    RenderIndirect(ECS::pEcsCoordinator->GetSystem<GPU_CULLING_SYSTEM>(), GPU_VIEW_GAME_CAMERA_DISOCCLUDED);
+}
 
-    const glm::vec4 skyColor = { 0.1f, 0.6f, 0.9f, 0.f };
-    pDrvInterface->ClearBackBuffer(skyColor);
+void RENDER_PASS_FILL_GBUFFER::RenderIndirect(GPU_CULLING_SYSTEM* pGpuCullingSystem, GPU_CULLING_VIEW view)
+{
+    const glm::mat4x4& viewProj = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera)->viewProjMatrix;
+    pGpuCullingSystem->CullInstances(view, viewProj);
 
-    pDrvInterface->SetShader(EFFECT_DATA::SHR_FILL_GBUFFER);
+    const bool isFirstPhase = view == GPU_VIEW_GAME_CAMERA;
+    BeginRenderPass(false, isFirstPhase ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD);
+    if (isFirstPhase) {
+        pDrvInterface->ClearBackBuffer(SKY_COLOR);
+    }
 
+    pDrvInterface->SetShader(EFFECT_DATA::SHR_FILL_GBUFFER_INDIRECT);
     pDrvInterface->SetDepthTestState(true);
     pDrvInterface->SetDepthWriteState(true);
     pDrvInterface->SetDepthComparitionOperation(true);
     pDrvInterface->SetStencilTestState(false);
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_COMMON_DATA);
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_DEBUG);
+    pGpuCullingSystem->DrawInstances(view);
 
+    EndRenderPass(false);
+}
+
+void RENDER_PASS_FILL_GBUFFER::FillConstBuffers()
+{
     EFFECT_DATA::CB_COMMON_DATA_STRUCT dynBufferData;
     dynBufferData.fTime = 0.f;
     dynBufferData.vViewPos = ECS::pEcsCoordinator->GetComponent<TRANSFORM_COMPONENT>(gameCamera)->position;
@@ -54,13 +141,27 @@ void RENDER_PASS_FILL_GBUFFER::Render()
     dynBufferData.mProj = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera)->projMatrix;
     dynBufferData.mProjInv = glm::inverse(ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera)->projMatrix);
     dynBufferData.mView = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera)->viewMatrix;
+    dynBufferData.mViewInv = glm::inverse(ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera)->viewMatrix);
     pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_COMMON_DATA, &dynBufferData, EFFECT_DATA::CONST_BUFFERS_SIZE[EFFECT_DATA::CB_COMMON_DATA]);
 
     EFFECT_DATA::CB_DEBUG_STRUCT debugBufferData;
     debugBufferData.drawMode = gDebugVariables.drawMode;
     pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_DEBUG, &debugBufferData, EFFECT_DATA::CONST_BUFFERS_SIZE[EFFECT_DATA::CB_DEBUG]);
+}
 
-    for (auto rendEntity : m_entityList) {
+void RENDER_PASS_FILL_GBUFFER::RecordEntities(const std::vector<ECS::ENTITY_TYPE>& entityList, size_t begin, size_t end)
+{
+    //bindless shader takes material textures from global array by material id, so per draw descriptor set stays the same
+    const bool isBindless = pDrvInterface->IsBindlessSupported();
+    pDrvInterface->SetShader(isBindless ? EFFECT_DATA::SHR_FILL_GBUFFER_BINDLESS : EFFECT_DATA::SHR_FILL_GBUFFER);
+
+    pDrvInterface->SetDepthTestState(true);
+    pDrvInterface->SetDepthWriteState(true);
+    pDrvInterface->SetDepthComparitionOperation(true);
+    pDrvInterface->SetStencilTestState(false);
+
+    for (size_t entityId = begin; entityId < end; entityId++) {
+        const ECS::ENTITY_TYPE rendEntity = entityList[entityId];
         pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_COMMON_DATA);
         pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_DEBUG);
 
@@ -70,15 +171,21 @@ void RENDER_PASS_FILL_GBUFFER::Render()
         //         const NODE_COMPONENT* pNode = pMeshPrimitive->pParentHolder->pParentsNodes[0];
         //         worldTransformMatrix = glm::mat4_cast(pNode->rotation);
         //         worldTransformMatrix = glm::translate(worldTransformMatrix, pNode->translation);
-        pDrvInterface->FillPushConstantBuffer(&worldTransformMatrix, sizeof(worldTransformMatrix));
-
         const MATERIAL_COMPONENT* material = pMeshPrimitive->pMaterial;
         ASSERT(material);
 
-        pDrvInterface->SetTexture(material->pAlbedoTex, 20);
-        pDrvInterface->SetTexture(material->pNormalTex, 21);
-        pDrvInterface->SetTexture(material->pMetalRoughnessTex, 22);
-        //pDrvInterface->SetTexture(material->pDisplacementTex, 23);
+        if (isBindless) {
+            BINDLESS_PUSH_CONSTANT pushConstant;
+            pushConstant.modelMatrix = worldTransformMatrix;
+            pushConstant.materialId = material->materialId;
+            pDrvInterface->FillPushConstantBuffer(&pushConstant, sizeof(pushConstant));
+        } else {
+            pDrvInterface->FillPushConstantBuffer(&worldTransformMatrix, sizeof(worldTransformMatrix));
+            pDrvInterface->SetTexture(material->pAlbedoTex, 20);
+            pDrvInterface->SetTexture(material->pNormalTex, 21);
+            pDrvInterface->SetTexture(material->pMetalRoughnessTex, 22);
+            //pDrvInterface->SetTexture(material->pDisplacementTex, 23);
+        }
 
         const VULKAN_MESH* pMesh = pMeshPrimitive->pMesh;
         pDrvInterface->SetVertexFormat(pMesh->vertexFormatId);
@@ -87,8 +194,7 @@ void RENDER_PASS_FILL_GBUFFER::Render()
             pDrvInterface->Draw(pMesh->numOfVertexes);
         } else {
             pDrvInterface->SetIndexBuffer(pMesh->indexBuffer, 0);
-            pDrvInterface->DrawIndexed(pMesh->numOfIndexes);
+            pDrvInterface->DrawIndexed(pMesh->numOfIndexes, pMesh->vertexOffset, pMesh->firstIndex);
         }
     }
-    EndRenderPass();
 }
@@ -0,0 +1,76 @@
+#include "renderPassHiZ.h"
+
+#include "commonRenderVariables.h"
+#include "geometry.h"
+#include "gpuCullingSystem.h"
+#include "renderGraph.h"
+#include "renderTargetManager.h"
+
+#include "Components/camera.h"
+
+void RENDER_PASS_HI_Z::Init()
+{
+}
+
+void RENDER_PASS_HI_Z::AddToRenderGraph(RENDER_GRAPH& renderGraph)
+{
+    //only gpu culling reads the pyramid
+    if (!ECS::pEcsCoordinator->GetSystem<GPU_CULLING_SYSTEM>()->IsEnabled()) {
+        return;
+    }
+    for (uint32_t levelId = 0; levelId < HI_Z_LEVELS_NUM; levelId++) {
+        const std::vector<RENDER_GRAPH_RESOURCE> resourceList = {
+            { RENDER_TARGET_ID(RT_HI_Z_0 + levelId), RG_ACCESS_RENDER_TARGET },
+            { GetSourceId(levelId),                  RG_ACCESS_SRV },
+        };
+        renderGraph.AddPass("hi-z", resourceList, [this, levelId]() { BuildLevel(levelId); });
+    }
+}
+
+void RENDER_PASS_HI_Z::BuildLevel(uint32_t levelId)
+{
+    const RENDER_TARGET_ID sourceId = GetSourceId(levelId);
+    const VULKAN_TEXTURE& source = pRenderTargetManager->GetRenderTarget(sourceId);
+
+    pRenderTargetManager->SetTextureAsRenderTarget(RENDER_TARGET_ID(RT_HI_Z_0 + levelId), 0, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE);
+    pRenderTargetManager->SetTextureAsSRV(sourceId, SOURCE_SLOT);
+    pDrvInterface->BeginRenderPass();
+
+    pDrvInterface->SetShader(EFFECT_DATA::SHR_HI_Z_BUILD);
+    EFFECT_DATA::CB_CUSTOM_STRUCT levelData;
+    levelData.cb0.x = static_cast<float>(source.width);
+    levelData.cb0.y = static_cast<float>(source.height);
+    pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_CUSTOM, &levelData, sizeof(levelData));
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_CUSTOM);
+    pDrvInterface->SetVertexFormat(EMPTY_VERTEX::formatId);
+    pDrvInterface->DrawFullscreen();
+
+    pDrvInterface->EndRenderPass();
+    pRenderTargetManager->ReturnAllRenderTargetsToPool();
+
+    //pyramid is complete after the last level
+    if (levelId + 1 == HI_Z_LEVELS_NUM) {
+        const VULKAN_TEXTURE& depthBuffer = pRenderTargetManager->GetRenderTarget(RT_DEPTH_BUFFER);
+        m_pyramidBaseSize = glm::vec2(depthBuffer.width, depthBuffer.height);
+        m_pyramidViewProj = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera)->viewProjMatrix;
+    }
+}
+
+RENDER_TARGET_ID RENDER_PASS_HI_Z::GetSourceId(uint32_t levelId) const
+{
+    return levelId == 0 ? RT_DEPTH_BUFFER : RENDER_TARGET_ID(RT_HI_Z_0 + levelId - 1);
+}
+
+bool RENDER_PASS_HI_Z::IsPyramidValid() const
+{
+    //all levels are written together, after resize targets are recreated with new size
+    const VULKAN_TEXTURE& depthBuffer = pRenderTargetManager->GetRenderTarget(RT_DEPTH_BUFFER);
+    return pRenderTargetManager->IsHistoryValid(RT_HI_Z_0) && m_pyramidBaseSize == glm::vec2(depthBuffer.width, depthBuffer.height);
+}
+
+void RENDER_PASS_HI_Z::SetPyramidAsSRV(uint32_t firstSlot)
+{
+    for (uint32_t levelId = 0; levelId < HI_Z_LEVELS_NUM; levelId++) {
+        pRenderTargetManager->SetTextureAsSRV(RENDER_TARGET_ID(RT_HI_Z_0 + levelId), firstSlot + levelId);
+    }
+}
@@ -1,6 +1,7 @@
 #include "renderPassResolve.h"
 
 #include "ecsCoordinator.h"
+#include "renderGraph.h"
 #include "renderTargetManager.h"
 #include "geometry.h"
 
@@ -8,6 +9,15 @@ void RENDER_PASS_RESOLVE::Init()
 {
 }
 
+void RENDER_PASS_RESOLVE::AddToRenderGraph(RENDER_GRAPH& renderGraph)
+{
+    const std::vector<RENDER_GRAPH_RESOURCE> resourceList = {
+        { RT_BACK_BUFFER, RG_ACCESS_RENDER_TARGET },
+        { RT_FP16,        RG_ACCESS_SRV },
+    };
+    renderGraph.AddPass("resolve", resourceList, [this]() { Render(); });
+}
+
 void RENDER_PASS_RESOLVE::Render()
 {
     BeginRenderPass();
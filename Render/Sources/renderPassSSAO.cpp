@@ -5,6 +5,7 @@
 #include "geometry.h"
 
 #include "commonRenderVariables.h"
+#include "renderGraph.h"
 #include "renderTargetManager.h"
 #include "randomGenerator.h"
 
@@ -16,7 +17,35 @@ void RENDER_PASS_SSAO::Init()
     CreateNoiseTexture();
 }
 
-void RENDER_PASS_SSAO::Render()
+void RENDER_PASS_SSAO::AddToRenderGraph(RENDER_GRAPH& renderGraph)
+{
+    if (gSSAODebugVariables.turnOffSSAO || gSSAODebugVariables.resolution == SSAO_RESOLUTION_FULL) {
+        const std::vector<RENDER_GRAPH_RESOURCE> resourceList = {
+            { RT_SSAO_MASK,      RG_ACCESS_RENDER_TARGET },
+            { RT_GBUFFER_NORMAL, RG_ACCESS_SRV },
+            { RT_DEPTH_BUFFER,   RG_ACCESS_SRV },
+        };
+        renderGraph.AddPass("ssao", resourceList, [this]() { RenderFullResolution(); });
+        return;
+    }
+
+    const uint32_t levelId = gSSAODebugVariables.resolution - SSAO_RESOLUTION_HALF;
+    const RENDER_TARGET_ID depthNormalId = RENDER_TARGET_ID(RT_SSAO_DEPTH_NORMAL_HALF + levelId);
+    const RENDER_TARGET_ID ssaoMaskId = RENDER_TARGET_ID(RT_SSAO_MASK_HALF + levelId);
+    const std::vector<RENDER_GRAPH_RESOURCE> downsampleResourceList = {
+        { depthNormalId,     RG_ACCESS_RENDER_TARGET },
+        { RT_GBUFFER_NORMAL, RG_ACCESS_SRV },
+        { RT_DEPTH_BUFFER,   RG_ACCESS_SRV },
+    };
+    renderGraph.AddPass("ssao depth normal", downsampleResourceList, [this, levelId]() { DownsampleDepthNormal(levelId); });
+    const std::vector<RENDER_GRAPH_RESOURCE> ssaoResourceList = {
+        { ssaoMaskId,    RG_ACCESS_RENDER_TARGET },
+        { depthNormalId, RG_ACCESS_SRV },
+    };
+    renderGraph.AddPass("ssao reduced resolution", ssaoResourceList, [this, levelId]() { RenderReducedResolution(levelId); });
+}
+
+void RENDER_PASS_SSAO::RenderFullResolution()
 {
     BeginRenderPass();
 
@@ -33,6 +62,9 @@ void RENDER_PASS_SSAO::Render()
         ssaoData.cb0.x = 4; //kernel tex side
         ssaoData.cb0.y = gSSAODebugVariables.radius;
         ssaoData.cb0.z = gSSAODebugVariables.bias;
+        const VULKAN_TEXTURE& ssaoMask = pRenderTargetManager->GetRenderTarget(RT_SSAO_MASK);
+        ssaoData.cb1.x = static_cast<float>(ssaoMask.width);
+        ssaoData.cb1.y = static_cast<float>(ssaoMask.height);
         pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_CUSTOM, &ssaoData, sizeof(ssaoData));
         pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_CUSTOM);
 
@@ -43,6 +75,61 @@ void RENDER_PASS_SSAO::Render()
     EndRenderPass();
 }
 
+void RENDER_PASS_SSAO::DownsampleDepthNormal(uint32_t levelId)
+{
+    const RENDER_TARGET_ID depthNormalId = RENDER_TARGET_ID(RT_SSAO_DEPTH_NORMAL_HALF + levelId);
+
+    //closest depth and its normal of each downsampled block
+    pRenderTargetManager->SetTextureAsRenderTarget(depthNormalId, 0, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE);
+    pRenderTargetManager->SetTextureAsSRV(RT_GBUFFER_NORMAL, 21);
+    pRenderTargetManager->SetTextureAsSRV(RT_DEPTH_BUFFER, 25);
+    pDrvInterface->BeginRenderPass();
+
+    pDrvInterface->SetShader(EFFECT_DATA::SHR_SSAO_DEPTH_NORMAL);
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_COMMON_DATA);
+
+    const VULKAN_TEXTURE& depthBuffer = pRenderTargetManager->GetRenderTarget(RT_DEPTH_BUFFER);
+    EFFECT_DATA::CB_CUSTOM_STRUCT downsampleData;
+    downsampleData.cb0.x = static_cast<float>(2u << levelId);
+    downsampleData.cb0.y = static_cast<float>(depthBuffer.width);
+    downsampleData.cb0.z = static_cast<float>(depthBuffer.height);
+    pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_CUSTOM, &downsampleData, sizeof(downsampleData));
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_CUSTOM);
+
+    pDrvInterface->SetVertexFormat(EMPTY_VERTEX::formatId);
+    pDrvInterface->DrawFullscreen();
+    EndRenderPass();
+}
+
+void RENDER_PASS_SSAO::RenderReducedResolution(uint32_t levelId)
+{
+    const RENDER_TARGET_ID depthNormalId = RENDER_TARGET_ID(RT_SSAO_DEPTH_NORMAL_HALF + levelId);
+    const RENDER_TARGET_ID ssaoMaskId = RENDER_TARGET_ID(RT_SSAO_MASK_HALF + levelId);
+
+    pRenderTargetManager->SetTextureAsRenderTarget(ssaoMaskId, 0, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE);
+    pRenderTargetManager->SetTextureAsSRV(depthNormalId, 32);
+    pDrvInterface->BeginRenderPass();
+
+    pDrvInterface->SetShader(EFFECT_DATA::SHR_SSAO_LOW_RES);
+    pDrvInterface->SetTexture(&m_kernelTexture, 30);
+    pDrvInterface->SetTexture(&m_noiseTexture, 31);
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_COMMON_DATA);
+
+    const VULKAN_TEXTURE& ssaoMask = pRenderTargetManager->GetRenderTarget(ssaoMaskId);
+    EFFECT_DATA::CB_CUSTOM_STRUCT ssaoData;
+    ssaoData.cb0.x = 4; //kernel tex side
+    ssaoData.cb0.y = gSSAODebugVariables.radius;
+    ssaoData.cb0.z = gSSAODebugVariables.bias;
+    ssaoData.cb1.x = static_cast<float>(ssaoMask.width);
+    ssaoData.cb1.y = static_cast<float>(ssaoMask.height);
+    pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_CUSTOM, &ssaoData, sizeof(ssaoData));
+    pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_CUSTOM);
+
+    pDrvInterface->SetVertexFormat(EMPTY_VERTEX::formatId);
+    pDrvInterface->DrawFullscreen();
+    EndRenderPass();
+}
+
 void RENDER_PASS_SSAO::BeginRenderPass()
 {
     pRenderTargetManager->SetTextureAsRenderTarget(RT_SSAO_MASK, 0, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE);
@@ -10,6 +10,9 @@
 #include "Components/transformation.h"
 #include "Events/debug.h"
 
+#include "lightClusteringSystem.h"
+#include "renderGraph.h"
+#include "renderPassShadow.h"
 #include "resourceSystem.h"
 #include "renderTargetManager.h"
 
@@ -19,13 +22,24 @@ void RENDER_PASS_SHADE_GBUFFER::Init()
 {
 }
 
+void RENDER_PASS_SHADE_GBUFFER::AddToRenderGraph(RENDER_GRAPH& renderGraph)
+{
+    const std::vector<RENDER_GRAPH_RESOURCE> resourceList = {
+        { RT_FP16,              RG_ACCESS_RENDER_TARGET },
+        { RT_GBUFFER_ALBEDO,    RG_ACCESS_SRV },
+        { RT_GBUFFER_NORMAL,    RG_ACCESS_SRV },
+        { RT_SHADOW_MAP,        RG_ACCESS_SRV },
+        { RT_DEPTH_BUFFER,      RG_ACCESS_SRV },
+        { RT_SSAO_MASK_BLENDED, RG_ACCESS_SRV },
+    };
+    renderGraph.AddPass("shade gbuffer", resourceList, [this]() { Render(); });
+}
+
 void RENDER_PASS_SHADE_GBUFFER::BeginRenderPass()
 {
     pRenderTargetManager->SetTextureAsRenderTarget(RT_FP16, 0, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE);
     pRenderTargetManager->SetTextureAsSRV(RT_GBUFFER_ALBEDO, 20);
     pRenderTargetManager->SetTextureAsSRV(RT_GBUFFER_NORMAL, 21);
-    pRenderTargetManager->SetTextureAsSRV(RT_GBUFFER_METALL_ROUGHNESS, 22);
-    pRenderTargetManager->SetTextureAsSRV(RT_GBUFFER_WORLD_POS, 23);
     pRenderTargetManager->SetTextureAsSRV(RT_SHADOW_MAP, 24);
     pRenderTargetManager->SetTextureAsSRV(RT_DEPTH_BUFFER, 25);
     pRenderTargetManager->SetTextureAsSRV(RT_SSAO_MASK_BLENDED, 26);
@@ -46,6 +60,7 @@ void RENDER_PASS_SHADE_GBUFFER::Render()
     pDrvInterface->ClearBackBuffer(skyColor);
 
     pDrvInterface->SetShader(EFFECT_DATA::SHR_SHADE_GBUFFER);
+    ECS::pEcsCoordinator->GetSystem<LIGHT_CLUSTERING_SYSTEM>()->SetClustersAsSRV();
 
     pDrvInterface->SetDepthTestState(true);
     pDrvInterface->SetDepthWriteState(true);
@@ -59,16 +74,13 @@ void RENDER_PASS_SHADE_GBUFFER::Render()
     dynBufferData.mProj = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera)->projMatrix;
     dynBufferData.mProjInv = glm::inverse(ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera)->projMatrix);
     dynBufferData.mView = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera)->viewMatrix;
+    dynBufferData.mViewInv = glm::inverse(ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera)->viewMatrix);
     pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_COMMON_DATA, &dynBufferData, EFFECT_DATA::CONST_BUFFERS_SIZE[EFFECT_DATA::CB_COMMON_DATA]);
 
     EFFECT_DATA::CB_LIGHTS_STRUCT lightBufferData;
     lightBufferData.dirLight = *ECS::pEcsCoordinator->GetComponent<DIRECTIONAL_LIGHT_COMPONENT>(directionalLight);
-    lightBufferData.pointLight0Transform = *ECS::pEcsCoordinator->GetComponent<TRANSFORM_COMPONENT>(pointLights[0]);
-    lightBufferData.pointLight0 = *ECS::pEcsCoordinator->GetComponent<POINT_LIGHT_COMPONENT>(pointLights[0]);
     lightBufferData.ambientColor = COMMON_AMBIENT;
-    //tmp
-    lightBufferData.dirLightViewProj = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(directionalLight)->viewProjMatrix;
-    lightBufferData.pointLight0ViewProj = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(pointLights[0])->viewProjMatrix;
+    ECS::pEcsCoordinator->GetSystem<RENDER_PASS_SHADOW>()->FillCascadeData(lightBufferData);
     pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_LIGHTS, &lightBufferData, EFFECT_DATA::CONST_BUFFERS_SIZE[EFFECT_DATA::CB_LIGHTS]);
 
     pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_COMMON_DATA);
@@ -1,5 +1,8 @@
 #include "renderPassShadow.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "commonRenderVariables.h"
 #include "ecsCoordinator.h"
 
@@ -7,46 +10,215 @@
 #include "Components/camera.h"
 #include "Components/transformation.h"
 
+#include "gpuCullingSystem.h"
 #include "meshManager.h"
+#include "renderGraph.h"
 #include "renderTargetManager.h"
 #include "resourceSystem.h"
+#include "visibilitySystem.h"
 
 void RENDER_PASS_SHADOW::Init()
 {
     ECS::pEcsCoordinator->SubscrubeSystemToComponentType<RENDERED_COMPONENT>(this);
     ECS::pEcsCoordinator->SubscrubeSystemToComponentType<MESH_PRIMITIVE>(this);
+
+    //only the light camera is written, so the pass runs together with systems reading the game camera
+    DeclareEntityReadAccess<TRANSFORM_COMPONENT>(directionalLight);
+    DeclareEntityWriteAccess<DIRECTIONAL_LIGHT_COMPONENT>(directionalLight);
+    DeclareEntityWriteAccess<CAMERA_COMPONENT>(directionalLight);
+    DeclareEntityReadAccess<CAMERA_COMPONENT>(gameCamera);
+
+    //render target manager isn't covered by access declarations, so the atlas is queried only on the main thread
+    m_cascadeSize = pRenderTargetManager->GetRenderTarget(RT_SHADOW_MAP).width / EFFECT_DATA::SHADOW_ATLAS_COLUMNS;
+}
+
+void RENDER_PASS_SHADOW::AddEntity(ECS::ENTITY_TYPE entityId)
+{
+    ECS::SYSTEM<RENDER_PASS_SHADOW>::AddEntity(entityId);
+    m_isCasterListDirty = true;
 }
 
+void RENDER_PASS_SHADOW::RemoveEntity(ECS::ENTITY_TYPE entityId)
+{
+    ECS::SYSTEM<RENDER_PASS_SHADOW>::RemoveEntity(entityId);
+    m_isCasterListDirty = true;
+}
+
+//https://matthewwellings.com/blog/the-new-vulkan-coordinate-system/
+static const glm::mat4 CLIP(
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, -1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.f,
+    0.0f, 0.0f, 0.0f, 1.0f
+);
+
+//cascades cover camera frustum up to this depth, there are no shadows further
+static const float SHADOW_DISTANCE = 400.f;
+//blend between logarithmic and uniform splits of camera frustum
+static const float CASCADE_SPLIT_LAMBDA = 0.8f;
+//cascade bounds are extended towards the light, so casters out of camera frustum still shadow it
+static const float SHADOW_CASTER_DISTANCE = 1000.f;
+
+struct SHADOW_PUSH_CONSTANT
+{
+    glm::mat4x4 modelMatrix;
+    uint32_t    cascadeId;
+};
+
 void RENDER_PASS_SHADOW::Update()
 {
-    const glm::mat4 clip(
-        1.0f, 0.0f, 0.0f, 0.0f,
-        0.0f, -1.0f, 0.0f, 0.0f,
-        0.0f, 0.0f, 1.0f, 0.f,
-        0.0f, 0.0f, 0.0f, 1.0f
-    );
-
-    {
-        const TRANSFORM_COMPONENT* transform = ECS::pEcsCoordinator->GetComponent<TRANSFORM_COMPONENT>(directionalLight);
-        CAMERA_COMPONENT* cameraComponent = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(directionalLight);
-        cameraComponent->viewMatrix = glm::lookAt(transform->position, glm::vec3(-35.f, 0.f, 0.1f), UP_VECTOR);
-        const float width = 300.f;
-        const float height = 300.f;
-        const float nearPlane = 100.f;
-        const float farPlane = 3000.f;
-        cameraComponent->projMatrix = glm::ortho(-width, width, -height, height, nearPlane, farPlane);
-        cameraComponent->viewProjMatrix = clip * cameraComponent->projMatrix * cameraComponent->viewMatrix;
-
-        DIRECTIONAL_LIGHT_COMPONENT* dirLightComponent = ECS::pEcsCoordinator->GetComponent<DIRECTIONAL_LIGHT_COMPONENT>(directionalLight);
-        dirLightComponent->direction = glm::vec4(0.f, 0.f, 1.f, 0.f) * cameraComponent->viewMatrix;
+    const TRANSFORM_COMPONENT* transform = ECS::pEcsCoordinator->GetComponent<TRANSFORM_COMPONENT>(directionalLight);
+    CAMERA_COMPONENT* cameraComponent = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(directionalLight);
+    cameraComponent->viewMatrix = glm::lookAt(transform->position, glm::vec3(-35.f, 0.f, 0.1f), UP_VECTOR);
+
+    DIRECTIONAL_LIGHT_COMPONENT* dirLightComponent = ECS::pEcsCoordinator->GetComponent<DIRECTIONAL_LIGHT_COMPONENT>(directionalLight);
+    dirLightComponent->direction = glm::vec4(0.f, 0.f, 1.f, 0.f) * cameraComponent->viewMatrix;
+
+    const bool isCacheValid = !m_isCasterListDirty && m_cachedDepthBias == DEPTH_BIAS_PARAMS;
+    m_isCasterListDirty = false;
+    m_cachedDepthBias = DEPTH_BIAS_PARAMS;
+    for (SHADOW_CASCADE& cascade : m_cascadeList) {
+        cascade.isDirty |= !isCacheValid;
     }
+
+    UpdateCascades(*ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera), cameraComponent->viewMatrix);
+
+    //the last cascade covers all the others
+    cameraComponent->projMatrix = m_cascadeList.back().proj;
+    cameraComponent->viewProjMatrix = m_cascadeList.back().viewProj;
+}
+
+void RENDER_PASS_SHADOW::UpdateCascades(const CAMERA_COMPONENT& camera, const glm::mat4x4& lightView)
+{
+    const float nearPlane = camera.nearPlane;
+    const float farPlane = std::min(camera.farPlane, SHADOW_DISTANCE);
+
+    //corners of camera frustum on its near and far planes, slice corners lie between them
+    const glm::mat4x4 invViewProj = glm::inverse(camera.projMatrix * camera.viewMatrix);
+    std::array<glm::vec3, 4> nearCorners;
+    std::array<glm::vec3, 4> farCorners;
+    for (uint32_t cornerId = 0; cornerId < 4; cornerId++) {
+        const float x = (cornerId & 1) ? 1.f : -1.f;
+        const float y = (cornerId & 2) ? 1.f : -1.f;
+        const glm::vec4 nearCorner = invViewProj * glm::vec4(x, y, 0.f, 1.f);
+        const glm::vec4 farCorner = invViewProj * glm::vec4(x, y, 1.f, 1.f);
+        nearCorners[cornerId] = glm::vec3(nearCorner) / nearCorner.w;
+        farCorners[cornerId] = glm::vec3(farCorner) / farCorner.w;
+    }
+
+    float sliceNear = nearPlane;
+    for (uint32_t cascadeId = 0; cascadeId < EFFECT_DATA::SHADOW_CASCADES_NUM; cascadeId++) {
+        const float splitPart = float(cascadeId + 1) / EFFECT_DATA::SHADOW_CASCADES_NUM;
+        const float logSplit = nearPlane * std::pow(farPlane / nearPlane, splitPart);
+        const float uniformSplit = nearPlane + (farPlane - nearPlane) * splitPart;
+        const float sliceFar = glm::mix(uniformSplit, logSplit, CASCADE_SPLIT_LAMBDA);
+
+        //corners are on rays from the eye, so view depth changes linearly between near and far corners
+        std::array<glm::vec3, 8> sliceCorners;
+        const float nearLerp = (sliceNear - camera.nearPlane) / (camera.farPlane - camera.nearPlane);
+        const float farLerp = (sliceFar - camera.nearPlane) / (camera.farPlane - camera.nearPlane);
+        glm::vec3 sliceCenter(0.f);
+        for (uint32_t cornerId = 0; cornerId < 4; cornerId++) {
+            sliceCorners[cornerId] = glm::mix(nearCorners[cornerId], farCorners[cornerId], nearLerp);
+            sliceCorners[cornerId + 4] = glm::mix(nearCorners[cornerId], farCorners[cornerId], farLerp);
+            sliceCenter += sliceCorners[cornerId] + sliceCorners[cornerId + 4];
+        }
+        sliceCenter /= 8.f;
+
+        //bounding sphere doesn't depend on camera rotation, so cascade size is stable and doesn't make shadow edges shimmer
+        float radius = 0.f;
+        for (const glm::vec3& corner : sliceCorners) {
+            radius = std::max(radius, glm::length(corner - sliceCenter));
+        }
+        radius = std::ceil(radius * 16.f) / 16.f;
+
+        //the cascade is moved by whole texels only
+        const float texelSize = 2.f * radius / m_cascadeSize;
+        glm::vec3 lightSpaceCenter = glm::vec3(lightView * glm::vec4(sliceCenter, 1.f));
+        lightSpaceCenter.x = std::floor(lightSpaceCenter.x / texelSize) * texelSize;
+        lightSpaceCenter.y = std::floor(lightSpaceCenter.y / texelSize) * texelSize;
+        //depth is snapped by radius and the range is extended by it, so the slice is always inside and
+        //cascade projection doesn't change while camera moves along the light direction
+        lightSpaceCenter.z = std::floor(lightSpaceCenter.z / radius) * radius;
+
+        const glm::mat4x4 cascadeProj = glm::ortho(
+            lightSpaceCenter.x - radius, lightSpaceCenter.x + radius,
+            lightSpaceCenter.y - radius, lightSpaceCenter.y + radius,
+            lightSpaceCenter.z - radius - SHADOW_CASTER_DISTANCE, lightSpaceCenter.z + 2.f * radius);
+
+        //clip space of the cascade is scaled to its quarter of the atlas, top row of the atlas is at -1 in vulkan
+        const uint32_t column = cascadeId % EFFECT_DATA::SHADOW_ATLAS_COLUMNS;
+        const uint32_t row = cascadeId / EFFECT_DATA::SHADOW_ATLAS_COLUMNS;
+        const float atlasScale = 1.f / EFFECT_DATA::SHADOW_ATLAS_COLUMNS;
+        glm::mat4x4 atlasMatrix(1.f);
+        atlasMatrix[0][0] = atlasScale;
+        atlasMatrix[1][1] = atlasScale;
+        atlasMatrix[3][0] = -1.f + atlasScale * (2 * column + 1);
+        atlasMatrix[3][1] = -1.f + atlasScale * (2 * row + 1);
+
+        SHADOW_CASCADE& cascade = m_cascadeList[cascadeId];
+        const glm::mat4x4 viewProj = CLIP * cascadeProj * lightView;
+        //light and far cascades often stay in place while camera moves, since cascades are snapped to texels
+        cascade.isDirty |= viewProj != cascade.viewProj;
+        cascade.proj = cascadeProj;
+        cascade.viewProj = viewProj;
+        cascade.atlasViewProj = atlasMatrix * cascade.viewProj;
+        cascade.atlasRect.offset = { int32_t(column * m_cascadeSize), int32_t(row * m_cascadeSize) };
+        cascade.atlasRect.extent = { m_cascadeSize, m_cascadeSize };
+        cascade.splitDepth = sliceFar;
+
+        sliceNear = sliceFar;
+    }
+}
+
+void RENDER_PASS_SHADOW::FillCascadeData(EFFECT_DATA::CB_LIGHTS_STRUCT& lightBufferData) const
+{
+    for (uint32_t cascadeId = 0; cascadeId < EFFECT_DATA::SHADOW_CASCADES_NUM; cascadeId++) {
+        lightBufferData.dirLightCascadeViewProj[cascadeId] = m_cascadeList[cascadeId].atlasViewProj;
+        lightBufferData.dirLightCascadeSplits[cascadeId] = m_cascadeList[cascadeId].splitDepth;
+    }
+}
+
+void RENDER_PASS_SHADOW::AddToRenderGraph(RENDER_GRAPH& renderGraph)
+{
+    //atlas content is lost after render targets are recreated
+    if (!pRenderTargetManager->IsHistoryValid(RT_SHADOW_MAP)) {
+        for (SHADOW_CASCADE& cascade : m_cascadeList) {
+            cascade.isDirty = true;
+        }
+    }
+
+    //static light and casters keep the atlas from previous frames, so the pass costs nothing
+    auto isCascadeDirty = [](const SHADOW_CASCADE& cascade) { return cascade.isDirty; };
+    if (std::none_of(m_cascadeList.begin(), m_cascadeList.end(), isCascadeDirty)) {
+        return;
+    }
+
+    //clean cascades are kept in the atlas
+    std::vector<RENDER_GRAPH_RESOURCE> resourceList = { { RT_SHADOW_MAP, RG_ACCESS_DEPTH_BUFFER, true } };
+    ECS::pEcsCoordinator->GetSystem<GPU_CULLING_SYSTEM>()->AddCullingResources(resourceList);
+    renderGraph.AddPass("shadow", resourceList, [this]() { Render(); });
 }
 
 void RENDER_PASS_SHADOW::Render()
 {
-    BeginRenderPass();
+    auto isCascadeDirty = [](const SHADOW_CASCADE& cascade) { return cascade.isDirty; };
+    const bool isAllCascadesDirty = std::all_of(m_cascadeList.begin(), m_cascadeList.end(), isCascadeDirty);
 
-    pDrvInterface->SetShader(EFFECT_DATA::SHR_SHADOW);
+    //dirty cascades are drawn in one pass, each one to its region of the atlas
+    GPU_CULLING_SYSTEM* pGpuCullingSystem = ECS::pEcsCoordinator->GetSystem<GPU_CULLING_SYSTEM>();
+    const bool isIndirect = pGpuCullingSystem->IsEnabled();
+    if (isIndirect) {
+        for (uint32_t cascadeId = 0; cascadeId < EFFECT_DATA::SHADOW_CASCADES_NUM; cascadeId++) {
+            if (m_cascadeList[cascadeId].isDirty) {
+                pGpuCullingSystem->CullInstances(GPU_CULLING_VIEW(GPU_VIEW_SHADOW_CASCADE_0 + cascadeId), m_cascadeList[cascadeId].viewProj);
+            }
+        }
+    }
+
+    BeginRenderPass(isAllCascadesDirty ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD);
+
+    pDrvInterface->SetShader(isIndirect ? EFFECT_DATA::SHR_SHADOW_INDIRECT : EFFECT_DATA::SHR_SHADOW);
 
     pDrvInterface->SetDepthTestState(true);
     pDrvInterface->SetDepthWriteState(true);
@@ -54,42 +226,67 @@ void RENDER_PASS_SHADOW::Render()
     pDrvInterface->SetStencilTestState(false);
     pDrvInterface->SetDynamicState(VK_DYNAMIC_STATE_DEPTH_BIAS, true);
     pDrvInterface->SetDepthBiasParams(DEPTH_BIAS_PARAMS.x, DEPTH_BIAS_PARAMS.y);
+    //geometry out of the cascade bounds mustn't be drawn to neighbour cascades
+    pDrvInterface->SetDynamicState(VK_DYNAMIC_STATE_SCISSOR, true);
 
     EFFECT_DATA::CB_LIGHTS_STRUCT lightBufferData;
-    lightBufferData.dirLightViewProj = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(directionalLight)->viewProjMatrix;
-    lightBufferData.pointLight0ViewProj = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(pointLights[0])->viewProjMatrix;
+    FillCascadeData(lightBufferData);
 
     pDrvInterface->FillConstBuffer(EFFECT_DATA::CB_LIGHTS, &lightBufferData, EFFECT_DATA::CONST_BUFFERS_SIZE[EFFECT_DATA::CB_LIGHTS]);
 
-    for (auto& rendEntity : m_entityList) 
-    {
-        pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_LIGHTS);
-
-        glm::mat4x4 worldTransformMatrix(1.f);
-
-        const MESH_PRIMITIVE* pMeshPrimitive = ECS::pEcsCoordinator->GetComponent<MESH_PRIMITIVE>(rendEntity);
-//         const NODE_COMPONENT* pNode = pMeshPrimitive->pParentHolder->pParentsNodes[0];
-//         worldTransformMatrix = glm::mat4_cast(pNode->rotation);
-//         worldTransformMatrix = glm::translate(worldTransformMatrix, pNode->translation);
-        pDrvInterface->FillPushConstantBuffer(&worldTransformMatrix, sizeof(worldTransformMatrix));
-
-        const VULKAN_MESH* pMesh = pMeshPrimitive->pMesh;
-        pDrvInterface->SetVertexFormat(pMesh->vertexFormatId);
-        pDrvInterface->SetVertexBuffer(pMesh->vertexBuffer, 0);
-        if (pMesh->numOfIndexes == 0) {
-            pDrvInterface->Draw(pMesh->numOfVertexes);
-        } else {
-            pDrvInterface->SetIndexBuffer(pMesh->indexBuffer, 0);
-            pDrvInterface->DrawIndexed(pMesh->numOfIndexes);
+    const VISIBILITY_SYSTEM* pVisibilitySystem = ECS::pEcsCoordinator->GetSystem<VISIBILITY_SYSTEM>();
+    for (uint32_t cascadeId = 0; cascadeId < EFFECT_DATA::SHADOW_CASCADES_NUM; cascadeId++) {
+        SHADOW_CASCADE& cascade = m_cascadeList[cascadeId];
+        if (!cascade.isDirty) {
+            continue;
+        }
+        cascade.isDirty = false;
+        if (!isAllCascadesDirty) {
+            pDrvInterface->ClearDepthBuffer(cascade.atlasRect);
+        }
+        pDrvInterface->SetScissorRect(cascade.atlasRect);
+
+        if (isIndirect) {
+            pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_LIGHTS);
+            pDrvInterface->FillPushConstantBuffer(&cascadeId, sizeof(cascadeId));
+            pGpuCullingSystem->DrawInstances(GPU_CULLING_VIEW(GPU_VIEW_SHADOW_CASCADE_0 + cascadeId));
+            continue;
+        }
+
+        pVisibilitySystem->CullFrustum(cascade.viewProj, m_casterList);
+        for (ECS::ENTITY_TYPE casterEntity : m_casterList)
+        {
+            pDrvInterface->SetConstBuffer(EFFECT_DATA::CB_LIGHTS);
+
+            glm::mat4x4 worldTransformMatrix(1.f);
+
+            const MESH_PRIMITIVE* pMeshPrimitive = ECS::pEcsCoordinator->GetComponent<MESH_PRIMITIVE>(casterEntity);
+//             const NODE_COMPONENT* pNode = pMeshPrimitive->pParentHolder->pParentsNodes[0];
+//             worldTransformMatrix = glm::mat4_cast(pNode->rotation);
+//             worldTransformMatrix = glm::translate(worldTransformMatrix, pNode->translation);
+            SHADOW_PUSH_CONSTANT pushConstant;
+            pushConstant.modelMatrix = worldTransformMatrix;
+            pushConstant.cascadeId = cascadeId;
+            pDrvInterface->FillPushConstantBuffer(&pushConstant, sizeof(pushConstant));
+
+            const VULKAN_MESH* pMesh = pMeshPrimitive->pMesh;
+            pDrvInterface->SetVertexFormat(pMesh->vertexFormatId);
+            pDrvInterface->SetVertexBuffer(pMesh->vertexBuffer, 0);
+            if (pMesh->numOfIndexes == 0) {
+                pDrvInterface->Draw(pMesh->numOfVertexes);
+            } else {
+                pDrvInterface->SetIndexBuffer(pMesh->indexBuffer, 0);
+                pDrvInterface->DrawIndexed(pMesh->numOfIndexes, pMesh->vertexOffset, pMesh->firstIndex);
+            }
         }
     }
 
     EndRenderPass();
 }
 
-void RENDER_PASS_SHADOW::BeginRenderPass()
+void RENDER_PASS_SHADOW::BeginRenderPass(VkAttachmentLoadOp loadOp)
 {
-    pRenderTargetManager->SetTextureAsDepthBuffer(RT_SHADOW_MAP, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+    pRenderTargetManager->SetTextureAsDepthBuffer(RT_SHADOW_MAP, loadOp, VK_ATTACHMENT_STORE_OP_STORE);
     pDrvInterface->BeginRenderPass();
 }
 
@@ -1,5 +1,7 @@
 #include "renderTargetManager.h"
 
+#include <algorithm>
+
 std::unique_ptr< RENDER_TARGET_MANAGER> pRenderTargetManager;
 
 bool RENDER_TARGET_MANAGER::Init(uint32_t backBufferWidth, uint32_t backBufferHeight, VkFormat backBufferFormat)
@@ -7,65 +9,50 @@ bool RENDER_TARGET_MANAGER::Init(uint32_t backBufferWidth, uint32_t backBufferHe
     m_renderTargetsAvailabilityMask.set();
 
     bool isInited = true;
-    {
-        VULKAN_TEXTURE_CREATE_DATA depthBufferCreateData(VK_FORMAT_D24_UNORM_S8_UINT,
-            VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
-        VkResult result = pDrvInterface->CreateRenderTarget(depthBufferCreateData, m_renderTargetList[RT_DEPTH_BUFFER]);
-        ASSERT(result == VK_SUCCESS);
-        isInited &= result == VK_SUCCESS;
-    }
-
-    {
-        VULKAN_TEXTURE_CREATE_DATA fp16CreateData(VK_FORMAT_R16G16B16A16_SFLOAT, VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
-        VkResult result = pDrvInterface->CreateRenderTarget(fp16CreateData, m_renderTargetList[RT_FP16]);
-        ASSERT(result == VK_SUCCESS);
-        isInited &= result == VK_SUCCESS;
-    }
+    m_transientCreateDataList[RT_DEPTH_BUFFER] = VULKAN_TEXTURE_CREATE_DATA(VK_FORMAT_D24_UNORM_S8_UINT,
+        VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
+    m_transientCreateDataList[RT_FP16] = VULKAN_TEXTURE_CREATE_DATA(VK_FORMAT_R16G16B16A16_SFLOAT,
+        VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
+    m_transientCreateDataList[RT_GBUFFER_ALBEDO] = VULKAN_TEXTURE_CREATE_DATA(VK_FORMAT_R8G8B8A8_UNORM,
+        VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
+    //10 bits per normal component are enough after octahedral encoding
+    m_transientCreateDataList[RT_GBUFFER_NORMAL] = VULKAN_TEXTURE_CREATE_DATA(VK_FORMAT_A2B10G10R10_UNORM_PACK32,
+        VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
+    m_transientCreateDataList[RT_SSAO_MASK] = VULKAN_TEXTURE_CREATE_DATA(VK_FORMAT_R8_UNORM,
+        VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
+    m_transientCreateDataList[RT_SSAO_MASK_BLENDED] = VULKAN_TEXTURE_CREATE_DATA(VK_FORMAT_R8_UNORM,
+        VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
 
     {
-        VULKAN_TEXTURE_CREATE_DATA gBufferAlbedoCreateData(VK_FORMAT_R8G8B8A8_UNORM, VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
-        VkResult result = pDrvInterface->CreateRenderTarget(gBufferAlbedoCreateData, m_renderTargetList[RT_GBUFFER_ALBEDO]);
-        ASSERT(result == VK_SUCCESS);
-        isInited &= result == VK_SUCCESS;
-    }
+        uint32_t levelWidth = backBufferWidth;
+        uint32_t levelHeight = backBufferHeight;
+        for (uint32_t levelId = 0; levelId < SSAO_REDUCED_LEVELS_NUM; levelId++) {
+            levelWidth = std::max((levelWidth + 1) / 2, 1u);
+            levelHeight = std::max((levelHeight + 1) / 2, 1u);
+            m_transientCreateDataList[RT_SSAO_DEPTH_NORMAL_HALF + levelId] = VULKAN_TEXTURE_CREATE_DATA(VK_FORMAT_R16G16B16A16_SFLOAT,
+                VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), levelWidth, levelHeight);
 
-    {
-        VULKAN_TEXTURE_CREATE_DATA gBufferNormalCreateData(VK_FORMAT_R16G16B16A16_SFLOAT, VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
-        VkResult result = pDrvInterface->CreateRenderTarget(gBufferNormalCreateData, m_renderTargetList[RT_GBUFFER_NORMAL]);
-        ASSERT(result == VK_SUCCESS);
-        isInited &= result == VK_SUCCESS;
-    }
-
-    {
-        VULKAN_TEXTURE_CREATE_DATA gBufferMetalnessRoughnessCreateData(VK_FORMAT_R8G8_UNORM, VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
-        VkResult result = pDrvInterface->CreateRenderTarget(gBufferMetalnessRoughnessCreateData, m_renderTargetList[RT_GBUFFER_METALL_ROUGHNESS]);
-        ASSERT(result == VK_SUCCESS);
-        isInited &= result == VK_SUCCESS;
-    }
-
-    {
-        VULKAN_TEXTURE_CREATE_DATA gBufferWorldPosCreateData(VK_FORMAT_R16G16B16A16_SFLOAT, VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
-        VkResult result = pDrvInterface->CreateRenderTarget(gBufferWorldPosCreateData, m_renderTargetList[RT_GBUFFER_WORLD_POS]);
-        ASSERT(result == VK_SUCCESS);
-        isInited &= result == VK_SUCCESS;
-    }
-
-    {
-        VULKAN_TEXTURE_CREATE_DATA ssaoMaskCreateData(VK_FORMAT_R8_UNORM, VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
-        VkResult result = pDrvInterface->CreateRenderTarget(ssaoMaskCreateData, m_renderTargetList[RT_SSAO_MASK]);
-        ASSERT(result == VK_SUCCESS);
-        isInited &= result == VK_SUCCESS;
+            //blur is done by compute shader, r32 is the single channel format with mandatory storage support
+            VULKAN_TEXTURE_CREATE_DATA ssaoMaskCreateData(VK_FORMAT_R32_SFLOAT,
+                VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT), levelWidth, levelHeight);
+            m_transientCreateDataList[RT_SSAO_MASK_HALF + levelId] = ssaoMaskCreateData;
+            m_transientCreateDataList[RT_SSAO_BLUR_HALF + levelId] = ssaoMaskCreateData;
+        }
     }
 
     {
-        VULKAN_TEXTURE_CREATE_DATA ssaoMaskBlendedCreateData(VK_FORMAT_R8_UNORM, VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), backBufferWidth, backBufferHeight);
-        VkResult result = pDrvInterface->CreateRenderTarget(ssaoMaskBlendedCreateData, m_renderTargetList[RT_SSAO_MASK_BLENDED]);
-        ASSERT(result == VK_SUCCESS);
-        isInited &= result == VK_SUCCESS;
+        //lifetimes are unknown till the first frame graph, so each transient target has own memory
+        std::array<uint32_t, RT_LAST> memoryIdList;
+        uint32_t memoriesNum = 0;
+        for (int rtId = 0; rtId < RT_LAST; rtId++) {
+            memoryIdList[rtId] = IsTransientRenderTarget((RENDER_TARGET_ID)rtId) ? memoriesNum++ : UINT32_MAX;
+        }
+        isInited &= CreateTransientRenderTargets(memoryIdList);
     }
 
     {
-        const uint32_t SHADOW_MAP_SIZE = 2048;
+        //atlas of 2x2 shadow cascades
+        const uint32_t SHADOW_MAP_SIZE = 4096;
         VULKAN_TEXTURE_CREATE_DATA shadowMapCreateData(VK_FORMAT_D16_UNORM, VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT),
             SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
         VkResult result = pDrvInterface->CreateRenderTarget(shadowMapCreateData, m_renderTargetList[RT_SHADOW_MAP]);
@@ -73,6 +60,20 @@ bool RENDER_TARGET_MANAGER::Init(uint32_t backBufferWidth, uint32_t backBufferHe
         isInited &= result == VK_SUCCESS;
     }
 
+    {
+        uint32_t levelWidth = backBufferWidth;
+        uint32_t levelHeight = backBufferHeight;
+        for (uint32_t levelId = 0; levelId < HI_Z_LEVELS_NUM; levelId++) {
+            //rounded up, so every texel of previous level is covered
+            levelWidth = std::max((levelWidth + 1) / 2, 1u);
+            levelHeight = std::max((levelHeight + 1) / 2, 1u);
+            VULKAN_TEXTURE_CREATE_DATA hiZCreateData(VK_FORMAT_R32_SFLOAT, VkImageUsageFlagBits(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT), levelWidth, levelHeight);
+            VkResult result = pDrvInterface->CreateRenderTarget(hiZCreateData, m_renderTargetList[RT_HI_Z_0 + levelId]);
+            ASSERT(result == VK_SUCCESS);
+            isInited &= result == VK_SUCCESS;
+        }
+    }
+
     m_renderTargetList[RT_BACK_BUFFER].format = backBufferFormat;
 
     for (int i = 0; i < RT_LAST; i++)
@@ -101,8 +102,11 @@ void RENDER_TARGET_MANAGER::Resize(uint32_t backBufferWidth, uint32_t backBuffer
 void RENDER_TARGET_MANAGER::Term()
 {
     static_assert(RT_BACK_BUFFER + 1 == RT_LAST);
+    DestroyTransientRenderTargets();
     for (int i = 0; i < RT_BACK_BUFFER; i++) {
-        pDrvInterface->DestroyTexture(m_renderTargetList[i]);
+        if (!IsTransientRenderTarget((RENDER_TARGET_ID)i)) {
+            pDrvInterface->DestroyTexture(m_renderTargetList[i]);
+        }
     }
 }
 
@@ -110,14 +114,19 @@ void RENDER_TARGET_MANAGER::StartFrame()
 {
     ASSERT(m_renderTargetsAvailabilityMask.all());
     m_renderTargetList[RT_BACK_BUFFER] = pDrvInterface->GetCurSwapChainTexture();
-    for (auto& desc : m_renderTargetDesc) {
+    for (int rtId = 0; rtId < RT_LAST; rtId++) {
+        auto& desc = m_renderTargetDesc[rtId];
         desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        desc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        desc.finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if (!IsHistoryRenderTarget((RENDER_TARGET_ID)rtId)) {
+            desc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            desc.finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        }
         desc.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         desc.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     }
+    m_skipLoadMask.reset();
+    m_skipStoreMask.reset();
 }
 
 void RENDER_TARGET_MANAGER::EndFrame()
@@ -127,6 +136,19 @@ void RENDER_TARGET_MANAGER::EndFrame()
     ReturnRenderTarget(RT_BACK_BUFFER);
 }
 
+bool RENDER_TARGET_MANAGER::IsHistoryRenderTarget(RENDER_TARGET_ID rtIndex) const
+{
+    //shadow map is cached while light and casters don't change
+    return rtIndex == RT_SHADOW_MAP || (rtIndex >= RT_HI_Z_0 && rtIndex <= RT_HI_Z_7);
+}
+
+bool RENDER_TARGET_MANAGER::IsHistoryValid(RENDER_TARGET_ID rtIndex) const
+{
+    ASSERT(IsHistoryRenderTarget(rtIndex));
+    //layout is undefined until the target is written after creation
+    return m_renderTargetDesc[rtIndex].initialLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+}
+
 void RENDER_TARGET_MANAGER::SetTextureAsRenderTarget(RENDER_TARGET_ID rtIndex, size_t slotIndex, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp)
 {
     ObtainRenderTarget(
@@ -134,8 +156,7 @@ void RENDER_TARGET_MANAGER::SetTextureAsRenderTarget(RENDER_TARGET_ID rtIndex, s
         VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
     );
-    m_renderTargetDesc[rtIndex].loadOp = loadOp;
-    m_renderTargetDesc[rtIndex].storeOp = storeOp;
+    SetAttachmentOps(rtIndex, loadOp, storeOp);
     pDrvInterface->SetRenderTarget(&m_renderTargetList[rtIndex], slotIndex, m_renderTargetDesc[rtIndex]);
 }
 
@@ -146,8 +167,7 @@ void RENDER_TARGET_MANAGER::SetTextureAsDepthBuffer(RENDER_TARGET_ID rtIndex, Vk
         VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
         VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
     );
-    m_renderTargetDesc[rtIndex].loadOp = loadOp;
-    m_renderTargetDesc[rtIndex].storeOp = storeOp;
+    SetAttachmentOps(rtIndex, loadOp, storeOp);
     pDrvInterface->SetDepthBuffer(&m_renderTargetList[rtIndex], m_renderTargetDesc[rtIndex]);
 }
 
@@ -157,18 +177,41 @@ void RENDER_TARGET_MANAGER::SetTextureAsSRV(RENDER_TARGET_ID rtIndex, size_t slo
     pDrvInterface->SetTexture(&m_renderTargetList[rtIndex], slotIndex);
 }
 
+void RENDER_TARGET_MANAGER::SetTextureAsUAV(RENDER_TARGET_ID rtIndex, size_t slotIndex)
+{
+    ObtainRenderTarget(rtIndex, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL);
+    pDrvInterface->SetStorageImage(&m_renderTargetList[rtIndex], slotIndex);
+}
+
 void RENDER_TARGET_MANAGER::ObtainRenderTarget(RENDER_TARGET_ID rtIndex, VkAccessFlags accessFlags, VkImageLayout layout)
 {
     ASSERT(m_renderTargetsAvailabilityMask.test(rtIndex));
     m_renderTargetsAvailabilityMask.reset(rtIndex);
     
+    std::vector<TEXTURE_LAYOUT_TRANSITION> transitionList;
+    AddTransition(rtIndex, layout, transitionList);
+    pDrvInterface->ChangeTextureLayouts(transitionList);
+}
+
+void RENDER_TARGET_MANAGER::AddTransition(RENDER_TARGET_ID rtIndex, VkImageLayout layout, std::vector<TEXTURE_LAYOUT_TRANSITION>& transitionList)
+{
+    //initial layout is set to final one when target is returned
     VkAttachmentDescription& desc = m_renderTargetDesc[rtIndex];
     desc.finalLayout = layout;
     if (desc.initialLayout != desc.finalLayout) {
-        pDrvInterface->ChangeTextureLayout(desc.initialLayout, desc.finalLayout, m_renderTargetList[rtIndex]);
+        //undefined layout means the first use in the frame, memory could be used by other target before
+        const bool isAliased = desc.initialLayout == VK_IMAGE_LAYOUT_UNDEFINED && m_aliasedMask.test(rtIndex);
+        transitionList.push_back({ &m_renderTargetList[rtIndex], desc.initialLayout, desc.finalLayout, isAliased });
     }
 }
 
+void RENDER_TARGET_MANAGER::SetAttachmentOps(RENDER_TARGET_ID rtIndex, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp)
+{
+    VkAttachmentDescription& desc = m_renderTargetDesc[rtIndex];
+    desc.loadOp = loadOp == VK_ATTACHMENT_LOAD_OP_LOAD && m_skipLoadMask.test(rtIndex) ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : loadOp;
+    desc.storeOp = m_skipStoreMask.test(rtIndex) ? VK_ATTACHMENT_STORE_OP_DONT_CARE : storeOp;
+}
+
 void RENDER_TARGET_MANAGER::ReturnRenderTarget(RENDER_TARGET_ID rtIndex)
 {
     m_renderTargetsAvailabilityMask.set(rtIndex);
@@ -185,3 +228,135 @@ void RENDER_TARGET_MANAGER::ReturnAllRenderTargetsToPool()
         }
     }
 }
+
+void RENDER_TARGET_MANAGER::ChangeLayouts(const std::vector<RENDER_TARGET_TRANSITION>& transitionList)
+{
+    std::vector<TEXTURE_LAYOUT_TRANSITION> textureTransitionList;
+    for (const RENDER_TARGET_TRANSITION& transition : transitionList) {
+        ASSERT(m_renderTargetsAvailabilityMask.test(transition.rtIndex));
+        AddTransition(transition.rtIndex, transition.layout, textureTransitionList);
+        m_renderTargetDesc[transition.rtIndex].initialLayout = transition.layout;
+    }
+    pDrvInterface->ChangeTextureLayouts(textureTransitionList);
+}
+
+void RENDER_TARGET_MANAGER::SetContentUsage(RENDER_TARGET_ID rtIndex, bool isContentLoaded, bool isContentStored)
+{
+    m_skipLoadMask.set(rtIndex, !isContentLoaded);
+    m_skipStoreMask.set(rtIndex, !isContentStored);
+}
+
+void RENDER_TARGET_MANAGER::AliasTransientRenderTargets(const std::array<RENDER_TARGET_LIFETIME, RT_LAST>& lifetimeList)
+{
+    //bigger targets are placed first, smaller ones reuse their memory
+    std::vector<RENDER_TARGET_ID> transientList;
+    for (int rtId = 0; rtId < RT_LAST; rtId++) {
+        if (IsTransientRenderTarget((RENDER_TARGET_ID)rtId)) {
+            transientList.push_back((RENDER_TARGET_ID)rtId);
+        }
+    }
+    std::stable_sort(transientList.begin(), transientList.end(), [this](RENDER_TARGET_ID left, RENDER_TARGET_ID right) {
+        return m_memRequirementsList[left].size > m_memRequirementsList[right].size;
+    });
+
+    struct MEMORY_SLOT
+    {
+        uint32_t                      memoryTypeBits;
+        std::vector<RENDER_TARGET_ID> rtList;
+    };
+    std::vector<MEMORY_SLOT> slotList;
+    std::array<uint32_t, RT_LAST> memoryIdList;
+    memoryIdList.fill(UINT32_MAX);
+    for (RENDER_TARGET_ID rtIndex : transientList) {
+        const VkMemoryRequirements& memRequirements = m_memRequirementsList[rtIndex];
+        auto isSlotFree = [&](const MEMORY_SLOT& slot) {
+            if ((slot.memoryTypeBits & memRequirements.memoryTypeBits) == 0) {
+                return false;
+            }
+            return std::none_of(slot.rtList.begin(), slot.rtList.end(), [&](RENDER_TARGET_ID slotRtIndex) {
+                return lifetimeList[slotRtIndex].IsOverlapped(lifetimeList[rtIndex]);
+            });
+        };
+        auto slotIt = std::find_if(slotList.begin(), slotList.end(), isSlotFree);
+        if (slotIt == slotList.end()) {
+            slotIt = slotList.insert(slotList.end(), MEMORY_SLOT{ memRequirements.memoryTypeBits, {} });
+        }
+        slotIt->memoryTypeBits &= memRequirements.memoryTypeBits;
+        slotIt->rtList.push_back(rtIndex);
+        memoryIdList[rtIndex] = static_cast<uint32_t>(slotIt - slotList.begin());
+    }
+
+    if (memoryIdList == m_memoryIdList) {
+        return;
+    }
+
+    //images can't be rebound, so all transient targets are created again
+    pDrvInterface->WaitGPU();
+    pDrvInterface->DropFrameBufferCache();
+    DestroyTransientRenderTargets();
+    bool isCreated = CreateTransientRenderTargets(memoryIdList);
+    ASSERT(isCreated);
+}
+
+bool RENDER_TARGET_MANAGER::CreateTransientRenderTargets(const std::array<uint32_t, RT_LAST>& memoryIdList)
+{
+    m_memoryIdList = memoryIdList;
+    m_aliasedMask.reset();
+
+    std::vector<VkMemoryRequirements> memoryRequirementsList;
+    std::vector<uint32_t> memoryUsersNumList;
+    bool isCreated = true;
+    for (int rtId = 0; rtId < RT_LAST; rtId++) {
+        const uint32_t memoryId = m_memoryIdList[rtId];
+        if (memoryId == UINT32_MAX) {
+            continue;
+        }
+        VkMemoryRequirements& memRequirements = m_memRequirementsList[rtId];
+        VkResult result = pDrvInterface->CreateAliasedRenderTarget(m_transientCreateDataList[rtId], m_renderTargetList[rtId], memRequirements);
+        ASSERT(result == VK_SUCCESS);
+        isCreated &= result == VK_SUCCESS;
+
+        if (memoryId >= memoryRequirementsList.size()) {
+            memoryRequirementsList.resize(memoryId + 1, VkMemoryRequirements{ 0, 1, UINT32_MAX });
+            memoryUsersNumList.resize(memoryId + 1, 0);
+        }
+        VkMemoryRequirements& sharedRequirements = memoryRequirementsList[memoryId];
+        sharedRequirements.size = std::max(sharedRequirements.size, memRequirements.size);
+        sharedRequirements.alignment = std::max(sharedRequirements.alignment, memRequirements.alignment);
+        sharedRequirements.memoryTypeBits &= memRequirements.memoryTypeBits;
+        memoryUsersNumList[memoryId]++;
+    }
+
+    m_aliasedMemoryList.resize(memoryRequirementsList.size());
+    for (size_t memoryId = 0; memoryId < memoryRequirementsList.size(); memoryId++) {
+        VkResult result = pDrvInterface->AllocateAliasedMemory(memoryRequirementsList[memoryId], m_aliasedMemoryList[memoryId]);
+        ASSERT(result == VK_SUCCESS);
+        isCreated &= result == VK_SUCCESS;
+    }
+
+    for (int rtId = 0; rtId < RT_LAST; rtId++) {
+        const uint32_t memoryId = m_memoryIdList[rtId];
+        if (memoryId == UINT32_MAX) {
+            continue;
+        }
+        VkResult result = pDrvInterface->BindAliasedMemory(m_aliasedMemoryList[memoryId], m_renderTargetList[rtId]);
+        ASSERT(result == VK_SUCCESS);
+        isCreated &= result == VK_SUCCESS;
+        m_aliasedMask.set(rtId, memoryUsersNumList[memoryId] > 1);
+        m_renderTargetDesc[rtId].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+    return isCreated;
+}
+
+void RENDER_TARGET_MANAGER::DestroyTransientRenderTargets()
+{
+    for (int rtId = 0; rtId < RT_LAST; rtId++) {
+        if (m_memoryIdList[rtId] != UINT32_MAX) {
+            pDrvInterface->DestroyTexture(m_renderTargetList[rtId]);
+        }
+    }
+    for (VULKAN_MEMORY_ALLOCATION& allocation : m_aliasedMemoryList) {
+        pDrvInterface->FreeAliasedMemory(allocation);
+    }
+    m_aliasedMemoryList.clear();
+}
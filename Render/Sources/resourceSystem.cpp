@@ -1,20 +1,21 @@
 #include "resourceSystem.h"
 #include "shaderManager.h"
 #include "geometry.h"
+#include "meshCooker.h"
+#include "textureCooker.h"
+#include "textureStreamingManager.h"
+#include "commonRenderVariables.h"
+#include "visibilitySystem.h"
 
 #include "ecsCoordinator.h"
+#include "jobSystem.h"
+
+#include <algorithm>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <gli.hpp>
 
-#define TINYGLTF_IMPLEMENTATION
-#define TINYGLTF_NO_STB_IMAGE
-#define TINYGLTF_NO_STB_IMAGE_WRITE
-#define TINYGLTF_NO_EXTERNAL_IMAGE
-#define TINYGLTF_NOEXCEPTION
-#define JSON_NOEXCEPTION
-#include "tiny_gltf.h"
-
+#include "Components/camera.h"
 #include "Components/rendered.h"
 
 std::unique_ptr<RESOURCE_SYSTEM> pResourceSystem;
@@ -25,56 +26,107 @@ void RESOURCE_SYSTEM::Init()
     //pMeshManager.reset(new MESH_MANAGER);
     //pTextureManager.reset(new TEXTURE_MANAGER);
     pVertexDeclarationManager.reset(new VERTEX_DECLARATION_MANAGER);
+    pTextureStreamingManager.reset(new TEXTURE_STREAMING_MANAGER);
 
     pShaderManager->Init();
     //pMeshManager->Init();
     //pTextureManager->Init();
     pVertexDeclarationManager->Init();
-}
-
-VkFormat CastGltfToVulkanTextureFormat(int componentNum, int componentType) 
-{
-    if (componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
-        if (componentNum == 4) {
-            return VK_FORMAT_R8G8B8A8_SRGB;
-        }
-    }
-    ASSERT_MSG(false, "Unknown texture type!");
-    return VK_FORMAT_UNDEFINED;
+    pTextureStreamingManager->Init(TEXTURE_MEMORY_BUDGET);
 }
 
 void RESOURCE_SYSTEM::CreateDefaultResources()
 {
     CreateDefalutTextures();
+    CreateSharedGeometryBuffers();
 }
 
-bool RESOURCE_SYSTEM::LoadModel (const std::string& modelName)
+void RESOURCE_SYSTEM::CreateSharedGeometryBuffers()
 {
-    tinygltf::Model gltfModel;
-    tinygltf::TinyGLTF gltfContext;
-    std::string error;
-    std::string warning;
-
-    const std::string GLTF_MESH_DIR = "../Media/Meshes/gltf/";
-    const std::string GLTF_MESH_EXT = ".gltf";
-    std::string levelName = GLTF_MESH_DIR + modelName + "/glTF/" + modelName + GLTF_MESH_EXT;
+    m_sharedVertexesNum = 0;
+    m_sharedIndexesNum = 0;
+
+    VkBufferCreateInfo vertexBufferInfo = {};
+    vertexBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    vertexBufferInfo.size = SHARED_VERTEX_BUFFER_SIZE;
+    vertexBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    vertexBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkResult vertexBufferCreated = pDrvInterface->CreateBuffer(vertexBufferInfo, false, m_sharedVertexBuffer);
+    ASSERT_MSG(vertexBufferCreated == VK_SUCCESS, "Shared vertex buffer not created!");
+
+    VkBufferCreateInfo indexBufferInfo = {};
+    indexBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    indexBufferInfo.size = SHARED_INDEX_BUFFER_SIZE;
+    indexBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    indexBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkResult indexBufferCreated = pDrvInterface->CreateBuffer(indexBufferInfo, false, m_sharedIndexBuffer);
+    ASSERT_MSG(indexBufferCreated == VK_SUCCESS, "Shared index buffer not created!");
+}
 
-    bool binary = false;
-    size_t extpos = levelName.rfind('.', levelName.length());
-    if (extpos != std::string::npos) {
-        binary = (levelName.substr(extpos + 1, levelName.length() - extpos) == "glb");
+bool RESOURCE_SYSTEM::AddGeometryToSharedBuffers(const uint8_t* pVertexData, uint32_t vertexesNum, const uint8_t* pIndexData, uint32_t indexesNum)
+{
+    const uint64_t vertexDataSize = uint64_t(vertexesNum) * sizeof(SIMPLE_VERTEX);
+    const uint64_t indexDataSize = uint64_t(indexesNum) * sizeof(uint16_t);
+    const uint64_t vertexDataOffset = uint64_t(m_sharedVertexesNum) * sizeof(SIMPLE_VERTEX);
+    const uint64_t indexDataOffset = uint64_t(m_sharedIndexesNum) * sizeof(uint16_t);
+    if (vertexDataOffset + vertexDataSize > m_sharedVertexBuffer.bufferSize || indexDataOffset + indexDataSize > m_sharedIndexBuffer.bufferSize) {
+        ERROR_MSG("Shared geometry buffers are full!");
+        return false;
     }
 
-    bool fileLoaded = false;
-    if (binary) {
-        fileLoaded = gltfContext.LoadBinaryFromFile(&gltfModel, &error, &warning, levelName.c_str());
-    } else {
-        fileLoaded = gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, levelName.c_str());
+    //indexes stay 16 bit, vertex offset of the draw moves them to the mesh part of the buffer
+    if (vertexDataSize) {
+        pDrvInterface->UploadBuffer(pVertexData, vertexDataSize, vertexDataOffset, m_sharedVertexBuffer);
+    }
+    if (indexDataSize) {
+        pDrvInterface->UploadBuffer(pIndexData, indexDataSize, indexDataOffset, m_sharedIndexBuffer);
     }
 
-    if (!fileLoaded) {
-        WARNING_MSG(formatString("Can't open %s mesh file! %s\n", levelName.c_str(), error.c_str()).c_str());
+    m_sharedVertexesNum += vertexesNum;
+    m_sharedIndexesNum += indexesNum;
+    return true;
+}
 
+bool RESOURCE_SYSTEM::LoadModel (const std::string& modelName)
+{
+    const std::string GLTF_MESH_DIR = "../Media/Meshes/gltf/";
+    const std::string GLTF_MESH_EXT = ".gltf";
+    const std::string modelDir = GLTF_MESH_DIR + modelName + "/glTF";
+    const std::string levelName = modelDir + "/" + modelName + GLTF_MESH_EXT;
+    const std::string packagePath = CACHE_MESH_DIR + modelName + MESH_PACKAGE_EXT;
+
+    //gltf is parsed only when package is missing or sources are changed, otherwise data is used right from the mapped file
+    MAPPED_FILE packageFile;
+    if (!packageFile.Open(packagePath) || !IsMeshPackageUpToDate(packageFile.GetData(), packageFile.GetSize())) {
+        packageFile.Close();
+        DEBUG_MSG(formatString("Can't load mesh %s from cache\n", modelName.c_str()).c_str());
+        if (!CookMesh(levelName, packagePath)) {
+            ERROR_MSG("Can't create cached version!");
+            return false;
+        }
+        if (!packageFile.Open(packagePath) || !IsMeshPackageUpToDate(packageFile.GetData(), packageFile.GetSize())) {
+            ERROR_MSG("Can't load cached version!");
+            return false;
+        }
+    }
+    const uint8_t* pPackageData = packageFile.GetData();
+    const MESH_PACKAGE_HEADER& packageHeader = *reinterpret_cast<const MESH_PACKAGE_HEADER*>(pPackageData);
+    const uint32_t imagesNum = packageHeader.sectionSizes[MESH_PACKAGE_IMAGES];
+    const uint32_t materialsNum = packageHeader.sectionSizes[MESH_PACKAGE_MATERIALS];
+    const uint32_t nodesNum = packageHeader.sectionSizes[MESH_PACKAGE_NODES];
+
+    //stores are fixed size and shared geometry can't grow, so model which doesn't fit is not loaded at all
+    const uint32_t primitivesNum = packageHeader.sectionSizes[MESH_PACKAGE_PRIMITIVES];
+    const uint32_t meshHoldersNum = packageHeader.sectionSizes[MESH_PACKAGE_MESH_HOLDERS];
+    if (uint64_t(m_meshNum) + primitivesNum > MAX_ARRAY_SIZE || uint64_t(m_meshHolderNum) + meshHoldersNum > MAX_ARRAY_SIZE ||
+        uint64_t(m_textureNum) + imagesNum > MAX_ARRAY_SIZE || uint64_t(m_materialNum) + materialsNum > MAX_ARRAY_SIZE ||
+        uint64_t(m_nodeNum) + nodesNum > MAX_ARRAY_SIZE) {
+        WARNING_MSG(formatString("Model %s doesn't fit resource stores!\n", modelName.c_str()).c_str());
+        return false;
+    }
+    if ((uint64_t(m_sharedVertexesNum) + packageHeader.sectionSizes[MESH_PACKAGE_VERTEXES]) * sizeof(SIMPLE_VERTEX) > m_sharedVertexBuffer.bufferSize ||
+        (uint64_t(m_sharedIndexesNum) + packageHeader.sectionSizes[MESH_PACKAGE_INDEXES]) * sizeof(uint16_t) > m_sharedIndexBuffer.bufferSize) {
+        WARNING_MSG(formatString("Model %s doesn't fit shared geometry buffers!\n", modelName.c_str()).c_str());
         return false;
     }
 
@@ -84,248 +136,119 @@ bool RESOURCE_SYSTEM::LoadModel (const std::string& modelName)
     uint32_t storeMaterialOffset = m_materialNum;
     uint32_t storeNodeOffset = m_nodeNum;
 
-    {
-        size_t numOfPrimitiveMeshes = 0;
-        for (size_t meshId = 0; meshId < gltfModel.meshes.size(); meshId++) {
-            numOfPrimitiveMeshes += gltfModel.meshes[meshId].primitives.size();
-        }
-        m_meshNum += numOfPrimitiveMeshes;
-        m_meshHolderNum += gltfModel.meshes.size();
-        m_textureNum += gltfModel.images.size();
-        m_materialNum += gltfModel.materials.size();
-        m_nodeNum += gltfModel.nodes.size();
+    m_meshNum += primitivesNum;
+    m_meshHolderNum += meshHoldersNum;
+    m_textureNum += imagesNum;
+    m_materialNum += materialsNum;
+    m_nodeNum += nodesNum;
+
+    //textures are decoded and uploaded by workers while geometry is copied, materials get them after all are done
+    const MESH_PACKAGE_IMAGE* pImageList = GetMeshPackageSection<MESH_PACKAGE_IMAGE>(pPackageData, MESH_PACKAGE_IMAGES);
+    ECS::JOB_COUNTER textureCounter;
+    std::atomic<uint32_t> loadedTexturesNum(0);
+    for (uint32_t imageId = 0; imageId < imagesNum; imageId++) {
+        ECS::pJobSystem->Schedule([this, pPackageData, pImageList, &modelDir, &loadedTexturesNum, imageId, storeTextureOffset]() {
+            const MESH_PACKAGE_IMAGE& image = pImageList[imageId];
+            bool isTextureLoaded = LoadTexture(GetMeshPackageString(pPackageData, image.uri), modelDir, image.sourceHash, TEXTURE_COOK_FORMAT(image.cookFormat),
+                m_textureList[storeTextureOffset + imageId]);
+            ASSERT(isTextureLoaded);
+            //gpu copies finished textures while the rest are still decoded
+            if (++loadedTexturesNum % TEXTURE_UPLOAD_BATCH_SIZE == 0) {
+                pDrvInterface->SubmitUploads();
+            }
+        }, &textureCounter);
     }
 
-    std::string baseDir = tinygltf::GetBaseDir(levelName);
-    for (size_t texId = 0; texId < gltfModel.images.size(); texId++) {
-        const tinygltf::Image& image = gltfModel.images[texId];
-        bool isTextureLoaded = LoadTexture(image.uri, baseDir, m_textureList[storeTextureOffset + texId]);
-        ASSERT(isTextureLoaded);
+    const bool isMeshesLoaded = LoadMeshes(pPackageData, storeMeshOffset, storeMeshHolderOffset, storeMaterialOffset);
+    ECS::pJobSystem->Wait(textureCounter);
+    if (!isMeshesLoaded) {
+        return false;
     }
 
-    for (size_t materialId = 0; materialId < gltfModel.materials.size(); materialId++) {
-        const tinygltf::Material& gltfMaterial = gltfModel.materials[materialId];
+    auto GetMaterialTexture = [this, storeTextureOffset](int32_t imageId, DEFAULT_TEXTURES defaultTextureId) -> const VULKAN_TEXTURE* {
+        return imageId != -1 ? &m_textureList[storeTextureOffset + imageId] : &m_defaultTextureList[defaultTextureId];
+    };
+    const MESH_PACKAGE_MATERIAL* pMaterialList = GetMeshPackageSection<MESH_PACKAGE_MATERIAL>(pPackageData, MESH_PACKAGE_MATERIALS);
+    for (uint32_t materialId = 0; materialId < materialsNum; materialId++) {
+        const MESH_PACKAGE_MATERIAL& packageMaterial = pMaterialList[materialId];
 
         MATERIAL_COMPONENT& material = m_materialsList[storeMaterialOffset + materialId];
 
-        material.isDoubleSided = gltfMaterial.doubleSided;
-        material.baseColor = glm::make_vec4(gltfMaterial.pbrMetallicRoughness.baseColorFactor.data());
-
-        if (gltfMaterial.pbrMetallicRoughness.baseColorTexture.index != -1) {
-            material.pAlbedoTex = &m_textureList[storeTextureOffset + gltfMaterial.pbrMetallicRoughness.baseColorTexture.index];
-        } else {
-            material.pAlbedoTex = &m_defaultTextureList[DEFAULT_RED_TEXTURE];
-        }
-
-        if (gltfMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index != -1) {
-            material.pMetalRoughnessTex = &m_textureList[storeTextureOffset + gltfMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index];
-        } else {
-            material.pMetalRoughnessTex = &m_defaultTextureList[DEFAULT_GREEN_TEXTURE];
+        material.isDoubleSided = packageMaterial.isDoubleSided != 0;
+        material.baseColor = packageMaterial.baseColor;
+        material.pAlbedoTex = GetMaterialTexture(packageMaterial.albedoImageId, DEFAULT_RED_TEXTURE);
+        material.pMetalRoughnessTex = GetMaterialTexture(packageMaterial.metalRoughnessImageId, DEFAULT_GREEN_TEXTURE);
+        material.pNormalTex = GetMaterialTexture(packageMaterial.normalImageId, DEFAULT_NORMAL_TEXTURE);
+        material.pEmissiveTex = GetMaterialTexture(packageMaterial.emissiveImageId, DEFAULT_BLACK_TEXTURE);
+        material.materialId = storeMaterialOffset + materialId;
+        if (pDrvInterface->IsBindlessSupported()) {
+            const uint32_t firstTextureId = material.materialId * EFFECT_DATA::BINDLESS_MATERIAL_TEXTURES_NUM;
+            pDrvInterface->SetBindlessTexture(firstTextureId + EFFECT_DATA::BINDLESS_ALBEDO, material.pAlbedoTex);
+            pDrvInterface->SetBindlessTexture(firstTextureId + EFFECT_DATA::BINDLESS_NORMAL, material.pNormalTex);
+            pDrvInterface->SetBindlessTexture(firstTextureId + EFFECT_DATA::BINDLESS_METAL_ROUGHNESS, material.pMetalRoughnessTex);
         }
 
-        if (gltfMaterial.normalTexture.index != -1) {
-            material.pNormalTex = &m_textureList[storeTextureOffset + gltfMaterial.normalTexture.index];
-        } else {
-            material.pNormalTex = &m_defaultTextureList[DEFAULT_NORMAL_TEXTURE];
-        }
-        if (gltfMaterial.emissiveTexture.index != -1) {
-            material.pEmissiveTex = &m_textureList[storeTextureOffset + gltfMaterial.emissiveTexture.index];
-        } else {
-            material.pEmissiveTex = &m_defaultTextureList[DEFAULT_BLACK_TEXTURE];
-        }
-//         if (mat.additionalValues.find("occlusionTexture") != mat.additionalValues.end()) {
-//             material.occlusionTexture = &textures[mat.additionalValues["occlusionTexture"].TextureIndex()];
-//             material.texCoordSets.occlusion = mat.additionalValues["occlusionTexture"].TextureTexCoord();
-//         }
-        material.alphaCutFactor = static_cast<float>(gltfMaterial.alphaCutoff);
-        if (gltfMaterial.alphaMode == "BLEND") {
-            material.alphaMode = MATERIAL_COMPONENT::ALPHA_MODE::ALPHA_BLEND;
-        }
-        if (gltfMaterial.alphaMode == "MASK") {
-            material.alphaMode = MATERIAL_COMPONENT::ALPHA_MODE::ALPHA_MASK;
-        }
-//         if (mat.additionalValues.find("emissiveFactor") != mat.additionalValues.end()) {
-//             material.emissiveFactor = glm::vec4(glm::make_vec3(mat.additionalValues["emissiveFactor"].ColorFactor().data()), 1.0);
-//             material.emissiveFactor = glm::vec4(0.0f);
-//         }
-
-        // Extensions
-        // @TODO: Find out if there is a nicer way of reading these properties with recent tinygltf headers
-//         if (mat.extensions.find("KHR_materials_pbrSpecularGlossiness") != mat.extensions.end()) {
-//             auto ext = mat.extensions.find("KHR_materials_pbrSpecularGlossiness");
-//             if (ext->second.Has("specularGlossinessTexture")) {
-//                 auto index = ext->second.Get("specularGlossinessTexture").Get("index");
-//                 material.extension.specularGlossinessTexture = &textures[index.Get<int>()];
-//                 auto texCoordSet = ext->second.Get("specularGlossinessTexture").Get("texCoord");
-//                 material.texCoordSets.specularGlossiness = texCoordSet.Get<int>();
-//                 material.pbrWorkflows.specularGlossiness = true;
-//             }
-//             if (ext->second.Has("diffuseTexture")) {
-//                 auto index = ext->second.Get("diffuseTexture").Get("index");
-//                 material.extension.diffuseTexture = &textures[index.Get<int>()];
-//             }
-//             if (ext->second.Has("diffuseFactor")) {
-//                 auto factor = ext->second.Get("diffuseFactor");
-//                 for (uint32_t i = 0; i < factor.ArrayLen(); i++) {
-//                     auto val = factor.Get(i);
-//                     material.extension.diffuseFactor[i] = val.IsNumber() ? (float)val.Get<double>() : (float)val.Get<int>();
-//                 }
-//             }
-//             if (ext->second.Has("specularFactor")) {
-//                 auto factor = ext->second.Get("specularFactor");
-//                 for (uint32_t i = 0; i < factor.ArrayLen(); i++) {
-//                     auto val = factor.Get(i);
-//                     material.extension.specularFactor[i] = val.IsNumber() ? (float)val.Get<double>() : (float)val.Get<int>();
-//                 }
-//             }
-//         }
+        material.alphaCutFactor = packageMaterial.alphaCutFactor;
+        material.alphaMode = static_cast<MATERIAL_COMPONENT::ALPHA_MODE>(packageMaterial.alphaMode);
     }
 
+    const MESH_PACKAGE_NODE* pNodeList = GetMeshPackageSection<MESH_PACKAGE_NODE>(pPackageData, MESH_PACKAGE_NODES);
+    for (uint32_t nodeId = 0; nodeId < nodesNum; nodeId++) {
+        const MESH_PACKAGE_NODE& packageNode = pNodeList[nodeId];
 
-    //load meshes
-    for (size_t meshId = 0; meshId < gltfModel.meshes.size(); meshId++) {
-        const tinygltf::Mesh& gltfMesh = gltfModel.meshes[meshId];
-        MESH_HOLDER_COMPONENT& meshHolder = m_meshHolderList[storeMeshHolderOffset + meshId];
-        meshHolder.meshPrimitives.resize(gltfMesh.primitives.size());
-        for (size_t primitiveId = 0; primitiveId < gltfMesh.primitives.size(); primitiveId++) {
-            const tinygltf::Primitive& gltfPrimitive = gltfMesh.primitives[primitiveId];
-            ASSERT(gltfPrimitive.mode == TINYGLTF_MODE_TRIANGLES);
-
-            const unsigned char* bufferPos = nullptr;
-            size_t posByteStride = 0;
-            const unsigned char* bufferNormals = nullptr;
-            size_t normByteStride = 0;
-            const unsigned char* bufferTexCoordSet0 = nullptr;
-            size_t uv0ByteStride = 0;
-            const unsigned char* bufferTexCoordSet1 = nullptr;
-            size_t uv1ByteStride = 0;
-            size_t indexCount = 0;
-            bool isMeshHasIndexes = true;
-
-            const tinygltf::Accessor& posAccessor = gltfModel.accessors[gltfPrimitive.attributes.find("POSITION")->second];
-            const tinygltf::BufferView& posView = gltfModel.bufferViews[posAccessor.bufferView];
-            bufferPos = &(gltfModel.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]);
-            posByteStride = posAccessor.ByteStride(posView);
-
-
-            if (gltfPrimitive.attributes.find("NORMAL") != gltfPrimitive.attributes.end()) {
-                const tinygltf::Accessor& normAccessor = gltfModel.accessors[gltfPrimitive.attributes.find("NORMAL")->second];
-                const tinygltf::BufferView& normView = gltfModel.bufferViews[normAccessor.bufferView];
-                bufferNormals = &(gltfModel.buffers[normView.buffer].data[normAccessor.byteOffset + normView.byteOffset]);
-                normByteStride = normAccessor.ByteStride(normView);
-            }
+        NODE_COMPONENT& node = m_nodeList[storeNodeOffset + nodeId];
+        node.translation = packageNode.translation;
+        node.rotation = glm::make_quat(glm::value_ptr(packageNode.rotation));
+        node.scale = packageNode.scale;
+        node.matrix = packageNode.matrix;
+        if (packageNode.meshHolderId > -1) {
+            m_meshHolderList[storeMeshHolderOffset + packageNode.meshHolderId].pParentsNodes.push_back(&node);
+            node.mesh = &m_meshHolderList[storeMeshHolderOffset + packageNode.meshHolderId];
+        }
+    }
 
-            if (gltfPrimitive.attributes.find("TEXCOORD_0") != gltfPrimitive.attributes.end()) {
-                const tinygltf::Accessor& uvAccessor = gltfModel.accessors[gltfPrimitive.attributes.find("TEXCOORD_0")->second];
-                const tinygltf::BufferView& uvView = gltfModel.bufferViews[uvAccessor.bufferView];
-                bufferTexCoordSet0 = &(gltfModel.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]);
-                uv0ByteStride = uvAccessor.ByteStride(uvView);
-            }
+    return true;
+}
 
-            if (gltfPrimitive.attributes.find("TEXCOORD_1") != gltfPrimitive.attributes.end()) {
-                const tinygltf::Accessor& uvAccessor = gltfModel.accessors[gltfPrimitive.attributes.find("TEXCOORD_1")->second];
-                const tinygltf::BufferView& uvView = gltfModel.bufferViews[uvAccessor.bufferView];
-                bufferTexCoordSet1 = &(gltfModel.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]);
-                uv1ByteStride = uvAccessor.ByteStride(uvView);
-            }
+bool RESOURCE_SYSTEM::LoadMeshes(const uint8_t* pPackageData, uint32_t storeMeshOffset, uint32_t storeMeshHolderOffset, uint32_t storeMaterialOffset)
+{
+    const MESH_PACKAGE_HEADER& packageHeader = *reinterpret_cast<const MESH_PACKAGE_HEADER*>(pPackageData);
 
-            //TODO: use separated buffers, don't blend them into one buffer
-            std::vector<SIMPLE_VERTEX> vertexBuf(posAccessor.count);
-            for (int verId = 0; verId < posAccessor.count; verId++) {
-                SIMPLE_VERTEX& vertex = vertexBuf[verId];
-                vertex.position = glm::make_vec3((float*)&bufferPos[verId * posByteStride]) / 10.f;
-                if (bufferTexCoordSet0) {
-                    vertex.texCoord = glm::make_vec2((float*)&bufferTexCoordSet0[verId * uv0ByteStride]);
-                } else {
-                    vertex.texCoord = glm::vec2(0.f, 0.f);
-                }
-                if (bufferNormals) {
-                    vertex.normal = glm::make_vec3((float*)&bufferNormals[verId * normByteStride]);
-                } else {
-                    vertex.normal = glm::vec3(0.f, 1.f, 0.f);
-                }
-            }
+    //vertexes and indexes of all primitives are copied from the mapped file to staging memory at once
+    const uint32_t baseVertex = m_sharedVertexesNum;
+    const uint32_t baseIndex = m_sharedIndexesNum;
+    if (!AddGeometryToSharedBuffers(GetMeshPackageSection<uint8_t>(pPackageData, MESH_PACKAGE_VERTEXES), packageHeader.sectionSizes[MESH_PACKAGE_VERTEXES],
+        GetMeshPackageSection<uint8_t>(pPackageData, MESH_PACKAGE_INDEXES), packageHeader.sectionSizes[MESH_PACKAGE_INDEXES])) {
+        return false;
+    }
 
-            std::vector<uint16_t> indexBuf;
-            if (isMeshHasIndexes) {
-                const tinygltf::Accessor& accessor = gltfModel.accessors[gltfPrimitive.indices];
-                const tinygltf::BufferView& bufferView = gltfModel.bufferViews[accessor.bufferView];
-                const tinygltf::Buffer& buffer = gltfModel.buffers[bufferView.buffer];
-                
-                indexCount = accessor.count;
-                const void* pData = &buffer.data[accessor.byteOffset + bufferView.byteOffset];
-
-                switch (accessor.componentType) {
-                    case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: 
-                    {
-                        const uint32_t* pData32 = static_cast<const uint32_t*>(pData);
-                        for (size_t index = 0; index < accessor.count; index++) {
-                            indexBuf.push_back(pData32[index]);
-                        }
-                        break;
-                    }
-                    case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
-                    {
-                        const uint16_t* pData16 = static_cast<const uint16_t*>(pData);
-                        for (size_t index = 0; index < accessor.count; index++) {
-                            indexBuf.push_back(pData16[index]);
-                        }
-                        break;
-                    }
-                    case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: 
-                    {
-                        const uint8_t* pData8 = static_cast<const uint8_t*>(pData);
-                        for (size_t index = 0; index < accessor.count; index++) {
-                            indexBuf.push_back(pData8[index]);
-                        }
-                        break;
-                    }
-                    default:
-                    {
-                        ERROR_MSG("Not implemented type");
-                        return false;
-                    }
-                }
-            }
+    const MESH_PACKAGE_MESH_HOLDER* pMeshHolderList = GetMeshPackageSection<MESH_PACKAGE_MESH_HOLDER>(pPackageData, MESH_PACKAGE_MESH_HOLDERS);
+    const MESH_PACKAGE_PRIMITIVE* pPrimitiveList = GetMeshPackageSection<MESH_PACKAGE_PRIMITIVE>(pPackageData, MESH_PACKAGE_PRIMITIVES);
+    for (uint32_t meshId = 0; meshId < packageHeader.sectionSizes[MESH_PACKAGE_MESH_HOLDERS]; meshId++) {
+        const MESH_PACKAGE_MESH_HOLDER& packageMeshHolder = pMeshHolderList[meshId];
+        MESH_HOLDER_COMPONENT& meshHolder = m_meshHolderList[storeMeshHolderOffset + meshId];
+        meshHolder.meshPrimitives.resize(packageMeshHolder.primitivesNum);
+        for (uint32_t primitiveId = 0; primitiveId < packageMeshHolder.primitivesNum; primitiveId++) {
+            const MESH_PACKAGE_PRIMITIVE& packagePrimitive = pPrimitiveList[packageMeshHolder.firstPrimitive + primitiveId];
 
             VULKAN_MESH mesh;
             mesh.vertexFormatId = SIMPLE_VERTEX::formatId;
-            mesh.numOfIndexes = indexBuf.size();
-            mesh.numOfVertexes = vertexBuf.size();
-
-            VkResult vertexBufferCreated = VK_SUCCESS;
-            VkBufferCreateInfo vertexBufferInfo = {};
-            vertexBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            vertexBufferInfo.size = vertexBuf.size() * sizeof(SIMPLE_VERTEX);
-            vertexBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-            vertexBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-            //alloc memory and init buffer
-            vertexBufferCreated =
-                pDrvInterface->CreateAndFillBuffer(vertexBufferInfo, (const uint8_t*)vertexBuf.data(), false, mesh.vertexBuffer);
-
-            VkResult indexBufferCreated = VK_SUCCESS;
-            if (isMeshHasIndexes) {
-                VkBufferCreateInfo indexBufferInfo = {};
-                indexBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-                indexBufferInfo.size = indexBuf.size() * sizeof(uint16_t);
-                indexBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-                indexBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-                indexBufferCreated =
-                    pDrvInterface->CreateAndFillBuffer(indexBufferInfo, (const byte*)indexBuf.data(), false, mesh.indexBuffer);
-            }
-
-            if (vertexBufferCreated != VK_SUCCESS || indexBufferCreated != VK_SUCCESS) {
-                ASSERT_MSG(vertexBufferCreated == VK_SUCCESS, "Vertex buffer not created!");
-                ASSERT_MSG(indexBufferCreated == VK_SUCCESS, "Index buffer not created!");
-                //DestroyMesh(primitiveMesh);
-                return false;
-            }
+            mesh.numOfIndexes = packagePrimitive.indexesNum;
+            mesh.numOfVertexes = packagePrimitive.vertexesNum;
+            mesh.vertexBuffer = m_sharedVertexBuffer;
+            mesh.indexBuffer = m_sharedIndexBuffer;
+            mesh.vertexOffset = baseVertex + packagePrimitive.firstVertex;
+            mesh.firstIndex = baseIndex + packagePrimitive.firstIndex;
             m_meshList[storeMeshOffset] = mesh;
 
             MESH_PRIMITIVE& primitiveMesh = meshHolder.meshPrimitives[primitiveId];
-            primitiveMesh.aabb.minPos = glm::make_vec3(posAccessor.minValues.data());
-            primitiveMesh.aabb.maxPos = glm::make_vec3(posAccessor.maxValues.data());
-            primitiveMesh.pMaterial = &m_materialsList[storeMaterialOffset + gltfPrimitive.material];
+            primitiveMesh.aabb.minPos = packagePrimitive.minPos;
+            primitiveMesh.aabb.maxPos = packagePrimitive.maxPos;
+            if (packagePrimitive.materialId != -1) {
+                primitiveMesh.pMaterial = &m_materialsList[storeMaterialOffset + packagePrimitive.materialId];
+            } else {
+                primitiveMesh.pMaterial = &m_defaultMaterial;
+            }
             primitiveMesh.pMesh = &m_meshList[storeMeshOffset];
             primitiveMesh.pParentHolder = &meshHolder;
 
@@ -334,35 +257,11 @@ bool RESOURCE_SYSTEM::LoadModel (const std::string& modelName)
             ECS::pEcsCoordinator->AddComponentToEntity(primEntity, RENDERED_COMPONENT());
 
             meshHolder.aabb.minPos = glm::min(meshHolder.aabb.minPos, primitiveMesh.aabb.minPos);
-            meshHolder.aabb.maxPos = glm::min(meshHolder.aabb.maxPos, primitiveMesh.aabb.maxPos);
+            meshHolder.aabb.maxPos = glm::max(meshHolder.aabb.maxPos, primitiveMesh.aabb.maxPos);
 
             storeMeshOffset++;
         }
     }
-
-    const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
-    for (size_t nodeId = 0; nodeId < scene.nodes.size(); nodeId++) {
-        const tinygltf::Node& gltfNode = gltfModel.nodes[scene.nodes[nodeId]];
-
-        NODE_COMPONENT& node = m_nodeList[storeNodeOffset + nodeId];
-        if (gltfNode.translation.size() == 3) {
-            node.translation = glm::make_vec3(gltfNode.translation.data());
-        } 
-        if (gltfNode.rotation.size() == 4) {
-            node.rotation = glm::make_quat(gltfNode.rotation.data());
-        }
-        if (gltfNode.scale.size() == 3) {
-            node.scale = glm::make_vec3(gltfNode.scale.data());
-        }
-        if (gltfNode.matrix.size() == 16) {
-            node.matrix = glm::make_mat4x4(gltfNode.matrix.data());
-        }
-        if (gltfNode.mesh > -1) {
-            m_meshHolderList[storeMeshHolderOffset + gltfNode.mesh].pParentsNodes.push_back(&node);
-            node.mesh = &m_meshHolderList[storeMeshHolderOffset + gltfNode.mesh];
-        }
-    }
-
     return true;
 }
 
@@ -370,107 +269,84 @@ void RESOURCE_SYSTEM::UnloadScene()
 {
 }
 
-VkFormat CastGliToVulkanFormat(gli::format gliFormat) {
-    switch (gliFormat)
-    {
-    case gli::FORMAT_R_ATI1N_UNORM_BLOCK8:
-        return VK_FORMAT_BC4_UNORM_BLOCK;
-    case gli::FORMAT_RGB_BP_SFLOAT_BLOCK16:
-        return VK_FORMAT_BC6H_SFLOAT_BLOCK;
-    case  gli::FORMAT_RGBA_BP_UNORM_BLOCK16:
-        return VK_FORMAT_BC7_UNORM_BLOCK;
-    default:
-        ERROR_MSG("Unsupported format!");
-    }
-    return VK_FORMAT_UNDEFINED;
-}
-
-std::string GetTextureCachedName(const std::string& texName)
+void RESOURCE_SYSTEM::UpdateTextureStreaming()
 {
-    std::string cachedName = texName;
-    std::replace(cachedName.begin(), cachedName.end(), ' ', '_');
-    std::replace(cachedName.begin(), cachedName.end(), '/', '_');
-    std::replace(cachedName.begin(), cachedName.end(), '\\', '_');
-    std::replace(cachedName.begin(), cachedName.end(), '.', '_');
-    return cachedName + ".dds";
-}
+    //texture is assumed to cover the primitive bounds once, so it needs as many texels as bounds have pixels
+    if (gameCamera != ECS::INVALID_ENTITY_ID) {
+        const CAMERA_COMPONENT* pCamera = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera);
+        const glm::vec3 cameraPos = glm::inverse(pCamera->viewMatrix)[3];
+        const float pixelsPerUnit = pCamera->projMatrix[1][1] * 0.5f * pDrvInterface->GetBackBufferHeight();
+        const std::vector<ECS::ENTITY_TYPE>& visibleEntityList = ECS::pEcsCoordinator->GetSystem<VISIBILITY_SYSTEM>()->GetVisibleEntities(VIEW_GAME_CAMERA);
+        for (ECS::ENTITY_TYPE entity : visibleEntityList) {
+            const MESH_PRIMITIVE* pPrimitive = ECS::pEcsCoordinator->GetComponent<MESH_PRIMITIVE>(entity);
+            if (pPrimitive == nullptr || pPrimitive->pMaterial == nullptr) {
+                continue;
+            }
+            const glm::vec3 center = 0.5f * (pPrimitive->aabb.minPos + pPrimitive->aabb.maxPos);
+            const float radius = 0.5f * glm::length(pPrimitive->aabb.maxPos - pPrimitive->aabb.minPos);
+            const float distance = glm::max(glm::length(center - cameraPos) - radius, pCamera->nearPlane);
+            const float screenSize = 2.f * radius * pixelsPerUnit / distance;
+
+            const MATERIAL_COMPONENT* pMaterial = pPrimitive->pMaterial;
+            pTextureStreamingManager->RequestTexture(pMaterial->pAlbedoTex, screenSize);
+            pTextureStreamingManager->RequestTexture(pMaterial->pNormalTex, screenSize);
+            pTextureStreamingManager->RequestTexture(pMaterial->pMetalRoughnessTex, screenSize);
+            pTextureStreamingManager->RequestTexture(pMaterial->pEmissiveTex, screenSize);
+        }
+    }
 
-bool CreateCachedTexture(const std::string& texSourcePath, const std::string& texDestPath, std::string format)
-{
-    STARTUPINFO si;
-    PROCESS_INFORMATION pi;
-
-    // set the size of the structures
-    ZeroMemory(&si, sizeof(si));
-    si.cb = sizeof(si);
-    ZeroMemory(&pi, sizeof(pi));
-
-    const std::wstring converterPath = L"C:/Program Files/NVIDIA Corporation/NVIDIA Texture Tools Exporter/nvtt_export.exe";
-    const std::string commandLineSting = texSourcePath + " --format " + format + " --mip-filter kaiser" + " --output " + texDestPath;
-    const std::wstring commandLineWstring(commandLineSting.begin(), commandLineSting.end());
-
-    // start the program up
-    CreateProcess(converterPath.c_str(),                       // the path
-        const_cast<LPWSTR>((L"\"" + converterPath + L"\" " + commandLineWstring).c_str()),        // Command line
-        NULL,           // Process handle not inheritable
-        NULL,           // Thread handle not inheritable
-        FALSE,          // Set handle inheritance to FALSE
-        0,              // No creation flags
-        NULL,           // Use parent's environment block
-        NULL,           // Use parent's starting directory 
-        &si,            // Pointer to STARTUPINFO structure
-        &pi             // Pointer to PROCESS_INFORMATION structure (removed extra parentheses)
-    );
-
-    WaitForSingleObject(pi.hProcess, INFINITE);
-    // Close process and thread handles. 
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
-    return true;
+    std::vector<const VULKAN_TEXTURE*> changedTextureList;
+    pTextureStreamingManager->Update(changedTextureList);
+    if (changedTextureList.empty() || !pDrvInterface->IsBindlessSupported()) {
+        return;
+    }
+    //image views of streamed textures are new, bindless table still has the old ones
+    std::sort(changedTextureList.begin(), changedTextureList.end());
+    auto IsTextureChanged = [&changedTextureList](const VULKAN_TEXTURE* pTexture) {
+        return std::binary_search(changedTextureList.begin(), changedTextureList.end(), pTexture);
+    };
+    for (uint32_t materialId = 0; materialId < m_materialNum; materialId++) {
+        const MATERIAL_COMPONENT& material = m_materialsList[materialId];
+        const uint32_t firstTextureId = material.materialId * EFFECT_DATA::BINDLESS_MATERIAL_TEXTURES_NUM;
+        if (IsTextureChanged(material.pAlbedoTex)) {
+            pDrvInterface->SetBindlessTexture(firstTextureId + EFFECT_DATA::BINDLESS_ALBEDO, material.pAlbedoTex);
+        }
+        if (IsTextureChanged(material.pNormalTex)) {
+            pDrvInterface->SetBindlessTexture(firstTextureId + EFFECT_DATA::BINDLESS_NORMAL, material.pNormalTex);
+        }
+        if (IsTextureChanged(material.pMetalRoughnessTex)) {
+            pDrvInterface->SetBindlessTexture(firstTextureId + EFFECT_DATA::BINDLESS_METAL_ROUGHNESS, material.pMetalRoughnessTex);
+        }
+    }
 }
 
-bool RESOURCE_SYSTEM::LoadTexture(const std::string& textureName, const std::string& textureDir, VULKAN_TEXTURE& texture)
+bool RESOURCE_SYSTEM::LoadTexture(const std::string& textureName, const std::string& textureDir, uint64_t sourceHash, TEXTURE_COOK_FORMAT format, VULKAN_TEXTURE& texture)
 {
-    const std::string cachedTexturePath = CACHE_TEXTURE_DIR + GetTextureCachedName(textureName);
+    const std::string cachedTexturePath = CACHE_TEXTURE_DIR + GetCookedTextureName(sourceHash, format);
 
     gli::texture gliTexture = gli::load(cachedTexturePath);
 
     if (gliTexture.empty()) {
         DEBUG_MSG(formatString("Can't load texture %s from cache\n", textureName.c_str()).c_str());
-        const std::string texturePath = textureDir + "/" + textureName;
-        std::string format = "bc7";
-//         if (textureName.find("Displacement") || textureName.find("Roughness") || textureName.find("Metalness")) {
-//             format = "bc4";
-//         }
-        CreateCachedTexture(texturePath, cachedTexturePath, format);
+        const std::vector<char> sourceData = ReadFile(textureDir + "/" + textureName);
+        if (sourceData.empty()) {
+            WARNING_MSG(formatString("Can't read texture source %s!\n", textureName.c_str()).c_str());
+            return false;
+        }
+        if (!CookTexture(sourceData, format, cachedTexturePath)) {
+            ERROR_MSG("Can't create cached version!");
+            return false;
+        }
         gliTexture = gli::load(cachedTexturePath);
         if (gliTexture.empty()) {
-            ERROR_MSG("Can't create cached version!");
+            ERROR_MSG("Can't load cached version!");
             return false;
         }
-
-    }
-
-    VULKAN_TEXTURE_CREATE_DATA createData;
-    createData.pData = gliTexture.data<uint8_t>();
-    createData.dataSize = gliTexture.size();
-    createData.extent.width = static_cast<uint32_t>(gliTexture.mip_level_width(0));
-    createData.extent.height = static_cast<uint32_t>(gliTexture.mip_level_height(0));
-    createData.extent.depth = static_cast<uint32_t>(gliTexture.mip_level_depth(0));
-    createData.format = CastGliToVulkanFormat(gliTexture.format());
-    createData.mipLevels = static_cast<uint32_t>(gliTexture.levels());
-    createData.usage = VkImageUsageFlagBits(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
-    size_t mipOffset = 0;
-    for (int i = 0; i < gliTexture.levels(); i++) {
-        createData.mipLevelsOffsets.push_back(mipOffset);
-        mipOffset += gliTexture.size(i);
     }
-    VkResult textureCreated = pDrvInterface->CreateTexture(createData, texture);
 
-    gliTexture.clear();
-    if (textureCreated != VK_SUCCESS) {
+    //only the smallest mips are created here, the rest are streamed in when they are needed
+    if (!pTextureStreamingManager->AddTexture(cachedTexturePath, gliTexture, texture)) {
         WARNING_MSG(formatString("%s texture creatino failed!", textureName.c_str()).c_str());
-        pDrvInterface->DestroyTexture(texture);
         return false;
     }
     return true;
@@ -533,6 +409,10 @@ void RESOURCE_SYSTEM::Reload()
 
 void RESOURCE_SYSTEM::Term()
 {
+    pTextureStreamingManager->Term();
+    pTextureStreamingManager.reset();
+    pDrvInterface->DestroyBuffer(m_sharedVertexBuffer);
+    pDrvInterface->DestroyBuffer(m_sharedIndexBuffer);
     pShaderManager->TermShaders();
     pShaderManager.release();
 }
@@ -540,6 +420,7 @@ void RESOURCE_SYSTEM::Term()
 bool RESOURCE_SYSTEM::LoadShaders()
 {
     pShaderManager->LoadShaders();
+    pDrvInterface->PrecompilePipelines();
     return true;
 }
 
@@ -548,4 +429,5 @@ void RESOURCE_SYSTEM::ReloadShaders()
     pDrvInterface->WaitGPU();
     pDrvInterface->DropPiplineStateCache();
     pShaderManager->ReloadShaders();
+    pDrvInterface->PrecompilePipelines();
 }
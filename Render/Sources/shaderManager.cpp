@@ -1,4 +1,5 @@
 #include "shaderManager.h"
+#include "renderTargetEnum.h"
 #include "support.h"
 #include "vulkanDriver.h"
 
@@ -19,16 +20,28 @@ namespace EFFECT_DATA {
         "ssao",
         "ssaoBlend",
         "terrain",
-        "ui"
+        "ui",
+        "fillGBufferBindless",
+        "fillGBufferIndirect",
+        "shadowIndirect",
+        "gpuCulling",
+        "hiZBuild",
+        "lightClustering",
+        "ssaoDepthNormal",
+        "ssaoLowRes",
+        "ssaoBilateralBlur",
+        "ssaoUpsample"
     };
 
     std::unordered_map<EFFECT_DATA::SHADER_TYPE, std::string> SHADER_TYPE_TO_NAME_CAST = {
     { EFFECT_DATA::SHADER_TYPE::VERTEX, "vs"},
     { EFFECT_DATA::SHADER_TYPE::PIXEL,  "ps" },
+    { EFFECT_DATA::SHADER_TYPE::COMPUTE, "cs" },
     };
     std::unordered_map<std::string, EFFECT_DATA::SHADER_TYPE> SHADER_NAME_TO_TYPE_CAST = {
         { "vs", EFFECT_DATA::SHADER_TYPE::VERTEX },
         { "ps", EFFECT_DATA::SHADER_TYPE::PIXEL },
+        { "cs", EFFECT_DATA::SHADER_TYPE::COMPUTE },
     };
 }
 
@@ -56,51 +69,115 @@ void SHADER_MANAGER::InitShaderDecriptorLayoutTable()
     m_shaderDesc[shrFullscreenId].push_back(CreateLayoutBinding(20, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
 
     const size_t shrFillGBufferId = EFFECT_DATA::SHR_FILL_GBUFFER;
-    m_shaderDesc[shrFillGBufferId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS));
-    m_shaderDesc[shrFillGBufferId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_MATERIAL], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrFillGBufferId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS));
+    m_shaderDesc[shrFillGBufferId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_MATERIAL], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrFillGBufferId].push_back(CreateLayoutBinding(20, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrFillGBufferId].push_back(CreateLayoutBinding(21, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrFillGBufferId].push_back(CreateLayoutBinding(22, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
 
+    //textures are in the second set, see VULKAN_DRIVER_INTERFACE::SetBindlessTexture
+    const size_t shrFillGBufferBindlessId = EFFECT_DATA::SHR_FILL_GBUFFER_BINDLESS;
+    m_shaderDesc[shrFillGBufferBindlessId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS));
+    m_shaderDesc[shrFillGBufferBindlessId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_MATERIAL], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+
+    //instance data is read by SV_InstanceID, see GPU_CULLING_SYSTEM
+    const size_t shrFillGBufferIndirectId = EFFECT_DATA::SHR_FILL_GBUFFER_INDIRECT;
+    m_shaderDesc[shrFillGBufferIndirectId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS));
+    m_shaderDesc[shrFillGBufferIndirectId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_MATERIAL], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrFillGBufferIndirectId].push_back(CreateLayoutBinding(40, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT));
+
     const size_t shrShadeGBufferId = EFFECT_DATA::SHR_SHADE_GBUFFER;
-    m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT));
-    m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_LIGHTS], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_LIGHTS], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(20, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(21, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
-    m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(22, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
-    m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(23, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(24, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(25, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(26, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_LIGHT_CLUSTERS], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(44, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(45, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrShadeGBufferId].push_back(CreateLayoutBinding(46, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT));
 
     const size_t shrSSAOId = EFFECT_DATA::SHR_SSAO;
-    m_shaderDesc[shrSSAOId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT));
-    m_shaderDesc[shrSSAOId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_CUSTOM], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAOId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAOId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_CUSTOM], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrSSAOId].push_back(CreateLayoutBinding(21, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrSSAOId].push_back(CreateLayoutBinding(25, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrSSAOId].push_back(CreateLayoutBinding(30, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrSSAOId].push_back(CreateLayoutBinding(31, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
 
     const size_t shrSSAOBlendId = EFFECT_DATA::SHR_SSAO_BLEND;
-    m_shaderDesc[shrSSAOBlendId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT));
-    m_shaderDesc[shrSSAOBlendId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_CUSTOM], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAOBlendId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAOBlendId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_CUSTOM], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrSSAOBlendId].push_back(CreateLayoutBinding(30, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
 
+    //reduced resolution ssao, see RENDER_PASS_SSAO and RENDER_PASS_BLEND_SSAO
+    const size_t shrSSAODepthNormalId = EFFECT_DATA::SHR_SSAO_DEPTH_NORMAL;
+    m_shaderDesc[shrSSAODepthNormalId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAODepthNormalId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_CUSTOM], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAODepthNormalId].push_back(CreateLayoutBinding(21, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAODepthNormalId].push_back(CreateLayoutBinding(25, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
+
+    const size_t shrSSAOLowResId = EFFECT_DATA::SHR_SSAO_LOW_RES;
+    m_shaderDesc[shrSSAOLowResId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAOLowResId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_CUSTOM], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAOLowResId].push_back(CreateLayoutBinding(30, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAOLowResId].push_back(CreateLayoutBinding(31, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAOLowResId].push_back(CreateLayoutBinding(32, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
+
+    const size_t shrSSAOBilateralBlurId = EFFECT_DATA::SHR_SSAO_BILATERAL_BLUR;
+    m_shaderDesc[shrSSAOBilateralBlurId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_CUSTOM], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_COMPUTE_BIT));
+    m_shaderDesc[shrSSAOBilateralBlurId].push_back(CreateLayoutBinding(30, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT));
+    m_shaderDesc[shrSSAOBilateralBlurId].push_back(CreateLayoutBinding(32, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT));
+    m_shaderDesc[shrSSAOBilateralBlurId].push_back(CreateLayoutBinding(33, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT));
+
+    const size_t shrSSAOUpsampleId = EFFECT_DATA::SHR_SSAO_UPSAMPLE;
+    m_shaderDesc[shrSSAOUpsampleId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAOUpsampleId].push_back(CreateLayoutBinding(25, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAOUpsampleId].push_back(CreateLayoutBinding(30, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrSSAOUpsampleId].push_back(CreateLayoutBinding(32, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
+
     const size_t shrShadow = EFFECT_DATA::SHR_SHADOW;
-    m_shaderDesc[shrShadow].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_LIGHTS], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT));
+    m_shaderDesc[shrShadow].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_LIGHTS], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT));
+
+    const size_t shrShadowIndirect = EFFECT_DATA::SHR_SHADOW_INDIRECT;
+    m_shaderDesc[shrShadowIndirect].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_LIGHTS], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT));
+    m_shaderDesc[shrShadowIndirect].push_back(CreateLayoutBinding(40, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT));
+
+    const size_t shrGpuCulling = EFFECT_DATA::SHR_GPU_CULLING;
+    m_shaderDesc[shrGpuCulling].push_back(CreateLayoutBinding(40, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT));
+    m_shaderDesc[shrGpuCulling].push_back(CreateLayoutBinding(41, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT));
+    m_shaderDesc[shrGpuCulling].push_back(CreateLayoutBinding(42, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT));
+    m_shaderDesc[shrGpuCulling].push_back(CreateLayoutBinding(43, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT));
+    m_shaderDesc[shrGpuCulling].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_CULLING], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_COMPUTE_BIT));
+    for (uint32_t levelId = 0; levelId < HI_Z_LEVELS_NUM; levelId++) {
+        m_shaderDesc[shrGpuCulling].push_back(CreateLayoutBinding(50 + levelId, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT));
+    }
+
+    const size_t shrHiZBuild = EFFECT_DATA::SHR_HI_Z_BUILD;
+    m_shaderDesc[shrHiZBuild].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_CUSTOM], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrHiZBuild].push_back(CreateLayoutBinding(50, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
+
+    //see LIGHT_CLUSTERING_SYSTEM
+    const size_t shrLightClustering = EFFECT_DATA::SHR_LIGHT_CLUSTERING;
+    m_shaderDesc[shrLightClustering].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_LIGHT_CLUSTERS], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_COMPUTE_BIT));
+    m_shaderDesc[shrLightClustering].push_back(CreateLayoutBinding(44, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT));
+    m_shaderDesc[shrLightClustering].push_back(CreateLayoutBinding(45, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT));
+    m_shaderDesc[shrLightClustering].push_back(CreateLayoutBinding(46, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT));
 
     const size_t shrTerrain = EFFECT_DATA::SHR_TERRAIN;
-    m_shaderDesc[shrTerrain].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT));
-    m_shaderDesc[shrTerrain].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_LIGHTS], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT));
-    m_shaderDesc[shrTerrain].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_TERRAIN], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT));
+    m_shaderDesc[shrTerrain].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_COMMON_DATA], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT));
+    m_shaderDesc[shrTerrain].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_LIGHTS], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT));
+    m_shaderDesc[shrTerrain].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_TERRAIN], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT));
 
     const size_t shrUiId = EFFECT_DATA::SHR_UI;
-    m_shaderDesc[shrUiId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_UI], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT));
+    m_shaderDesc[shrUiId].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_UI], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT));
     m_shaderDesc[shrUiId].push_back(CreateLayoutBinding(20, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
     m_shaderDesc[shrUiId].push_back(CreateLayoutBinding(21, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT));
 
     for (int i = 0; i < EFFECT_DATA::SHR_LAST; i++) {
-        m_shaderDesc[i].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_DEBUG], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL));
+        m_shaderDesc[i].push_back(CreateLayoutBinding(EFFECT_DATA::CONST_BUFFERS_SLOT[EFFECT_DATA::CB_DEBUG], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL));
         for (int s = 0; s < EFFECT_DATA::SAMPLER_LAST; s++) {
             m_shaderDesc[i].push_back(CreateLayoutBinding(120 + s, VK_DESCRIPTOR_TYPE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS));
         }
@@ -184,6 +261,9 @@ void SHADER_MANAGER::LoadShaders()
     for (int passId = 0; passId < EFFECT_DATA::SHADER_ID::SHR_LAST; passId++) {
         for (int typeId = 0; typeId < (int)EFFECT_DATA::SHADER_TYPE::LAST; typeId++) {
             EFFECT_DATA::SHADER_TYPE shaderType = (EFFECT_DATA::SHADER_TYPE)typeId;
+            if ((shaderType == EFFECT_DATA::SHADER_TYPE::COMPUTE) != IsComputeShader(passId)) {
+                continue;
+            }
             const std::string& shaderName = EFFECT_DATA::SHADER_NAMES[passId];
             const std::string& typeName = EFFECT_DATA::SHADER_TYPE_TO_NAME_CAST[shaderType];
             std::string filePath = SHADERS_FOLDER;
@@ -204,6 +284,9 @@ void SHADER_MANAGER::LoadShaders()
             if (shaderType == EFFECT_DATA::SHADER_TYPE::PIXEL) {
                 m_pixelShaderModules[passId] = createdShader;
             }
+            if (shaderType == EFFECT_DATA::SHADER_TYPE::COMPUTE) {
+                m_computeShaderModules[passId] = createdShader;
+            }
         }
     }
 }
@@ -222,6 +305,9 @@ void SHADER_MANAGER::TermShaders()
     for (SHADER_MODULE& shaderModule : m_pixelShaderModules) {
         pDrvInterface->DestroyShader(shaderModule.shader);
     }
+    for (SHADER_MODULE& shaderModule : m_computeShaderModules) {
+        pDrvInterface->DestroyShader(shaderModule.shader);
+    }
 }
 
 const std::vector<VkDescriptorSetLayoutBinding>& SHADER_MANAGER::GetDecriptorLayouts(uint8_t shaderId) const
@@ -238,3 +324,8 @@ const VkShaderModule& SHADER_MANAGER::GetPixelShader(uint8_t shaderId) const
 {
     return m_pixelShaderModules[shaderId].shader;
 }
+
+const VkShaderModule& SHADER_MANAGER::GetComputeShader(uint8_t shaderId) const
+{
+    return m_computeShaderModules[shaderId].shader;
+}
@@ -0,0 +1,501 @@
+#include "textureCooker.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <filesystem>
+#include <thread>
+#include <emmintrin.h>
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <gli.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#include "stb_image.h"
+
+#include "jobSystem.h"
+#include "support.h"
+
+//textures cooked by previous versions are cooked again after it is changed
+static const uint32_t COOKER_VERSION = 1;
+
+//same parameters as default kaiser mip filter of nvtt
+static const float KAISER_WIDTH = 3.f;
+static const float KAISER_ALPHA = 4.f;
+
+static const uint32_t BLOCK_SIZE = 4;
+static const uint32_t BLOCK_PIXELS_NUM = BLOCK_SIZE * BLOCK_SIZE;
+//rows of blocks or pixels processed by one job
+static const size_t ROWS_PER_JOB = 4;
+
+//bc7 interpolation weights for 4 bit indexes
+static const std::array<int, 16> BC7_WEIGHTS = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct COOK_IMAGE
+{
+    uint32_t               width = 0;
+    uint32_t               height = 0;
+    //channels in [0, 1]
+    std::vector<glm::vec4> pixelList;
+};
+
+struct FILTER_TAPS
+{
+    int                firstPixelId;
+    std::vector<float> weightList;
+};
+
+using BLOCK_PIXELS = std::array<glm::vec4, BLOCK_PIXELS_NUM>;
+
+static uint64_t HashData(const void* pData, size_t dataSize, uint64_t hash)
+{
+    //fnv-1a
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+    for (size_t byteId = 0; byteId < dataSize; byteId++) {
+        hash ^= pBytes[byteId];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t GetTextureSourceHash(const std::vector<char>& sourceData)
+{
+    return HashData(sourceData.data(), sourceData.size(), 14695981039346656037ull);
+}
+
+std::string GetCookedTextureName(uint64_t sourceHash, TEXTURE_COOK_FORMAT format)
+{
+    const uint32_t cookParams[] = { COOKER_VERSION, static_cast<uint32_t>(format) };
+    const uint64_t hash = HashData(cookParams, sizeof(cookParams), sourceHash);
+    return formatString("%016llx.dds", static_cast<unsigned long long>(hash));
+}
+
+static bool DecodeImage(const std::vector<char>& sourceData, COOK_IMAGE& image)
+{
+    int width, height, channelsNum;
+    stbi_uc* pPixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(sourceData.data()), static_cast<int>(sourceData.size()),
+        &width, &height, &channelsNum, 4);
+    if (!pPixels) {
+        return false;
+    }
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.pixelList.resize(size_t(width) * height);
+    for (size_t pixelId = 0; pixelId < image.pixelList.size(); pixelId++) {
+        image.pixelList[pixelId] = glm::vec4(glm::make_vec4(&pPixels[4 * pixelId])) / 255.f;
+    }
+    stbi_image_free(pPixels);
+    return true;
+}
+
+static void NormalizeNormals(COOK_IMAGE& image)
+{
+    for (glm::vec4& pixel : image.pixelList) {
+        glm::vec3 normal = glm::vec3(pixel) * 2.f - 1.f;
+        const float normalLength = glm::length(normal);
+        normal = normalLength > 0.f ? normal / normalLength : glm::vec3(0.f, 0.f, 1.f);
+        pixel = glm::vec4(normal * 0.5f + 0.5f, pixel.a);
+    }
+}
+
+static float BesselI0(float x)
+{
+    //power series converges fast for kaiser window arguments
+    const float halfX = 0.5f * x;
+    float sum = 1.f;
+    float term = 1.f;
+    for (int k = 1; k < 32 && term > sum * 1e-7f; k++) {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+    }
+    return sum;
+}
+
+static float Kaiser(float x)
+{
+    if (std::abs(x) >= KAISER_WIDTH) {
+        return 0.f;
+    }
+    const float sinc = std::abs(x) < 1e-4f ? 1.f : std::sin(glm::pi<float>() * x) / (glm::pi<float>() * x);
+    const float t = x / KAISER_WIDTH;
+    return sinc * BesselI0(KAISER_ALPHA * std::sqrt(1.f - t * t)) / BesselI0(KAISER_ALPHA);
+}
+
+static std::vector<FILTER_TAPS> ComputeFilterTaps(uint32_t srcSize, uint32_t dstSize)
+{
+    //filter is stretched to the destination pixel footprint, out of image pixels are clamped
+    const float scale = float(srcSize) / dstSize;
+    const float radius = KAISER_WIDTH * scale;
+    std::vector<FILTER_TAPS> tapsList(dstSize);
+    for (uint32_t dstPixelId = 0; dstPixelId < dstSize; dstPixelId++) {
+        const float center = (dstPixelId + 0.5f) * scale;
+        FILTER_TAPS& taps = tapsList[dstPixelId];
+        taps.firstPixelId = static_cast<int>(std::floor(center - radius));
+        const int lastPixelId = static_cast<int>(std::ceil(center + radius));
+        float weightSum = 0.f;
+        for (int srcPixelId = taps.firstPixelId; srcPixelId <= lastPixelId; srcPixelId++) {
+            const float weight = Kaiser((srcPixelId + 0.5f - center) / scale);
+            taps.weightList.push_back(weight);
+            weightSum += weight;
+        }
+        for (float& weight : taps.weightList) {
+            weight /= weightSum;
+        }
+    }
+    return tapsList;
+}
+
+static COOK_IMAGE Downsample(const COOK_IMAGE& srcImage)
+{
+    COOK_IMAGE dstImage;
+    dstImage.width = std::max(srcImage.width / 2, 1u);
+    dstImage.height = std::max(srcImage.height / 2, 1u);
+    dstImage.pixelList.resize(size_t(dstImage.width) * dstImage.height);
+
+    const std::vector<FILTER_TAPS> horizontalTapsList = ComputeFilterTaps(srcImage.width, dstImage.width);
+    const std::vector<FILTER_TAPS> verticalTapsList = ComputeFilterTaps(srcImage.height, dstImage.height);
+    const int srcMaxX = static_cast<int>(srcImage.width) - 1;
+    const int srcMaxY = static_cast<int>(srcImage.height) - 1;
+
+    //separable filter, horizontal pass keeps source height
+    std::vector<glm::vec4> tempPixelList(size_t(dstImage.width) * srcImage.height);
+    ECS::pJobSystem->ParallelFor(srcImage.height, ROWS_PER_JOB, [&](size_t beginRow, size_t endRow) {
+        for (size_t y = beginRow; y < endRow; y++) {
+            const glm::vec4* pSrcRow = &srcImage.pixelList[y * srcImage.width];
+            for (uint32_t x = 0; x < dstImage.width; x++) {
+                const FILTER_TAPS& taps = horizontalTapsList[x];
+                glm::vec4 sum(0.f);
+                for (size_t tapId = 0; tapId < taps.weightList.size(); tapId++) {
+                    sum += taps.weightList[tapId] * pSrcRow[std::clamp(taps.firstPixelId + static_cast<int>(tapId), 0, srcMaxX)];
+                }
+                tempPixelList[y * dstImage.width + x] = sum;
+            }
+        }
+    });
+    ECS::pJobSystem->ParallelFor(dstImage.height, ROWS_PER_JOB, [&](size_t beginRow, size_t endRow) {
+        for (size_t y = beginRow; y < endRow; y++) {
+            const FILTER_TAPS& taps = verticalTapsList[y];
+            for (uint32_t x = 0; x < dstImage.width; x++) {
+                glm::vec4 sum(0.f);
+                for (size_t tapId = 0; tapId < taps.weightList.size(); tapId++) {
+                    const int srcY = std::clamp(taps.firstPixelId + static_cast<int>(tapId), 0, srcMaxY);
+                    sum += taps.weightList[tapId] * tempPixelList[size_t(srcY) * dstImage.width + x];
+                }
+                //negative lobes can leave the range
+                dstImage.pixelList[y * dstImage.width + x] = glm::clamp(sum, 0.f, 1.f);
+            }
+        }
+    });
+    return dstImage;
+}
+
+static void FetchBlock(const COOK_IMAGE& image, uint32_t blockX, uint32_t blockY, BLOCK_PIXELS& blockPixels)
+{
+    //blocks on the border of non multiple of 4 images repeat the last pixels
+    for (uint32_t y = 0; y < BLOCK_SIZE; y++) {
+        const uint32_t imageY = std::min(blockY * BLOCK_SIZE + y, image.height - 1);
+        for (uint32_t x = 0; x < BLOCK_SIZE; x++) {
+            const uint32_t imageX = std::min(blockX * BLOCK_SIZE + x, image.width - 1);
+            blockPixels[y * BLOCK_SIZE + x] = image.pixelList[size_t(imageY) * image.width + imageX] * 255.f;
+        }
+    }
+}
+
+//four pixels of the block starting from firstPixelId, one register per channel
+static void LoadBlockPixels(const BLOCK_PIXELS& blockPixels, uint32_t firstPixelId, std::array<__m128, 4>& channelList)
+{
+    channelList[0] = _mm_loadu_ps(glm::value_ptr(blockPixels[firstPixelId]));
+    channelList[1] = _mm_loadu_ps(glm::value_ptr(blockPixels[firstPixelId + 1]));
+    channelList[2] = _mm_loadu_ps(glm::value_ptr(blockPixels[firstPixelId + 2]));
+    channelList[3] = _mm_loadu_ps(glm::value_ptr(blockPixels[firstPixelId + 3]));
+    _MM_TRANSPOSE4_PS(channelList[0], channelList[1], channelList[2], channelList[3]);
+}
+
+static float GetHorizontalMin(__m128 value)
+{
+    value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(value);
+}
+
+static float GetHorizontalMax(__m128 value)
+{
+    value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(value);
+}
+
+static void EncodeBC4(const BLOCK_PIXELS& blockPixels, int channelId, uint8_t* pBlock)
+{
+    std::array<__m128, BLOCK_PIXELS_NUM / 4> valueList;
+    for (uint32_t quadId = 0; quadId < valueList.size(); quadId++) {
+        std::array<__m128, 4> channelList;
+        LoadBlockPixels(blockPixels, quadId * 4, channelList);
+        valueList[quadId] = channelList[channelId];
+    }
+    const __m128 minValues = _mm_min_ps(_mm_min_ps(valueList[0], valueList[1]), _mm_min_ps(valueList[2], valueList[3]));
+    const __m128 maxValues = _mm_max_ps(_mm_max_ps(valueList[0], valueList[1]), _mm_max_ps(valueList[2], valueList[3]));
+    //first endpoint is greater, so palette has 6 interpolated values between endpoints
+    const uint8_t endpoint0 = static_cast<uint8_t>(std::round(GetHorizontalMax(maxValues)));
+    const uint8_t endpoint1 = static_cast<uint8_t>(std::round(GetHorizontalMin(minValues)));
+    pBlock[0] = endpoint0;
+    pBlock[1] = endpoint1;
+
+    uint64_t indexBits = 0;
+    if (endpoint0 > endpoint1) {
+        //indexes 0 and 1 are endpoints, 2..7 go from the first endpoint to the second one
+        static const std::array<uint64_t, 8> STEP_INDEXES = { 0, 2, 3, 4, 5, 6, 7, 1 };
+        const __m128 endpointValue0 = _mm_set1_ps(float(endpoint0));
+        const __m128 endpointRange = _mm_set1_ps(float(endpoint0 - endpoint1));
+        alignas(16) std::array<int32_t, BLOCK_PIXELS_NUM> stepList;
+        for (uint32_t quadId = 0; quadId < valueList.size(); quadId++) {
+            const __m128 t = _mm_div_ps(_mm_sub_ps(endpointValue0, valueList[quadId]), endpointRange);
+            //clamped before truncation, so it gives the same steps as clamping of truncated value
+            __m128 step = _mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(7.f)), _mm_set1_ps(0.5f));
+            step = _mm_min_ps(_mm_max_ps(step, _mm_setzero_ps()), _mm_set1_ps(7.f));
+            _mm_store_si128(reinterpret_cast<__m128i*>(&stepList[quadId * 4]), _mm_cvttps_epi32(step));
+        }
+        for (uint32_t pixelId = 0; pixelId < BLOCK_PIXELS_NUM; pixelId++) {
+            indexBits |= STEP_INDEXES[stepList[pixelId]] << (3 * pixelId);
+        }
+    }
+    for (uint32_t byteId = 0; byteId < 6; byteId++) {
+        pBlock[2 + byteId] = static_cast<uint8_t>(indexBits >> (8 * byteId));
+    }
+}
+
+static glm::vec4 DequantizeBC7Endpoint(const glm::ivec4& endpoint, int pBit)
+{
+    return glm::vec4(endpoint * 2 + pBit);
+}
+
+static void QuantizeBC7Endpoint(const glm::vec4& value, glm::ivec4& endpoint, int& pBit)
+{
+    //mode 6 endpoints are 7 bits per channel plus shared lowest bit
+    float bestError = FLT_MAX;
+    for (int candidatePBit = 0; candidatePBit < 2; candidatePBit++) {
+        const glm::ivec4 candidate = glm::clamp(glm::ivec4(glm::round((value - float(candidatePBit)) * 0.5f)), 0, 127);
+        const glm::vec4 delta = DequantizeBC7Endpoint(candidate, candidatePBit) - value;
+        const float error = glm::dot(delta, delta);
+        if (error < bestError) {
+            bestError = error;
+            endpoint = candidate;
+            pBit = candidatePBit;
+        }
+    }
+}
+
+static float FindBC7Indexes(const BLOCK_PIXELS& blockPixels, const glm::vec4& endpoint0, const glm::vec4& endpoint1, std::array<uint32_t, BLOCK_PIXELS_NUM>& indexList)
+{
+    std::array<glm::vec4, BC7_WEIGHTS.size()> palette;
+    for (size_t indexId = 0; indexId < palette.size(); indexId++) {
+        palette[indexId] = glm::floor(((64.f - BC7_WEIGHTS[indexId]) * endpoint0 + float(BC7_WEIGHTS[indexId]) * endpoint1 + 32.f) / 64.f);
+    }
+    //four pixels are tested against each palette entry at once, first of equally close entries is chosen
+    __m128 blockErrors = _mm_setzero_ps();
+    for (uint32_t pixelId = 0; pixelId < BLOCK_PIXELS_NUM; pixelId += 4) {
+        std::array<__m128, 4> channelList;
+        LoadBlockPixels(blockPixels, pixelId, channelList);
+        __m128 bestErrors = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndexes = _mm_setzero_si128();
+        for (uint32_t indexId = 0; indexId < palette.size(); indexId++) {
+            __m128 errors = _mm_setzero_ps();
+            for (int channelId = 0; channelId < 4; channelId++) {
+                const __m128 delta = _mm_sub_ps(_mm_set1_ps(palette[indexId][channelId]), channelList[channelId]);
+                errors = _mm_add_ps(errors, _mm_mul_ps(delta, delta));
+            }
+            const __m128i isCloser = _mm_castps_si128(_mm_cmplt_ps(errors, bestErrors));
+            bestErrors = _mm_min_ps(errors, bestErrors);
+            bestIndexes = _mm_or_si128(_mm_and_si128(isCloser, _mm_set1_epi32(indexId)), _mm_andnot_si128(isCloser, bestIndexes));
+        }
+        blockErrors = _mm_add_ps(blockErrors, bestErrors);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&indexList[pixelId]), bestIndexes);
+    }
+    alignas(16) std::array<float, 4> blockErrorList;
+    _mm_store_ps(blockErrorList.data(), blockErrors);
+    return blockErrorList[0] + blockErrorList[1] + blockErrorList[2] + blockErrorList[3];
+}
+
+static void WriteBits(uint8_t* pBlock, uint32_t& bitOffset, uint32_t value, uint32_t bitsNum)
+{
+    for (uint32_t bitId = 0; bitId < bitsNum; bitId++, bitOffset++) {
+        pBlock[bitOffset / 8] |= ((value >> bitId) & 1) << (bitOffset % 8);
+    }
+}
+
+static void EncodeBC7(const BLOCK_PIXELS& blockPixels, uint8_t* pBlock)
+{
+    //mode 6 only: one subset, rgba endpoints and 4 bit indexes, fits smooth color textures well
+    glm::vec4 mean(0.f);
+    for (const glm::vec4& pixel : blockPixels) {
+        mean += pixel;
+    }
+    mean /= float(BLOCK_PIXELS_NUM);
+
+    glm::mat4 covariance(0.f);
+    for (const glm::vec4& pixel : blockPixels) {
+        const glm::vec4 delta = pixel - mean;
+        covariance += glm::outerProduct(delta, delta);
+    }
+    //principal axis of block colors by power iteration
+    glm::vec4 axis(1.f);
+    for (int iterationId = 0; iterationId < 8; iterationId++) {
+        axis = covariance * axis;
+        const float axisLength = glm::length(axis);
+        if (axisLength < 1e-6f) {
+            break;
+        }
+        axis /= axisLength;
+    }
+    float minProjection = 0.f;
+    float maxProjection = 0.f;
+    for (const glm::vec4& pixel : blockPixels) {
+        const float projection = glm::dot(pixel - mean, axis);
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    std::array<glm::ivec4, 2> endpointList;
+    std::array<int, 2> pBitList;
+    std::array<uint32_t, BLOCK_PIXELS_NUM> indexList;
+    QuantizeBC7Endpoint(glm::clamp(mean + axis * minProjection, 0.f, 255.f), endpointList[0], pBitList[0]);
+    QuantizeBC7Endpoint(glm::clamp(mean + axis * maxProjection, 0.f, 255.f), endpointList[1], pBitList[1]);
+    float blockError = FindBC7Indexes(blockPixels, DequantizeBC7Endpoint(endpointList[0], pBitList[0]),
+        DequantizeBC7Endpoint(endpointList[1], pBitList[1]), indexList);
+
+    //least squares fit of endpoints to chosen indexes, kept if it reduces the error
+    float weightSum00 = 0.f;
+    float weightSum01 = 0.f;
+    float weightSum11 = 0.f;
+    glm::vec4 pixelSum0(0.f);
+    glm::vec4 pixelSum1(0.f);
+    for (uint32_t pixelId = 0; pixelId < BLOCK_PIXELS_NUM; pixelId++) {
+        const float weight1 = BC7_WEIGHTS[indexList[pixelId]] / 64.f;
+        const float weight0 = 1.f - weight1;
+        weightSum00 += weight0 * weight0;
+        weightSum01 += weight0 * weight1;
+        weightSum11 += weight1 * weight1;
+        pixelSum0 += weight0 * blockPixels[pixelId];
+        pixelSum1 += weight1 * blockPixels[pixelId];
+    }
+    const float determinant = weightSum00 * weightSum11 - weightSum01 * weightSum01;
+    if (std::abs(determinant) > 1e-6f) {
+        std::array<glm::ivec4, 2> fitEndpointList;
+        std::array<int, 2> fitPBitList;
+        std::array<uint32_t, BLOCK_PIXELS_NUM> fitIndexList;
+        QuantizeBC7Endpoint(glm::clamp((weightSum11 * pixelSum0 - weightSum01 * pixelSum1) / determinant, 0.f, 255.f), fitEndpointList[0], fitPBitList[0]);
+        QuantizeBC7Endpoint(glm::clamp((weightSum00 * pixelSum1 - weightSum01 * pixelSum0) / determinant, 0.f, 255.f), fitEndpointList[1], fitPBitList[1]);
+        const float fitBlockError = FindBC7Indexes(blockPixels, DequantizeBC7Endpoint(fitEndpointList[0], fitPBitList[0]),
+            DequantizeBC7Endpoint(fitEndpointList[1], fitPBitList[1]), fitIndexList);
+        if (fitBlockError < blockError) {
+            endpointList = fitEndpointList;
+            pBitList = fitPBitList;
+            indexList = fitIndexList;
+        }
+    }
+
+    //highest bit of the first index isn't stored, endpoints are swapped to make it zero
+    if (indexList[0] & 8) {
+        std::swap(endpointList[0], endpointList[1]);
+        std::swap(pBitList[0], pBitList[1]);
+        for (uint32_t& index : indexList) {
+            index = 15 - index;
+        }
+    }
+
+    std::fill(pBlock, pBlock + 16, uint8_t(0));
+    uint32_t bitOffset = 0;
+    WriteBits(pBlock, bitOffset, 1 << 6, 7);
+    for (int channelId = 0; channelId < 4; channelId++) {
+        WriteBits(pBlock, bitOffset, endpointList[0][channelId], 7);
+        WriteBits(pBlock, bitOffset, endpointList[1][channelId], 7);
+    }
+    WriteBits(pBlock, bitOffset, pBitList[0], 1);
+    WriteBits(pBlock, bitOffset, pBitList[1], 1);
+    WriteBits(pBlock, bitOffset, indexList[0], 3);
+    for (uint32_t pixelId = 1; pixelId < BLOCK_PIXELS_NUM; pixelId++) {
+        WriteBits(pBlock, bitOffset, indexList[pixelId], 4);
+    }
+}
+
+static void CompressLevel(const COOK_IMAGE& image, TEXTURE_COOK_FORMAT format, uint8_t* pLevelData)
+{
+    const uint32_t blocksX = (image.width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const uint32_t blocksY = (image.height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    //bc7 and bc5 blocks are both 16 bytes
+    const size_t blockDataSize = 16;
+    ECS::pJobSystem->ParallelFor(blocksY, ROWS_PER_JOB, [&](size_t beginRow, size_t endRow) {
+        BLOCK_PIXELS blockPixels;
+        for (size_t blockY = beginRow; blockY < endRow; blockY++) {
+            for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+                FetchBlock(image, blockX, static_cast<uint32_t>(blockY), blockPixels);
+                uint8_t* pBlock = pLevelData + (blockY * blocksX + blockX) * blockDataSize;
+                switch (format) {
+                case TEXTURE_COOK_COLOR:
+                    EncodeBC7(blockPixels, pBlock);
+                    break;
+                case TEXTURE_COOK_NORMAL:
+                    EncodeBC4(blockPixels, 0, pBlock);
+                    EncodeBC4(blockPixels, 1, pBlock + 8);
+                    break;
+                }
+            }
+        }
+    });
+}
+
+static gli::format GetCookedGliFormat(TEXTURE_COOK_FORMAT format)
+{
+    switch (format) {
+    case TEXTURE_COOK_COLOR:
+        return gli::FORMAT_RGBA_BP_UNORM_BLOCK16;
+    case TEXTURE_COOK_NORMAL:
+        return gli::FORMAT_RG_ATI2N_UNORM_BLOCK16;
+    }
+    ERROR_MSG("Unknown cook format!");
+    return gli::FORMAT_UNDEFINED;
+}
+
+bool CookTexture(const std::vector<char>& sourceData, TEXTURE_COOK_FORMAT format, const std::string& destPath)
+{
+    COOK_IMAGE image;
+    if (!DecodeImage(sourceData, image)) {
+        WARNING_MSG(formatString("Can't decode source of %s: %s\n", destPath.c_str(), stbi_failure_reason()).c_str());
+        return false;
+    }
+    if (format == TEXTURE_COOK_NORMAL) {
+        NormalizeNormals(image);
+    }
+
+    gli::texture2d cookedTexture(GetCookedGliFormat(format), gli::extent2d(image.width, image.height));
+    for (size_t levelId = 0; levelId < cookedTexture.levels(); levelId++) {
+        if (levelId) {
+            image = Downsample(image);
+            if (format == TEXTURE_COOK_NORMAL) {
+                NormalizeNormals(image);
+            }
+        }
+        ASSERT(cookedTexture.extent(levelId) == gli::extent2d(image.width, image.height));
+        CompressLevel(image, format, cookedTexture[levelId].data<uint8_t>());
+    }
+
+    //file is written under unique name and renamed, so loading never sees partially written texture
+    std::error_code fileError;
+    std::filesystem::create_directories(std::filesystem::path(destPath).parent_path(), fileError);
+    const std::string tempPath = formatString("%s.%zx.tmp", destPath.c_str(), std::hash<std::thread::id>()(std::this_thread::get_id()));
+    if (!gli::save_dds(cookedTexture, tempPath)) {
+        WARNING_MSG(formatString("Can't write cooked texture %s\n", destPath.c_str()).c_str());
+        return false;
+    }
+    std::filesystem::rename(tempPath, destPath, fileError);
+    if (fileError) {
+        //the same content was cooked by another job meanwhile
+        std::filesystem::remove(tempPath, fileError);
+        return std::filesystem::exists(destPath);
+    }
+    return true;
+}
@@ -0,0 +1,304 @@
+#include "textureStreamingManager.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <gli.hpp>
+
+#include "support.h"
+#include "vulkanDriver.h"
+
+std::unique_ptr<TEXTURE_STREAMING_MANAGER> pTextureStreamingManager;
+
+static VkFormat CastGliToVulkanFormat(gli::format gliFormat) {
+    switch (gliFormat)
+    {
+    case gli::FORMAT_R_ATI1N_UNORM_BLOCK8:
+        return VK_FORMAT_BC4_UNORM_BLOCK;
+    case gli::FORMAT_RG_ATI2N_UNORM_BLOCK16:
+        return VK_FORMAT_BC5_UNORM_BLOCK;
+    case gli::FORMAT_RGB_BP_SFLOAT_BLOCK16:
+        return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+    case  gli::FORMAT_RGBA_BP_UNORM_BLOCK16:
+        return VK_FORMAT_BC7_UNORM_BLOCK;
+    default:
+        ERROR_MSG("Unsupported format!");
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+void TEXTURE_STREAMING_MANAGER::Init(uint64_t memoryBudget)
+{
+    m_memoryBudget = memoryBudget;
+}
+
+void TEXTURE_STREAMING_MANAGER::Term()
+{
+    for (std::unique_ptr<STREAMED_TEXTURE>& pStreamedTexture : m_textureList) {
+        if (pStreamedTexture->isLoading) {
+            ECS::pJobSystem->Wait(pStreamedTexture->loadCounter);
+        }
+    }
+    pDrvInterface->WaitGPU();
+    for (std::unique_ptr<STREAMED_TEXTURE>& pStreamedTexture : m_textureList) {
+        if (pStreamedTexture->isLoading && pStreamedTexture->isLoaded) {
+            pDrvInterface->DestroyTexture(pStreamedTexture->loadedTexture);
+        }
+        pDrvInterface->DestroyTexture(*pStreamedTexture->pTexture);
+    }
+    DestroyRetiredTextures(true);
+    m_textureList.clear();
+    m_textureIdMap.clear();
+    m_committedSize = 0;
+    m_releasingSize = 0;
+    m_loadsInFlightNum = 0;
+}
+
+bool TEXTURE_STREAMING_MANAGER::AddTexture(const std::string& cachedTexturePath, const gli::texture& gliTexture, VULKAN_TEXTURE& texture)
+{
+    std::unique_ptr<STREAMED_TEXTURE> pStreamedTexture(new STREAMED_TEXTURE);
+    pStreamedTexture->cachedTexturePath = cachedTexturePath;
+    pStreamedTexture->pTexture = &texture;
+    const uint32_t levelsNum = static_cast<uint32_t>(gliTexture.levels());
+    for (uint32_t levelId = 0; levelId < levelsNum; levelId++) {
+        pStreamedTexture->levelSizeList.push_back(gliTexture.size(levelId));
+    }
+    uint32_t minResidentMip = 0;
+    while (minResidentMip + 1 < levelsNum && glm::max(gliTexture.extent(minResidentMip).x, gliTexture.extent(minResidentMip).y) > MIN_RESIDENT_SIZE) {
+        minResidentMip++;
+    }
+    pStreamedTexture->textureSize = static_cast<float>(glm::max(gliTexture.extent(0).x, gliTexture.extent(0).y));
+    pStreamedTexture->minResidentMip = minResidentMip;
+    //levels of single layer texture are stored one after another
+    const uint8_t* pMinResidentMipData = static_cast<const uint8_t*>(gliTexture.data(0, 0, minResidentMip));
+    pStreamedTexture->minResidentMipData.assign(pMinResidentMipData, pMinResidentMipData + GetResidentSize(*pStreamedTexture, minResidentMip));
+    pStreamedTexture->minResidentMipExtent.width = static_cast<uint32_t>(gliTexture.extent(minResidentMip).x);
+    pStreamedTexture->minResidentMipExtent.height = static_cast<uint32_t>(gliTexture.extent(minResidentMip).y);
+    pStreamedTexture->minResidentMipExtent.depth = static_cast<uint32_t>(gliTexture.extent(minResidentMip).z);
+    pStreamedTexture->format = CastGliToVulkanFormat(gliTexture.format());
+    pStreamedTexture->residentMip = minResidentMip;
+    pStreamedTexture->requestedMip = minResidentMip;
+
+    VkResult textureCreated = CreateTexture(gliTexture, minResidentMip, texture);
+    if (textureCreated != VK_SUCCESS) {
+        pDrvInterface->DestroyTexture(texture);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_committedSize += GetResidentSize(*pStreamedTexture, minResidentMip);
+    m_textureIdMap.emplace(&texture, static_cast<uint32_t>(m_textureList.size()));
+    m_textureList.push_back(std::move(pStreamedTexture));
+    return true;
+}
+
+void TEXTURE_STREAMING_MANAGER::RequestTexture(const VULKAN_TEXTURE* pTexture, float screenSize)
+{
+    auto textureIdIt = m_textureIdMap.find(pTexture);
+    if (textureIdIt == m_textureIdMap.end()) {
+        return;
+    }
+    STREAMED_TEXTURE& streamedTexture = *m_textureList[textureIdIt->second];
+    streamedTexture.lastUsedFrameId = m_frameId;
+
+    //one texel per pixel is enough, texture is minified by mips below it
+    uint32_t mip = streamedTexture.minResidentMip;
+    if (screenSize > 1.f) {
+        const float wantedMip = std::floor(std::log2(streamedTexture.textureSize / screenSize));
+        mip = static_cast<uint32_t>(glm::clamp(wantedMip, 0.f, static_cast<float>(streamedTexture.minResidentMip)));
+    }
+    streamedTexture.requestedMip = std::min(streamedTexture.requestedMip, mip);
+}
+
+void TEXTURE_STREAMING_MANAGER::Update(std::vector<const VULKAN_TEXTURE*>& changedTextureList)
+{
+    DestroyRetiredTextures(false);
+    FinishLoads(changedTextureList);
+
+    //budget could be lowered since the last frame, memory being released already counts as evicted
+    if (m_committedSize - m_releasingSize > m_memoryBudget) {
+        EvictTextures(m_committedSize - m_releasingSize - m_memoryBudget);
+    }
+
+    std::vector<STREAMED_TEXTURE*> upgradeList;
+    for (std::unique_ptr<STREAMED_TEXTURE>& pStreamedTexture : m_textureList) {
+        if (!pStreamedTexture->isLoading && pStreamedTexture->requestedMip < pStreamedTexture->residentMip) {
+            upgradeList.push_back(pStreamedTexture.get());
+        }
+    }
+    //textures which miss the most mips are the blurriest ones on the screen
+    std::sort(upgradeList.begin(), upgradeList.end(), [](const STREAMED_TEXTURE* pTextureA, const STREAMED_TEXTURE* pTextureB) {
+        return pTextureA->residentMip - pTextureA->requestedMip > pTextureB->residentMip - pTextureB->requestedMip;
+    });
+    for (STREAMED_TEXTURE* pStreamedTexture : upgradeList) {
+        if (m_loadsInFlightNum >= MAX_LOADS_IN_FLIGHT) {
+            break;
+        }
+        //the old texture is released a few frames after the new one is resident, so the whole new size is needed
+        const uint64_t neededSize = GetResidentSize(*pStreamedTexture, pStreamedTexture->requestedMip);
+        if (m_committedSize + neededSize > m_memoryBudget) {
+            //loads wait until evicted memory is actually released
+            if (m_committedSize - m_releasingSize + neededSize > m_memoryBudget) {
+                EvictTextures(m_committedSize - m_releasingSize + neededSize - m_memoryBudget);
+            }
+            break;
+        }
+        StartLoad(*pStreamedTexture, pStreamedTexture->requestedMip);
+    }
+
+    for (std::unique_ptr<STREAMED_TEXTURE>& pStreamedTexture : m_textureList) {
+        pStreamedTexture->requestedMip = pStreamedTexture->minResidentMip;
+    }
+    m_frameId++;
+}
+
+VkResult TEXTURE_STREAMING_MANAGER::CreateTexture(const gli::texture& gliTexture, uint32_t firstMip, VULKAN_TEXTURE& texture)
+{
+    //mips above firstMip aren't uploaded, so offsets start from it
+    VULKAN_TEXTURE_CREATE_DATA createData;
+    createData.pData = static_cast<const uint8_t*>(gliTexture.data(0, 0, firstMip));
+    createData.extent.width = static_cast<uint32_t>(gliTexture.extent(firstMip).x);
+    createData.extent.height = static_cast<uint32_t>(gliTexture.extent(firstMip).y);
+    createData.extent.depth = static_cast<uint32_t>(gliTexture.extent(firstMip).z);
+    createData.format = CastGliToVulkanFormat(gliTexture.format());
+    createData.mipLevels = static_cast<uint32_t>(gliTexture.levels()) - firstMip;
+    createData.usage = VkImageUsageFlagBits(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    size_t mipOffset = 0;
+    for (size_t levelId = firstMip; levelId < gliTexture.levels(); levelId++) {
+        createData.mipLevelsOffsets.push_back(mipOffset);
+        mipOffset += gliTexture.size(levelId);
+    }
+    createData.dataSize = mipOffset;
+    return pDrvInterface->CreateTexture(createData, texture);
+}
+
+VkResult TEXTURE_STREAMING_MANAGER::CreateMinResidentTexture(const STREAMED_TEXTURE& streamedTexture, VULKAN_TEXTURE& texture)
+{
+    VULKAN_TEXTURE_CREATE_DATA createData;
+    createData.pData = streamedTexture.minResidentMipData.data();
+    createData.dataSize = streamedTexture.minResidentMipData.size();
+    createData.extent = streamedTexture.minResidentMipExtent;
+    createData.format = streamedTexture.format;
+    createData.mipLevels = static_cast<uint32_t>(streamedTexture.levelSizeList.size()) - streamedTexture.minResidentMip;
+    createData.usage = VkImageUsageFlagBits(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    size_t mipOffset = 0;
+    for (size_t levelId = streamedTexture.minResidentMip; levelId < streamedTexture.levelSizeList.size(); levelId++) {
+        createData.mipLevelsOffsets.push_back(mipOffset);
+        mipOffset += streamedTexture.levelSizeList[levelId];
+    }
+    return pDrvInterface->CreateTexture(createData, texture);
+}
+
+uint64_t TEXTURE_STREAMING_MANAGER::GetResidentSize(const STREAMED_TEXTURE& streamedTexture, uint32_t firstMip)
+{
+    uint64_t residentSize = 0;
+    for (size_t levelId = firstMip; levelId < streamedTexture.levelSizeList.size(); levelId++) {
+        residentSize += streamedTexture.levelSizeList[levelId];
+    }
+    return residentSize;
+}
+
+void TEXTURE_STREAMING_MANAGER::FinishLoads(std::vector<const VULKAN_TEXTURE*>& changedTextureList)
+{
+    for (std::unique_ptr<STREAMED_TEXTURE>& pStreamedTexture : m_textureList) {
+        STREAMED_TEXTURE& streamedTexture = *pStreamedTexture;
+        if (!streamedTexture.isLoading || !streamedTexture.loadCounter.IsDone()) {
+            continue;
+        }
+        //texture is replaced only when its copy is done, so frames never sample unfilled mips
+        if (streamedTexture.isLoaded && !pDrvInterface->IsUploadComplete(streamedTexture.loadedTexture.uploadTicket)) {
+            continue;
+        }
+        streamedTexture.isLoading = false;
+        m_loadsInFlightNum--;
+        const uint64_t residentSize = GetResidentSize(streamedTexture, streamedTexture.residentMip);
+        if (!streamedTexture.isLoaded) {
+            WARNING_MSG(formatString("Can't stream texture %s!", streamedTexture.cachedTexturePath.c_str()).c_str());
+            m_committedSize -= GetResidentSize(streamedTexture, streamedTexture.loadingMip);
+            m_releasingSize -= residentSize;
+            continue;
+        }
+        //frames in flight can still sample the old texture, its memory stays committed until it's destroyed
+        m_retiredTextureList.push_back({ *streamedTexture.pTexture, residentSize, m_frameId });
+        *streamedTexture.pTexture = streamedTexture.loadedTexture;
+        streamedTexture.residentMip = streamedTexture.loadingMip;
+        changedTextureList.push_back(streamedTexture.pTexture);
+    }
+}
+
+void TEXTURE_STREAMING_MANAGER::StartLoad(STREAMED_TEXTURE& streamedTexture, uint32_t firstMip)
+{
+    m_committedSize += GetResidentSize(streamedTexture, firstMip);
+    m_releasingSize += GetResidentSize(streamedTexture, streamedTexture.residentMip);
+    m_loadsInFlightNum++;
+
+    streamedTexture.isLoading = true;
+    streamedTexture.isLoaded = false;
+    streamedTexture.loadingMip = firstMip;
+    STREAMED_TEXTURE* pStreamedTexture = &streamedTexture;
+    //file reading and decoding take milliseconds, the main thread mustn't pick them up while it waits for frame jobs
+    ECS::pJobSystem->ScheduleBackground([pStreamedTexture, firstMip]() {
+        const gli::texture gliTexture = gli::load(pStreamedTexture->cachedTexturePath);
+        if (gliTexture.empty() || gliTexture.levels() != pStreamedTexture->levelSizeList.size()) {
+            return;
+        }
+        if (CreateTexture(gliTexture, firstMip, pStreamedTexture->loadedTexture) != VK_SUCCESS) {
+            pDrvInterface->DestroyTexture(pStreamedTexture->loadedTexture);
+            return;
+        }
+        pStreamedTexture->isLoaded = true;
+    }, &streamedTexture.loadCounter);
+}
+
+bool TEXTURE_STREAMING_MANAGER::StartEviction(STREAMED_TEXTURE& streamedTexture)
+{
+    //texture is created from the kept mips right away, it's swapped by FinishLoads when its upload is done
+    if (CreateMinResidentTexture(streamedTexture, streamedTexture.loadedTexture) != VK_SUCCESS) {
+        pDrvInterface->DestroyTexture(streamedTexture.loadedTexture);
+        return false;
+    }
+    m_committedSize += GetResidentSize(streamedTexture, streamedTexture.minResidentMip);
+    m_releasingSize += GetResidentSize(streamedTexture, streamedTexture.residentMip);
+    m_loadsInFlightNum++;
+
+    streamedTexture.isLoading = true;
+    streamedTexture.isLoaded = true;
+    streamedTexture.loadingMip = streamedTexture.minResidentMip;
+    return true;
+}
+
+void TEXTURE_STREAMING_MANAGER::EvictTextures(uint64_t neededSize)
+{
+    //textures used this frame keep their mips, the rest fall back to the smallest mips from the least recently used
+    std::vector<STREAMED_TEXTURE*> evictList;
+    for (std::unique_ptr<STREAMED_TEXTURE>& pStreamedTexture : m_textureList) {
+        if (!pStreamedTexture->isLoading && pStreamedTexture->residentMip < pStreamedTexture->minResidentMip && pStreamedTexture->lastUsedFrameId < m_frameId) {
+            evictList.push_back(pStreamedTexture.get());
+        }
+    }
+    std::sort(evictList.begin(), evictList.end(), [](const STREAMED_TEXTURE* pTextureA, const STREAMED_TEXTURE* pTextureB) {
+        return pTextureA->lastUsedFrameId < pTextureB->lastUsedFrameId;
+    });
+
+    //evictions share the limit with loads, so one frame doesn't create and retire too many textures
+    uint64_t freedSize = 0;
+    for (STREAMED_TEXTURE* pStreamedTexture : evictList) {
+        if (freedSize >= neededSize || m_loadsInFlightNum >= MAX_LOADS_IN_FLIGHT) {
+            break;
+        }
+        const uint64_t evictedSize = GetResidentSize(*pStreamedTexture, pStreamedTexture->residentMip) - GetResidentSize(*pStreamedTexture, pStreamedTexture->minResidentMip);
+        if (StartEviction(*pStreamedTexture)) {
+            freedSize += evictedSize;
+        }
+    }
+}
+
+void TEXTURE_STREAMING_MANAGER::DestroyRetiredTextures(bool isForced)
+{
+    while (!m_retiredTextureList.empty() && (isForced || m_frameId >= m_retiredTextureList.front().retiredFrameId + NUM_FRAME_BUFFERS)) {
+        pDrvInterface->DestroyTexture(m_retiredTextureList.front().texture);
+        m_committedSize -= m_retiredTextureList.front().textureSize;
+        m_releasingSize -= m_retiredTextureList.front().textureSize;
+        m_retiredTextureList.pop_front();
+    }
+}
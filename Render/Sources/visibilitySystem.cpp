@@ -1,16 +1,84 @@
 #include "visibilitySystem.h"
 
+#include <algorithm>
+
+#include "commonRenderVariables.h"
+#include "resourceSystem.h"
+
+#include "Components/camera.h"
 #include "Components/rendered.h"
 
 bool VISIBILITY_SYSTEM::Init()
 {
     ECS::pEcsCoordinator->SubscrubeSystemToComponentType<RENDERED_COMPONENT>(this);
+    ECS::pEcsCoordinator->SubscrubeSystemToComponentType<MESH_PRIMITIVE>(this);
+    DeclareReadAccess<MESH_PRIMITIVE>();
+    DeclareEntityReadAccess<CAMERA_COMPONENT>(gameCamera);
     return true;
 }
 
+void VISIBILITY_SYSTEM::AddEntity(ECS::ENTITY_TYPE entityId)
+{
+    ECS::SYSTEM<VISIBILITY_SYSTEM>::AddEntity(entityId);
+    m_isBoundsDirty = true;
+}
+
+void VISIBILITY_SYSTEM::RemoveEntity(ECS::ENTITY_TYPE entityId)
+{
+    ECS::SYSTEM<VISIBILITY_SYSTEM>::RemoveEntity(entityId);
+    m_isBoundsDirty = true;
+}
+
 void VISIBILITY_SYSTEM::Update()
 {
-    for (auto& rendEntity : m_entityList) {
-        ECS::pEcsCoordinator->AddComponentToEntity(rendEntity, VISIBLE_COMPONENT());
+    if (m_isBoundsDirty) {
+        UpdateBounds();
+    }
+
+    if (gameCamera == ECS::INVALID_ENTITY_ID) {
+        m_visibleEntityList[VIEW_GAME_CAMERA].clear();
+        return;
     }
+    const CAMERA_COMPONENT* pCamera = ECS::pEcsCoordinator->GetComponent<CAMERA_COMPONENT>(gameCamera);
+    CullFrustum(pCamera->viewProjMatrix, m_visibleEntityList[VIEW_GAME_CAMERA]);
+}
+
+void VISIBILITY_SYSTEM::UpdateBounds()
+{
+    //whole hierarchy is rebuilt when primitives are added or removed, it happens on level loading
+    ECS::pEcsCoordinator->SortEntitiesByComponent<MESH_PRIMITIVE>(m_entityList);
+
+    m_itemEntityList.assign(m_entityList.begin(), m_entityList.end());
+    std::vector<AABB> itemBoundsList(m_itemEntityList.size());
+    for (uint32_t itemId = 0; itemId < m_itemEntityList.size(); itemId++) {
+        //primitives are drawn without node transforms, so their mesh space bounds are world space ones
+        itemBoundsList[itemId] = ECS::pEcsCoordinator->GetComponent<MESH_PRIMITIVE>(m_itemEntityList[itemId])->aabb;
+    }
+    m_bvh.Build(itemBoundsList);
+    m_isBoundsDirty = false;
+}
+
+void VISIBILITY_SYSTEM::CullFrustum(const glm::mat4x4& viewProj, std::vector<ECS::ENTITY_TYPE>& visibleEntityList) const
+{
+    std::vector<uint32_t> visibleItemList;
+    m_bvh.QueryFrustum(FRUSTUM(viewProj), [&visibleItemList](uint32_t itemId) {
+        visibleItemList.push_back(itemId);
+    });
+    //items are numbered in component storage order, sorting keeps component access linear for passes
+    std::sort(visibleItemList.begin(), visibleItemList.end());
+
+    visibleEntityList.resize(visibleItemList.size());
+    for (size_t visibleId = 0; visibleId < visibleItemList.size(); visibleId++) {
+        visibleEntityList[visibleId] = m_itemEntityList[visibleItemList[visibleId]];
+    }
+}
+
+bool VISIBILITY_SYSTEM::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, ECS::ENTITY_TYPE& hitEntity, float& hitDistance) const
+{
+    uint32_t hitItemId;
+    if (!m_bvh.RayCast(origin, direction, maxDistance, hitItemId, hitDistance)) {
+        return false;
+    }
+    hitEntity = m_itemEntityList[hitItemId];
+    return true;
 }
@@ -6,10 +6,12 @@
 #include "resourceSystem.h"
 #include "geometry.h"
 #include "effectData.h"
+#include "jobSystem.h"
 //TODO: remove form here. create pso in resource system 
 #include "shaderManager.h"
 
 #include <algorithm>
+#include <fstream>
 #include <set>
 #include <unordered_set>
 
@@ -22,6 +24,24 @@ std::function<void(uint32_t&, uint32_t&, void*&)> pCallbackGetWindowParams;
 
 static const float DEPTH_BIAS_CLAMP = 1.f;
 
+static const std::string PIPLINE_CACHE_FILE = "..\\shaders\\binaries\\pipelineCache.bin";
+static const uint32_t    PIPLINE_CACHE_MAGIC = 0x50434355; //'UCCP'
+//must be increased when PIPLINE_CACHE_RECORD or meaning of its fields changes
+static const uint32_t    PIPLINE_CACHE_VERSION = 1;
+
+struct PIPLINE_CACHE_FILE_HEADER {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t shadersNum;
+    uint32_t vendorId;
+    uint32_t deviceId;
+    uint32_t driverVersion;
+    uint8_t  pipelineCacheUUID[VK_UUID_SIZE];
+    uint32_t recordsNum;
+    uint64_t cacheDataSize;
+};
+
 bool VULKAN_DRIVER_INTERFACE::Init()
 {
 	m_frameId = 0;
@@ -38,6 +58,7 @@ bool VULKAN_DRIVER_INTERFACE::Init()
     SAFE_FUNC_WRAPPER(InitWindowSurface, "Init surface error!");
     SAFE_FUNC_WRAPPER(InitPhysicalDevice, "Physical device select error! Cant find sutable GPU.");
     SAFE_FUNC_WRAPPER(InitLogicalDevice, "Logical device init error!");
+    SAFE_FUNC_WRAPPER(InitMemoryAllocator, "Memory allocator init error!");
     SAFE_FUNC_WRAPPER(InitSwapChain, "Initialization of swap chain failed!");
     SAFE_FUNC_WRAPPER(InitSwapChainImages, "Initialization of swap chain images failed!");
     //SAFE_FUNC_WRAPPER(InitDefaultRenderPass, "Default render pass creation failed!");
@@ -59,9 +80,11 @@ void VULKAN_DRIVER_INTERFACE::Term()
     for (int i = 0; i < m_descriptorSetLayout.size(); i++) {
         vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout[i], nullptr);
     }
-    for (int i = 0; i < m_descriptorPool.size(); i++) {
-        vkDestroyDescriptorPool(m_device, m_descriptorPool[i], nullptr);
+    TermBindlessTextures();
+    for (int i = 0; i < m_mainRecordingContext.descriptorPool.size(); i++) {
+        vkDestroyDescriptorPool(m_device, m_mainRecordingContext.descriptorPool[i], nullptr);
     }
+    TermRecordingContexts();
 
 	for (int i = 0; i < NUM_FRAME_BUFFERS; i++) {
 		vkDestroySemaphore(m_device, m_renderFinishedSemaphore[i], nullptr);
@@ -85,7 +108,9 @@ void VULKAN_DRIVER_INTERFACE::Term()
     for (auto& pso : m_pipelineStateCache) {
         vkDestroyPipeline(m_device, pso.second, nullptr);
     }
+    TermPipelineCache();
     vkDestroySwapchainKHR(m_device, m_swapChain.swapChain, nullptr);
+    m_memoryAllocator.Term();
     vkDestroyDevice(m_device, nullptr);
     if (m_enableValidationLayer) {
         TermDebugMessenger();
@@ -133,13 +158,17 @@ uint32_t VULKAN_DRIVER_INTERFACE::GetMemoryType(uint32_t typeFilter, VkMemoryPro
 
 VkResult VULKAN_DRIVER_INTERFACE::CreateBuffer (const VkBufferCreateInfo& bufferInfo, bool isUpdatedByCPU, VULKAN_BUFFER& createdBuffer)
 {
+    VkBufferCreateInfo createInfo = bufferInfo;
     if (!isUpdatedByCPU) {
         //buffer must be somehow filled
         ASSERT(IsEachMaskState(bufferInfo.usage, VK_BUFFER_USAGE_TRANSFER_DST_BIT));
     }
+    if (IsEachMaskState(createInfo.usage, VK_BUFFER_USAGE_TRANSFER_DST_BIT)) {
+        SetupUploadSharingMode(createInfo.sharingMode, createInfo.queueFamilyIndexCount, createInfo.pQueueFamilyIndices);
+    }
 
     VkResult result;
-    result = vkCreateBuffer(m_device, &bufferInfo, nullptr, &createdBuffer.buffer);
+    result = vkCreateBuffer(m_device, &createInfo, nullptr, &createdBuffer.buffer);
     if (result != VK_SUCCESS) {
         ERROR_MSG("Failed buffer creation");
         return result;
@@ -157,19 +186,14 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateBuffer (const VkBufferCreateInfo& buffer
     if (memoryType == -1) {
         return VK_ERROR_INITIALIZATION_FAILED;
     }
-    
-    VkMemoryAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = memoryType;
 
-    result = AllocateMemory(allocInfo, createdBuffer.bufferMemory);
+    result = m_memoryAllocator.Allocate(memReq, memoryType, true, createdBuffer.bufferMemory);
     if (result != VK_SUCCESS) {
         ERROR_MSG("Failed to allocate buffer memory!");
         return result;
     }
 
-    result = vkBindBufferMemory(m_device, createdBuffer.buffer, createdBuffer.bufferMemory, 0);
+    result = vkBindBufferMemory(m_device, createdBuffer.buffer, createdBuffer.bufferMemory.memory, createdBuffer.bufferMemory.offset);
     if (result != VK_SUCCESS) {
         ERROR_MSG("Failed to bind buffer memory!");
         return result;
@@ -177,6 +201,7 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateBuffer (const VkBufferCreateInfo& buffer
 
     createdBuffer.bufferSize = bufferInfo.size;
     createdBuffer.realBufferSize = memReq.size;
+    createdBuffer.usage = createInfo.usage;
 
     return result;
 }
@@ -185,10 +210,7 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateAndFillBuffer(const VkBufferCreateInfo&
 {
     VkResult result = CreateBuffer(bufferInfo, isUpdatedByCPU, createdBuffer);
     if (result == VK_SUCCESS) {
-        result = FillBuffer(pSourceData, bufferInfo.size, 0, m_intermediateStagingBuffer);
-    } 
-    if (result == VK_SUCCESS) {
-        CopyBuffer(m_intermediateStagingBuffer, createdBuffer, bufferInfo.size);
+        createdBuffer.uploadTicket = m_stagingRing.UploadBuffer(pSourceData, bufferInfo.size, createdBuffer, 0);
     }
     return result;
 }
@@ -198,27 +220,31 @@ uint32_t VULKAN_DRIVER_INTERFACE::GetDeviceCoherentValue (uint32_t bufferSize) c
     return(bufferSize + m_deviceProperties.limits.nonCoherentAtomSize - 1) & ~(m_deviceProperties.limits.nonCoherentAtomSize - 1);
 }
 
-VkResult VULKAN_DRIVER_INTERFACE::FillBuffer (const uint8_t* pSourceData,  uint64_t rawDataSize, uint64_t offset, VULKAN_BUFFER& buffer)
+void VULKAN_DRIVER_INTERFACE::SetupUploadSharingMode(VkSharingMode& sharingMode, uint32_t& queueFamilyIndexCount, const uint32_t*& pQueueFamilyIndices) const
 {
-    void* data;
-    size_t mappedSize = GetDeviceCoherentValue(rawDataSize);
-    VkResult result = vkMapMemory(m_device, buffer.bufferMemory, offset, mappedSize, 0, &data);
-    if (result != VK_SUCCESS) {
-        return result;
+    //resources filled by dedicated transfer queue are shared instead of queue ownership transfer
+    if (m_uploadQueueFamilyIndices[0] == m_uploadQueueFamilyIndices[1]) {
+        return;
     }
-    memcpy(data, pSourceData, rawDataSize);
-
-    VkMappedMemoryRange memoryRange{};
-    memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    memoryRange.pNext = nullptr;
-    memoryRange.offset = offset;
-    memoryRange.memory = buffer.bufferMemory;
-    memoryRange.size = mappedSize;
-    result = vkFlushMappedMemoryRanges(m_device, 1, &memoryRange);
+    sharingMode = VK_SHARING_MODE_CONCURRENT;
+    queueFamilyIndexCount = static_cast<uint32_t>(m_uploadQueueFamilyIndices.size());
+    pQueueFamilyIndices = m_uploadQueueFamilyIndices.data();
+}
 
-    vkUnmapMemory(m_device, buffer.bufferMemory);
+VkResult VULKAN_DRIVER_INTERFACE::FillBuffer (const uint8_t* pSourceData,  uint64_t rawDataSize, uint64_t offset, VULKAN_BUFFER& buffer)
+{
+    ASSERT(buffer.bufferMemory.pMappedData);
+    ASSERT(offset + rawDataSize <= buffer.bufferMemory.size);
+    memcpy(buffer.bufferMemory.pMappedData + offset, pSourceData, rawDataSize);
+    return m_memoryAllocator.Flush(buffer.bufferMemory, offset, rawDataSize);
+}
 
-    return result;
+UPLOAD_TICKET VULKAN_DRIVER_INTERFACE::UploadBuffer(const uint8_t* pSourceData, uint64_t rawDataSize, uint64_t offset, VULKAN_BUFFER& buffer)
+{
+    ASSERT(offset + rawDataSize <= buffer.bufferSize);
+    //buffer is destroyed only after its last upload
+    buffer.uploadTicket = m_stagingRing.UploadBuffer(pSourceData, rawDataSize, buffer, offset);
+    return buffer.uploadTicket;
 }
 
 
@@ -238,8 +264,11 @@ void VULKAN_DRIVER_INTERFACE::CopyBuffer(VULKAN_BUFFER srcBuffer, VULKAN_BUFFER
 
 void VULKAN_DRIVER_INTERFACE::DestroyBuffer(VULKAN_BUFFER& buffer)
 {
+    if (buffer.uploadTicket) {
+        m_stagingRing.Wait(buffer.uploadTicket);
+    }
     vkDestroyBuffer(m_device, buffer.buffer, nullptr);
-    vkFreeMemory(m_device, buffer.bufferMemory, nullptr);
+    m_memoryAllocator.Free(buffer.bufferMemory);
 }
 
 VkImageAspectFlags CastFormatToAspect(VkFormat format) {
@@ -260,7 +289,60 @@ VkImageAspectFlags CastFormatToAspect(VkFormat format) {
 
 void VULKAN_DRIVER_INTERFACE::ChangeTextureLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VULKAN_TEXTURE& texture)
 {
-    VkImageMemoryBarrier barrier{};
+    VkImageMemoryBarrier barrier;
+    VkPipelineStageFlags sourceStage;
+    VkPipelineStageFlags destinationStage;
+    FillLayoutBarrier(oldLayout, newLayout, texture, barrier, sourceStage, destinationStage);
+
+    vkCmdPipelineBarrier(
+        GetCurRecordingContext().commandBuffer,
+        sourceStage, destinationStage,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &barrier
+    );
+}
+
+void VULKAN_DRIVER_INTERFACE::ChangeTextureLayouts(const std::vector<TEXTURE_LAYOUT_TRANSITION>& transitionList)
+{
+    if (transitionList.empty()) {
+        return;
+    }
+
+    std::vector<VkImageMemoryBarrier> barrierList(transitionList.size());
+    VkPipelineStageFlags sourceStages = 0;
+    VkPipelineStageFlags destinationStages = 0;
+    for (size_t transitionId = 0; transitionId < transitionList.size(); transitionId++) {
+        const TEXTURE_LAYOUT_TRANSITION& transition = transitionList[transitionId];
+        VkImageMemoryBarrier& barrier = barrierList[transitionId];
+        VkPipelineStageFlags sourceStage;
+        VkPipelineStageFlags destinationStage;
+        FillLayoutBarrier(transition.oldLayout, transition.newLayout, *transition.pTexture, barrier, sourceStage, destinationStage);
+        if (transition.isAliased) {
+            //memory was used by other texture, its reads and writes must be done before content is discarded
+            barrier.srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            sourceStage |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        }
+        sourceStages |= sourceStage;
+        destinationStages |= destinationStage;
+    }
+
+    vkCmdPipelineBarrier(
+        GetCurRecordingContext().commandBuffer,
+        sourceStages, destinationStages,
+        0,
+        0, nullptr,
+        0, nullptr,
+        static_cast<uint32_t>(barrierList.size()), barrierList.data()
+    );
+}
+
+void VULKAN_DRIVER_INTERFACE::FillLayoutBarrier(VkImageLayout oldLayout, VkImageLayout newLayout, const VULKAN_TEXTURE& texture,
+    VkImageMemoryBarrier& barrier, VkPipelineStageFlags& sourceStage, VkPipelineStageFlags& destinationStage) const
+{
+    barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.oldLayout = oldLayout;
     barrier.newLayout = newLayout;
@@ -273,9 +355,6 @@ void VULKAN_DRIVER_INTERFACE::ChangeTextureLayout(VkImageLayout oldLayout, VkIma
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = 1;
 
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
-
     if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) 
     {
         barrier.srcAccessMask = 0;
@@ -338,24 +417,86 @@ void VULKAN_DRIVER_INTERFACE::ChangeTextureLayout(VkImageLayout oldLayout, VkIma
         barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
         sourceStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        destinationStage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+        destinationStage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    } else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+    {
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+        sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        destinationStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    } else if ((oldLayout == VK_IMAGE_LAYOUT_UNDEFINED || oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) && newLayout == VK_IMAGE_LAYOUT_GENERAL)
+    {
+        //storage image written by compute shader
+        barrier.srcAccessMask = oldLayout == VK_IMAGE_LAYOUT_UNDEFINED ? 0 : VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        sourceStage = oldLayout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        destinationStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    } else if (oldLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_GENERAL)
+    {
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        sourceStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        destinationStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    } else if (oldLayout == VK_IMAGE_LAYOUT_GENERAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        sourceStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    } else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+    {
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
     } else {
         ERROR_MSG("unsupported layout transition!");
+        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        destinationStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
     }
+}
+
+void VULKAN_DRIVER_INTERFACE::BufferBarrier(const VULKAN_BUFFER& buffer, VkAccessFlags srcAccess, VkPipelineStageFlags srcStage, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage)
+{
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer.buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
 
     vkCmdPipelineBarrier(
-        m_curCommandBuffer,
-        sourceStage, destinationStage,
+        GetCurRecordingContext().commandBuffer,
+        srcStage, dstStage,
         0,
         0, nullptr,
-        0, nullptr,
-        1, &barrier
+        1, &barrier,
+        0, nullptr
     );
 }
 
+void VULKAN_DRIVER_INTERFACE::ClearBuffer(const VULKAN_BUFFER& buffer)
+{
+    ASSERT(IsEachMaskState(buffer.usage, VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+    vkCmdFillBuffer(GetCurRecordingContext().commandBuffer, buffer.buffer, 0, VK_WHOLE_SIZE, 0);
+}
+
 VkResult VULKAN_DRIVER_INTERFACE::CreateTextureImage(const VkImageCreateInfo& imageInfo, VULKAN_TEXTURE& createdTexture)
 {
-    VkResult result = vkCreateImage(m_device, &imageInfo, nullptr, &createdTexture.image);
+    VkImageCreateInfo createInfo = imageInfo;
+    if (IsEachMaskState(createInfo.usage, VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+        SetupUploadSharingMode(createInfo.sharingMode, createInfo.queueFamilyIndexCount, createInfo.pQueueFamilyIndices);
+    }
+
+    VkResult result = vkCreateImage(m_device, &createInfo, nullptr, &createdTexture.image);
     if (result != VK_SUCCESS) {
         ERROR_MSG( "Can't create texture image");
         return result;
@@ -364,21 +505,19 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateTextureImage(const VkImageCreateInfo& im
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(m_device, createdTexture.image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = GetMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (allocInfo.memoryTypeIndex == -1) {
+    const uint32_t memoryType = GetMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (memoryType == -1) {
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
-    result = AllocateMemory(allocInfo, createdTexture.imageMemory);
+    const bool isLinearImage = imageInfo.tiling == VK_IMAGE_TILING_LINEAR;
+    result = m_memoryAllocator.Allocate(memRequirements, memoryType, isLinearImage, createdTexture.imageMemory);
     if(result != VK_SUCCESS) {
         ERROR_MSG("Can't allocate memory for texture");
         return result;
     }
 
-    result = vkBindImageMemory(m_device, createdTexture.image, createdTexture.imageMemory, 0);
+    result = vkBindImageMemory(m_device, createdTexture.image, createdTexture.imageMemory.memory, createdTexture.imageMemory.offset);
     if (result != VK_SUCCESS) {
         ERROR_MSG("Can't bind memory for texture");
         return result;
@@ -392,37 +531,6 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateTextureImage(const VkImageCreateInfo& im
     return result;
 }
 
-VkResult VULKAN_DRIVER_INTERFACE::CopyBufferToTexture (const VULKAN_BUFFER& buffer, VkDeviceSize bufferOffset, VULKAN_TEXTURE& texture, uint32_t mipLevel) 
-{
-    VkBufferImageCopy region{};
-    region.bufferOffset = bufferOffset;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = mipLevel;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-
-    region.imageOffset = { 0, 0, 0 };
-    region.imageExtent = {
-        texture.width >> mipLevel,
-        texture.height >> mipLevel,
-        1
-    };
-
-    vkCmdCopyBufferToImage(
-        m_curCommandBuffer,
-        buffer.buffer,
-        texture.image,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        1,
-        &region
-    );
-
-    return VK_SUCCESS;
-}
-
 VkResult VULKAN_DRIVER_INTERFACE::CreateImageView(const VkImageViewCreateInfo& imageViewInfo, VULKAN_TEXTURE& texture)
 {
     VkResult result = vkCreateImageView(m_device, &imageViewInfo, nullptr, &texture.imageView);
@@ -431,7 +539,7 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateImageView(const VkImageViewCreateInfo& i
 }
 
 
-VkResult VULKAN_DRIVER_INTERFACE::CreateRenderTarget(VULKAN_TEXTURE_CREATE_DATA& createData, VULKAN_TEXTURE& createdTexture)
+static VkImageCreateInfo GetRenderTargetImageInfo(const VULKAN_TEXTURE_CREATE_DATA& createData)
 {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -446,41 +554,83 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateRenderTarget(VULKAN_TEXTURE_CREATE_DATA&
     imageInfo.usage = createData.usage;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageInfo.flags = 0; // Optional
+    return imageInfo;
+}
 
-    VkResult imageCreated = CreateTextureImage(imageInfo, createdTexture);
+VkResult VULKAN_DRIVER_INTERFACE::CreateRenderTarget(VULKAN_TEXTURE_CREATE_DATA& createData, VULKAN_TEXTURE& createdTexture)
+{
+    VkResult imageCreated = CreateTextureImage(GetRenderTargetImageInfo(createData), createdTexture);
     if (imageCreated != VK_SUCCESS) {
         return imageCreated;
     }
+    return CreateRenderTargetView(createdTexture);
+}
 
+VkResult VULKAN_DRIVER_INTERFACE::CreateAliasedRenderTarget(const VULKAN_TEXTURE_CREATE_DATA& createData, VULKAN_TEXTURE& createdTexture, VkMemoryRequirements& memRequirements)
+{
+    const VkImageCreateInfo imageInfo = GetRenderTargetImageInfo(createData);
+    VkResult result = vkCreateImage(m_device, &imageInfo, nullptr, &createdTexture.image);
+    if (result != VK_SUCCESS) {
+        ERROR_MSG("Can't create render target image");
+        return result;
+    }
+    vkGetImageMemoryRequirements(m_device, createdTexture.image, &memRequirements);
+
+    createdTexture.width = imageInfo.extent.width;
+    createdTexture.height = imageInfo.extent.height;
+    createdTexture.format = imageInfo.format;
+    createdTexture.mipLevels = imageInfo.mipLevels;
+    return VK_SUCCESS;
+}
+
+VkResult VULKAN_DRIVER_INTERFACE::AllocateAliasedMemory(const VkMemoryRequirements& memRequirements, VULKAN_MEMORY_ALLOCATION& allocation)
+{
+    const uint32_t memoryType = GetMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (memoryType == -1) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    VkResult result = m_memoryAllocator.Allocate(memRequirements, memoryType, false, allocation);
+    if (result != VK_SUCCESS) {
+        ERROR_MSG("Can't allocate memory for aliased render targets");
+    }
+    return result;
+}
+
+VkResult VULKAN_DRIVER_INTERFACE::BindAliasedMemory(const VULKAN_MEMORY_ALLOCATION& allocation, VULKAN_TEXTURE& texture)
+{
+    VkResult result = vkBindImageMemory(m_device, texture.image, allocation.memory, allocation.offset);
+    if (result != VK_SUCCESS) {
+        ERROR_MSG("Can't bind memory for render target");
+        return result;
+    }
+    return CreateRenderTargetView(texture);
+}
+
+void VULKAN_DRIVER_INTERFACE::FreeAliasedMemory(VULKAN_MEMORY_ALLOCATION& allocation)
+{
+    m_memoryAllocator.Free(allocation);
+}
+
+VkResult VULKAN_DRIVER_INTERFACE::CreateRenderTargetView(VULKAN_TEXTURE& texture)
+{
     //todo: replace CreateImageView inside CreateTexture
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    viewInfo.image = createdTexture.image;
+    viewInfo.image = texture.image;
     viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    viewInfo.format = createData.format;;
+    viewInfo.format = texture.format;
     //todo
-    viewInfo.subresourceRange.aspectMask = CastFormatToAspect(createData.format) & ~VK_IMAGE_ASPECT_STENCIL_BIT;
+    viewInfo.subresourceRange.aspectMask = CastFormatToAspect(texture.format) & ~VK_IMAGE_ASPECT_STENCIL_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = 1;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
-    VkResult imageViewCreated = CreateImageView(viewInfo, createdTexture);
-    if (imageViewCreated != VK_SUCCESS) {
-        return imageViewCreated;
-    }
-
-    return VK_SUCCESS;
+    return CreateImageView(viewInfo, texture);
 }
 
 VkResult VULKAN_DRIVER_INTERFACE::CreateTexture(VULKAN_TEXTURE_CREATE_DATA& createData, VULKAN_TEXTURE& createdTexture)
 {
-    VkResult bufferFilled = pDrvInterface->FillBuffer(createData.pData, createData.dataSize, 0, m_intermediateStagingBuffer);
-    if (bufferFilled != VK_SUCCESS) {
-        WARNING_MSG("Can't fill tex buffer\n");
-        return bufferFilled;
-    }
-
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -500,19 +650,8 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateTexture(VULKAN_TEXTURE_CREATE_DATA& crea
         return textureCreated;
     }
 
-    VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
-    SetupCurrentCommandBuffer(commandBuffer);
-    ChangeTextureLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, createdTexture);
-
-    for (uint32_t mipLevelId = 0; mipLevelId < createData.mipLevels; mipLevelId++) {
-        VkResult textureDataSubmitted = pDrvInterface->CopyBufferToTexture(m_intermediateStagingBuffer, mipLevelId == 0 ? 0 : createData.mipLevelsOffsets[mipLevelId], createdTexture, mipLevelId);
-        if (textureDataSubmitted != VK_SUCCESS) {
-            WARNING_MSG("Can't submit data to texture\n");
-            return textureDataSubmitted;
-        }
-    }
-    ChangeTextureLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, createdTexture);
-    EndSingleTimeCommands(commandBuffer);
+    //layout transitions are recorded by the ring together with copies
+    createdTexture.uploadTicket = m_stagingRing.UploadTexture(createData, createdTexture);
 
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -535,40 +674,29 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateTexture(VULKAN_TEXTURE_CREATE_DATA& crea
 }
 
 void VULKAN_DRIVER_INTERFACE::DestroyTexture(VULKAN_TEXTURE& texture) {
-    VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
-    SetupCurrentCommandBuffer(commandBuffer);
-    ChangeTextureLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, texture);
-
+    if (texture.uploadTicket) {
+        m_stagingRing.Wait(texture.uploadTicket);
+    }
     vkDestroyImageView(m_device, texture.imageView, nullptr);
     vkDestroyImage(m_device, texture.image, nullptr);
-    vkFreeMemory(m_device, texture.imageMemory, nullptr);
-    EndSingleTimeCommands(commandBuffer);
+    m_memoryAllocator.Free(texture.imageMemory);
 }
 
 
-VkResult VULKAN_DRIVER_INTERFACE::AllocateMemory (const VkMemoryAllocateInfo& allocationInfo, VkDeviceMemory& allocatedMemory)
-{
-    VkResult result = vkAllocateMemory(m_device, &allocationInfo, nullptr, &allocatedMemory);
-    ASSERT(result == VK_SUCCESS);
-    return result;
-}
-
-void VULKAN_DRIVER_INTERFACE::FreeMemory (VkDeviceMemory& allocatedMemory)
-{
-    vkFreeMemory(m_device, allocatedMemory, nullptr);
-}
-
-
-VkResult VULKAN_DRIVER_INTERFACE::CreateDecriptorPools()
+VkResult VULKAN_DRIVER_INTERFACE::CreateDecriptorPools(std::array<VkDescriptorPool, NUM_FRAME_BUFFERS>& descriptorPool)
 {
     //todo : TOO MUCH DESCRIPTORS!
-    std::array<VkDescriptorPoolSize, 3> poolSizeDesc;
-    poolSizeDesc[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    std::array<VkDescriptorPoolSize, 5> poolSizeDesc;
+    poolSizeDesc[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     poolSizeDesc[0].descriptorCount = static_cast<uint32_t>(2048);
     poolSizeDesc[1].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
     poolSizeDesc[1].descriptorCount = static_cast<uint32_t>(2048);
     poolSizeDesc[2].type = VK_DESCRIPTOR_TYPE_SAMPLER;
     poolSizeDesc[2].descriptorCount = static_cast<uint32_t>(4096);
+    poolSizeDesc[3].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizeDesc[3].descriptorCount = static_cast<uint32_t>(512);
+    poolSizeDesc[4].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizeDesc[4].descriptorCount = static_cast<uint32_t>(256);
 
     VkDescriptorPoolCreateInfo poolInfo = {};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -577,8 +705,8 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateDecriptorPools()
     poolInfo.maxSets = 4096;
     poolInfo.flags = 0;
 
-    for (int i = 0; i < m_descriptorPool.size(); i++) {
-        VkResult result = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_descriptorPool[i]);
+    for (int i = 0; i < descriptorPool.size(); i++) {
+        VkResult result = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &descriptorPool[i]);
         if (result != VK_SUCCESS) {
             return result;
         }
@@ -596,6 +724,40 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateDecsriptorSetLayout(uint8_t shaderId)
     layoutInfo.pBindings = bindings.data();
 
     VkResult result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &m_descriptorSetLayout[shaderId]);
+
+    std::vector<std::pair<uint8_t, VkDescriptorBufferInfo>>& constBufferDescriptors = m_constBufferDescriptors[shaderId];
+    constBufferDescriptors.clear();
+    m_imageDescriptorSlots[shaderId].reset();
+    m_storageImageDescriptorSlots[shaderId].reset();
+    m_storageBufferDescriptorSlots[shaderId].reset();
+    for (const VkDescriptorSetLayoutBinding& binding : bindings) {
+        ASSERT(binding.binding < MAX_DESCRIPTOR_SLOTS);
+        if (binding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE) {
+            m_imageDescriptorSlots[shaderId].set(binding.binding);
+        }
+        if (binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) {
+            m_storageImageDescriptorSlots[shaderId].set(binding.binding);
+        }
+        if (binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+            m_storageBufferDescriptorSlots[shaderId].set(binding.binding);
+        }
+        if (binding.descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+            continue;
+        }
+        const uint32_t* pBufferSlot = std::find(std::begin(EFFECT_DATA::CONST_BUFFERS_SLOT), std::end(EFFECT_DATA::CONST_BUFFERS_SLOT), binding.binding);
+        ASSERT_MSG(pBufferSlot != std::end(EFFECT_DATA::CONST_BUFFERS_SLOT), "Unknown const buffer slot");
+        const size_t bufferId = pBufferSlot - std::begin(EFFECT_DATA::CONST_BUFFERS_SLOT);
+
+        std::pair<uint8_t, VkDescriptorBufferInfo> bufferInfo;
+        bufferInfo.first         = binding.binding;
+        bufferInfo.second.buffer = m_constBuffer.buffer;
+        bufferInfo.second.offset = 0;
+        bufferInfo.second.range  = EFFECT_DATA::CONST_BUFFERS_SIZE[bufferId];
+        constBufferDescriptors.push_back(bufferInfo);
+    }
+    std::sort(constBufferDescriptors.begin(), constBufferDescriptors.end(), [](const auto& left, const auto& right) {
+        return left.first < right.first;
+    });
     return result;
 }
 
@@ -606,13 +768,17 @@ VkResult VULKAN_DRIVER_INTERFACE::CreatePiplineLayout(const PIPLINE_LAYOUT_STATE
     VkPushConstantRange pushConstantRange;
     pushConstantRange.offset = 0;
     pushConstantRange.size = 128;
-    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.stageFlags = pShaderManager->IsComputeShader(piplineLayoutKey.shaderId) ? VK_SHADER_STAGE_COMPUTE_BIT : VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    //bindless textures are always in the second set
+    const std::array<VkDescriptorSetLayout, 2> setLayouts = { m_descriptorSetLayout[piplineLayoutKey.shaderId], m_bindlessSetLayout };
+    const bool isShaderUseBindless = pShaderManager->IsUseBindlessTextures(piplineLayoutKey.shaderId);
 
     bool isShaderUsePushConst = true;
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout[piplineLayoutKey.shaderId];
+    pipelineLayoutInfo.setLayoutCount = isShaderUseBindless ? 2 : 1;
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
     pipelineLayoutInfo.pushConstantRangeCount = isShaderUsePushConst ? 1 : 0;
     pipelineLayoutInfo.pPushConstantRanges = isShaderUsePushConst ? &pushConstantRange : nullptr;
 
@@ -698,10 +864,26 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateRenderPass(const RENDER_PASS_STATE& rend
 
 VkResult VULKAN_DRIVER_INTERFACE::InitPipelineState()
 {
-    CreateDecriptorPools();
-    VkResult result;
+    CreateDecriptorPools(m_mainRecordingContext.descriptorPool);
+    VkResult result = InitRecordingContexts();
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    result = InitPipelineCache();
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    if (m_isBindlessSupported) {
+        result = InitBindlessTextures();
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
     for (uint8_t shaderId = 0; shaderId < EFFECT_DATA::SHR_LAST; shaderId++) {
         CreateDecsriptorSetLayout(shaderId);
+        if (pShaderManager->IsUseBindlessTextures(shaderId) && !m_isBindlessSupported) {
+            continue;
+        }
         PIPLINE_LAYOUT_STATE plk;
         plk.shaderId = shaderId;
         result = CreatePiplineLayout(plk);
@@ -716,6 +898,8 @@ void VULKAN_DRIVER_INTERFACE::StartFrame()
 {
 	vkWaitForFences(m_device, 1, &m_cpuGpuSyncFence[m_curContextId], VK_TRUE, UINT64_MAX);
 	vkResetFences(m_device, 1, &m_cpuGpuSyncFence[m_curContextId]);
+    //gpu doesn't read const buffer region of this context anymore
+    m_constBufferFrameOffset = 0;
 
     VkResult result = vkAcquireNextImageKHR(m_device, m_swapChain.swapChain, UINT64_MAX, m_imageAvailableSemaphore[m_curContextId], VK_NULL_HANDLE, &m_swapChain.curSwapChainImageId);
 	ASSERT(result == VK_SUCCESS);
@@ -723,7 +907,18 @@ void VULKAN_DRIVER_INTERFACE::StartFrame()
     //todo:
     //vkResetCommandPool(m_device, m_commandPool[m_curContextId], 0);
     VkDescriptorPoolResetFlags resetFlags = 0;
-    vkResetDescriptorPool(m_device, m_descriptorPool[m_curContextId], resetFlags);
+    vkResetDescriptorPool(m_device, m_mainRecordingContext.descriptorPool[m_curContextId], resetFlags);
+    m_mainRecordingContext.descriptorSetCache[m_curContextId].clear();
+    if (m_isBindlessSupported) {
+        FlushBindlessTextures();
+    }
+    //fence is waited, so secondary buffers of this frame can be reused
+    for (auto& pContext : m_recordingContextList) {
+        vkResetDescriptorPool(m_device, pContext->descriptorPool[m_curContextId], resetFlags);
+        pContext->descriptorSetCache[m_curContextId].clear();
+        vkResetCommandPool(m_device, pContext->commandPool[m_curContextId], 0);
+        pContext->usedSecondaryCommandBuffersNum[m_curContextId] = 0;
+    }
 
     InvalidateDeviceState();
     SetupCurrentCommandBuffer(m_commandBuffers[m_curContextId]);
@@ -733,14 +928,14 @@ void VULKAN_DRIVER_INTERFACE::StartFrame()
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     beginInfo.pInheritanceInfo = nullptr; // Optional
 
-    if (vkBeginCommandBuffer(m_curCommandBuffer, &beginInfo) != VK_SUCCESS) {
+    if (vkBeginCommandBuffer(m_mainRecordingContext.commandBuffer, &beginInfo) != VK_SUCCESS) {
         ERROR_MSG("Failed to begin recording command buffer!");
     }
 }
 
 void VULKAN_DRIVER_INTERFACE::EndFrame()
 {
-    if (vkEndCommandBuffer(m_curCommandBuffer) != VK_SUCCESS) {
+    if (vkEndCommandBuffer(m_mainRecordingContext.commandBuffer) != VK_SUCCESS) {
         ERROR_MSG("Failed to record command buffer!");
     }
     SubmitCommandBuffer();
@@ -758,7 +953,10 @@ void VULKAN_DRIVER_INTERFACE::EndFrame()
 	presentInfo.pSwapchains = swapChains;
 	presentInfo.pImageIndices = &m_swapChain.curSwapChainImageId;
 	presentInfo.pResults = nullptr; // Optional
-	vkQueuePresentKHR(m_queueFamilies.presentQueue, &presentInfo);
+	{
+		std::lock_guard<std::mutex> queueLock(m_graphicsQueueLock);
+		vkQueuePresentKHR(m_queueFamilies.presentQueue, &presentInfo);
+	}
 
 	m_frameId++;
 	m_curContextId = (m_curContextId + 1) % NUM_FRAME_BUFFERS;
@@ -777,6 +975,14 @@ void VULKAN_DRIVER_INTERFACE::WaitGPU()
 
 void VULKAN_DRIVER_INTERFACE::SubmitCommandBuffer()
 {
+    //const buffer memory can be non coherent, flush everything written during the frame at once
+    const uint32_t constBufferFrameUsedSize = std::min(m_constBufferFrameOffset.load(), m_constBufferFrameSize);
+    if (constBufferFrameUsedSize) {
+        m_memoryAllocator.Flush(m_constBuffer.bufferMemory, m_curContextId * m_constBufferFrameSize, constBufferFrameUsedSize);
+    }
+    //uploads recorded during the frame go to gpu before it
+    m_stagingRing.Submit();
+
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
@@ -786,12 +992,13 @@ void VULKAN_DRIVER_INTERFACE::SubmitCommandBuffer()
 	submitInfo.pWaitSemaphores = waitSemaphores;
 	submitInfo.pWaitDstStageMask = waitStages;
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &m_curCommandBuffer;
+	submitInfo.pCommandBuffers = &m_mainRecordingContext.commandBuffer;
 
 	VkSemaphore signalSemaphores[] = { m_renderFinishedSemaphore[m_curContextId] };
 	submitInfo.signalSemaphoreCount = 1;
 	submitInfo.pSignalSemaphores = signalSemaphores;
 
+	std::lock_guard<std::mutex> queueLock(m_graphicsQueueLock);
 	if (vkQueueSubmit(m_queueFamilies.graphicsQueue, 1, &submitInfo, m_cpuGpuSyncFence[m_curContextId]) != VK_SUCCESS) {
 		ERROR_MSG("Failed to submit draw command buffer!");
 	}
@@ -810,7 +1017,22 @@ void VULKAN_DRIVER_INTERFACE::ClearBackBuffer(const glm::vec4& clearColor)
     clearRect.baseArrayLayer = 0;
     clearRect.layerCount = 1;
 
-    vkCmdClearAttachments(m_curCommandBuffer, 1, &clearAttachment, 1, &clearRect);
+    vkCmdClearAttachments(GetCurRecordingContext().commandBuffer, 1, &clearAttachment, 1, &clearRect);
+}
+
+void VULKAN_DRIVER_INTERFACE::ClearDepthBuffer(const VkRect2D& rect, float clearDepth)
+{
+    VkClearAttachment clearAttachment;
+    clearAttachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    clearAttachment.clearValue.depthStencil = { clearDepth, 0 };
+    clearAttachment.colorAttachment = 0;
+
+    VkClearRect clearRect;
+    clearRect.rect = rect;
+    clearRect.baseArrayLayer = 0;
+    clearRect.layerCount = 1;
+
+    vkCmdClearAttachments(GetCurRecordingContext().commandBuffer, 1, &clearAttachment, 1, &clearRect);
 }
 
 VkResult VULKAN_DRIVER_INTERFACE::CreateFrameBuffer(const FRAME_BUFFER_STATE& frameBufferState)
@@ -855,60 +1077,81 @@ VkResult VULKAN_DRIVER_INTERFACE::RecreateSwapChain()
 
 void VULKAN_DRIVER_INTERFACE::InvalidateDeviceState()
 {
-    m_updatePiplineLayout = true;
-    m_updatePiplineState = true;
-    m_updateDescriptorSet = true;
+    m_curRenderPass = VK_NULL_HANDLE;
+    m_curRenderPassState = RENDER_PASS_STATE();
 
-    m_curPassImageDescriptors.clear();
-    m_curPassBufferDescriptors.clear();
+    m_curFrameBuffer = VK_NULL_HANDLE;
+    m_curFrameBufferState = FRAME_BUFFER_STATE();
+    m_isSecondaryRenderPass = false;
+
+    InvalidateRecordingContextState(m_mainRecordingContext);
+}
+
+void VULKAN_DRIVER_INTERFACE::InvalidateRecordingContextState(RECORDING_CONTEXT& context)
+{
+    context.updatePiplineLayout = true;
+    context.updatePiplineState = true;
+    context.updateDescriptorSet = true;
+
+    context.passImageDescriptors.clear();
+    context.passBufferDescriptors.clear();
+    context.constBufferOffsets.fill(0);
+    context.updateConstBufferOffsets = false;
 
-    m_isDynamicDepthBiasDirty = false;
-    m_isDynamicScissorRectDirty = false;
+    context.pushConstantBufferDirtySize = 0;
+    context.isDynamicDepthBiasDirty = false;
+    context.isDynamicScissorRectDirty = false;
 
     //states
-    m_curPiplineLayout = VK_NULL_HANDLE;
-    m_curPiplineLayoutState = PIPLINE_LAYOUT_STATE();
+    context.descriptorSet = VK_NULL_HANDLE;
+    context.piplineLayout = VK_NULL_HANDLE;
+    context.piplineLayoutState = PIPLINE_LAYOUT_STATE();
 
-    m_curRenderPass = VK_NULL_HANDLE;
-    m_curRenderPassState = RENDER_PASS_STATE();
+    context.pipeline = VK_NULL_HANDLE;
+    context.piplineState.piplineLayoutId = SIZE_MAX;
+    context.piplineState.renderPassId = SIZE_MAX;
+    context.piplineState.shaderId = EFFECT_DATA::SHR_LAST;
+    context.piplineState.vertexFormatId = UINT8_MAX;
+    context.piplineState.dynamicFlagsBitset.reset();
+    context.piplineState.depthStateState.depthTestEnable = false;
+    context.piplineState.depthStateState.depthWriteEnable = false;
+    context.piplineState.depthStateState.depthCompareOp = false;
+    context.piplineState.depthStateState.stencilTestEnable = false;
+    context.piplineState.viewportHeight = 0;
+    context.piplineState.viewportWidth = 0;
 
-    m_curFrameBuffer = VK_NULL_HANDLE;
-    m_curFrameBufferState = FRAME_BUFFER_STATE();
+    context.vertexBuffer = VULKAN_BUFFER();
+    context.indexBuffer = VULKAN_BUFFER();
+}
 
-    m_curPipeline = VK_NULL_HANDLE;
-    m_curPiplineState.piplineLayoutId = SIZE_MAX;
-    m_curPiplineState.shaderId = EFFECT_DATA::SHR_LAST;
-    m_curPiplineState.vertexFormatId = UINT8_MAX;
-    m_curPiplineState.dynamicFlagsBitset.reset();
-    m_curPiplineState.depthStateState.depthTestEnable = false;
-    m_curPiplineState.depthStateState.depthWriteEnable = false;
-    m_curPiplineState.depthStateState.depthCompareOp = false;
-    m_curPiplineState.depthStateState.stencilTestEnable = false;
-    m_curPiplineState.viewportHeight = 0;
-    m_curPiplineState.viewportWidth = 0;
+//set only while thread records secondary command buffer, otherwise main context is used
+static thread_local RECORDING_CONTEXT* pThreadRecordingContext = nullptr;
 
-    m_curVertexBuffer = VULKAN_BUFFER();
-    m_curIndexBuffer = VULKAN_BUFFER();
+RECORDING_CONTEXT& VULKAN_DRIVER_INTERFACE::GetCurRecordingContext()
+{
+    return pThreadRecordingContext ? *pThreadRecordingContext : m_mainRecordingContext;
 }
 
 
 void VULKAN_DRIVER_INTERFACE::SetVertexBuffer(VULKAN_BUFFER vertexBuffer, uint32_t offset)
 {
-    if (m_curVertexBuffer != vertexBuffer) 
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    if (context.vertexBuffer != vertexBuffer) 
     {
-        m_curVertexBuffer = vertexBuffer;
+        context.vertexBuffer = vertexBuffer;
         VkBuffer vertexBuffers[] = { vertexBuffer.buffer };
         VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(m_curCommandBuffer, 0, 1, vertexBuffers, offsets);
+        vkCmdBindVertexBuffers(context.commandBuffer, 0, 1, vertexBuffers, offsets);
     }
 }
 
 void VULKAN_DRIVER_INTERFACE::SetIndexBuffer(VULKAN_BUFFER indexBuffer, uint32_t offset)
 {
-    if (m_curIndexBuffer != indexBuffer)
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    if (context.indexBuffer != indexBuffer)
     {
-        m_curIndexBuffer = indexBuffer;
-        vkCmdBindIndexBuffer(m_curCommandBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
+        context.indexBuffer = indexBuffer;
+        vkCmdBindIndexBuffer(context.commandBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
     }
     
 }
@@ -916,65 +1159,169 @@ void VULKAN_DRIVER_INTERFACE::SetIndexBuffer(VULKAN_BUFFER indexBuffer, uint32_t
 
 void VULKAN_DRIVER_INTERFACE::FillPushConstantBuffer(const void* pData, uint32_t dataSize)
 {
-    ASSERT(dataSize <= m_pushConstantBuffer.size());
-    m_pushConstantBufferDirtySize = dataSize;
-    std::memcpy(m_pushConstantBuffer.data(), pData, m_pushConstantBufferDirtySize);
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    ASSERT(dataSize <= context.pushConstantBuffer.size());
+    context.pushConstantBufferDirtySize = dataSize;
+    std::memcpy(context.pushConstantBuffer.data(), pData, context.pushConstantBufferDirtySize);
 }
 
-void VULKAN_DRIVER_INTERFACE::FillConstBuffer(uint32_t bufferId, const void* pData, uint32_t dataSize)
+uint32_t VULKAN_DRIVER_INTERFACE::FillConstBuffer(uint32_t bufferId, const void* pData, uint32_t dataSize)
 {
     ASSERT(EFFECT_DATA::CONST_BUFFERS_SIZE[bufferId] == dataSize);
-    if (m_constBufferOffsets[bufferId] + EFFECT_DATA::CONST_BUFFERS_SIZE[bufferId] > m_constBuffers[bufferId].realBufferSize) {
-        m_constBufferOffsets[bufferId] = 0;
+    const uint32_t alignedSize = (dataSize + m_constBufferAlignment - 1) / m_constBufferAlignment * m_constBufferAlignment;
+    const uint32_t frameOffset = m_constBufferFrameOffset.fetch_add(alignedSize);
+    uint32_t offset = INVALID_CONST_BUFFER_OFFSET;
+    if (frameOffset + alignedSize <= m_constBufferFrameSize) {
+        offset = m_curContextId * m_constBufferFrameSize + frameOffset;
+        memcpy(m_constBuffer.bufferMemory.pMappedData + offset, pData, dataSize);
+    } else if (frameOffset <= m_constBufferFrameSize) {
+        //data of draws recorded earlier in the frame mustn't be overwritten.
+        //offsets only grow, so only the fill which crosses the region end reports it once per frame
+        WARNING_MSG("Const buffer frame region is overflowed, draws are skipped!\n");
     }
-    FillBuffer(static_cast<const uint8_t*>(pData), dataSize, m_constBufferOffsets[bufferId], m_constBuffers[bufferId]);
-    m_constBufferLastRecordOffset[bufferId] = m_constBufferOffsets[bufferId];
-    m_constBufferOffsets[bufferId] += GetDeviceCoherentValue(EFFECT_DATA::CONST_BUFFERS_SIZE[bufferId]);
+
+    //last record is shared between contexts, secondary contexts use returned offset
+    if (pThreadRecordingContext == nullptr) {
+        m_constBufferLastRecordOffset[bufferId] = offset;
+    }
+    return offset;
 }
 
 void VULKAN_DRIVER_INTERFACE::SetConstBuffer(uint32_t bufferId)
 {
-    std::pair<uint8_t, VkDescriptorBufferInfo> bufferInfo;
-    bufferInfo.first         = EFFECT_DATA::CONST_BUFFERS_SLOT[bufferId];
-    bufferInfo.second.buffer = m_constBuffers[bufferId].buffer;
-    bufferInfo.second.offset = m_constBufferLastRecordOffset[bufferId];
-    bufferInfo.second.range  = EFFECT_DATA::CONST_BUFFERS_SIZE[bufferId];
+    SetConstBuffer(bufferId, m_constBufferLastRecordOffset[bufferId]);
+}
 
-    m_updateDescriptorSet = true;
-    m_curPassBufferDescriptors.push_back(bufferInfo);
+void VULKAN_DRIVER_INTERFACE::SetConstBuffer(uint32_t bufferId, uint32_t offset)
+{
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    uint32_t& slotOffset = context.constBufferOffsets[EFFECT_DATA::CONST_BUFFERS_SLOT[bufferId]];
+    if (slotOffset != offset) {
+        slotOffset = offset;
+        context.updateConstBufferOffsets = true;
+    }
 }
 
 void VULKAN_DRIVER_INTERFACE::SetTexture(const VULKAN_TEXTURE* texture, uint32_t slot)
 {
-    m_updateDescriptorSet = true;
     if (texture == nullptr) {
         ASSERT(false);
     } 
+    SetImageDescriptor(texture, slot, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
 
-    std::pair<uint8_t, VkDescriptorImageInfo> imageInfo;
-    imageInfo.first = slot;
-    imageInfo.second.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    imageInfo.second.imageView = texture->imageView;
-    imageInfo.second.sampler = nullptr;
-    m_curPassImageDescriptors.push_back(imageInfo);
+void VULKAN_DRIVER_INTERFACE::SetStorageImage(const VULKAN_TEXTURE* texture, uint32_t slot)
+{
+    ASSERT(texture != nullptr);
+    SetImageDescriptor(texture, slot, VK_IMAGE_LAYOUT_GENERAL);
+}
+
+void VULKAN_DRIVER_INTERFACE::SetImageDescriptor(const VULKAN_TEXTURE* texture, uint32_t slot, VkImageLayout layout)
+{
+    //sampled and storage images share slots, descriptor type is taken from the shader layout
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    auto imageDesc = std::lower_bound(context.passImageDescriptors.begin(), context.passImageDescriptors.end(), slot,
+        [](const std::pair<uint8_t, VkDescriptorImageInfo>& desc, uint32_t slot) { return desc.first < slot; });
+    if (imageDesc != context.passImageDescriptors.end() && imageDesc->first == slot) {
+        if (imageDesc->second.imageView == texture->imageView && imageDesc->second.imageLayout == layout) {
+            return;
+        }
+        imageDesc->second.imageView = texture->imageView;
+        imageDesc->second.imageLayout = layout;
+    } else {
+        std::pair<uint8_t, VkDescriptorImageInfo> imageInfo;
+        imageInfo.first = slot;
+        imageInfo.second.imageLayout = layout;
+        imageInfo.second.imageView = texture->imageView;
+        imageInfo.second.sampler = nullptr;
+        context.passImageDescriptors.insert(imageDesc, imageInfo);
+    }
+    context.updateDescriptorSet = true;
+}
+
+void VULKAN_DRIVER_INTERFACE::SetBindlessTexture(uint32_t textureId, const VULKAN_TEXTURE* pTexture)
+{
+    ASSERT(m_isBindlessSupported);
+    ASSERT(textureId < MAX_BINDLESS_TEXTURES);
+
+    //set of each context is written when its previous frame is done, so replaced textures aren't changed under gpu
+    std::lock_guard<std::mutex> bindlessLock(m_bindlessLock);
+    for (auto& bindlessWriteList : m_bindlessWriteList) {
+        bindlessWriteList.emplace_back(textureId, pTexture->imageView);
+    }
+}
+
+void VULKAN_DRIVER_INTERFACE::FlushBindlessTextures()
+{
+    std::lock_guard<std::mutex> bindlessLock(m_bindlessLock);
+    auto& bindlessWriteList = m_bindlessWriteList[m_curContextId];
+    if (bindlessWriteList.empty()) {
+        return;
+    }
+
+    std::vector<VkDescriptorImageInfo> imageInfoList(bindlessWriteList.size());
+    std::vector<VkWriteDescriptorSet> writeDescList(bindlessWriteList.size());
+    for (size_t writeId = 0; writeId < bindlessWriteList.size(); writeId++) {
+        VkDescriptorImageInfo& imageInfo = imageInfoList[writeId];
+        imageInfo = {};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = bindlessWriteList[writeId].second;
+        imageInfo.sampler = nullptr;
+
+        //writes are applied in order, the last one of the same element wins
+        VkWriteDescriptorSet& writeDesc = writeDescList[writeId];
+        writeDesc = {};
+        writeDesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writeDesc.dstSet = m_bindlessDescriptorSets[m_curContextId];
+        writeDesc.dstBinding = 0;
+        writeDesc.dstArrayElement = bindlessWriteList[writeId].first;
+        writeDesc.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writeDesc.descriptorCount = 1;
+        writeDesc.pImageInfo = &imageInfo;
+    }
+    vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writeDescList.size()), writeDescList.data(), 0, nullptr);
+    bindlessWriteList.clear();
+}
+
+void VULKAN_DRIVER_INTERFACE::SetStorageBuffer(const VULKAN_BUFFER& buffer, uint32_t slot)
+{
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    auto bufferDesc = std::lower_bound(context.passBufferDescriptors.begin(), context.passBufferDescriptors.end(), slot,
+        [](const std::pair<uint8_t, VkDescriptorBufferInfo>& desc, uint32_t slot) { return desc.first < slot; });
+    if (bufferDesc != context.passBufferDescriptors.end() && bufferDesc->first == slot) {
+        if (bufferDesc->second.buffer == buffer.buffer) {
+            return;
+        }
+        bufferDesc->second.buffer = buffer.buffer;
+    } else {
+        std::pair<uint8_t, VkDescriptorBufferInfo> bufferInfo;
+        bufferInfo.first = slot;
+        bufferInfo.second.buffer = buffer.buffer;
+        bufferInfo.second.offset = 0;
+        bufferInfo.second.range = VK_WHOLE_SIZE;
+        context.passBufferDescriptors.insert(bufferDesc, bufferInfo);
+    }
+    context.updateDescriptorSet = true;
 }
 
 void VULKAN_DRIVER_INTERFACE::SetShader(uint8_t shaderId)
 {
-    if (shaderId != m_curPiplineState.shaderId) {
-        m_curPiplineLayoutState.shaderId = shaderId;
-        m_curPiplineState.shaderId       = shaderId;
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    if (shaderId != context.piplineState.shaderId) {
+        context.piplineLayoutState.shaderId = shaderId;
+        context.piplineState.shaderId       = shaderId;
 
-        m_updatePiplineLayout = true;
-        m_updatePiplineState = true;
+        context.updatePiplineLayout = true;
+        context.updatePiplineState = true;
     }
 }
 
 void VULKAN_DRIVER_INTERFACE::SetVertexFormat(uint8_t vertexFormat)
 {
-    if (vertexFormat != m_curPiplineState.vertexFormatId) {
-        m_curPiplineState.vertexFormatId = vertexFormat;
-        m_updatePiplineState = true;
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    if (vertexFormat != context.piplineState.vertexFormatId) {
+        context.piplineState.vertexFormatId = vertexFormat;
+        context.updatePiplineState = true;
     }
 }
 
@@ -998,59 +1345,66 @@ void VULKAN_DRIVER_INTERFACE::SetDepthBuffer(const VULKAN_TEXTURE* pDepthTexture
 void VULKAN_DRIVER_INTERFACE::SetDynamicState(VkDynamicState state, bool enableState)
 {
     ASSERT(state < 8);
-    const uint8_t stateMask = 1 << state;
-    if (m_curPiplineState.dynamicFlagsBitset.test(state) != enableState) {
-        m_curPiplineState.dynamicFlagsBitset.set(state, enableState);
-        m_updatePiplineState = true;
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    if (context.piplineState.dynamicFlagsBitset.test(state) != enableState) {
+        context.piplineState.dynamicFlagsBitset.set(state, enableState);
+        context.updatePiplineState = true;
     }
 }
 
 void VULKAN_DRIVER_INTERFACE::SetDepthTestState(bool depthTestEnable)
 {
-    if (m_curPiplineState.depthStateState.depthTestEnable != depthTestEnable) {
-        m_curPiplineState.depthStateState.depthTestEnable = depthTestEnable;
-        m_updatePiplineState = true;
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    if (context.piplineState.depthStateState.depthTestEnable != depthTestEnable) {
+        context.piplineState.depthStateState.depthTestEnable = depthTestEnable;
+        context.updatePiplineState = true;
     }
 }
 
 void VULKAN_DRIVER_INTERFACE::SetDepthWriteState(bool depthWriteEnable)
 {
-    if (m_curPiplineState.depthStateState.depthWriteEnable != depthWriteEnable) {
-        m_curPiplineState.depthStateState.depthWriteEnable = depthWriteEnable;
-        m_updatePiplineState = true;
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    if (context.piplineState.depthStateState.depthWriteEnable != depthWriteEnable) {
+        context.piplineState.depthStateState.depthWriteEnable = depthWriteEnable;
+        context.updatePiplineState = true;
     }
 }
 
 void VULKAN_DRIVER_INTERFACE::SetDepthComparitionOperation(bool depthCompare)
 {
-    if (m_curPiplineState.depthStateState.depthCompareOp != depthCompare) {
-        m_curPiplineState.depthStateState.depthCompareOp = depthCompare;
-        m_updatePiplineState = true;
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    if (context.piplineState.depthStateState.depthCompareOp != depthCompare) {
+        context.piplineState.depthStateState.depthCompareOp = depthCompare;
+        context.updatePiplineState = true;
     }
 }
 
 void VULKAN_DRIVER_INTERFACE::SetStencilTestState(bool stencilTestEnable)
 {
-    if (m_curPiplineState.depthStateState.stencilTestEnable != stencilTestEnable) {
-        m_curPiplineState.depthStateState.stencilTestEnable = stencilTestEnable;
-        m_updatePiplineState = true;
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    if (context.piplineState.depthStateState.stencilTestEnable != stencilTestEnable) {
+        context.piplineState.depthStateState.stencilTestEnable = stencilTestEnable;
+        context.updatePiplineState = true;
     }
 }
 
 void VULKAN_DRIVER_INTERFACE::SetScissorRect(const VkRect2D& scissorRect) 
 {
-    m_dynamicScissorRect = scissorRect;
-    m_isDynamicScissorRectDirty = true;
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    context.dynamicScissorRect = scissorRect;
+    context.isDynamicScissorRectDirty = true;
 }
 
 void VULKAN_DRIVER_INTERFACE::SetDepthBiasParams(float depthBiasConstant, float depthBiasSlope)
 {
-    m_dynamicBiasParams = {depthBiasConstant, depthBiasSlope};
-    m_isDynamicDepthBiasDirty = true;
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    context.dynamicBiasParams = {depthBiasConstant, depthBiasSlope};
+    context.isDynamicDepthBiasDirty = true;
 }
 
-void VULKAN_DRIVER_INTERFACE::BeginRenderPass()
+void VULKAN_DRIVER_INTERFACE::BeginRenderPass(bool useSecondaryCommandBuffers)
 {
+    RECORDING_CONTEXT& context = m_mainRecordingContext;
     const size_t curRenderPassId = m_curRenderPassState.GetHashValue();
     auto renderPass = m_renderPassCache.find(curRenderPassId);
     if (renderPass == m_renderPassCache.end()) {
@@ -1060,9 +1414,9 @@ void VULKAN_DRIVER_INTERFACE::BeginRenderPass()
     m_curRenderPass = renderPass->second;
     m_curFrameBufferState.renderPassId = curRenderPassId;
 
-    if (m_curPiplineState.renderPassId != curRenderPassId) {
-        m_curPiplineState.renderPassId = curRenderPassId;
-        m_updatePiplineState = true;
+    if (context.piplineState.renderPassId != curRenderPassId) {
+        context.piplineState.renderPassId = curRenderPassId;
+        context.updatePiplineState = true;
     }
 
     const size_t curFrameBufferId = m_curFrameBufferState.GetHashValue();
@@ -1073,12 +1427,12 @@ void VULKAN_DRIVER_INTERFACE::BeginRenderPass()
     }
     m_curFrameBuffer = frameBuffer->second;
 
-    if (m_curPiplineState.viewportHeight != m_curFrameBufferState.GetFrameBufferHeight()
-        || m_curPiplineState.viewportWidth != m_curFrameBufferState.GetFrameBufferWigth()) 
+    if (context.piplineState.viewportHeight != m_curFrameBufferState.GetFrameBufferHeight()
+        || context.piplineState.viewportWidth != m_curFrameBufferState.GetFrameBufferWigth()) 
     {
-        m_curPiplineState.viewportHeight = m_curFrameBufferState.GetFrameBufferHeight();
-        m_curPiplineState.viewportWidth = m_curFrameBufferState.GetFrameBufferWigth();
-        m_updatePiplineState = true;
+        context.piplineState.viewportHeight = m_curFrameBufferState.GetFrameBufferHeight();
+        context.piplineState.viewportWidth = m_curFrameBufferState.GetFrameBufferWigth();
+        context.updatePiplineState = true;
     }
 
     uint32_t numClearValues = 0;
@@ -1101,20 +1455,99 @@ void VULKAN_DRIVER_INTERFACE::BeginRenderPass()
     renderPassInfo.renderArea.extent.width = m_curFrameBufferState.GetFrameBufferWigth();
     renderPassInfo.clearValueCount = numClearValues;
     renderPassInfo.pClearValues = clearValues.data();
-    vkCmdBeginRenderPass(m_curCommandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    m_isSecondaryRenderPass = useSecondaryCommandBuffers;
+    const VkSubpassContents subpassContents = useSecondaryCommandBuffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+    vkCmdBeginRenderPass(context.commandBuffer, &renderPassInfo, subpassContents);
 }
 
 void VULKAN_DRIVER_INTERFACE::EndRenderPass()
 {
-    vkCmdEndRenderPass(m_curCommandBuffer);
+    vkCmdEndRenderPass(m_mainRecordingContext.commandBuffer);
     InvalidateDeviceState();
 }
 
+void VULKAN_DRIVER_INTERFACE::BeginSecondaryRecording(uint32_t recordingContextId)
+{
+    ASSERT(m_isSecondaryRenderPass);
+    ASSERT(pThreadRecordingContext == nullptr);
+    RECORDING_CONTEXT& context = *m_recordingContextList[recordingContextId];
+    ASSERT(!context.isRecorded);
+
+    std::vector<VkCommandBuffer>& commandBuffers = context.secondaryCommandBuffers[m_curContextId];
+    uint32_t& usedCommandBuffersNum = context.usedSecondaryCommandBuffersNum[m_curContextId];
+    if (usedCommandBuffersNum == commandBuffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = context.commandPool[m_curContextId];
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(m_device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            ERROR_MSG("Failed to allocate secondary command buffer!");
+            return;
+        }
+        commandBuffers.push_back(commandBuffer);
+    }
+    context.commandBuffer = commandBuffers[usedCommandBuffersNum++];
+
+    //pipline states of secondary buffer must match current render pass
+    InvalidateRecordingContextState(context);
+    context.piplineState.renderPassId = m_curFrameBufferState.renderPassId;
+    context.piplineState.viewportHeight = m_curFrameBufferState.GetFrameBufferHeight();
+    context.piplineState.viewportWidth = m_curFrameBufferState.GetFrameBufferWigth();
+
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = m_curRenderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = m_curFrameBuffer;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    if (vkBeginCommandBuffer(context.commandBuffer, &beginInfo) != VK_SUCCESS) {
+        ERROR_MSG("Failed to begin recording secondary command buffer!");
+        return;
+    }
+    pThreadRecordingContext = &context;
+}
+
+void VULKAN_DRIVER_INTERFACE::EndSecondaryRecording()
+{
+    ASSERT(pThreadRecordingContext != nullptr);
+    RECORDING_CONTEXT& context = *pThreadRecordingContext;
+    if (vkEndCommandBuffer(context.commandBuffer) != VK_SUCCESS) {
+        ERROR_MSG("Failed to record secondary command buffer!");
+    }
+    context.isRecorded = true;
+    pThreadRecordingContext = nullptr;
+}
+
+void VULKAN_DRIVER_INTERFACE::ExecuteSecondaryCommandBuffers()
+{
+    ASSERT(m_isSecondaryRenderPass);
+    //keep order of contexts, so draw order doesn't depend on threads timings
+    std::vector<VkCommandBuffer> commandBuffers;
+    for (auto& pContext : m_recordingContextList) {
+        if (pContext->isRecorded) {
+            commandBuffers.push_back(pContext->commandBuffer);
+            pContext->isRecorded = false;
+        }
+    }
+    if (!commandBuffers.empty()) {
+        vkCmdExecuteCommands(m_mainRecordingContext.commandBuffer, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+    }
+}
+
 void VULKAN_DRIVER_INTERFACE::Draw(uint32_t vertexesNum)
 {
     const bool stateUpdated = UpdatePiplineState();
     if (stateUpdated) {
-        vkCmdDraw(m_curCommandBuffer, vertexesNum, 1, 0, 0);
+        vkCmdDraw(GetCurRecordingContext().commandBuffer, vertexesNum, 1, 0, 0);
     }
 }
 
@@ -1122,7 +1555,7 @@ void VULKAN_DRIVER_INTERFACE::DrawIndexed(uint32_t indexesNum, uint32_t vertexBu
 {
     const bool stateUpdated = UpdatePiplineState();
     if (stateUpdated) {
-        vkCmdDrawIndexed(m_curCommandBuffer, indexesNum, 1, indexBufferOffset, vertexBufferOffset, 0);
+        vkCmdDrawIndexed(GetCurRecordingContext().commandBuffer, indexesNum, 1, indexBufferOffset, vertexBufferOffset, 0);
     }
 }
 
@@ -1131,126 +1564,297 @@ void VULKAN_DRIVER_INTERFACE::DrawFullscreen()
     Draw(3);
 }
 
+void VULKAN_DRIVER_INTERFACE::DrawIndexedIndirect(const VULKAN_BUFFER& commandBuffer, const VULKAN_BUFFER& countBuffer, uint32_t maxDrawsNum)
+{
+    const bool stateUpdated = UpdatePiplineState();
+    if (!stateUpdated || maxDrawsNum == 0) {
+        return;
+    }
+    const VkCommandBuffer cmdBuffer = GetCurRecordingContext().commandBuffer;
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    if (m_isDrawIndirectCountSupported) {
+        m_vkCmdDrawIndexedIndirectCount(cmdBuffer, commandBuffer.buffer, 0, countBuffer.buffer, 0, maxDrawsNum, stride);
+    } else if (m_deviceFeatures.multiDrawIndirect) {
+        vkCmdDrawIndexedIndirect(cmdBuffer, commandBuffer.buffer, 0, maxDrawsNum, stride);
+    } else {
+        for (uint32_t drawId = 0; drawId < maxDrawsNum; drawId++) {
+            vkCmdDrawIndexedIndirect(cmdBuffer, commandBuffer.buffer, drawId * stride, 1, stride);
+        }
+    }
+}
+
+void VULKAN_DRIVER_INTERFACE::Dispatch(uint32_t groupsNumX, uint32_t groupsNumY, uint32_t groupsNumZ)
+{
+    ASSERT(pShaderManager->IsComputeShader(GetCurRecordingContext().piplineState.shaderId));
+    const bool stateUpdated = UpdatePiplineState();
+    if (stateUpdated) {
+        vkCmdDispatch(GetCurRecordingContext().commandBuffer, groupsNumX, groupsNumY, groupsNumZ);
+    }
+}
+
 
 bool VULKAN_DRIVER_INTERFACE::UpdatePiplineState()
 {
-    bool bindDescriptorSet = m_updateDescriptorSet;
-    if (m_updatePiplineLayout) {
-        const size_t curLayoutId = m_curPiplineLayoutState.GetHashValue();
-        auto piplineLayout = m_pipelineLayoutCache.find(curLayoutId);
-        if (piplineLayout == m_pipelineLayoutCache.end()) {
-            CreatePiplineLayout(m_curPiplineLayoutState);
-            piplineLayout = m_pipelineLayoutCache.find(curLayoutId);
+    RECORDING_CONTEXT& context = GetCurRecordingContext();
+    ASSERT_MSG(&context != &m_mainRecordingContext || !m_isSecondaryRenderPass, "Render pass expects secondary command buffers!");
+    const bool isComputeShader = pShaderManager->IsComputeShader(context.piplineState.shaderId);
+    const VkPipelineBindPoint bindPoint = isComputeShader ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+    bool bindDescriptorSet = false;
+    if (context.updatePiplineLayout) {
+        const size_t curLayoutId = context.piplineLayoutState.GetHashValue();
+        {
+            std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+            auto piplineLayout = m_pipelineLayoutCache.find(curLayoutId);
+            if (piplineLayout == m_pipelineLayoutCache.end()) {
+                CreatePiplineLayout(context.piplineLayoutState);
+                piplineLayout = m_pipelineLayoutCache.find(curLayoutId);
+            }
+            context.piplineLayout = piplineLayout->second;
         }
-        m_curPiplineLayout = piplineLayout->second;
-        if (m_curPiplineState.piplineLayoutId != curLayoutId) {
-            m_curPiplineState.piplineLayoutId = curLayoutId;
-            m_updatePiplineState = true;
+        if (context.piplineState.piplineLayoutId != curLayoutId) {
+            context.piplineState.piplineLayoutId = curLayoutId;
+            context.updatePiplineState = true;
+            //set must match the layout of new shader
+            context.updateDescriptorSet = true;
             bindDescriptorSet = true;
         }
         
-        m_updatePiplineLayout = false;
-    }
-
-    if (m_updateDescriptorSet) {
-        VkDescriptorSetAllocateInfo allocInfo = {};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = m_descriptorPool[m_curContextId];
-        allocInfo.descriptorSetCount  = 1;
-        allocInfo.pSetLayouts = &m_descriptorSetLayout[m_curPiplineLayoutState.shaderId];
-        VkResult result = vkAllocateDescriptorSets(m_device, &allocInfo, &m_curDescriptorSet);
-
-        std::vector<VkWriteDescriptorSet> writeDescSet;
-        for (const auto& samplerDesc : m_samplerDescriptors) {
-            VkWriteDescriptorSet writeDesc = {};
-            writeDesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writeDesc.dstSet = m_curDescriptorSet;
-            writeDesc.dstBinding = samplerDesc.first;
-            writeDesc.dstArrayElement = 0;
-            writeDesc.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-            writeDesc.descriptorCount = 1;
-            writeDesc.pImageInfo = &samplerDesc.second;
-
-            writeDescSet.push_back(writeDesc);
-        }
-        for (const auto& imageDesc : m_curPassImageDescriptors) {
-            VkWriteDescriptorSet writeDesc = {};
-            writeDesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writeDesc.dstSet = m_curDescriptorSet;
-            writeDesc.dstBinding = imageDesc.first;
-            writeDesc.dstArrayElement = 0;
-            writeDesc.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-            writeDesc.descriptorCount = 1;
-            writeDesc.pImageInfo = &imageDesc.second;
-
-            writeDescSet.push_back(writeDesc);
+        context.updatePiplineLayout = false;
+    }
+
+    if (context.updateDescriptorSet) {
+        const uint8_t shaderId = context.piplineLayoutState.shaderId;
+        const std::bitset<MAX_DESCRIPTOR_SLOTS>& imageSlots = m_imageDescriptorSlots[shaderId];
+        const std::bitset<MAX_DESCRIPTOR_SLOTS>& storageImageSlots = m_storageImageDescriptorSlots[shaderId];
+        const std::bitset<MAX_DESCRIPTOR_SLOTS>& storageBufferSlots = m_storageBufferDescriptorSlots[shaderId];
+
+        //samplers and const buffers are the same for all sets of the shader, only images and storage buffers make a difference
+        size_t descriptorSetKey = 0;
+        hash_combine(descriptorSetKey, shaderId);
+        for (const auto& imageDesc : context.passImageDescriptors) {
+            if (imageSlots[imageDesc.first] || storageImageSlots[imageDesc.first]) {
+                hash_combine(descriptorSetKey, imageDesc.first, imageDesc.second.imageView, imageDesc.second.imageLayout);
+            }
         }
-        for (const auto& bufferDesc : m_curPassBufferDescriptors) {
-            VkWriteDescriptorSet writeDesc = {};
-            writeDesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writeDesc.dstSet = m_curDescriptorSet;
-            writeDesc.dstBinding = bufferDesc.first;
-            writeDesc.dstArrayElement = 0;
-            writeDesc.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            writeDesc.descriptorCount = 1;
-            writeDesc.pBufferInfo = &bufferDesc.second;
-
-            writeDescSet.push_back(writeDesc);
+        for (const auto& bufferDesc : context.passBufferDescriptors) {
+            if (storageBufferSlots[bufferDesc.first]) {
+                hash_combine(descriptorSetKey, bufferDesc.first, bufferDesc.second.buffer);
+            }
         }
-        vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writeDescSet.size()), writeDescSet.data(), 0, nullptr);
-        m_curPassImageDescriptors.clear();
-        m_curPassBufferDescriptors.clear();
-        m_updateDescriptorSet = false;
-    }
 
-    if (bindDescriptorSet) {
-        vkCmdBindDescriptorSets(m_curCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_curPiplineLayout, 0, 1, &m_curDescriptorSet, 0, nullptr);
-    }
+        std::unordered_map<size_t, VkDescriptorSet>& descriptorSetCache = context.descriptorSetCache[m_curContextId];
+        auto cachedDescriptorSet = descriptorSetCache.find(descriptorSetKey);
+        VkDescriptorSet descriptorSet;
+        if (cachedDescriptorSet != descriptorSetCache.end()) {
+            descriptorSet = cachedDescriptorSet->second;
+        } else {
+            VkDescriptorSetAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocInfo.descriptorPool = context.descriptorPool[m_curContextId];
+            allocInfo.descriptorSetCount  = 1;
+            allocInfo.pSetLayouts = &m_descriptorSetLayout[shaderId];
+            VkResult result = vkAllocateDescriptorSets(m_device, &allocInfo, &descriptorSet);
+            ASSERT_MSG(result == VK_SUCCESS, "Descriptor set wasn't allocated!");
+
+            std::vector<VkWriteDescriptorSet> writeDescSet;
+            for (const auto& samplerDesc : m_samplerDescriptors) {
+                VkWriteDescriptorSet writeDesc = {};
+                writeDesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writeDesc.dstSet = descriptorSet;
+                writeDesc.dstBinding = samplerDesc.first;
+                writeDesc.dstArrayElement = 0;
+                writeDesc.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+                writeDesc.descriptorCount = 1;
+                writeDesc.pImageInfo = &samplerDesc.second;
+
+                writeDescSet.push_back(writeDesc);
+            }
+            for (const auto& imageDesc : context.passImageDescriptors) {
+                const bool isStorageImage = storageImageSlots[imageDesc.first];
+                if (!imageSlots[imageDesc.first] && !isStorageImage) {
+                    continue;
+                }
+                VkWriteDescriptorSet writeDesc = {};
+                writeDesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writeDesc.dstSet = descriptorSet;
+                writeDesc.dstBinding = imageDesc.first;
+                writeDesc.dstArrayElement = 0;
+                writeDesc.descriptorType = isStorageImage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                writeDesc.descriptorCount = 1;
+                writeDesc.pImageInfo = &imageDesc.second;
+
+                writeDescSet.push_back(writeDesc);
+            }
+            for (const auto& bufferDesc : context.passBufferDescriptors) {
+                if (!storageBufferSlots[bufferDesc.first]) {
+                    continue;
+                }
+                VkWriteDescriptorSet writeDesc = {};
+                writeDesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writeDesc.dstSet = descriptorSet;
+                writeDesc.dstBinding = bufferDesc.first;
+                writeDesc.dstArrayElement = 0;
+                writeDesc.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writeDesc.descriptorCount = 1;
+                writeDesc.pBufferInfo = &bufferDesc.second;
+
+                writeDescSet.push_back(writeDesc);
+            }
+            for (const auto& bufferDesc : m_constBufferDescriptors[shaderId]) {
+                VkWriteDescriptorSet writeDesc = {};
+                writeDesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writeDesc.dstSet = descriptorSet;
+                writeDesc.dstBinding = bufferDesc.first;
+                writeDesc.dstArrayElement = 0;
+                writeDesc.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+                writeDesc.descriptorCount = 1;
+                writeDesc.pBufferInfo = &bufferDesc.second;
+
+                writeDescSet.push_back(writeDesc);
+            }
+            vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writeDescSet.size()), writeDescSet.data(), 0, nullptr);
+            descriptorSetCache.emplace(descriptorSetKey, descriptorSet);
+        }
 
-    if (m_updatePiplineState) {
-        const size_t curPiplineStateObjectId = m_curPiplineState.GetHashValue();
-        auto piplineState = m_pipelineStateCache.find(curPiplineStateObjectId);
-        if (piplineState == m_pipelineStateCache.end()) {
-            VkResult piplineCreated = CreateGraphicPipeline(m_curPiplineState);
+        if (descriptorSet != context.descriptorSet) {
+            context.descriptorSet = descriptorSet;
+            bindDescriptorSet = true;
+        }
+        context.updateDescriptorSet = false;
+    }
+
+    //new const buffer data only changes dynamic offsets, the set is rebound without descriptor writes
+    if (bindDescriptorSet || context.updateConstBufferOffsets) {
+        const auto& constBufferDescriptors = m_constBufferDescriptors[context.piplineLayoutState.shaderId];
+        std::array<uint32_t, NUM_CONSTANT_BUFFERS> dynamicOffsets;
+        for (size_t descId = 0; descId < constBufferDescriptors.size(); descId++) {
+            dynamicOffsets[descId] = context.constBufferOffsets[constBufferDescriptors[descId].first];
+            if (dynamicOffsets[descId] == INVALID_CONST_BUFFER_OFFSET) {
+                //const buffer data wasn't written, set is bound by the next draw with valid data
+                context.updateConstBufferOffsets = true;
+                return false;
+            }
+        }
+        const std::array<VkDescriptorSet, 2> descriptorSets = { context.descriptorSet, m_bindlessDescriptorSets[m_curContextId] };
+        const uint32_t descriptorSetsNum = pShaderManager->IsUseBindlessTextures(context.piplineLayoutState.shaderId) ? 2 : 1;
+        vkCmdBindDescriptorSets(context.commandBuffer, bindPoint, context.piplineLayout, 0, descriptorSetsNum, descriptorSets.data(),
+            static_cast<uint32_t>(constBufferDescriptors.size()), dynamicOffsets.data());
+        context.updateConstBufferOffsets = false;
+    }
+
+    if (context.updatePiplineState && isComputeShader) {
+        //compute pipeline depends only on the shader, it doesn't need render pass and fixed function state
+        size_t computePiplineId = 0;
+        hash_combine(computePiplineId, context.piplineState.shaderId, context.piplineState.piplineLayoutId, bindPoint);
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        bool isPipelineCached;
+        {
+            std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+            auto piplineState = m_pipelineStateCache.find(computePiplineId);
+            isPipelineCached = piplineState != m_pipelineStateCache.end();
+            if (isPipelineCached) {
+                pipeline = piplineState->second;
+            }
+        }
+        if (!isPipelineCached) {
+            VkResult piplineCreated = CreateComputePipeline(context.piplineState.shaderId, context.piplineLayout, pipeline);
+            ASSERT_MSG(piplineCreated == VK_SUCCESS, "Compute pipine wasn't created!");
+            std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+            auto piplineState = m_pipelineStateCache.emplace(computePiplineId, pipeline);
+            if (!piplineState.second && pipeline != VK_NULL_HANDLE) {
+                vkDestroyPipeline(m_device, pipeline, nullptr);
+            }
+            pipeline = piplineState.first->second;
+        }
+        if (pipeline == VK_NULL_HANDLE) {
+            return false;
+        }
+        context.pipeline = pipeline;
+        vkCmdBindPipeline(context.commandBuffer, bindPoint, context.pipeline);
+        context.updatePiplineState = false;
+    }
+
+    if (context.updatePiplineState) {
+        const size_t curPiplineStateObjectId = context.piplineState.GetHashValue();
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        bool isPipelineCached;
+        {
+            std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+            auto piplineState = m_pipelineStateCache.find(curPiplineStateObjectId);
+            isPipelineCached = piplineState != m_pipelineStateCache.end();
+            if (isPipelineCached) {
+                pipeline = piplineState->second;
+            }
+        }
+        if (!isPipelineCached) {
+            //compiled without the lock, so a miss doesn't stall other recording threads
+            PIPLINE_CACHE_RECORD psoRecord;
+            psoRecord.piplineState = context.piplineState;
+            psoRecord.renderPassState = m_curRenderPassState;
+            VkResult piplineCreated = CreateGraphicPipeline(psoRecord, pipeline);
             ASSERT_MSG(piplineCreated == VK_SUCCESS, "Pipine wasn't created!");
-            piplineState = m_pipelineStateCache.find(curPiplineStateObjectId);
+            pipeline = StoreGraphicPipeline(psoRecord, pipeline);
         }
-        if (piplineState->second == VK_NULL_HANDLE) {
+        if (pipeline == VK_NULL_HANDLE) {
             return false;
         }
-        m_curPipeline = piplineState->second;
-        vkCmdBindPipeline(m_curCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_curPipeline);
-        m_updatePiplineState = false;
+        context.pipeline = pipeline;
+        vkCmdBindPipeline(context.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, context.pipeline);
+        context.updatePiplineState = false;
     }
 
-    if (m_pushConstantBufferDirtySize) {
+    if (context.pushConstantBufferDirtySize) {
         vkCmdPushConstants(
-            m_curCommandBuffer,
-            m_curPiplineLayout,
-            VK_SHADER_STAGE_VERTEX_BIT,
+            context.commandBuffer,
+            context.piplineLayout,
+            isComputeShader ? VK_SHADER_STAGE_COMPUTE_BIT : VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
             0,
-            m_pushConstantBufferDirtySize,
-            m_pushConstantBuffer.data()
+            context.pushConstantBufferDirtySize,
+            context.pushConstantBuffer.data()
         );
-        m_pushConstantBufferDirtySize = 0;
+        context.pushConstantBufferDirtySize = 0;
     }
-    if (m_isDynamicScissorRectDirty) {
-        vkCmdSetScissor(m_curCommandBuffer, 0, 1, &m_dynamicScissorRect);
-        m_isDynamicScissorRectDirty = false;
+    if (context.isDynamicScissorRectDirty) {
+        vkCmdSetScissor(context.commandBuffer, 0, 1, &context.dynamicScissorRect);
+        context.isDynamicScissorRectDirty = false;
     }
 
-    if (m_isDynamicDepthBiasDirty) {
+    if (context.isDynamicDepthBiasDirty) {
         //we can't change clamp value dynamically by documentation
-        vkCmdSetDepthBias(m_curCommandBuffer, m_dynamicBiasParams.x, 0.f, m_dynamicBiasParams.y);
-        m_isDynamicDepthBiasDirty = false;
+        vkCmdSetDepthBias(context.commandBuffer, context.dynamicBiasParams.x, 0.f, context.dynamicBiasParams.y);
+        context.isDynamicDepthBiasDirty = false;
     }
 
     return true;
 }
 
-VkResult VULKAN_DRIVER_INTERFACE::CreateGraphicPipeline(const PIPLINE_STATE& piplineState)
+VkResult VULKAN_DRIVER_INTERFACE::CreateGraphicPipeline(const PIPLINE_CACHE_RECORD& psoRecord, VkPipeline& pipline)
 {
-    ASSERT(m_pipelineLayoutCache.find(piplineState.piplineLayoutId) != m_pipelineLayoutCache.end());
+    const PIPLINE_STATE& piplineState = psoRecord.piplineState;
+    pipline = VK_NULL_HANDLE;
+
+    VkPipelineLayout pipelineLayout;
+    VkRenderPass     renderPass;
+    {
+        std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+        auto piplineLayout = m_pipelineLayoutCache.find(piplineState.piplineLayoutId);
+        if (piplineLayout == m_pipelineLayoutCache.end()) {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        pipelineLayout = piplineLayout->second;
+
+        //render pass of precompiled pipeline may be not created yet, any compatible one is enough
+        auto renderPassIt = m_renderPassCache.find(piplineState.renderPassId);
+        if (renderPassIt == m_renderPassCache.end()) {
+            VkResult result = CreateRenderPass(psoRecord.renderPassState);
+            if (result != VK_SUCCESS) {
+                return result;
+            }
+            renderPassIt = m_renderPassCache.find(piplineState.renderPassId);
+        }
+        renderPass = renderPassIt->second;
+    }
 
     VERTEX_FORMAT_DESCRIPTOR vertexFormatDescriptor = pVertexDeclarationManager->GetDesc(piplineState.vertexFormatId);
     VkPipelineVertexInputStateCreateInfo vertexInputDescriptor;
@@ -1343,7 +1947,7 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateGraphicPipeline(const PIPLINE_STATE& pip
         colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
         colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
     }
-    std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachmentStateVector(m_curRenderPassState.useRT.count(), colorBlendAttachment);
+    std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachmentStateVector(psoRecord.renderPassState.useRT.count(), colorBlendAttachment);
 
     VkPipelineColorBlendStateCreateInfo colorBlending = {};
     colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -1407,29 +2011,189 @@ VkResult VULKAN_DRIVER_INTERFACE::CreateGraphicPipeline(const PIPLINE_STATE& pip
     pipelineInfo.pDepthStencilState = &depthStencil;
     pipelineInfo.pColorBlendState = &colorBlending;
     pipelineInfo.pDynamicState = &dynamicState;
-    pipelineInfo.layout = m_pipelineLayoutCache[piplineState.piplineLayoutId];
-    pipelineInfo.renderPass = m_renderPassCache[piplineState.renderPassId];
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.renderPass = renderPass;
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
     pipelineInfo.basePipelineIndex = -1; // Optional
 
-    VkPipeline pipline;
-    VkResult result = vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipline);
+    VkResult result = vkCreateGraphicsPipelines(m_device, m_pipelineCache, 1, &pipelineInfo, nullptr, &pipline);
     if (result != VK_SUCCESS) {
         ERROR_MSG("Can't create pipline!");
-        vkDestroyPipeline(m_device, pipline, nullptr);
         pipline = VK_NULL_HANDLE;
     } 
-    m_pipelineStateCache.emplace(piplineState.GetHashValue(), pipline);
+    return result;
+}
+
+VkPipeline VULKAN_DRIVER_INTERFACE::StoreGraphicPipeline(const PIPLINE_CACHE_RECORD& psoRecord, VkPipeline pipeline)
+{
+    const size_t piplineStateId = psoRecord.piplineState.GetHashValue();
+
+    std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+    auto piplineState = m_pipelineStateCache.emplace(piplineStateId, pipeline);
+    if (!piplineState.second) {
+        if (pipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(m_device, pipeline, nullptr);
+        }
+        return piplineState.first->second;
+    }
+    //failed pipelines are cached too, so they aren't recreated each draw, but they aren't saved
+    if (pipeline != VK_NULL_HANDLE) {
+        m_pipelineRecordCache[piplineStateId] = psoRecord;
+    }
+    return pipeline;
+}
+
+VkResult VULKAN_DRIVER_INTERFACE::CreateComputePipeline(uint8_t shaderId, VkPipelineLayout pipelineLayout, VkPipeline& pipeline)
+{
+    pipeline = VK_NULL_HANDLE;
+    const VkShaderModule& computeShader = pShaderManager->GetComputeShader(shaderId);
+    if (computeShader == VK_NULL_HANDLE) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = computeShader;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
 
+    VkResult result = vkCreateComputePipelines(m_device, m_pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+    if (result != VK_SUCCESS) {
+        ERROR_MSG("Can't create compute pipline!");
+        pipeline = VK_NULL_HANDLE;
+    }
     return result;
 }
 
+void VULKAN_DRIVER_INTERFACE::PrecompilePipelines()
+{
+    std::vector<PIPLINE_CACHE_RECORD> psoRecordList;
+    {
+        std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+        for (const auto& psoRecord : m_pipelineRecordCache) {
+            if (m_pipelineStateCache.find(psoRecord.first) == m_pipelineStateCache.end()) {
+                psoRecordList.push_back(psoRecord.second);
+            }
+        }
+    }
+
+    ECS::pJobSystem->ParallelFor(psoRecordList.size(), 1, [this, &psoRecordList](size_t begin, size_t end) {
+        for (size_t recordId = begin; recordId < end; recordId++) {
+            const PIPLINE_CACHE_RECORD& psoRecord = psoRecordList[recordId];
+            VkPipeline pipeline;
+            if (CreateGraphicPipeline(psoRecord, pipeline) == VK_SUCCESS) {
+                StoreGraphicPipeline(psoRecord, pipeline);
+            } else {
+                //shader or its layout doesn't exist anymore
+                std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+                m_pipelineRecordCache.erase(psoRecord.piplineState.GetHashValue());
+            }
+        }
+    });
+}
+
 void VULKAN_DRIVER_INTERFACE::DropPiplineStateCache()
 {
     m_pipelineStateCache.clear();
 }
 
+void VULKAN_DRIVER_INTERFACE::DropFrameBufferCache()
+{
+    for (auto frameBuffer : m_frameBufferCache) {
+        vkDestroyFramebuffer(m_device, frameBuffer.second, nullptr);
+    }
+    m_frameBufferCache.clear();
+}
+
+VkResult VULKAN_DRIVER_INTERFACE::InitPipelineCache()
+{
+    const std::vector<char> fileData = ReadFile(PIPLINE_CACHE_FILE);
+
+    //saved data is used only if it was made by the same device and driver
+    const PIPLINE_CACHE_FILE_HEADER* pHeader = reinterpret_cast<const PIPLINE_CACHE_FILE_HEADER*>(fileData.data());
+    bool isFileValid = fileData.size() >= sizeof(PIPLINE_CACHE_FILE_HEADER);
+    isFileValid = isFileValid && pHeader->magic == PIPLINE_CACHE_MAGIC && pHeader->version == PIPLINE_CACHE_VERSION;
+    isFileValid = isFileValid && pHeader->recordSize == sizeof(PIPLINE_CACHE_RECORD) && pHeader->shadersNum == EFFECT_DATA::SHR_LAST;
+    isFileValid = isFileValid && pHeader->vendorId == m_deviceProperties.vendorID && pHeader->deviceId == m_deviceProperties.deviceID;
+    isFileValid = isFileValid && pHeader->driverVersion == m_deviceProperties.driverVersion;
+    isFileValid = isFileValid && memcmp(pHeader->pipelineCacheUUID, m_deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    isFileValid = isFileValid && fileData.size() == sizeof(PIPLINE_CACHE_FILE_HEADER) +
+        pHeader->recordsNum * sizeof(PIPLINE_CACHE_RECORD) + pHeader->cacheDataSize;
+    if (!fileData.empty() && !isFileValid) {
+        WARNING_MSG("Pipeline cache file is outdated, it is ignored.\n");
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    if (isFileValid) {
+        const char* pRecordData = fileData.data() + sizeof(PIPLINE_CACHE_FILE_HEADER);
+        for (uint32_t recordId = 0; recordId < pHeader->recordsNum; recordId++) {
+            PIPLINE_CACHE_RECORD psoRecord;
+            memcpy(&psoRecord, pRecordData + recordId * sizeof(PIPLINE_CACHE_RECORD), sizeof(PIPLINE_CACHE_RECORD));
+            //ids are hashes, they are recalculated in case hash function differs
+            PIPLINE_LAYOUT_STATE piplineLayoutState;
+            piplineLayoutState.shaderId = psoRecord.piplineState.shaderId;
+            psoRecord.piplineState.piplineLayoutId = piplineLayoutState.GetHashValue();
+            psoRecord.piplineState.renderPassId = psoRecord.renderPassState.GetHashValue();
+            m_pipelineRecordCache.emplace(psoRecord.piplineState.GetHashValue(), psoRecord);
+        }
+        cacheInfo.initialDataSize = static_cast<size_t>(pHeader->cacheDataSize);
+        cacheInfo.pInitialData = pRecordData + pHeader->recordsNum * sizeof(PIPLINE_CACHE_RECORD);
+    }
+    VkResult result = vkCreatePipelineCache(m_device, &cacheInfo, nullptr, &m_pipelineCache);
+    if (result != VK_SUCCESS && isFileValid) {
+        //driver may still reject the data, start from the empty cache then
+        m_pipelineRecordCache.clear();
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = nullptr;
+        result = vkCreatePipelineCache(m_device, &cacheInfo, nullptr, &m_pipelineCache);
+    }
+    return result;
+}
+
+void VULKAN_DRIVER_INTERFACE::TermPipelineCache()
+{
+    static_assert(std::is_trivially_copyable<PIPLINE_CACHE_RECORD>::value, "Pipeline cache records are saved as raw data");
+
+    size_t cacheDataSize = 0;
+    std::vector<char> cacheData;
+    if (vkGetPipelineCacheData(m_device, m_pipelineCache, &cacheDataSize, nullptr) == VK_SUCCESS) {
+        cacheData.resize(cacheDataSize);
+        if (vkGetPipelineCacheData(m_device, m_pipelineCache, &cacheDataSize, cacheData.data()) != VK_SUCCESS) {
+            cacheDataSize = 0;
+        }
+    }
+    vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+
+    PIPLINE_CACHE_FILE_HEADER header = {};
+    header.magic = PIPLINE_CACHE_MAGIC;
+    header.version = PIPLINE_CACHE_VERSION;
+    header.recordSize = sizeof(PIPLINE_CACHE_RECORD);
+    header.shadersNum = EFFECT_DATA::SHR_LAST;
+    header.vendorId = m_deviceProperties.vendorID;
+    header.deviceId = m_deviceProperties.deviceID;
+    header.driverVersion = m_deviceProperties.driverVersion;
+    memcpy(header.pipelineCacheUUID, m_deviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+    header.recordsNum = static_cast<uint32_t>(m_pipelineRecordCache.size());
+    header.cacheDataSize = cacheDataSize;
+
+    std::ofstream file(PIPLINE_CACHE_FILE, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        WARNING_MSG("Can't save pipeline cache!\n");
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& psoRecord : m_pipelineRecordCache) {
+        file.write(reinterpret_cast<const char*>(&psoRecord.second), sizeof(PIPLINE_CACHE_RECORD));
+    }
+    file.write(cacheData.data(), cacheDataSize);
+}
+
 std::vector<const char*> VULKAN_DRIVER_INTERFACE::GetRequiredInstanceExtentions() const
 {
     std::vector<const char*> requiredExtentions;
@@ -1508,7 +2272,8 @@ VkResult VULKAN_DRIVER_INTERFACE::InitInstance()
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    //1.1 is needed for vkGetPhysicalDeviceFeatures2
+    appInfo.apiVersion = VK_API_VERSION_1_1;
 
     std::vector<const char*> enabledExtentions = GetRequiredInstanceExtentions();
     std::vector<const char*> enabledLayers = GetRequiredInstanceLayers();
@@ -1550,6 +2315,11 @@ VkResult VULKAN_DRIVER_INTERFACE::InitPhysicalDevice()
 
         vkGetPhysicalDeviceProperties(m_physicalDevice, &m_deviceProperties);
         vkGetPhysicalDeviceFeatures(m_physicalDevice, &m_deviceFeatures);
+        m_isBindlessSupported = CheckBindlessSupport(m_physicalDevice);
+        m_isDrawIndirectCountSupported = CheckDeviceExtentionSupport(m_physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        m_vkCmdDrawIndexedIndirectCount = nullptr;
+        m_bindlessSetLayout = VK_NULL_HANDLE;
+        m_bindlessDescriptorPool = VK_NULL_HANDLE;
         return VK_SUCCESS;
     } else {
         return VK_ERROR_INITIALIZATION_FAILED;
@@ -1562,7 +2332,8 @@ VkResult VULKAN_DRIVER_INTERFACE::InitLogicalDevice()
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = { 
         m_queueFamilies.createParams.graphicsFamilyIndex.value(), 
-        m_queueFamilies.createParams.presentFamilyIndex.value() 
+        m_queueFamilies.createParams.presentFamilyIndex.value(),
+        m_queueFamilies.createParams.transferFamilyIndex.value()
     };
     for (uint32_t queueFamily : uniqueQueueFamilies) {
         VkDeviceQueueCreateInfo queueCreateInfo = {};
@@ -1574,9 +2345,27 @@ VkResult VULKAN_DRIVER_INTERFACE::InitLogicalDevice()
     }
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    //used by gpu driven passes, draws fall back to single ones without multiDrawIndirect
+    deviceFeatures.multiDrawIndirect = m_deviceFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = m_deviceFeatures.drawIndirectFirstInstance;
 
     std::vector<const char*> deviceExtentions = GetRequiredDeviceExtentions();
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+    indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    if (m_isBindlessSupported) {
+        deviceExtentions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    }
+    if (m_isDrawIndirectCountSupported) {
+        deviceExtentions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+
     VkDeviceCreateInfo createInfo = {};
+    createInfo.pNext = m_isBindlessSupported ? &indexingFeatures : nullptr;
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.queueCreateInfoCount = (uint32_t)queueCreateInfos.size();
@@ -1588,6 +2377,15 @@ VkResult VULKAN_DRIVER_INTERFACE::InitLogicalDevice()
     if (result == VK_SUCCESS) {
         vkGetDeviceQueue(m_device, m_queueFamilies.createParams.graphicsFamilyIndex.value(), 0, &m_queueFamilies.graphicsQueue);
         vkGetDeviceQueue(m_device, m_queueFamilies.createParams.presentFamilyIndex.value(), 0, &m_queueFamilies.presentQueue);
+        vkGetDeviceQueue(m_device, m_queueFamilies.createParams.transferFamilyIndex.value(), 0, &m_queueFamilies.transferQueue);
+        m_uploadQueueFamilyIndices = {
+            m_queueFamilies.createParams.graphicsFamilyIndex.value(),
+            m_queueFamilies.createParams.transferFamilyIndex.value()
+        };
+        if (m_isDrawIndirectCountSupported) {
+            m_vkCmdDrawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(m_device, "vkCmdDrawIndexedIndirectCountKHR");
+            m_isDrawIndirectCountSupported = m_vkCmdDrawIndexedIndirectCount != nullptr;
+        }
     }
     return result;
 }
@@ -1706,6 +2504,108 @@ VkResult VULKAN_DRIVER_INTERFACE::InitCommandBuffers()
     return VK_SUCCESS;
 }
 
+VkResult VULKAN_DRIVER_INTERFACE::InitRecordingContexts()
+{
+    //one context per thread which can take a job: every worker and the main thread
+    const uint32_t contextsNum = ECS::pJobSystem ? ECS::pJobSystem->GetWorkersNum() + 1 : 1;
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = m_queueFamilies.createParams.graphicsFamilyIndex.value();
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    for (uint32_t contextId = 0; contextId < contextsNum; contextId++) {
+        std::unique_ptr<RECORDING_CONTEXT> pContext(new RECORDING_CONTEXT);
+        for (uint32_t frameId = 0; frameId < NUM_FRAME_BUFFERS; frameId++) {
+            VkResult result = vkCreateCommandPool(m_device, &poolInfo, nullptr, &pContext->commandPool[frameId]);
+            if (result != VK_SUCCESS) {
+                ERROR_MSG("Can't create command pool for recording context!");
+                return result;
+            }
+        }
+        VkResult result = CreateDecriptorPools(pContext->descriptorPool);
+        if (result != VK_SUCCESS) {
+            ERROR_MSG("Can't create descriptor pool for recording context!");
+            return result;
+        }
+        m_recordingContextList.push_back(std::move(pContext));
+    }
+    return VK_SUCCESS;
+}
+
+void VULKAN_DRIVER_INTERFACE::TermRecordingContexts()
+{
+    for (auto& pContext : m_recordingContextList) {
+        for (uint32_t frameId = 0; frameId < NUM_FRAME_BUFFERS; frameId++) {
+            vkDestroyCommandPool(m_device, pContext->commandPool[frameId], nullptr);
+            vkDestroyDescriptorPool(m_device, pContext->descriptorPool[frameId], nullptr);
+        }
+    }
+    m_recordingContextList.clear();
+}
+
+VkResult VULKAN_DRIVER_INTERFACE::InitBindlessTextures()
+{
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    binding.descriptorCount = MAX_BINDLESS_TEXTURES;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    binding.pImmutableSamplers = nullptr;
+
+    //textures of new materials are written while old ones are used by frames in flight
+    const VkDescriptorBindingFlagsEXT bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    bindingFlagsInfo.bindingCount = 1;
+    bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    VkResult result = vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &m_bindlessSetLayout);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    VkDescriptorPoolSize poolSize;
+    poolSize.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    poolSize.descriptorCount = MAX_BINDLESS_TEXTURES * NUM_FRAME_BUFFERS;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = NUM_FRAME_BUFFERS;
+    result = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_bindlessDescriptorPool);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    std::array<VkDescriptorSetLayout, NUM_FRAME_BUFFERS> setLayoutList;
+    setLayoutList.fill(m_bindlessSetLayout);
+    allocInfo.descriptorPool = m_bindlessDescriptorPool;
+    allocInfo.descriptorSetCount = NUM_FRAME_BUFFERS;
+    allocInfo.pSetLayouts = setLayoutList.data();
+    return vkAllocateDescriptorSets(m_device, &allocInfo, m_bindlessDescriptorSets.data());
+}
+
+void VULKAN_DRIVER_INTERFACE::TermBindlessTextures()
+{
+    if (!m_isBindlessSupported) {
+        return;
+    }
+    vkDestroyDescriptorPool(m_device, m_bindlessDescriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_bindlessSetLayout, nullptr);
+}
+
 VkResult VULKAN_DRIVER_INTERFACE::InitSemaphoresAndFences()
 {
     VkSemaphoreCreateInfo semaphoreInfo = {};
@@ -1737,15 +2637,26 @@ VkResult VULKAN_DRIVER_INTERFACE::InitSemaphoresAndFences()
     return VK_SUCCESS;
 }
 
+VkResult VULKAN_DRIVER_INTERFACE::InitMemoryAllocator()
+{
+    return m_memoryAllocator.Init(m_physicalDevice, m_device);
+}
+
 VkResult VULKAN_DRIVER_INTERFACE::InitIntermediateBuffers()
 {
+    const uint32_t STAGING_RING_SIZE = 64 * 1024 * 1024; // 64 Mb
+
     VkBufferCreateInfo stagingBufferInfo = {};
     stagingBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    stagingBufferInfo.size = 8192 * 8192 *  sizeof(float);
+    stagingBufferInfo.size = STAGING_RING_SIZE;
     stagingBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     stagingBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    VkResult bufferCreated = pDrvInterface->CreateBuffer(stagingBufferInfo, true, m_intermediateStagingBuffer);
-    return bufferCreated;
+    VkResult bufferCreated = pDrvInterface->CreateBuffer(stagingBufferInfo, true, m_stagingRingBuffer);
+    if (bufferCreated != VK_SUCCESS) {
+        return bufferCreated;
+    }
+    return m_stagingRing.Init(m_device, m_stagingRingBuffer, m_queueFamilies.createParams.transferFamilyIndex.value(),
+        m_queueFamilies.transferQueue, m_queueFamilies.graphicsQueue, m_graphicsQueueLock);
 }
 
 
@@ -1755,36 +2666,30 @@ VkResult VULKAN_DRIVER_INTERFACE::InitConstBuffers()
         ASSERT(NUM_CONSTANT_BUFFERS > EFFECT_DATA::CONST_BUFFERS_SLOT[i]);
     }
     
-    m_constBufferOffsets.fill(0);
     m_constBufferLastRecordOffset.fill(0);
+    m_constBufferFrameOffset = 0;
 
-    const uint32_t DYNAMIC_CONST_BUFFER_SIZE = 1 * 1024 * 1024; // 1 Mb
+    m_constBufferFrameSize = FRAME_CONST_BUFFER_SIZE;
+    m_constBufferAlignment = static_cast<uint32_t>(m_deviceProperties.limits.minUniformBufferOffsetAlignment);
 
     VkBufferCreateInfo constBufferInfo = {};
     constBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    constBufferInfo.size = DYNAMIC_CONST_BUFFER_SIZE;
+    constBufferInfo.size = NUM_FRAME_BUFFERS * m_constBufferFrameSize;
     constBufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
     constBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    for (int i = 0; i < m_constBuffers.size(); i++) {
-        VkResult bufferCreateStatus = CreateBuffer(constBufferInfo, true, m_constBuffers[i]);
-        if (bufferCreateStatus != VK_SUCCESS) {
-            return bufferCreateStatus;
-        }
-    }
-    return VK_SUCCESS;
+    return CreateBuffer(constBufferInfo, true, m_constBuffer);
 }
 
 void VULKAN_DRIVER_INTERFACE::TermConstBuffers()
 {
-    for (int i = 0; i < m_constBuffers.size(); i++) {
-        DestroyBuffer(m_constBuffers[i]);
-    }
+    DestroyBuffer(m_constBuffer);
 }
 
 
 void VULKAN_DRIVER_INTERFACE::TermIntermediateBuffers() {
-    DestroyBuffer(m_intermediateStagingBuffer);
+    m_stagingRing.Term();
+    DestroyBuffer(m_stagingRingBuffer);
 }
 
 void VULKAN_DRIVER_INTERFACE::SetupSamples()
@@ -1946,6 +2851,34 @@ int VULKAN_DRIVER_INTERFACE::DeviceSuitabilityRate(const VkPhysicalDevice & devi
     return deviceRate;
 }
 
+bool VULKAN_DRIVER_INTERFACE::CheckDeviceExtentionSupport(const VkPhysicalDevice& device, const char* extentionName) const
+{
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+    return std::any_of(availableExtensions.begin(), availableExtensions.end(), [extentionName](const VkExtensionProperties& extention) {
+        return strcmp(extention.extensionName, extentionName) == 0;
+    });
+}
+
+bool VULKAN_DRIVER_INTERFACE::CheckBindlessSupport(const VkPhysicalDevice& device) const
+{
+    if (!CheckDeviceExtentionSupport(device, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+        return false;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    VkPhysicalDeviceFeatures2 deviceFeatures = {};
+    deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    deviceFeatures.pNext = &indexingFeatures;
+    vkGetPhysicalDeviceFeatures2(device, &deviceFeatures);
+
+    return indexingFeatures.runtimeDescriptorArray && indexingFeatures.descriptorBindingPartiallyBound &&
+        indexingFeatures.descriptorBindingSampledImageUpdateAfterBind && indexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+}
+
 QUEUE_FAMILIES::QUEUE_FAMILY_CREATE_PARAMS VULKAN_DRIVER_INTERFACE::FindQueueFamilies(const VkPhysicalDevice & device) const
 {
     uint32_t queueFamilyCount = 0;
@@ -1955,11 +2888,21 @@ QUEUE_FAMILIES::QUEUE_FAMILY_CREATE_PARAMS VULKAN_DRIVER_INTERFACE::FindQueueFam
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
     QUEUE_FAMILIES::QUEUE_FAMILY_CREATE_PARAMS indices;
-    int familyIndex = 0;
+    bool isTransferOnlyFamily = false;
+    int familyIndex = -1;
     for (const VkQueueFamilyProperties& queueFamily : queueFamilies) {
+        familyIndex++;
         if (queueFamily.queueCount == 0) {
             continue;
         }
+        //dma engines are exposed as families without graphics and compute
+        const bool isTransferFamily = (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+        const bool isTransferOnly = isTransferFamily && !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT);
+        if (isTransferFamily && (!indices.transferFamilyIndex.has_value() || (isTransferOnly && !isTransferOnlyFamily))) {
+            indices.transferFamilyIndex = familyIndex;
+            isTransferOnlyFamily = isTransferOnly;
+        }
+
         VkBool32 isGraphicsSupport = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT;
         VkBool32 isPresentSupport = false;
         vkGetPhysicalDeviceSurfaceSupportKHR(device, familyIndex, m_windowSurface, &isPresentSupport);
@@ -1975,7 +2918,9 @@ QUEUE_FAMILIES::QUEUE_FAMILY_CREATE_PARAMS VULKAN_DRIVER_INTERFACE::FindQueueFam
         if (isPresentSupport && !indices.presentFamilyIndex.has_value()) {
             indices.presentFamilyIndex = familyIndex;
         }
-        familyIndex++;
+    }
+    if (!indices.transferFamilyIndex.has_value()) {
+        indices.transferFamilyIndex = indices.graphicsFamilyIndex;
     }
     return indices;
 }
@@ -2097,7 +3042,7 @@ void SWAP_CHAIN::SWAP_CHAIN_CREATE_PARAMS::ChooseExtent(const VkSurfaceCapabilit
 
 void VULKAN_DRIVER_INTERFACE::SetupCurrentCommandBuffer(VkCommandBuffer newCurrentBuffer)
 {
-    m_curCommandBuffer = newCurrentBuffer;
+    m_mainRecordingContext.commandBuffer = newCurrentBuffer;
 }
 
 VkCommandBuffer VULKAN_DRIVER_INTERFACE::BeginSingleTimeCommands()
@@ -2128,9 +3073,12 @@ void VULKAN_DRIVER_INTERFACE::EndSingleTimeCommands(VkCommandBuffer commandBuffe
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer;
 
-    vkQueueSubmit(m_queueFamilies.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    //todo: remove idle
-    vkQueueWaitIdle(m_queueFamilies.graphicsQueue);
+    {
+        std::lock_guard<std::mutex> queueLock(m_graphicsQueueLock);
+        vkQueueSubmit(m_queueFamilies.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+        //todo: remove idle
+        vkQueueWaitIdle(m_queueFamilies.graphicsQueue);
+    }
 
     vkFreeCommandBuffers(m_device, m_commandPool, 1, &commandBuffer);
 }
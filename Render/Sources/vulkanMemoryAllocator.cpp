@@ -0,0 +1,444 @@
+#include "vulkanMemoryAllocator.h"
+#include "support.h"
+
+#include <algorithm>
+
+static const VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+static uint32_t FindLastSetBit(uint64_t mask)
+{
+    uint32_t bitId = 0;
+    while (mask >>= 1) {
+        bitId++;
+    }
+    return bitId;
+}
+
+static uint32_t FindFirstSetBit(uint64_t mask)
+{
+    uint32_t bitId = 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        bitId++;
+    }
+    return bitId;
+}
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static VkDeviceSize AlignDown(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return value / alignment * alignment;
+}
+
+
+VULKAN_MEMORY_BLOCK::VULKAN_MEMORY_BLOCK(VkDeviceMemory memory, VkDeviceSize size, uint32_t poolId, uint8_t* pMappedData)
+    : m_memory(memory), m_size(size), m_poolId(poolId), m_pMappedData(pMappedData), m_usedSize(0), m_allocationsNum(0), m_flBitmap(0)
+{
+    m_slBitmap.fill(0);
+    for (auto& slFreeList : m_freeListHead) {
+        slFreeList.fill(INVALID_NODE_ID);
+    }
+
+    const uint32_t nodeId = CreateNode();
+    NODE& node = m_nodeList[nodeId];
+    node.offset = 0;
+    node.size = size;
+    InsertFreeNode(nodeId);
+}
+
+bool VULKAN_MEMORY_BLOCK::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, uint32_t& nodeId)
+{
+    if (m_allocationsNum == 0) {
+        //empty block is one free node at offset 0, it is aligned for any alignment,
+        //so blocks created with exact resource size don't need alignment slack
+        if (size > m_size) {
+            return false;
+        }
+        uint32_t flId, slId;
+        MapSize(m_size, flId, slId);
+        nodeId = m_freeListHead[flId][slId];
+        ASSERT(nodeId != INVALID_NODE_ID && m_nodeList[nodeId].offset == 0);
+    } else {
+        //any free range of this size fits the request after alignment
+        const VkDeviceSize searchSize = size + alignment - 1;
+        if (searchSize > m_size - m_usedSize) {
+            return false;
+        }
+        nodeId = FindFreeNode(searchSize);
+        if (nodeId == INVALID_NODE_ID) {
+            return false;
+        }
+    }
+    RemoveFreeNode(nodeId);
+
+    const VkDeviceSize padding = AlignUp(m_nodeList[nodeId].offset, alignment) - m_nodeList[nodeId].offset;
+    if (padding > 0) {
+        //previous physical node is never free, so padding can't be merged with it
+        const uint32_t paddingNodeId = nodeId;
+        nodeId = SplitNode(paddingNodeId, padding);
+        InsertFreeNode(paddingNodeId);
+    }
+    if (m_nodeList[nodeId].size > size) {
+        const uint32_t tailNodeId = SplitNode(nodeId, size);
+        InsertFreeNode(tailNodeId);
+    }
+
+    NODE& node = m_nodeList[nodeId];
+    node.isFree = false;
+    offset = node.offset;
+    m_usedSize += node.size;
+    m_allocationsNum++;
+    return true;
+}
+
+void VULKAN_MEMORY_BLOCK::Free(uint32_t nodeId)
+{
+    ASSERT(nodeId < m_nodeList.size() && !m_nodeList[nodeId].isFree);
+    m_usedSize -= m_nodeList[nodeId].size;
+    m_allocationsNum--;
+
+    const uint32_t nextNodeId = m_nodeList[nodeId].nextPhysicalId;
+    if (nextNodeId != INVALID_NODE_ID && m_nodeList[nextNodeId].isFree) {
+        RemoveFreeNode(nextNodeId);
+        MergeWithNext(nodeId);
+    }
+    const uint32_t prevNodeId = m_nodeList[nodeId].prevPhysicalId;
+    if (prevNodeId != INVALID_NODE_ID && m_nodeList[prevNodeId].isFree) {
+        RemoveFreeNode(prevNodeId);
+        MergeWithNext(prevNodeId);
+        nodeId = prevNodeId;
+    }
+    InsertFreeNode(nodeId);
+}
+
+void VULKAN_MEMORY_BLOCK::MapSize(VkDeviceSize size, uint32_t& flId, uint32_t& slId) const
+{
+    if (size < SL_COUNT) {
+        flId = 0;
+        slId = static_cast<uint32_t>(size);
+        return;
+    }
+    const uint32_t lastBitId = FindLastSetBit(size);
+    flId = lastBitId - SL_LOG2 + 1;
+    slId = static_cast<uint32_t>(size >> (lastBitId - SL_LOG2)) - SL_COUNT;
+}
+
+uint32_t VULKAN_MEMORY_BLOCK::FindFreeNode(VkDeviceSize size) const
+{
+    //round size up to the next list, so every node of found list is big enough
+    if (size >= SL_COUNT) {
+        size += (VkDeviceSize(1) << (FindLastSetBit(size) - SL_LOG2)) - 1;
+    }
+    uint32_t flId, slId;
+    MapSize(size, flId, slId);
+
+    uint32_t slMask = m_slBitmap[flId] & (~0u << slId);
+    if (slMask == 0) {
+        const uint64_t flMask = flId + 1 < 64 ? m_flBitmap & (~0ull << (flId + 1)) : 0;
+        if (flMask == 0) {
+            return INVALID_NODE_ID;
+        }
+        flId = FindFirstSetBit(flMask);
+        slMask = m_slBitmap[flId];
+    }
+    slId = FindFirstSetBit(slMask);
+    return m_freeListHead[flId][slId];
+}
+
+void VULKAN_MEMORY_BLOCK::InsertFreeNode(uint32_t nodeId)
+{
+    NODE& node = m_nodeList[nodeId];
+    uint32_t flId, slId;
+    MapSize(node.size, flId, slId);
+
+    node.isFree = true;
+    node.prevFreeId = INVALID_NODE_ID;
+    node.nextFreeId = m_freeListHead[flId][slId];
+    if (node.nextFreeId != INVALID_NODE_ID) {
+        m_nodeList[node.nextFreeId].prevFreeId = nodeId;
+    }
+    m_freeListHead[flId][slId] = nodeId;
+    m_flBitmap |= 1ull << flId;
+    m_slBitmap[flId] |= 1u << slId;
+}
+
+void VULKAN_MEMORY_BLOCK::RemoveFreeNode(uint32_t nodeId)
+{
+    NODE& node = m_nodeList[nodeId];
+    uint32_t flId, slId;
+    MapSize(node.size, flId, slId);
+
+    if (node.prevFreeId != INVALID_NODE_ID) {
+        m_nodeList[node.prevFreeId].nextFreeId = node.nextFreeId;
+    } else {
+        m_freeListHead[flId][slId] = node.nextFreeId;
+    }
+    if (node.nextFreeId != INVALID_NODE_ID) {
+        m_nodeList[node.nextFreeId].prevFreeId = node.prevFreeId;
+    }
+    if (m_freeListHead[flId][slId] == INVALID_NODE_ID) {
+        m_slBitmap[flId] &= ~(1u << slId);
+        if (m_slBitmap[flId] == 0) {
+            m_flBitmap &= ~(1ull << flId);
+        }
+    }
+    node.isFree = false;
+}
+
+uint32_t VULKAN_MEMORY_BLOCK::SplitNode(uint32_t nodeId, VkDeviceSize leftSize)
+{
+    //CreateNode can reallocate node list, don't keep references across it
+    const uint32_t rightNodeId = CreateNode();
+    NODE& leftNode = m_nodeList[nodeId];
+    NODE& rightNode = m_nodeList[rightNodeId];
+    ASSERT(leftSize < leftNode.size);
+
+    rightNode.offset = leftNode.offset + leftSize;
+    rightNode.size = leftNode.size - leftSize;
+    rightNode.prevPhysicalId = nodeId;
+    rightNode.nextPhysicalId = leftNode.nextPhysicalId;
+    if (rightNode.nextPhysicalId != INVALID_NODE_ID) {
+        m_nodeList[rightNode.nextPhysicalId].prevPhysicalId = rightNodeId;
+    }
+    leftNode.size = leftSize;
+    leftNode.nextPhysicalId = rightNodeId;
+    return rightNodeId;
+}
+
+void VULKAN_MEMORY_BLOCK::MergeWithNext(uint32_t nodeId)
+{
+    NODE& node = m_nodeList[nodeId];
+    const uint32_t nextNodeId = node.nextPhysicalId;
+    const NODE& nextNode = m_nodeList[nextNodeId];
+
+    node.size += nextNode.size;
+    node.nextPhysicalId = nextNode.nextPhysicalId;
+    if (node.nextPhysicalId != INVALID_NODE_ID) {
+        m_nodeList[node.nextPhysicalId].prevPhysicalId = nodeId;
+    }
+    ReleaseNode(nextNodeId);
+}
+
+uint32_t VULKAN_MEMORY_BLOCK::CreateNode()
+{
+    uint32_t nodeId;
+    if (!m_unusedNodeIdList.empty()) {
+        nodeId = m_unusedNodeIdList.back();
+        m_unusedNodeIdList.pop_back();
+    } else {
+        nodeId = static_cast<uint32_t>(m_nodeList.size());
+        m_nodeList.emplace_back();
+    }
+    NODE& node = m_nodeList[nodeId];
+    node.offset = 0;
+    node.size = 0;
+    node.prevPhysicalId = INVALID_NODE_ID;
+    node.nextPhysicalId = INVALID_NODE_ID;
+    node.prevFreeId = INVALID_NODE_ID;
+    node.nextFreeId = INVALID_NODE_ID;
+    node.isFree = false;
+    return nodeId;
+}
+
+void VULKAN_MEMORY_BLOCK::ReleaseNode(uint32_t nodeId)
+{
+    m_nodeList[nodeId].size = 0;
+    m_nodeList[nodeId].isFree = false;
+    m_unusedNodeIdList.push_back(nodeId);
+}
+
+
+VULKAN_MEMORY_ALLOCATOR::VULKAN_MEMORY_ALLOCATOR() : m_device(VK_NULL_HANDLE), m_nonCoherentAtomSize(1)
+{
+    m_blockSize.fill(DEFAULT_BLOCK_SIZE);
+}
+
+VkResult VULKAN_MEMORY_ALLOCATOR::Init(VkPhysicalDevice physicalDevice, VkDevice device)
+{
+    m_device = device;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+    m_nonCoherentAtomSize = std::max<VkDeviceSize>(deviceProperties.limits.nonCoherentAtomSize, 1);
+
+    //small heaps (e.g. 256Mb of host visible device memory) must not be eaten by one block
+    for (uint32_t typeId = 0; typeId < m_memoryProperties.memoryTypeCount; typeId++) {
+        const VkDeviceSize heapSize = m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[typeId].heapIndex].size;
+        m_blockSize[typeId] = std::min(DEFAULT_BLOCK_SIZE, AlignUp(heapSize / 8, m_nonCoherentAtomSize));
+    }
+    return VK_SUCCESS;
+}
+
+void VULKAN_MEMORY_ALLOCATOR::Term()
+{
+    std::lock_guard<std::mutex> allocatorLock(m_lock);
+    for (auto& pool : m_poolList) {
+        for (auto& pBlock : pool) {
+            if (!pBlock->IsEmpty()) {
+                WARNING_MSG("Memory block is destroyed with alive allocations\n");
+            }
+            DestroyBlock(*pBlock);
+        }
+        pool.clear();
+    }
+}
+
+VkResult VULKAN_MEMORY_ALLOCATOR::Allocate(const VkMemoryRequirements& memReq, uint32_t memoryTypeId, bool isLinearResource, VULKAN_MEMORY_ALLOCATION& allocation)
+{
+    ASSERT(memoryTypeId < m_memoryProperties.memoryTypeCount);
+    const uint32_t poolId = GetPoolId(memoryTypeId, isLinearResource);
+    std::lock_guard<std::mutex> allocatorLock(m_lock);
+
+    //big resources get own block, otherwise they leave too much unusable space in shared ones
+    const VkDeviceSize blockSize = m_blockSize[memoryTypeId];
+    const bool isDedicated = memReq.size > blockSize / 2;
+    if (!isDedicated) {
+        for (auto& pBlock : m_poolList[poolId]) {
+            if (AllocateFromBlock(*pBlock, memReq, allocation)) {
+                return VK_SUCCESS;
+            }
+        }
+    }
+
+    VULKAN_MEMORY_BLOCK* pBlock = nullptr;
+    VkResult result = CreateBlock(poolId, isDedicated ? AlignUp(memReq.size, m_nonCoherentAtomSize) : blockSize, pBlock);
+    if (result != VK_SUCCESS && !isDedicated) {
+        //not enough memory for full block, try to fit at least this resource
+        result = CreateBlock(poolId, AlignUp(memReq.size, m_nonCoherentAtomSize), pBlock);
+    }
+    if (result != VK_SUCCESS) {
+        ERROR_MSG("Failed to allocate device memory block!");
+        return result;
+    }
+    if (!AllocateFromBlock(*pBlock, memReq, allocation)) {
+        WARNING_MSG("Resource doesn't fit new memory block!\n");
+        auto& pool = m_poolList[poolId];
+        auto blockIter = std::find_if(pool.begin(), pool.end(), [pBlock](const std::unique_ptr<VULKAN_MEMORY_BLOCK>& pPoolBlock) {
+            return pPoolBlock.get() == pBlock;
+        });
+        DestroyBlock(*pBlock);
+        pool.erase(blockIter);
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    return VK_SUCCESS;
+}
+
+void VULKAN_MEMORY_ALLOCATOR::Free(VULKAN_MEMORY_ALLOCATION& allocation)
+{
+    if (!allocation.pBlock) {
+        return;
+    }
+    std::lock_guard<std::mutex> allocatorLock(m_lock);
+
+    VULKAN_MEMORY_BLOCK& block = *allocation.pBlock;
+    block.Free(allocation.nodeId);
+    allocation = VULKAN_MEMORY_ALLOCATION();
+    if (!block.IsEmpty()) {
+        return;
+    }
+
+    //keep first block of pool alive to avoid vkAllocateMemory/vkFreeMemory ping-pong
+    auto& pool = m_poolList[block.GetPoolId()];
+    if (pool.size() > 1 || block.GetSize() > m_blockSize[GetMemoryTypeId(block.GetPoolId())]) {
+        auto blockIter = std::find_if(pool.begin(), pool.end(), [&block](const std::unique_ptr<VULKAN_MEMORY_BLOCK>& pBlock) {
+            return pBlock.get() == &block;
+        });
+        ASSERT(blockIter != pool.end());
+        DestroyBlock(block);
+        pool.erase(blockIter);
+    }
+}
+
+VkResult VULKAN_MEMORY_ALLOCATOR::Flush(const VULKAN_MEMORY_ALLOCATION& allocation, VkDeviceSize offset, VkDeviceSize size)
+{
+    ASSERT(allocation.pMappedData);
+    const uint32_t memoryTypeId = GetMemoryTypeId(allocation.pBlock->GetPoolId());
+    if (IsEachMaskState(m_memoryProperties.memoryTypes[memoryTypeId].propertyFlags, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        return VK_SUCCESS;
+    }
+
+    //host visible allocations are aligned to nonCoherentAtomSize, so the range doesn't leave the allocation
+    const VkDeviceSize rangeBegin = AlignDown(allocation.offset + offset, m_nonCoherentAtomSize);
+    const VkDeviceSize rangeEnd = std::min(AlignUp(allocation.offset + offset + size, m_nonCoherentAtomSize), allocation.offset + allocation.size);
+
+    VkMappedMemoryRange memoryRange{};
+    memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    memoryRange.memory = allocation.memory;
+    memoryRange.offset = rangeBegin;
+    memoryRange.size = rangeEnd - rangeBegin;
+    return vkFlushMappedMemoryRanges(m_device, 1, &memoryRange);
+}
+
+VkResult VULKAN_MEMORY_ALLOCATOR::CreateBlock(uint32_t poolId, VkDeviceSize blockSize, VULKAN_MEMORY_BLOCK*& pBlock)
+{
+    const uint32_t memoryTypeId = GetMemoryTypeId(poolId);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = blockSize;
+    allocInfo.memoryTypeIndex = memoryTypeId;
+
+    VkDeviceMemory memory;
+    VkResult result = vkAllocateMemory(m_device, &allocInfo, nullptr, &memory);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    //host visible blocks stay mapped for the whole life, memory can't be mapped twice
+    void* pMappedData = nullptr;
+    if (IsEachMaskState(m_memoryProperties.memoryTypes[memoryTypeId].propertyFlags, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+        result = vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &pMappedData);
+        if (result != VK_SUCCESS) {
+            vkFreeMemory(m_device, memory, nullptr);
+            return result;
+        }
+    }
+
+    m_poolList[poolId].emplace_back(new VULKAN_MEMORY_BLOCK(memory, blockSize, poolId, static_cast<uint8_t*>(pMappedData)));
+    pBlock = m_poolList[poolId].back().get();
+    DEBUG_MSG(formatString("Device memory block allocated: type %u, size %llu\n", memoryTypeId, blockSize).c_str());
+    return VK_SUCCESS;
+}
+
+void VULKAN_MEMORY_ALLOCATOR::DestroyBlock(VULKAN_MEMORY_BLOCK& block)
+{
+    if (block.GetMappedData()) {
+        vkUnmapMemory(m_device, block.GetMemory());
+    }
+    vkFreeMemory(m_device, block.GetMemory(), nullptr);
+}
+
+bool VULKAN_MEMORY_ALLOCATOR::AllocateFromBlock(VULKAN_MEMORY_BLOCK& block, const VkMemoryRequirements& memReq, VULKAN_MEMORY_ALLOCATION& allocation)
+{
+    const VkDeviceSize alignment = GetAlignment(block.GetPoolId(), memReq.alignment);
+    const VkDeviceSize size = AlignUp(memReq.size, block.GetMappedData() ? m_nonCoherentAtomSize : 1);
+
+    VkDeviceSize offset;
+    uint32_t nodeId;
+    if (!block.Allocate(size, alignment, offset, nodeId)) {
+        return false;
+    }
+    allocation.memory = block.GetMemory();
+    allocation.offset = offset;
+    allocation.size = block.GetAllocationSize(nodeId);
+    allocation.pMappedData = block.GetMappedData() ? block.GetMappedData() + offset : nullptr;
+    allocation.pBlock = &block;
+    allocation.nodeId = nodeId;
+    return true;
+}
+
+VkDeviceSize VULKAN_MEMORY_ALLOCATOR::GetAlignment(uint32_t poolId, VkDeviceSize alignment) const
+{
+    //non coherent memory is flushed by atoms, neighbour allocations must not share them
+    const uint32_t memoryTypeId = GetMemoryTypeId(poolId);
+    const VkMemoryPropertyFlags flags = m_memoryProperties.memoryTypes[memoryTypeId].propertyFlags;
+    if (IsEachMaskState(flags, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+        return std::max(std::max<VkDeviceSize>(alignment, 1), m_nonCoherentAtomSize);
+    }
+    return std::max<VkDeviceSize>(alignment, 1);
+}
@@ -0,0 +1,335 @@
+#include "vulkanStagingRing.h"
+#include "vulkanDriver.h"
+#include "support.h"
+
+//image copies need offsets aligned to texel block size
+static const VkDeviceSize STAGING_ALIGNMENT = 16;
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VULKAN_STAGING_RING::VULKAN_STAGING_RING()
+    : m_device(VK_NULL_HANDLE), m_transferQueue(VK_NULL_HANDLE), m_graphicsQueue(VK_NULL_HANDLE), m_commandPool(VK_NULL_HANDLE),
+      m_isDedicatedTransferQueue(false), m_pGraphicsQueueLock(nullptr), m_ringHead(0), m_ringTail(0),
+      m_recordingBatchId(BATCHES_NUM - 1), m_isRecording(false), m_nextTicket(1), m_completedTicket(0)
+{
+}
+
+VkResult VULKAN_STAGING_RING::Init(VkDevice device, const VULKAN_BUFFER& ringBuffer, uint32_t transferFamilyIndex, VkQueue transferQueue,
+    VkQueue graphicsQueue, std::mutex& graphicsQueueLock)
+{
+    ASSERT(ringBuffer.bufferMemory.pMappedData);
+    m_device = device;
+    m_ringBuffer = ringBuffer;
+    m_transferQueue = transferQueue;
+    m_graphicsQueue = graphicsQueue;
+    m_isDedicatedTransferQueue = transferQueue != graphicsQueue;
+    m_pGraphicsQueueLock = &graphicsQueueLock;
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = transferFamilyIndex;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    VkResult result = vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    for (BATCH& batch : m_batchList) {
+        result = vkAllocateCommandBuffers(m_device, &allocInfo, &batch.commandBuffer);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        result = vkCreateFence(m_device, &fenceInfo, nullptr, &batch.fence);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        if (m_isDedicatedTransferQueue) {
+            result = vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &batch.semaphore);
+            if (result != VK_SUCCESS) {
+                return result;
+            }
+        }
+    }
+    return VK_SUCCESS;
+}
+
+void VULKAN_STAGING_RING::Term()
+{
+    {
+        std::lock_guard<std::mutex> ringLock(m_lock);
+        SubmitRecordingBatch();
+        while (!m_inFlightBatchList.empty()) {
+            RetireOldestBatch(true);
+        }
+    }
+    for (BATCH& batch : m_batchList) {
+        vkDestroyFence(m_device, batch.fence, nullptr);
+        if (batch.semaphore != VK_NULL_HANDLE) {
+            vkDestroySemaphore(m_device, batch.semaphore, nullptr);
+        }
+    }
+    vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+}
+
+UPLOAD_TICKET VULKAN_STAGING_RING::UploadBuffer(const uint8_t* pData, VkDeviceSize dataSize, const VULKAN_BUFFER& dstBuffer, VkDeviceSize dstOffset)
+{
+    std::lock_guard<std::mutex> ringLock(m_lock);
+
+    VkDeviceSize stagingOffset;
+    VULKAN_BUFFER& stagingBuffer = Reserve(dataSize, stagingOffset);
+    pDrvInterface->FillBuffer(pData, dataSize, stagingOffset, stagingBuffer);
+
+    BATCH& batch = GetRecordingBatch();
+    VkBufferCopy copyRegion = {};
+    copyRegion.srcOffset = stagingOffset;
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size = dataSize;
+    vkCmdCopyBuffer(batch.commandBuffer, stagingBuffer.buffer, dstBuffer.buffer, 1, &copyRegion);
+    return batch.ticket;
+}
+
+UPLOAD_TICKET VULKAN_STAGING_RING::UploadTexture(const VULKAN_TEXTURE_CREATE_DATA& createData, const VULKAN_TEXTURE& dstTexture)
+{
+    std::lock_guard<std::mutex> ringLock(m_lock);
+
+    VkDeviceSize stagingOffset;
+    VULKAN_BUFFER& stagingBuffer = Reserve(createData.dataSize, stagingOffset);
+    pDrvInterface->FillBuffer(createData.pData, createData.dataSize, stagingOffset, stagingBuffer);
+
+    BATCH& batch = GetRecordingBatch();
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = dstTexture.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = createData.mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    std::vector<VkBufferImageCopy> regionList(createData.mipLevels);
+    for (uint32_t mipLevelId = 0; mipLevelId < createData.mipLevels; mipLevelId++) {
+        VkBufferImageCopy& region = regionList[mipLevelId];
+        region = {};
+        region.bufferOffset = stagingOffset + (mipLevelId == 0 ? 0 : createData.mipLevelsOffsets[mipLevelId]);
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = mipLevelId;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { std::max(dstTexture.width >> mipLevelId, 1u), std::max(dstTexture.height >> mipLevelId, 1u), 1 };
+    }
+    vkCmdCopyBufferToImage(batch.commandBuffer, stagingBuffer.buffer, dstTexture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(regionList.size()), regionList.data());
+
+    //transfer queue can't wait for shader stages, semaphore of the batch covers them
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = m_isDedicatedTransferQueue ? 0 : VK_ACCESS_SHADER_READ_BIT;
+    const VkPipelineStageFlags dstStage = m_isDedicatedTransferQueue ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    return batch.ticket;
+}
+
+UPLOAD_TICKET VULKAN_STAGING_RING::Submit()
+{
+    std::lock_guard<std::mutex> ringLock(m_lock);
+    return SubmitRecordingBatch();
+}
+
+bool VULKAN_STAGING_RING::IsComplete(UPLOAD_TICKET ticket)
+{
+    std::lock_guard<std::mutex> ringLock(m_lock);
+    RetireCompletedBatches();
+    return ticket <= m_completedTicket;
+}
+
+void VULKAN_STAGING_RING::Wait(UPLOAD_TICKET ticket)
+{
+    std::lock_guard<std::mutex> ringLock(m_lock);
+    if (ticket <= m_completedTicket) {
+        return;
+    }
+    if (m_isRecording && ticket >= m_batchList[m_recordingBatchId].ticket) {
+        SubmitRecordingBatch();
+    }
+    while (ticket > m_completedTicket && !m_inFlightBatchList.empty()) {
+        RetireOldestBatch(true);
+    }
+}
+
+VULKAN_STAGING_RING::BATCH& VULKAN_STAGING_RING::GetRecordingBatch()
+{
+    if (m_isRecording) {
+        return m_batchList[m_recordingBatchId];
+    }
+
+    //batches are reused in round robin, so the next one is the oldest in flight
+    const uint32_t batchId = (m_recordingBatchId + 1) % BATCHES_NUM;
+    if (!m_inFlightBatchList.empty() && m_inFlightBatchList.front() == batchId) {
+        RetireOldestBatch(true);
+    }
+    BATCH& batch = m_batchList[batchId];
+    batch.ticket = m_nextTicket++;
+    batch.ringEnd = m_ringHead;
+
+    vkResetCommandBuffer(batch.commandBuffer, 0);
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+
+    m_recordingBatchId = batchId;
+    m_isRecording = true;
+    return batch;
+}
+
+VULKAN_BUFFER& VULKAN_STAGING_RING::Reserve(VkDeviceSize size, VkDeviceSize& stagingOffset)
+{
+    if (size > m_ringBuffer.bufferSize / 2) {
+        //big uploads would stall the ring for a long time
+        VkBufferCreateInfo stagingBufferInfo = {};
+        stagingBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        stagingBufferInfo.size = size;
+        stagingBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        stagingBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        BATCH& batch = GetRecordingBatch();
+        batch.tempBufferList.emplace_back();
+        VkResult result = pDrvInterface->CreateBuffer(stagingBufferInfo, true, batch.tempBufferList.back());
+        ASSERT_MSG(result == VK_SUCCESS, "Can't create temporary staging buffer");
+        stagingOffset = 0;
+        return batch.tempBufferList.back();
+    }
+
+    while (!TryReserveRing(size, stagingOffset)) {
+        //ring is full: push recorded copies to gpu and wait for the oldest region to be released
+        SubmitRecordingBatch();
+        ASSERT(!m_inFlightBatchList.empty());
+        RetireOldestBatch(true);
+    }
+    GetRecordingBatch();
+    return m_ringBuffer;
+}
+
+bool VULKAN_STAGING_RING::TryReserveRing(VkDeviceSize size, VkDeviceSize& offset)
+{
+    const VkDeviceSize capacity = m_ringBuffer.bufferSize;
+    if (m_inFlightBatchList.empty() && (!m_isRecording || m_batchList[m_recordingBatchId].ringEnd == m_ringHead)) {
+        //nothing is in use, start from the beginning to avoid wrap
+        m_ringHead = 0;
+        m_ringTail = 0;
+        if (m_isRecording) {
+            m_batchList[m_recordingBatchId].ringEnd = 0;
+        }
+    }
+
+    //head == tail means empty ring, so head never reaches tail from behind
+    offset = AlignUp(m_ringHead, STAGING_ALIGNMENT);
+    if (m_ringHead >= m_ringTail) {
+        if (offset + size > capacity) {
+            offset = 0;
+            if (size >= m_ringTail) {
+                return false;
+            }
+        }
+    } else if (offset + size >= m_ringTail) {
+        return false;
+    }
+    m_ringHead = offset + size;
+    return true;
+}
+
+UPLOAD_TICKET VULKAN_STAGING_RING::SubmitRecordingBatch()
+{
+    if (!m_isRecording) {
+        return m_nextTicket - 1;
+    }
+    BATCH& batch = m_batchList[m_recordingBatchId];
+    if (!m_isDedicatedTransferQueue) {
+        //same queue: make copies visible for everything submitted later
+        VkMemoryBarrier memoryBarrier = {};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+    vkEndCommandBuffer(batch.commandBuffer);
+    batch.ringEnd = m_ringHead;
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+    std::lock_guard<std::mutex> queueLock(*m_pGraphicsQueueLock);
+    if (m_isDedicatedTransferQueue) {
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &batch.semaphore;
+        vkQueueSubmit(m_transferQueue, 1, &submitInfo, VK_NULL_HANDLE);
+
+        //empty submit consumes the semaphore, all later graphics work sees uploaded data
+        const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo waitInfo = {};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        waitInfo.waitSemaphoreCount = 1;
+        waitInfo.pWaitSemaphores = &batch.semaphore;
+        waitInfo.pWaitDstStageMask = &waitStage;
+        vkQueueSubmit(m_graphicsQueue, 1, &waitInfo, batch.fence);
+    } else {
+        vkQueueSubmit(m_transferQueue, 1, &submitInfo, batch.fence);
+    }
+
+    m_inFlightBatchList.push_back(m_recordingBatchId);
+    m_isRecording = false;
+    return batch.ticket;
+}
+
+void VULKAN_STAGING_RING::RetireOldestBatch(bool waitFence)
+{
+    BATCH& batch = m_batchList[m_inFlightBatchList.front()];
+    if (waitFence) {
+        vkWaitForFences(m_device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+    }
+    vkResetFences(m_device, 1, &batch.fence);
+    for (VULKAN_BUFFER& tempBuffer : batch.tempBufferList) {
+        pDrvInterface->DestroyBuffer(tempBuffer);
+    }
+    batch.tempBufferList.clear();
+
+    //batches are retired in submit order, everything before ringEnd is free now
+    m_ringTail = batch.ringEnd;
+    m_completedTicket = batch.ticket;
+    m_inFlightBatchList.pop_front();
+}
+
+void VULKAN_STAGING_RING::RetireCompletedBatches()
+{
+    while (!m_inFlightBatchList.empty() && vkGetFenceStatus(m_device, m_batchList[m_inFlightBatchList.front()].fence) == VK_SUCCESS) {
+        RetireOldestBatch(false);
+    }
+}
@@ -1,13 +1,6 @@
 #pragma once
 #define M_PI 3.14159265358979f
 
-struct POINT_LIGHT {
-    float3 pos;
-    float  areaLight;
-    float3 color;
-    float  intensity;
-};
-
 struct DIRECTIONAL_LIGHT{
     float3 pos;
     float  attenuationParam;
@@ -25,15 +18,19 @@ cbuffer COMMON_BUFFER : register(b0)
     float4x4 proj;
     float4x4 projInv;
     float4x4 view;
+    float4x4 viewInv;
 };
 
+//must match EFFECT_DATA::SHADOW_CASCADES_NUM and SHADOW_ATLAS_COLUMNS
+#define SHADOW_CASCADES_NUM  4
+#define SHADOW_ATLAS_COLUMNS 2
+
 [[vk::binding(1)]]
 cbuffer LIGHT_BUFFER : register (b1) {
     DIRECTIONAL_LIGHT dirLight;
-    POINT_LIGHT pointLight0;
-    float4x4 dirLightViewProj;
-    float4x4 pointLightViewProj;
+    float4x4 dirLightCascadeViewProj[SHADOW_CASCADES_NUM];
     float3   ambientColor;
+    float4   dirLightCascadeSplits;
 };
 
 [[vk::binding(2)]]
@@ -11,4 +11,41 @@ float3 GetPositionFromDepth(float2 texCoord, float z)
     float4 positionVS = mul(projInv, projectedPos);
     // Divide by w to get the view-space position
     return positionVS.xyz / positionVS.w;
+}
+
+//viewDepth is view space z
+float3 GetPositionFromViewDepth(float2 texCoord, float viewDepth)
+{
+    float3 viewRay = GetPositionFromDepth(texCoord, 1.f);
+    return viewRay * (viewDepth / viewRay.z);
+}
+
+float3 GetWorldPositionFromDepth(float2 texCoord, float z)
+{
+    return mul(viewInv, float4(GetPositionFromDepth(texCoord, z), 1.f)).xyz;
+}
+
+//octahedral normal encoding, see "A Survey of Efficient Representations for Independent Unit Vectors"
+float2 OctahedralWrap(float2 v)
+{
+    float2 signs = float2(v.x >= 0.f ? 1.f : -1.f, v.y >= 0.f ? 1.f : -1.f);
+    return (1.f - abs(v.yx)) * signs;
+}
+
+//result is in [0, 1] range to be stored in unorm target
+float2 EncodeOctahedralNormal(float3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    float2 encoded = n.z >= 0.f ? n.xy : OctahedralWrap(n.xy);
+    return encoded * 0.5f + 0.5f;
+}
+
+float3 DecodeOctahedralNormal(float2 encoded)
+{
+    encoded = encoded * 2.f - 1.f;
+    float3 n = float3(encoded, 1.f - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-n.z);
+    n.x += n.x >= 0.f ? -t : t;
+    n.y += n.y >= 0.f ? -t : t;
+    return normalize(n);
 }
\ No newline at end of file
@@ -2,11 +2,26 @@
 #include "common.fx"
 
 float ShadowFactorPCF(Texture2D texShadowMap, float4 worldPos) {
-    float4 dirLightSmPos = mul(projToScreenMat, mul(dirLightViewProj, worldPos));
-    float2 dirLightSmUV = dirLightSmPos.xy / dirLightSmPos.w;
-    if (any(dirLightSmUV < 0.f) || any(dirLightSmUV > 1.f)) {
+    //cascades are fit to slices of camera frustum, so the first one containing the pixel has the best resolution
+    float viewDepth = mul(view, worldPos).z;
+    if (viewDepth > dirLightCascadeSplits[SHADOW_CASCADES_NUM - 1]) {
         return 1.f;
     }
+    uint cascadeId = 0;
+    [unroll]
+    for (uint splitId = 0; splitId < SHADOW_CASCADES_NUM - 1; splitId++) {
+        cascadeId += viewDepth > dirLightCascadeSplits[splitId] ? 1 : 0;
+    }
+
+    float2 atlasSize;
+    texShadowMap.GetDimensions(atlasSize.x, atlasSize.y);
+    float d = 1.f / atlasSize.x;
+
+    float4 dirLightSmPos = mul(projToScreenMat, mul(dirLightCascadeViewProj[cascadeId], worldPos));
+    float2 dirLightSmUV = dirLightSmPos.xy / dirLightSmPos.w;
+    //pcf kernel mustn't take texels of neighbour cascade in the atlas
+    float2 cascadeMinUV = float2(cascadeId % SHADOW_ATLAS_COLUMNS, cascadeId / SHADOW_ATLAS_COLUMNS) / SHADOW_ATLAS_COLUMNS;
+    dirLightSmUV = clamp(dirLightSmUV, cascadeMinUV + 2.f * d, cascadeMinUV + 1.f / SHADOW_ATLAS_COLUMNS - 2.f * d);
     float  dirLightDepth = dirLightSmPos.z / dirLightSmPos.w;
 /*
     float center = 0.6f;
@@ -22,7 +37,6 @@ float ShadowFactorPCF(Texture2D texShadowMap, float4 worldPos) {
 
     float shadowParam = 0.f;
     float count = 0.f;
-    float d = 1.f / 2024.f;
     if (debugDrawMode == 1) {
         float2 offset = (frac(dirLightSmPos.xy * 0.5) > 0.25);  // mod 
         offset.y += offset.x;  
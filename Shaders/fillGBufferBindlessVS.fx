@@ -0,0 +1,2 @@
+#define BINDLESS_TEXTURES
+#include "fillGBufferVS.fx"
@@ -1,10 +1,30 @@
 #include "common.fx"
 
+#ifdef INDIRECT_DRAW
+//per draw data is taken from instance buffer, draw command sets first instance to the instance id
+#include "gpuDrivenCommon.fx"
+#define MODEL_MATRIX instanceBuffer[vertexIn.instanceId].modelMatrix
+#define MATERIAL_ID  vertexOut.materialId
+#else
+[[vk::push_constant]]
+struct PUSH_CONSTANT {
+    float4x4 modelMatrix;
+#ifdef BINDLESS_TEXTURES
+    uint     materialId;
+#endif
+} pushConstant;
+#define MODEL_MATRIX pushConstant.modelMatrix
+#define MATERIAL_ID  pushConstant.materialId
+#endif
+
 struct VERTEX_INPUT
 {
 	float3 position : POSITION;
 	float2 texCoord : TEXCOORD0;
 	float3 normal   : NORMAL;
+#ifdef INDIRECT_DRAW
+	uint instanceId : SV_InstanceID;
+#endif
 };
 
 struct VERTEX_OUTPUT
@@ -12,12 +32,15 @@ struct VERTEX_OUTPUT
 	float3 worldPos : POSITION;
 	float3 worldNormal : NORMAL;
 	float2 texCoord : TEXCOORD0;
+#ifdef INDIRECT_DRAW
+	nointerpolation uint materialId : MATERIAL_ID;
+#endif
 };
 
 struct GBUFFER_OUTPUT
 {
-	float4 albedo   : SV_TARGET0;
-	float4 normal   : SV_TARGET1;
-	float4 metalnessRoughness : SV_TARGET2;
-	float4 worldPos : SV_TARGET3;
+	//a is metalness
+	float4 albedoMetalness : SV_TARGET0;
+	//rg is octahedral encoded normal, b is roughness
+	float4 normalRoughness : SV_TARGET1;
 };
@@ -0,0 +1,3 @@
+#define BINDLESS_TEXTURES
+#define INDIRECT_DRAW
+#include "fillGBufferVS.fx"
@@ -1,8 +1,18 @@
 #include "fillGBufferCommon.fx"
-
+#include "commonFunctions.fx"
+
+#ifdef BINDLESS_TEXTURES
+//must match EFFECT_DATA::BINDLESS_MATERIAL_TEXTURES
+#define BINDLESS_MATERIAL_TEXTURES_NUM 3
+[[vk::binding(0, 1)]] Texture2D bindlessTextures[];
+#define texAlbedo         bindlessTextures[MATERIAL_ID * BINDLESS_MATERIAL_TEXTURES_NUM + 0]
+#define texNormal         bindlessTextures[MATERIAL_ID * BINDLESS_MATERIAL_TEXTURES_NUM + 1]
+#define texMetalRoughness bindlessTextures[MATERIAL_ID * BINDLESS_MATERIAL_TEXTURES_NUM + 2]
+#else
 [[vk::binding(20)]] Texture2D texAlbedo;
 [[vk::binding(21)]] Texture2D texNormal;
 [[vk::binding(22)]] Texture2D texMetalRoughness;
+#endif
 
 //http://www.thetenthplanet.de/archives/1180
 float3x3 CalculateTBN(float3 pos, float3 N, float2 uv, inout float3 T, inout float3 B) {
@@ -30,22 +40,21 @@ float3 TransposeNormal(float3 localNormal, float3x3 TBN) {
 
 void main(in VERTEX_OUTPUT vertexOut, out GBUFFER_OUTPUT pixelOut) {
     float4 albedo = texAlbedo.Sample(anisoSampler, vertexOut.texCoord);
-    float3 normal = texNormal.Sample(anisoSampler, vertexOut.texCoord).rgb;
+    //normal maps are bc5, z is restored from xy
+    float2 normalXY = texNormal.Sample(anisoSampler, vertexOut.texCoord).rg * 2.f - 1.f;
     //float displacement = texDisplacement.Sample(anisoSampler, vertexOut.texCoord).r;
     float roughness = texMetalRoughness.Sample(anisoSampler, vertexOut.texCoord).g;
     float metalness = texMetalRoughness.Sample(anisoSampler, vertexOut.texCoord).b;
 
     clip(albedo.a - 0.5f);
 
-    float3 normalDecompressed = normalize(normal * 2.f - 1.f);
+    float3 normalDecompressed = float3(normalXY, sqrt(saturate(1.f - dot(normalXY, normalXY))));
     float3 worldNormal = normalize(vertexOut.worldNormal);
 
     float3 T, B;
     float3x3 TBN = CalculateTBN(vertexOut.worldPos, worldNormal, vertexOut.texCoord, T, B);
     float3 N = TransposeNormal(normalDecompressed, TBN);
 
-    pixelOut.albedo = albedo;
-    pixelOut.normal = float4(N, 0.f);
-    pixelOut.metalnessRoughness = float4(metalness, roughness, 0.f, 0.f);
-    pixelOut.worldPos = float4(vertexOut.worldPos, 1.f);
+    pixelOut.albedoMetalness = float4(albedo.rgb, metalness);
+    pixelOut.normalRoughness = float4(EncodeOctahedralNormal(N), roughness, 0.f);
 }
\ No newline at end of file
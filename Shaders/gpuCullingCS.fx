@@ -0,0 +1,146 @@
+#include "gpuDrivenCommon.fx"
+
+struct DRAW_INDEXED_INDIRECT_COMMAND
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int  vertexOffset;
+    uint firstInstance;
+};
+
+[[vk::binding(41)]] RWStructuredBuffer<DRAW_INDEXED_INDIRECT_COMMAND> drawCommandBuffer;
+[[vk::binding(42)]] RWStructuredBuffer<uint> drawCountBuffer;
+[[vk::binding(43)]] RWStructuredBuffer<uint> occludedBuffer;
+
+//must match GPU_CULLING_SYSTEM::CULLING_FLAGS
+#define CULLING_FLAG_OCCLUSION      1
+#define CULLING_FLAG_WRITE_OCCLUDED 2
+#define CULLING_FLAG_ONLY_OCCLUDED  4
+
+[[vk::binding(7)]]
+cbuffer CULLING_BUFFER {
+    float4   frustumPlanes[6];
+    float4x4 hiZViewProj;
+    float2   hiZSize;
+    uint     instancesNum;
+    uint     cullingFlags;
+};
+
+//must match HI_Z_LEVELS_NUM
+#define HI_Z_LEVELS_NUM 8
+[[vk::binding(50)]] Texture2D hiZLevel0;
+[[vk::binding(51)]] Texture2D hiZLevel1;
+[[vk::binding(52)]] Texture2D hiZLevel2;
+[[vk::binding(53)]] Texture2D hiZLevel3;
+[[vk::binding(54)]] Texture2D hiZLevel4;
+[[vk::binding(55)]] Texture2D hiZLevel5;
+[[vk::binding(56)]] Texture2D hiZLevel6;
+[[vk::binding(57)]] Texture2D hiZLevel7;
+
+bool IsInsideFrustum(float3 center, float3 extent) {
+    for (int i = 0; i < 6; i++) {
+        float4 plane = frustumPlanes[i];
+        float distance = dot(plane.xyz, center) + plane.w;
+        float radius = dot(abs(plane.xyz), extent);
+        if (distance + radius < 0.f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+float LoadHiZ(uint level, int2 coord) {
+    switch (level) {
+    case 0: return hiZLevel0.Load(int3(coord, 0)).r;
+    case 1: return hiZLevel1.Load(int3(coord, 0)).r;
+    case 2: return hiZLevel2.Load(int3(coord, 0)).r;
+    case 3: return hiZLevel3.Load(int3(coord, 0)).r;
+    case 4: return hiZLevel4.Load(int3(coord, 0)).r;
+    case 5: return hiZLevel5.Load(int3(coord, 0)).r;
+    case 6: return hiZLevel6.Load(int3(coord, 0)).r;
+    default: return hiZLevel7.Load(int3(coord, 0)).r;
+    }
+}
+
+//level N texel covers 2^(N+1) depth buffer pixels, level size is rounded up, so texel coord is pixel coord shifted by N+1
+bool IsOccluded(float3 center, float3 extent) {
+    float2 rectMin = 1.f;
+    float2 rectMax = 0.f;
+    float  minDepth = 1.f;
+    for (int i = 0; i < 8; i++) {
+        float3 corner = center + extent * float3((i & 1) ? 1.f : -1.f, (i & 2) ? 1.f : -1.f, (i & 4) ? 1.f : -1.f);
+        float4 clipPos = mul(hiZViewProj, float4(corner, 1.f));
+        //box crosses near plane
+        if (clipPos.w <= 0.f) {
+            return false;
+        }
+        float3 ndcPos = clipPos.xyz / clipPos.w;
+        float2 uv = ndcPos.xy * 0.5f + 0.5f;
+        rectMin = min(rectMin, uv);
+        rectMax = max(rectMax, uv);
+        minDepth = min(minDepth, ndcPos.z);
+    }
+    rectMin = saturate(rectMin);
+    rectMax = saturate(rectMax);
+
+    float2 pixelMin = rectMin * hiZSize;
+    float2 pixelMax = rectMax * hiZSize;
+    float2 pixelExtent = pixelMax - pixelMin;
+    //rect fits into 2x2 texels of chosen level
+    uint level = (uint)max(ceil(log2(max(max(pixelExtent.x, pixelExtent.y), 1.f))) - 1.f, 0.f);
+    if (level >= HI_Z_LEVELS_NUM) {
+        return false;
+    }
+
+    int2 maxPixel = int2(hiZSize) - 1;
+    int2 texelMin = min(int2(pixelMin), maxPixel) >> (level + 1);
+    int2 texelMax = min(int2(pixelMax), maxPixel) >> (level + 1);
+    float occluderDepth = max(
+        max(LoadHiZ(level, texelMin), LoadHiZ(level, int2(texelMax.x, texelMin.y))),
+        max(LoadHiZ(level, int2(texelMin.x, texelMax.y)), LoadHiZ(level, texelMax)));
+    return minDepth > occluderDepth;
+}
+
+[numthreads(64, 1, 1)]
+void main(uint3 threadId : SV_DispatchThreadID) {
+    const uint instanceId = threadId.x;
+    if (instanceId >= instancesNum) {
+        return;
+    }
+    if ((cullingFlags & CULLING_FLAG_ONLY_OCCLUDED) && occludedBuffer[instanceId] == 0) {
+        return;
+    }
+    INSTANCE_DATA instance = instanceBuffer[instanceId];
+
+    //world space bounds of transformed box
+    float3 localCenter = (instance.aabbMax + instance.aabbMin) * 0.5f;
+    float3 localExtent = (instance.aabbMax - instance.aabbMin) * 0.5f;
+    float3 center = mul(instance.modelMatrix, float4(localCenter, 1.f)).xyz;
+    float3x3 absModel = abs((float3x3)instance.modelMatrix);
+    float3 extent = mul(absModel, localExtent);
+
+    bool isVisible = IsInsideFrustum(center, extent);
+    bool isOccluded = false;
+    if (isVisible && (cullingFlags & CULLING_FLAG_OCCLUSION)) {
+        isOccluded = IsOccluded(center, extent);
+    }
+    if (cullingFlags & CULLING_FLAG_WRITE_OCCLUDED) {
+        occludedBuffer[instanceId] = isOccluded ? 1 : 0;
+    }
+    if (!isVisible || isOccluded) {
+        return;
+    }
+
+    uint drawId;
+    InterlockedAdd(drawCountBuffer[0], 1, drawId);
+
+    DRAW_INDEXED_INDIRECT_COMMAND command;
+    command.indexCount = instance.indexesNum;
+    command.instanceCount = 1;
+    command.firstIndex = instance.firstIndex;
+    command.vertexOffset = instance.vertexOffset;
+    //vertex shader takes instance data by SV_InstanceID
+    command.firstInstance = instanceId;
+    drawCommandBuffer[drawId] = command;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+//must match GPU_INSTANCE_DATA
+struct INSTANCE_DATA
+{
+    float4x4 modelMatrix;
+    float3   aabbMin;
+    uint     indexesNum;
+    float3   aabbMax;
+    uint     firstIndex;
+    uint     vertexOffset;
+    uint     materialId;
+    uint2    padding;
+};
+
+//must match GPU_CULLING_SYSTEM::INSTANCE_BUFFER_SLOT
+[[vk::binding(40)]] StructuredBuffer<INSTANCE_DATA> instanceBuffer;
@@ -0,0 +1,18 @@
+#include "common.fx"
+
+#define sourceSize cb0.xy
+
+[[vk::binding(50)]] Texture2D texHiZSource;
+
+//each texel keeps max depth of 2x2 source texels, coords of last texel are clamped for odd source size
+void main(in float4 pixelPos : SV_Position, out float pixelOut : SV_Target)
+{
+    int2 sourceCoord = int2(pixelPos.xy) * 2;
+    int2 maxCoord = int2(sourceSize) - 1;
+
+    float depth0 = texHiZSource.Load(int3(min(sourceCoord, maxCoord), 0)).r;
+    float depth1 = texHiZSource.Load(int3(min(sourceCoord + int2(1, 0), maxCoord), 0)).r;
+    float depth2 = texHiZSource.Load(int3(min(sourceCoord + int2(0, 1), maxCoord), 0)).r;
+    float depth3 = texHiZSource.Load(int3(min(sourceCoord + int2(1, 1), maxCoord), 0)).r;
+    pixelOut = max(max(depth0, depth1), max(depth2, depth3));
+}
@@ -0,0 +1,5 @@
+void main(uint vertexId : SV_VertexID, out float4 projPos : SV_Position)
+{
+    float2 texCoord = float2((vertexId << 1) & 2, vertexId & 2);
+    projPos = float4(texCoord * 2.0f - 1.0f, 0.0f, 1.0f);
+}
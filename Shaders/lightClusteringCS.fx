@@ -0,0 +1,58 @@
+#define WRITE_LIGHT_CLUSTERS
+#include "lightClustersCommon.fx"
+
+//must match LIGHT_CLUSTERING_SYSTEM::CLUSTERING_GROUP_SIZE
+#define CLUSTERING_GROUP_SIZE 64
+
+//view space direction through the screen point, its z is 1
+float3 GetViewRay(float2 texCoord) {
+    //screen y is flipped relative to projection space
+    float4 viewPos = mul(clustersProjInv, float4(texCoord.x * 2.f - 1.f, 1.f - texCoord.y * 2.f, 1.f, 1.f));
+    return viewPos.xyz / viewPos.z;
+}
+
+float GetSliceDepth(uint slice) {
+    return clustersNear * pow(clustersFar / clustersNear, float(slice) / clustersNum.z);
+}
+
+[numthreads(CLUSTERING_GROUP_SIZE, 1, 1)]
+void main(uint3 threadId : SV_DispatchThreadID) {
+    uint clusterId = threadId.x;
+    if (clusterId >= clustersNum.x * clustersNum.y * clustersNum.z) {
+        return;
+    }
+    uint3 cluster = uint3(clusterId % clustersNum.x, (clusterId / clustersNum.x) % clustersNum.y, clusterId / (clustersNum.x * clustersNum.y));
+
+    //view space bounds of the frustum piece
+    float2 tileMin = float2(cluster.xy) / clustersNum.xy;
+    float2 tileMax = float2(cluster.xy + 1) / clustersNum.xy;
+    float3 rays[4] = {
+        GetViewRay(tileMin),
+        GetViewRay(float2(tileMax.x, tileMin.y)),
+        GetViewRay(float2(tileMin.x, tileMax.y)),
+        GetViewRay(tileMax)
+    };
+    float sliceNear = GetSliceDepth(cluster.z);
+    float sliceFar = GetSliceDepth(cluster.z + 1);
+    float3 boundsMin = rays[0] * sliceNear;
+    float3 boundsMax = boundsMin;
+    [unroll]
+    for (uint rayId = 0; rayId < 4; rayId++) {
+        boundsMin = min(boundsMin, min(rays[rayId] * sliceNear, rays[rayId] * sliceFar));
+        boundsMax = max(boundsMax, max(rays[rayId] * sliceNear, rays[rayId] * sliceFar));
+    }
+
+    //spot lights are tested by their spheres too, cone only makes their radiance zero
+    uint listOffset = clusterId * MAX_CLUSTER_LIGHTS;
+    uint clusterLightsNum = 0;
+    for (uint lightId = 0; lightId < lightsNum && clusterLightsNum < MAX_CLUSTER_LIGHTS; lightId++) {
+        LIGHT_DATA light = lightBuffer[lightId];
+        float3 lightViewPos = mul(clustersView, float4(light.position, 1.f)).xyz;
+        float3 toBounds = clamp(lightViewPos, boundsMin, boundsMax) - lightViewPos;
+        if (dot(toBounds, toBounds) <= light.radius * light.radius) {
+            clusterLightListBuffer[listOffset + clusterLightsNum] = lightId;
+            clusterLightsNum++;
+        }
+    }
+    clusterLightsNumBuffer[clusterId] = clusterLightsNum;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+//must match GPU_LIGHT_DATA
+struct LIGHT_DATA
+{
+    float3 position;
+    float  radius;
+    float3 radiance;
+    float  spotScale;
+    float3 direction;
+    float  spotOffset;
+};
+
+//must match LIGHT_CLUSTERING_SYSTEM::MAX_CLUSTER_LIGHTS
+#define MAX_CLUSTER_LIGHTS 128
+
+[[vk::binding(8)]]
+cbuffer LIGHT_CLUSTERS_BUFFER {
+    float4x4 clustersView;
+    float4x4 clustersProjInv;
+    uint3    clustersNum;
+    uint     lightsNum;
+    float2   sliceScaleBias;
+    float    clustersNear;
+    float    clustersFar;
+};
+
+//must match LIGHT_CLUSTERING_SYSTEM slots
+[[vk::binding(44)]] StructuredBuffer<LIGHT_DATA> lightBuffer;
+#ifdef WRITE_LIGHT_CLUSTERS
+[[vk::binding(45)]] RWStructuredBuffer<uint> clusterLightsNumBuffer;
+[[vk::binding(46)]] RWStructuredBuffer<uint> clusterLightListBuffer;
+#else
+[[vk::binding(45)]] StructuredBuffer<uint> clusterLightsNumBuffer;
+[[vk::binding(46)]] StructuredBuffer<uint> clusterLightListBuffer;
+#endif
+
+uint GetClusterId(uint3 cluster) {
+    return (cluster.z * clustersNum.y + cluster.y) * clustersNum.x + cluster.x;
+}
+
+//depth slices are exponential, so clusters keep close to cubic shape along view depth
+uint3 GetPixelCluster(float2 texCoord, float viewDepth) {
+    float slice = log(max(viewDepth, clustersNear)) * sliceScaleBias.x + sliceScaleBias.y;
+    uint3 cluster = uint3(texCoord * clustersNum.xy, max(slice, 0.f));
+    return min(cluster, clustersNum - 1);
+}
@@ -1,11 +1,10 @@
 #include "shadeGBufferCommon.fx"
 #include "commonFunctions.fx"
 #include "commonLighting.fx"
+#include "lightClustersCommon.fx"
 
-[[vk::binding(20)]] Texture2D texGBufferAlbedo;
-[[vk::binding(21)]] Texture2D texGBufferNormal;
-[[vk::binding(22)]] Texture2D texGBufferMetalnessRoughness;
-[[vk::binding(23)]] Texture2D texGBufferWorldPos;
+[[vk::binding(20)]] Texture2D texGBufferAlbedoMetalness;
+[[vk::binding(21)]] Texture2D texGBufferNormalRoughness;
 [[vk::binding(24)]] Texture2D texShadowMap;
 [[vk::binding(25)]] Texture2D texDepth;
 [[vk::binding(26)]] Texture2D texSSAOMask;
@@ -57,12 +56,34 @@ float3 FresnelSchlick(float cosTheta, float3 F0)
     return F0 + (1.0f - F0) * pow(2.f, (-5.55473f * cosTheta - 6.98316f) * cosTheta);
 }
 
+//cook-torrance brdf multiplied by NdotL, L is normalized direction to light
+float3 EvaluateBRDF(float3 N, float3 V, float3 L, float3 albedo, float3 metalness, float roughness, float3 F0)
+{
+    float3 H = normalize(V + L);
+    float  NDF = DistributionGGX(N, H, roughness);
+    float  G = GeometrySmith(N, V, L, GeomDirectLightParam(roughness));
+    float3 F = FresnelSchlick(max(dot(H, V), 0.0f), F0);
+
+    float3 kS = F;
+    float3 kD = 1.0f - kS;
+    kD *= 1.0f - metalness;
+
+    float3 numerator = NDF * G * F;
+    float denominator = 4.0f * max(dot(N, V), 0.001f) * max(dot(N, L), 0.001f);
+    float3 specular = numerator / max(denominator, 0.001f);
+
+    float NdotL = max(dot(N, L), 0.0f);
+    return (kD * albedo / M_PI + kS * specular) * NdotL;
+}
+
 void main(in VERTEX_OUTPUT vertexOut, out PIXEL_OUTPUT pixelOut) {
-    float4 albedo = texGBufferAlbedo.Sample(pointSampler, vertexOut.texCoord);
-    float3 worldNormal = texGBufferNormal.Sample(pointSampler, vertexOut.texCoord).rgb;
-    float roughness = texGBufferMetalnessRoughness.Sample(pointSampler, vertexOut.texCoord).g;
-    float3 metalness = texGBufferMetalnessRoughness.Sample(pointSampler, vertexOut.texCoord).rrr;
-    float4 worldPos = texGBufferWorldPos.Sample(pointSampler, vertexOut.texCoord);
+    float4 albedo = texGBufferAlbedoMetalness.Sample(pointSampler, vertexOut.texCoord);
+    float4 normalRoughness = texGBufferNormalRoughness.Sample(pointSampler, vertexOut.texCoord);
+    float3 worldNormal = DecodeOctahedralNormal(normalRoughness.rg);
+    float roughness = normalRoughness.b;
+    float3 metalness = albedo.aaa;
+    float  depth = texDepth.Sample(pointSampler, vertexOut.texCoord).r;
+    float4 worldPos = float4(GetWorldPositionFromDepth(vertexOut.texCoord, depth), 1.f);
     float  ssaoOcclusion = texSSAOMask.Sample(pointSampler, vertexOut.texCoord);
 
     float3 N = normalize(worldNormal);
@@ -73,36 +94,29 @@ void main(in VERTEX_OUTPUT vertexOut, out PIXEL_OUTPUT pixelOut) {
 
     // reflectance equation
     float3 Lo = 0.0f;
-    
- 
+
     float shadowFactor = ShadowFactorPCF(texShadowMap, worldPos);
-    {
-        float3 dirToLight = -dirLight.direction;
-        float attenuation = shadowFactor;
-        float3 L = normalize(dirToLight);
-
-        // calculate per-light radiance
-        float3 H = normalize(V + L);
-        float3 radiance = dirLight.intensity * dirLight.color * attenuation;
-
-        // cook-torrance brdf
-        float  NDF = DistributionGGX(N, H, roughness);
-        float  G = GeometrySmith(N, V, L, GeomDirectLightParam(roughness));
-        float3 F = FresnelSchlick(max(dot(H, V), 0.0f), F0);
-
-        float3 kS = F;
-        float3 kD = 1.0f - kS;
-        kD *= 1.0f - metalness;
-
-        float3 numerator = NDF * G * F;
-        float denominator = 4.0f * max(dot(N, V), 0.001f) * max(dot(N, L), 0.001f);
-        float3 specular = numerator / max(denominator, 0.001f);
-
-        // add to outgoing radiance Lo
-        float NdotL = max(dot(N, L), 0.0f);
-        Lo += (kD * albedo.rgb / M_PI + kS * specular)* radiance* NdotL;
+    Lo += EvaluateBRDF(N, V, normalize(-dirLight.direction), albedo.rgb, metalness, roughness, F0) * dirLight.intensity * dirLight.color * shadowFactor;
+
+    //point and spot lights of the pixel cluster
+    float viewDepth = mul(view, worldPos).z;
+    uint clusterId = GetClusterId(GetPixelCluster(vertexOut.texCoord, viewDepth));
+    uint clusterLightsNum = clusterLightsNumBuffer[clusterId];
+    for (uint clusterLightId = 0; clusterLightId < clusterLightsNum; clusterLightId++) {
+        LIGHT_DATA light = lightBuffer[clusterLightListBuffer[clusterId * MAX_CLUSTER_LIGHTS + clusterLightId]];
+        float3 dirToLight = light.position - worldPos.xyz;
+        float distSqr = dot(dirToLight, dirToLight);
+        float3 L = dirToLight * rsqrt(max(distSqr, 1e-4f));
+
+        //inverse square falloff smoothly windowed to zero at the light radius
+        float distRatio = distSqr / (light.radius * light.radius);
+        float windowFactor = saturate(1.f - distRatio * distRatio);
+        float attenuation = windowFactor * windowFactor / max(distSqr, 1e-4f);
+        float spotFactor = saturate(dot(light.direction, -L) * light.spotScale + light.spotOffset);
+        attenuation *= spotFactor * spotFactor;
+
+        Lo += EvaluateBRDF(N, V, L, albedo.rgb, metalness, roughness, F0) * light.radiance * attenuation;
     }
-    
 
     Lo += albedo.rgb * ambientColor * ssaoOcclusion;
 
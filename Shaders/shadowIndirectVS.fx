@@ -0,0 +1,2 @@
+#define INDIRECT_DRAW
+#include "shadowVS.fx"
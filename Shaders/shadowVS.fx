@@ -3,14 +3,27 @@
 struct VERTEX_INPUT
 {
     float3 position : POSITION;
+#ifdef INDIRECT_DRAW
+    uint instanceId : SV_InstanceID;
+#endif
 };
 
+#ifdef INDIRECT_DRAW
+#include "gpuDrivenCommon.fx"
+#define MODEL_MATRIX instanceBuffer[vertexIn.instanceId].modelMatrix
+#else
+#define MODEL_MATRIX pushConstant.modelMatrix
+#endif
+
 [[vk::push_constant]]
 struct PUSH_CONSTANT {
+#ifndef INDIRECT_DRAW
     float4x4 modelMatrix;
+#endif
+    uint cascadeId;
 } pushConstant;
 
 void main(in VERTEX_INPUT vertexIn, out float4 projPos : SV_Position) {
-    float4 worldPos = mul(pushConstant.modelMatrix, float4(vertexIn.position, 1.0f));
-    projPos = mul(dirLightViewProj, worldPos);
+    float4 worldPos = mul(MODEL_MATRIX, float4(vertexIn.position, 1.0f));
+    projPos = mul(dirLightCascadeViewProj[pushConstant.cascadeId], worldPos);
 }
\ No newline at end of file
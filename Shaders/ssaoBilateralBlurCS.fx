@@ -0,0 +1,69 @@
+#include "common.fx"
+
+//(1, 0) for horizontal pass, (0, 1) for vertical one
+#define blurDirection cb0.xy
+
+[[vk::binding(30)]] Texture2D texSSAOMask;
+[[vk::binding(32)]] Texture2D texSSAODepthNormal;
+[[vk::binding(33)]] RWTexture2D<float> outputSSAOMask;
+
+//must match RENDER_PASS_BLEND_SSAO::BLUR_GROUP_SIZE
+#define BLUR_GROUP_SIZE 64
+#define BLUR_RADIUS     4
+#define BLUR_SIGMA      2.5f
+#define TILE_SIZE       (BLUR_GROUP_SIZE + 2 * BLUR_RADIUS)
+//relative view depth difference which halves the sample weight
+#define DEPTH_TOLERANCE 0.05f
+
+//group blurs a segment of one line, the segment with its borders is read once into shared memory
+groupshared float  tileSSAO[TILE_SIZE];
+groupshared float4 tileDepthNormal[TILE_SIZE];
+
+int2 GetTexelCoord(int along, int across)
+{
+    return blurDirection.x > 0.f ? int2(along, across) : int2(across, along);
+}
+
+//one direction of separable gaussian blur, samples of other surfaces are rejected by depth and normal
+[numthreads(BLUR_GROUP_SIZE, 1, 1)]
+void main(uint3 groupId : SV_GroupID, uint3 localId : SV_GroupThreadID)
+{
+    int2 maskSize;
+    texSSAOMask.GetDimensions(maskSize.x, maskSize.y);
+    //x is length of blurred lines, y is their number
+    int2 linesSize = blurDirection.x > 0.f ? maskSize : maskSize.yx;
+
+    int across = int(groupId.y);
+    int tileStart = int(groupId.x) * BLUR_GROUP_SIZE - BLUR_RADIUS;
+    for (int tileId = int(localId.x); tileId < TILE_SIZE; tileId += BLUR_GROUP_SIZE) {
+        int3 coord = int3(GetTexelCoord(clamp(tileStart + tileId, 0, linesSize.x - 1), across), 0);
+        tileSSAO[tileId] = texSSAOMask.Load(coord).r;
+        tileDepthNormal[tileId] = texSSAODepthNormal.Load(coord);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    int along = int(groupId.x) * BLUR_GROUP_SIZE + int(localId.x);
+    if (along >= linesSize.x) {
+        return;
+    }
+
+    int centerId = int(localId.x) + BLUR_RADIUS;
+    float4 centerDepthNormal = tileDepthNormal[centerId];
+
+    float ssaoFactor = 0.f;
+    float weightSum = 0.f;
+    [unroll]
+    for (int i = -BLUR_RADIUS; i <= BLUR_RADIUS; i++) {
+        float4 sampleDepthNormal = tileDepthNormal[centerId + i];
+
+        float depthDiff = abs(sampleDepthNormal.w - centerDepthNormal.w) / (centerDepthNormal.w * DEPTH_TOLERANCE);
+        float weight = exp(-i * i / (2.f * BLUR_SIGMA * BLUR_SIGMA));
+        weight *= 1.f / (1.f + depthDiff * depthDiff);
+        weight *= saturate(dot(sampleDepthNormal.xyz, centerDepthNormal.xyz));
+
+        ssaoFactor += tileSSAO[centerId + i] * weight;
+        weightSum += weight;
+    }
+    //center sample always has non zero weight unless normal is broken
+    outputSSAOMask[GetTexelCoord(along, across)] = weightSum > 0.f ? ssaoFactor / weightSum : tileSSAO[centerId];
+}
@@ -0,0 +1,35 @@
+#include "common.fx"
+#include "commonFunctions.fx"
+
+#define downsampleFactor cb0.x
+#define sourceSize       cb0.yz
+
+[[vk::binding(21)]] Texture2D texGBufferNormal;
+[[vk::binding(25)]] Texture2D texDepthBuffer;
+
+//each texel keeps view space normal and depth of the closest source texel,
+//averaged depth would belong to none of surfaces on the edges
+void main(in float4 pixelPos : SV_Position, out float4 pixelOut : SV_Target)
+{
+    int factor = int(downsampleFactor);
+    int2 sourceCoord = int2(pixelPos.xy) * factor;
+    int2 maxCoord = int2(sourceSize) - 1;
+
+    int2 closestCoord = min(sourceCoord, maxCoord);
+    float closestDepth = texDepthBuffer.Load(int3(closestCoord, 0)).r;
+    for (int i = 0; i < factor; i++) {
+        for (int j = 0; j < factor; j++) {
+            int2 coord = min(sourceCoord + int2(i, j), maxCoord);
+            float depth = texDepthBuffer.Load(int3(coord, 0)).r;
+            if (depth < closestDepth) {
+                closestDepth = depth;
+                closestCoord = coord;
+            }
+        }
+    }
+
+    float2 texCoord = (float2(closestCoord) + 0.5f) / sourceSize;
+    float3 viewPos = GetPositionFromDepth(texCoord, closestDepth);
+    float3 normal = DecodeOctahedralNormal(texGBufferNormal.Load(int3(closestCoord, 0)).rg);
+    pixelOut = float4(mul(view, float4(normal, 0.f)).xyz, viewPos.z);
+}
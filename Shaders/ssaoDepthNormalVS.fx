@@ -0,0 +1 @@
+#include "hiZBuildVS.fx"
@@ -0,0 +1,2 @@
+#define LOW_RES_INPUT
+#include "ssaoPS.fx"
@@ -0,0 +1 @@
+#include "ssaoVS.fx"
@@ -1,23 +1,49 @@
 #include "ssaoCommon.fx"
 #include "commonFunctions.fx"
 
-[[vk::binding(21)]] Texture2D texGBufferNormal;
-[[vk::binding(25)]] Texture2D texDepthBuffer;
+#define targetSize cb1.xy
+
 [[vk::binding(30)]] Texture2D texSSAOKernel;
 [[vk::binding(31)]] Texture2D texSSAONoise;
 
+#ifdef LOW_RES_INPUT
+//view space normal and depth, see ssaoDepthNormalPS.fx
+[[vk::binding(32)]] Texture2D texSSAODepthNormal;
+
+float3 GetViewPosition(float2 texCoord)
+{
+    return GetPositionFromViewDepth(texCoord, texSSAODepthNormal.Sample(pointClampSampler, texCoord).w);
+}
+
+float3 GetViewNormal(float2 texCoord)
+{
+    return texSSAODepthNormal.Sample(pointClampSampler, texCoord).xyz;
+}
+#else
+[[vk::binding(21)]] Texture2D texGBufferNormal;
+[[vk::binding(25)]] Texture2D texDepthBuffer;
+
+float3 GetViewPosition(float2 texCoord)
+{
+    return GetPositionFromDepth(texCoord, texDepthBuffer.Sample(pointSampler, texCoord).r);
+}
+
+float3 GetViewNormal(float2 texCoord)
+{
+    float3 normal = DecodeOctahedralNormal(texGBufferNormal.Sample(pointSampler, texCoord).rg);
+    return mul(view, float4(normal, 0.f)).xyz;
+}
+#endif
+
 void main(in VERTEX_OUTPUT vertexOut, out PIXEL_OUTPUT pixelOut) 
 {
-    float2 noiseScale = float2(1600.f / kernelSide, 900.f / kernelSide);
+    float2 noiseScale = targetSize / kernelSide;
     
-    float  depth    = texDepthBuffer.Sample(pointSampler, vertexOut.texCoord).r;
-    float3 originView  = GetPositionFromDepth(vertexOut.texCoord, depth);
-    float3 normal     = texGBufferNormal.Sample(pointSampler, vertexOut.texCoord).rgb;
+    float3 originView  = GetViewPosition(vertexOut.texCoord);
+    float3 normal     = GetViewNormal(vertexOut.texCoord);
     float2 noiseData = texSSAONoise.Sample(pointSampler, vertexOut.texCoord * noiseScale).rg;
     float3 randomVector = normalize(float3(noiseData.x, noiseData.y, 0.f));
 
-    normal = mul(view, float4(normal, 0.f)).xyz;
-
     float3 tangent = normalize(randomVector - normal * dot(randomVector, normal));
     float3 bitangent = cross(normal, tangent);
     float3x3 TBN = float3x3(tangent, bitangent, normal);
@@ -35,9 +61,7 @@ void main(in VERTEX_OUTPUT vertexOut, out PIXEL_OUTPUT pixelOut)
             offsetPos.xy = offsetPos.xy * 0.5 + 0.5; // transform to range 0.0 - 1.0  
             offsetPos.y = 1.f - offsetPos.y;
 
-            float sampleDepth = texDepthBuffer.Sample(pointSampler, offsetPos.xy).r;
-
-            float3 realPosView = GetPositionFromDepth(offsetPos.xy, sampleDepth);
+            float3 realPosView = GetViewPosition(offsetPos.xy);
             float rangeCheck = smoothstep(0.0, 1.0, radius / abs(originView.z - realPosView.z));
             float obscureCoef = (realPosView.z <= (offsetPosView.z + bias) ? 1.f : 0.f);
             occlusion += obscureCoef * rangeCheck;
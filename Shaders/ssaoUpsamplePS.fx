@@ -0,0 +1,39 @@
+#include "common.fx"
+#include "commonFunctions.fx"
+
+[[vk::binding(25)]] Texture2D texDepthBuffer;
+[[vk::binding(30)]] Texture2D texSSAOMask;
+[[vk::binding(32)]] Texture2D texSSAODepthNormal;
+
+//relative view depth difference which halves the sample weight
+#define DEPTH_TOLERANCE 0.02f
+
+//bilinear upsample where low resolution texels of other surfaces lose their weight
+void main(in float2 texCoord : TEXCOORD0, out float pixelOut : SV_Target)
+{
+    float2 lowResSize;
+    texSSAOMask.GetDimensions(lowResSize.x, lowResSize.y);
+    int2 maxCoord = int2(lowResSize) - 1;
+
+    float viewDepth = GetPositionFromDepth(texCoord, texDepthBuffer.Sample(pointSampler, texCoord).r).z;
+
+    float2 lowResPos = texCoord * lowResSize - 0.5f;
+    int2 baseCoord = int2(floor(lowResPos));
+    float2 f = lowResPos - floor(lowResPos);
+    const float4 bilinearWeights = float4((1.f - f.x) * (1.f - f.y), f.x * (1.f - f.y), (1.f - f.x) * f.y, f.x * f.y);
+    const int2 offsets[4] = { int2(0, 0), int2(1, 0), int2(0, 1), int2(1, 1) };
+
+    float ssaoFactor = 0.f;
+    float weightSum = 0.f;
+    [unroll]
+    for (int i = 0; i < 4; i++) {
+        int2 coord = clamp(baseCoord + offsets[i], 0, maxCoord);
+        float sampleDepth = texSSAODepthNormal.Load(int3(coord, 0)).w;
+        float depthDiff = abs(sampleDepth - viewDepth) / (viewDepth * DEPTH_TOLERANCE);
+        float weight = bilinearWeights[i] / (1.f + depthDiff * depthDiff) + 1e-5f;
+
+        ssaoFactor += texSSAOMask.Load(int3(coord, 0)).r * weight;
+        weightSum += weight;
+    }
+    pixelOut = ssaoFactor / weightSum;
+}
@@ -0,0 +1 @@
+#include "ssaoBlendVS.fx"